@@ -0,0 +1,95 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <Engine/Core/CoreApplication.h>
+#include <Engine/Core/Platform.h>
+#include <Engine/Core/Logger.h>
+
+HK_NAMESPACE_BEGIN
+
+/** Console application for benchmarks. Several benchmarks may run at the same time. */
+class BenchmarkApplication : public CoreApplication
+{
+public:
+    BenchmarkApplication(ArgumentPack const& args) :
+        CoreApplication(args)
+    {}
+};
+
+/** Runs the function Iterations times and returns the average time of one call in nanoseconds. */
+template <typename Fn>
+double MeasureNanoseconds(int Iterations, Fn&& fn)
+{
+    // Warm up caches
+    fn();
+
+    int64_t startTime = Core::SysMicroseconds();
+    for (int i = 0; i < Iterations; i++)
+        fn();
+    int64_t time = Core::SysMicroseconds() - startTime;
+
+    return time * 1000.0 / Iterations;
+}
+
+/** Command line of a benchmark application. Several benchmarks may run at the same time. */
+class BenchmarkArguments
+{
+public:
+    BenchmarkArguments(int argc, const char* argv[])
+    {
+        for (; m_NumArgs < argc && m_NumArgs < MAX_ARGS - 1; m_NumArgs++)
+            m_Args[m_NumArgs] = argv[m_NumArgs];
+        m_Args[m_NumArgs++] = "-bAllowMultipleInstances";
+    }
+
+    ArgumentPack GetPack() { return ArgumentPack(m_NumArgs, m_Args); }
+
+private:
+    static constexpr int MAX_ARGS = 64;
+
+    const char* m_Args[MAX_ARGS];
+    int m_NumArgs = 0;
+};
+
+template <typename Fn>
+int RunBenchmark(int argc, const char* argv[], Fn&& fn)
+{
+    BenchmarkArguments args(argc, argv);
+
+    BenchmarkApplication app(args.GetPack());
+
+    fn();
+
+    return app.ExitCode();
+}
+
+HK_NAMESPACE_END
@@ -0,0 +1,176 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+/*
+
+Measures pose evaluation of deep blend trees built with AddBlendNode.
+
+Each tree is a chain: every blend node mixes the previous node with a new leaf.
+Trees are flattened into a list of weighted tracks when built, so the cost
+depends on the number of distinct tracks, not on the depth. The "shared tracks"
+trees reuse 4 animations along the whole chain and must stay flat as depth grows.
+
+*/
+
+#include "Benchmark.h"
+
+#include <Engine/World/Modules/Skeleton/SkeletalAnimation.h>
+
+using namespace Hk;
+
+namespace
+{
+
+const int NumJoints  = 64;
+const int NumFrames  = 60;
+const int NumTracks  = 32;
+const int Iterations = 2000;
+
+void CreateSkeleton(SkeletonResource& skeleton, bool bCompressed)
+{
+    skeleton.m_Joints.Resize(NumJoints);
+    for (int i = 0; i < NumJoints; i++)
+    {
+        SkeletonJoint& joint = skeleton.m_Joints[i];
+        joint.Parent         = i - 1;
+        joint.LocalTransform = Float3x4::Translation(Float3(0, 0.1f, 0));
+        Core::Sprintf(joint.Name, sizeof(joint.Name), "Joint%d", i);
+    }
+
+    skeleton.m_BindposeBounds = BvAxisAlignedBox(Float3(-1), Float3(1));
+
+    Vector<AnimationChannel> channels;
+    channels.Resize(NumJoints);
+    for (int i = 0; i < NumJoints; i++)
+    {
+        channels[i].JointIndex      = i;
+        channels[i].TransformOffset = i * NumFrames;
+        channels[i].bHasPosition    = true;
+        channels[i].bHasRotation    = true;
+        channels[i].bHasScale       = false;
+    }
+
+    Vector<Transform> transforms;
+    transforms.Resize(NumJoints * NumFrames);
+
+    Vector<BvAxisAlignedBox> bounds;
+    bounds.Resize(NumFrames, BvAxisAlignedBox(Float3(-1), Float3(1)));
+
+    Vector<Ref<SkeletalAnimation>> animations;
+    for (int track = 0; track < NumTracks; track++)
+    {
+        for (int joint = 0; joint < NumJoints; joint++)
+        {
+            for (int frame = 0; frame < NumFrames; frame++)
+            {
+                float t = frame * (Math::_2PI / NumFrames) + track * 0.37f + joint * 0.11f;
+
+                Transform& transform = transforms[joint * NumFrames + frame];
+                transform.Position   = Float3(0, 0.1f, Math::Sin(t) * 0.01f);
+                transform.Rotation   = Quat::RotationX(Math::Sin(t) * 0.5f) * Quat::RotationZ(Math::Cos(t) * 0.25f);
+                transform.Scale      = Float3(1);
+            }
+        }
+
+        Ref<SkeletalAnimation> animation = MakeRef<SkeletalAnimation>(NumFrames, 1.0f / 30, transforms.ToPtr(), transforms.Size(), channels.ToPtr(), channels.Size(), bounds.ToPtr());
+        animation->m_Name = HK_FORMAT("Anim{}", track);
+
+        if (bCompressed)
+            animation->Compress(AnimationCompressionSettings{});
+
+        animations.Add(animation);
+    }
+
+    skeleton.SetAnimations(ArrayView<Ref<SkeletalAnimation>>(animations.ToPtr(), animations.Size()));
+}
+
+double MeasureDeepTree(SkeletonResource const& skeleton, int depth, int numDistinctTracks)
+{
+    Ref<AnimationBlendMachine> machine = MakeRef<AnimationBlendMachine>(SkeletonHandle{});
+
+    AnimationBlendMachine::Layer* layer = machine->CreateLayer("Default");
+
+    Vector<Ref<SkeletalAnimationTrack>> tracks;
+    for (int i = 0; i < numDistinctTracks; i++)
+    {
+        tracks.Add(MakeRef<SkeletalAnimationTrack>(HK_FORMAT("Anim{}", i)));
+        tracks.Last()->SetPlaybackMode(SkeletalAnimationTrack::PLAYBACK_WRAP);
+    }
+
+    AnimationBlendMachine::NodeHandle node = layer->AddNode(tracks[0]);
+    for (int level = 1; level <= depth; level++)
+    {
+        AnimationBlendMachine::NodeHandle leaf = layer->AddNode(tracks[level % numDistinctTracks]);
+
+        node = layer->AddBlendNode({{node, 0.5f}, {leaf, 0.5f}});
+    }
+
+    layer->AddState("Deep", node);
+
+    Ref<AnimationInstance> instance = machine->Instantiate();
+    instance->SetLayerState(0, "Deep");
+
+    Ref<SkeletonPose> pose = MakeRef<SkeletonPose>();
+
+    return MeasureNanoseconds(Iterations,
+                              [&]()
+                              {
+                                  instance->Update(1.0f / 60, &skeleton, pose);
+                              });
+}
+
+void RunBlendTreeBenchmark()
+{
+    const int depths[] = {1, 2, 4, 8, 16, 31};
+
+    for (bool bCompressed : {false, true})
+    {
+        SkeletonResource skeleton;
+        CreateSkeleton(skeleton, bCompressed);
+
+        LOG("{} animations, {} joints\n", bCompressed ? "Compressed" : "Uncompressed", NumJoints);
+        LOG("  depth | unique tracks ns/pose | shared tracks ns/pose\n");
+
+        for (int depth : depths)
+        {
+            double unique = MeasureDeepTree(skeleton, depth, NumTracks);
+            double shared = MeasureDeepTree(skeleton, depth, 4);
+
+            LOG("  {:5} | {:21.0f} | {:21.0f}\n", depth, unique, shared);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+    return RunBenchmark(argc, argv, RunBlendTreeBenchmark);
+}
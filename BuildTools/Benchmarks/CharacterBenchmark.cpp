@@ -0,0 +1,160 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+/*
+
+Measures the update of N character controllers with com_ParallelCharacters 0 and 1.
+
+Characters stand on a static box in a grid, one meter apart, and walk in
+different directions. The time is taken from the "PhysicsUpdate" ticking group
+of the world, averaged over MeasureFrames fixed steps. The physics step of the
+scene is included, but with one static body it is small next to the characters.
+
+The benchmark needs the job manager and the physics module, so it runs inside
+a GameApplication and opens a window.
+
+*/
+
+#include "Benchmark.h"
+
+#include <Engine/GameApplication/GameApplication.h>
+#include <Engine/World/World.h>
+#include <Engine/World/Modules/Physics/Components/CharacterControllerComponent.h>
+#include <Engine/World/Modules/Physics/Components/StaticBodyComponent.h>
+#include <Engine/World/Modules/Physics/Components/Colliders/BoxCollider.h>
+#include <Engine/Core/ConsoleVar.h>
+
+HK_NAMESPACE_BEGIN
+extern ConsoleVar com_ParallelCharacters;
+HK_NAMESPACE_END
+
+using namespace Hk;
+
+namespace
+{
+
+const int WarmupFrames  = 10;
+const int MeasureFrames = 120;
+
+void CreateScene(World* world, int numCharacters)
+{
+    int gridSize = Math::Max(1, int(Math::Ceil(Math::Sqrt(float(numCharacters)))));
+
+    GameObjectDesc floorDesc;
+    floorDesc.Position = Float3(0, -0.5f, 0);
+
+    GameObject* floor;
+    world->CreateObject(floorDesc, floor);
+    floor->CreateComponent<StaticBodyComponent>();
+
+    BoxCollider* floorCollider;
+    floor->CreateComponent(floorCollider);
+    floorCollider->HalfExtents = Float3(gridSize + 50.0f, 0.5f, gridSize + 50.0f);
+
+    for (int i = 0; i < numCharacters; i++)
+    {
+        GameObjectDesc desc;
+        desc.Position  = Float3(i % gridSize - gridSize * 0.5f, 0.1f, i / gridSize - gridSize * 0.5f);
+        desc.IsDynamic = true;
+
+        GameObject* object;
+        world->CreateObject(desc, object);
+
+        CharacterControllerComponent* character;
+        object->CreateComponent(character);
+
+        float angle = i * 2.39996f;
+        character->MovementDirection = Float3(Math::Cos(angle), 0, Math::Sin(angle));
+    }
+}
+
+int64_t GetPhysicsUpdateTime(World const* world)
+{
+    TickingGroup const& group = world->GetTickingGroup(TickGroup::PhysicsUpdate);
+
+    int64_t time = 0;
+    for (uint32_t i = 0; i < group.GetFunctionCount(); i++)
+        time += group.GetFunctionTime(i);
+    return time;
+}
+
+double MeasureCharacters(GameApplication& app, int numCharacters, bool bParallel)
+{
+    com_ParallelCharacters = bParallel;
+
+    World* world = app.CreateWorld();
+
+    CreateScene(world, numCharacters);
+
+    const float timeStep = 1.0f / world->GetSettings().FixedUpdateRate;
+
+    for (int frame = 0; frame < WarmupFrames; frame++)
+        world->Tick(timeStep);
+
+    int64_t time = 0;
+    for (int frame = 0; frame < MeasureFrames; frame++)
+    {
+        world->Tick(timeStep);
+        time += GetPhysicsUpdateTime(world);
+    }
+
+    app.DestroyWorld(world);
+
+    return time / 1000.0 / MeasureFrames;
+}
+
+void RunCharacterBenchmark(GameApplication& app)
+{
+    const int counts[] = {64, 256, 1024, 4096};
+
+    LOG("Worker threads: {}\n", GameApplication::GetAsyncJobManager().GetNumWorkerThreads());
+    LOG("  characters | serial ms/step | parallel ms/step | speedup\n");
+
+    for (int numCharacters : counts)
+    {
+        double serial = MeasureCharacters(app, numCharacters, false);
+        double parallel = MeasureCharacters(app, numCharacters, true);
+
+        LOG("  {:10} | {:14.3f} | {:16.3f} | {:7.2f}\n", numCharacters, serial, parallel, parallel > 0 ? serial / parallel : 0.0);
+    }
+}
+
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkArguments args(argc, argv);
+
+    GameApplication app(args.GetPack(), "Character Benchmark");
+
+    RunCharacterBenchmark(app);
+
+    return app.ExitCode();
+}
@@ -0,0 +1,168 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+/*
+
+Measures the crowd update for N agents.
+
+Agents start in a grid on a flat static floor with a navmesh and walk to the
+mirrored position on the other side of the floor, so every agent has a path and
+neighbours to avoid. The LOD origin is in the center of the crowd. The time of
+the "Update Crowd" tick function is averaged over MeasureFrames fixed steps.
+
+The target for 2000 agents is 2 ms per step.
+
+*/
+
+#include "Benchmark.h"
+
+#include <Engine/GameApplication/GameApplication.h>
+#include <Engine/World/World.h>
+#include <Engine/World/Modules/NavMesh/NavMeshInterface.h>
+#include <Engine/World/Modules/NavMesh/Components/CrowdAgentComponent.h>
+#include <Engine/World/Modules/Physics/Components/StaticBodyComponent.h>
+#include <Engine/World/Modules/Physics/Components/Colliders/BoxCollider.h>
+
+using namespace Hk;
+
+namespace
+{
+
+const int   WarmupFrames  = 10;
+const int   MeasureFrames = 120;
+const float AgentSpacing  = 2.0f;
+
+int64_t GetTickFunctionTime(World const* world, TickGroup group, StringView name)
+{
+    TickingGroup const& tickingGroup = world->GetTickingGroup(group);
+
+    for (uint32_t i = 0; i < tickingGroup.GetFunctionCount(); i++)
+    {
+        if (tickingGroup.GetFunctionName(i).GetStringView() == name)
+            return tickingGroup.GetFunctionTime(i);
+    }
+    return 0;
+}
+
+double MeasureCrowd(GameApplication& app, int numAgents)
+{
+    World* world = app.CreateWorld();
+
+    const float timeStep = 1.0f / world->GetSettings().FixedUpdateRate;
+
+    int gridSize = Math::Max(1, int(Math::Ceil(Math::Sqrt(float(numAgents)))));
+    float halfExtent = gridSize * AgentSpacing * 0.5f + 10.0f;
+
+    GameObjectDesc floorDesc;
+    floorDesc.Position = Float3(0, -0.5f, 0);
+
+    GameObject* floor;
+    world->CreateObject(floorDesc, floor);
+    floor->CreateComponent<StaticBodyComponent>();
+
+    BoxCollider* floorCollider;
+    floor->CreateComponent(floorCollider);
+    floorCollider->HalfExtents = Float3(halfExtent, 0.5f, halfExtent);
+
+    // Add the floor to the physics scene before the navmesh gathers it
+    world->Tick(timeStep);
+
+    NavMeshInterface& navMesh = world->GetInterface<NavMeshInterface>();
+    navMesh.IsDynamic = false;
+    navMesh.NavigationVolumes.Add(BvAxisAlignedBox(Float3(-halfExtent, -1, -halfExtent), Float3(halfExtent, 2, halfExtent)));
+    navMesh.Create();
+    navMesh.Build();
+
+    Vector<CrowdAgentComponent*> agents;
+    Vector<Float3> targets;
+    for (int i = 0; i < numAgents; i++)
+    {
+        Float3 position((i % gridSize - gridSize * 0.5f) * AgentSpacing, 0, (i / gridSize - gridSize * 0.5f) * AgentSpacing);
+
+        GameObjectDesc desc;
+        desc.Position = position;
+        desc.IsDynamic = true;
+
+        GameObject* object;
+        world->CreateObject(desc, object);
+
+        CrowdAgentComponent* agent;
+        object->CreateComponent(agent);
+
+        agents.Add(agent);
+        targets.Add(Float3(-position.X, 0, -position.Z));
+    }
+
+    world->GetInterface<CrowdInterface>().SetLodOrigin(Float3(0));
+
+    // Agents are added to the crowd when the components begin play
+    world->Tick(timeStep);
+
+    for (int i = 0; i < numAgents; i++)
+        agents[i]->MoveTo(targets[i]);
+
+    for (int frame = 0; frame < WarmupFrames; frame++)
+        world->Tick(timeStep);
+
+    int64_t time = 0;
+    for (int frame = 0; frame < MeasureFrames; frame++)
+    {
+        world->Tick(timeStep);
+        time += GetTickFunctionTime(world, TickGroup::FixedUpdate, "Update Crowd");
+    }
+
+    app.DestroyWorld(world);
+
+    return time / 1000.0 / MeasureFrames;
+}
+
+void RunCrowdBenchmark(GameApplication& app)
+{
+    const int counts[] = {500, 1000, 2000, 4000, 8000, CrowdInterface::MaxAgents};
+
+    LOG("Worker threads: {}\n", GameApplication::GetAsyncJobManager().GetNumWorkerThreads());
+    LOG("  agents | ms/step\n");
+
+    for (int numAgents : counts)
+        LOG("  {:6} | {:7.3f}\n", numAgents, MeasureCrowd(app, numAgents));
+}
+
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkArguments args(argc, argv);
+
+    GameApplication app(args.GetPack(), "Crowd Benchmark");
+
+    RunCrowdBenchmark(app);
+
+    return app.ExitCode();
+}
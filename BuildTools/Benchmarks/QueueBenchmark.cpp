@@ -0,0 +1,157 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+/*
+
+Measures throughput of the lock-free queues with N producer threads and one consumer.
+
+Every producer pushes ItemsPerProducer values, the main thread pops them all.
+Bounded queues spin when full or empty, so the numbers include contention on the
+ring buffer. SPSCQueue only supports one producer.
+
+*/
+
+#include "Benchmark.h"
+
+#include <Engine/Core/Containers/MPSCQueue.h>
+#include <Engine/Core/Containers/SPSCQueue.h>
+#include <Engine/Core/Thread.h>
+#include <Engine/Core/Atomic.h>
+
+using namespace Hk;
+
+namespace
+{
+
+const uint32_t ItemsPerProducer = 1000000;
+const int      MaxProducers     = 16;
+
+/** Runs numProducers threads calling push(value) and pops everything on this thread. Returns millions of items per second. */
+template <typename Queue, typename PushFn>
+double MeasureThroughput(Queue& queue, int numProducers, PushFn push)
+{
+    AtomicBool start{false};
+
+    Thread producers[MaxProducers];
+    for (int p = 0; p < numProducers; p++)
+    {
+        producers[p].Start(
+            [&]()
+            {
+                while (!start.Load())
+                    YieldCPU();
+
+                for (uint32_t i = 1; i <= ItemsPerProducer; i++)
+                    push(queue, i);
+            });
+    }
+
+    const uint64_t total = uint64_t(ItemsPerProducer) * numProducers;
+    const uint64_t expectedSum = uint64_t(ItemsPerProducer) * (ItemsPerProducer + 1) / 2 * numProducers;
+
+    uint64_t received = 0;
+    uint64_t sum = 0;
+
+    int64_t startTime = Core::SysMicroseconds();
+    start.Store(true);
+
+    uint32_t value;
+    while (received < total)
+    {
+        if (queue.TryPop(value))
+        {
+            sum += value;
+            received++;
+        }
+        else
+            YieldCPU();
+    }
+
+    int64_t time = Core::SysMicroseconds() - startTime;
+
+    for (int p = 0; p < numProducers; p++)
+        producers[p].Join();
+
+    if (sum != expectedSum)
+        LOG("Queue lost or duplicated items\n");
+
+    return time > 0 ? double(total) / time : 0.0;
+}
+
+void PushUnbounded(MPSCQueue<uint32_t>& queue, uint32_t value)
+{
+    queue.Push(value);
+}
+
+template <typename Queue>
+void PushBounded(Queue& queue, uint32_t value)
+{
+    while (!queue.TryPush(value))
+        YieldCPU();
+}
+
+void RunQueueBenchmark()
+{
+    const int producerCounts[] = {1, 2, 4, 8};
+
+    LOG("  producers | MPSCQueue Mitems/s | BoundedMPSCQueue Mitems/s | SPSCQueue Mitems/s\n");
+
+    for (int numProducers : producerCounts)
+    {
+        double unbounded, bounded;
+        {
+            MPSCQueue<uint32_t> queue;
+            unbounded = MeasureThroughput(queue, numProducers, PushUnbounded);
+        }
+        {
+            BoundedMPSCQueue<uint32_t> queue;
+            bounded = MeasureThroughput(queue, numProducers, PushBounded<BoundedMPSCQueue<uint32_t>>);
+        }
+
+        if (numProducers == 1)
+        {
+            SPSCQueue<uint32_t> queue;
+            double spsc = MeasureThroughput(queue, numProducers, PushBounded<SPSCQueue<uint32_t>>);
+
+            LOG("  {:9} | {:18.2f} | {:25.2f} | {:18.2f}\n", numProducers, unbounded, bounded, spsc);
+        }
+        else
+            LOG("  {:9} | {:18.2f} | {:25.2f} | {:>18}\n", numProducers, unbounded, bounded, "-");
+    }
+
+    LOG("Hardware threads: {}\n", Thread::NumHardwareThreads);
+}
+
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+    return RunBenchmark(argc, argv, RunQueueBenchmark);
+}
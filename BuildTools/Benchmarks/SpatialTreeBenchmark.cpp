@@ -0,0 +1,369 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+/*
+
+Checks SpatialTree queries against a linear scan and compares their time.
+
+Primitives are random boxes and spheres with random masks. Every round moves,
+removes and adds primitives, including small moves that stay inside the fat
+leaf bounds and large jumps that reinsert leaves, then calls RebalanceIfNeeded.
+Every few rounds the tree is rebuilt with Rebalance. After each round box,
+sphere, frustum and ray queries must return the same primitives as a linear
+scan over a shadow copy of the primitives.
+
+The benchmark exits with code 1 on the first mismatch.
+
+*/
+
+#include "Benchmark.h"
+
+#include <Engine/World/Modules/Render/SpatialTree.h>
+#include <Engine/Geometry/BV/BvIntersect.h>
+#include <Engine/Core/Random.h>
+
+#include <algorithm>
+
+using namespace Hk;
+
+namespace
+{
+
+const int      NumPrimitives      = 4096;
+const int      NumRounds          = 200;
+const int      OpsPerRound        = 256;
+const int      QueriesPerRound    = 8;
+const int      RebalancePeriod    = 50;
+const float    WorldExtent        = 500.0f;
+
+struct ShadowPrimitive
+{
+    BvAxisAlignedBox Box;
+    BvSphere         Sphere;
+    SPATIAL_MASK     Mask = 0;
+    bool             bSphere = false;
+    bool             bUsed = false;
+};
+
+class SpatialTreeChecker
+{
+public:
+    bool Run()
+    {
+        for (int i = 0; i < NumPrimitives; i++)
+            Add();
+
+        for (int round = 0; round < NumRounds; round++)
+        {
+            for (int op = 0; op < OpsPerRound; op++)
+            {
+                uint32_t kind = m_Rand.Get(99);
+                if (kind < 60)
+                    Move(kind < 45);
+                else if (kind < 80)
+                    Remove();
+                else
+                    Add();
+            }
+
+            if ((round + 1) % RebalancePeriod == 0)
+                m_Tree.Rebalance();
+            else
+                m_Tree.RebalanceIfNeeded();
+
+            if (m_Tree.GetPrimitiveCount() != m_Ids.Size())
+            {
+                LOG("SpatialTree: primitive count {} != {}\n", m_Tree.GetPrimitiveCount(), m_Ids.Size());
+                return false;
+            }
+
+            for (int query = 0; query < QueriesPerRound; query++)
+            {
+                if (!CheckQueries())
+                {
+                    LOG("SpatialTree: mismatch on round {}\n", round);
+                    return false;
+                }
+            }
+        }
+
+        LOG("Primitives: {}, height: {}, area ratio: {:.2f}\n", m_Tree.GetPrimitiveCount(), m_Tree.GetHeight(), m_Tree.GetAreaRatio());
+        LOG("  query   | tree us | linear us | results\n");
+        LOG("  box     | {:7.2f} | {:9.2f} | {}\n", AverageTime(m_TreeTime[0]), AverageTime(m_LinearTime[0]), m_NumResults[0]);
+        LOG("  sphere  | {:7.2f} | {:9.2f} | {}\n", AverageTime(m_TreeTime[1]), AverageTime(m_LinearTime[1]), m_NumResults[1]);
+        LOG("  frustum | {:7.2f} | {:9.2f} | {}\n", AverageTime(m_TreeTime[2]), AverageTime(m_LinearTime[2]), m_NumResults[2]);
+        LOG("  ray     | {:7.2f} | {:9.2f} | {}\n", AverageTime(m_TreeTime[3]), AverageTime(m_LinearTime[3]), m_NumResults[3]);
+        return true;
+    }
+
+private:
+    Float3 RandomPoint(float extent)
+    {
+        return Float3(m_Rand.GetFloat(-extent, extent), m_Rand.GetFloat(-extent, extent), m_Rand.GetFloat(-extent, extent));
+    }
+
+    void RandomGeometry(ShadowPrimitive& primitive, Float3 const& center)
+    {
+        if (primitive.bSphere)
+        {
+            primitive.Sphere = BvSphere(center, m_Rand.GetFloat(0.1f, 5.0f));
+        }
+        else
+        {
+            Float3 halfSize(m_Rand.GetFloat(0.1f, 5.0f), m_Rand.GetFloat(0.1f, 5.0f), m_Rand.GetFloat(0.1f, 5.0f));
+            primitive.Box = BvAxisAlignedBox(center - halfSize, center + halfSize);
+        }
+    }
+
+    void Add()
+    {
+        ShadowPrimitive primitive;
+        primitive.Mask = 1u << m_Rand.Get(3);
+        primitive.bSphere = m_Rand.Get(1) == 0;
+        primitive.bUsed = true;
+        RandomGeometry(primitive, RandomPoint(WorldExtent));
+
+        uint32_t id = primitive.bSphere ? m_Tree.AddPrimitive(primitive.Sphere, primitive.Mask) : m_Tree.AddPrimitive(primitive.Box, primitive.Mask);
+
+        if (id >= m_Shadow.Size())
+            m_Shadow.Resize(id + 1);
+        HK_ASSERT(!m_Shadow[id].bUsed);
+        m_Shadow[id] = primitive;
+        m_Ids.Add(id);
+    }
+
+    void Remove()
+    {
+        if (m_Ids.IsEmpty())
+            return;
+
+        uint32_t index = m_Rand.Get(m_Ids.Size() - 1);
+        uint32_t id = m_Ids[index];
+
+        m_Tree.RemovePrimitive(id);
+        m_Shadow[id].bUsed = false;
+        m_Ids.RemoveUnsorted(index);
+    }
+
+    void Move(bool bSmall)
+    {
+        if (m_Ids.IsEmpty())
+            return;
+
+        uint32_t id = m_Ids[m_Rand.Get(m_Ids.Size() - 1)];
+        ShadowPrimitive& primitive = m_Shadow[id];
+
+        if (bSmall)
+        {
+            // Stays within the fat bounds of the leaf
+            Float3 offset = RandomPoint(m_Tree.FatMargin * 0.5f);
+            if (primitive.bSphere)
+                primitive.Sphere.Center += offset;
+            else
+                primitive.Box = BvAxisAlignedBox(primitive.Box.Mins + offset, primitive.Box.Maxs + offset);
+        }
+        else
+        {
+            // Reinserts the leaf
+            RandomGeometry(primitive, RandomPoint(WorldExtent));
+        }
+
+        if (primitive.bSphere)
+            m_Tree.SetBounds(id, primitive.Sphere);
+        else
+            m_Tree.SetBounds(id, primitive.Box);
+    }
+
+    template <typename Test>
+    void LinearScan(Test&& test, Vector<uint32_t>& result) const
+    {
+        for (uint32_t id : m_Ids)
+        {
+            ShadowPrimitive const& primitive = m_Shadow[id];
+            if ((primitive.Mask & m_FilterMask) && test(primitive))
+                result.Add(id);
+        }
+    }
+
+    bool Compare(int queryType, Vector<uint32_t>& treeResult, Vector<uint32_t>& linearResult)
+    {
+        std::sort(treeResult.Begin(), treeResult.End());
+        std::sort(linearResult.Begin(), linearResult.End());
+
+        m_NumResults[queryType] += linearResult.Size();
+
+        if (treeResult.Size() != linearResult.Size())
+        {
+            LOG("SpatialTree: query {} returned {} primitives, linear scan {}\n", queryType, treeResult.Size(), linearResult.Size());
+            return false;
+        }
+        for (uint32_t i = 0; i < treeResult.Size(); i++)
+        {
+            if (treeResult[i] != linearResult[i])
+            {
+                LOG("SpatialTree: query {} returned primitive {}, linear scan {}\n", queryType, treeResult[i], linearResult[i]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename TreeQuery, typename LinearQuery>
+    bool CheckQuery(int queryType, TreeQuery&& treeQuery, LinearQuery&& linearQuery)
+    {
+        Vector<uint32_t> treeResult, linearResult;
+
+        int64_t time = Core::SysMicroseconds();
+        treeQuery(treeResult);
+        m_TreeTime[queryType] += Core::SysMicroseconds() - time;
+
+        time = Core::SysMicroseconds();
+        linearQuery(linearResult);
+        m_LinearTime[queryType] += Core::SysMicroseconds() - time;
+
+        return Compare(queryType, treeResult, linearResult);
+    }
+
+    bool CheckQueries()
+    {
+        m_NumQueries++;
+
+        m_FilterMask = m_Rand.Get(1) ? SPATIAL_MASK_ALL : (1u << m_Rand.Get(3)) | (1u << m_Rand.Get(3));
+
+        Float3 center = RandomPoint(WorldExtent);
+        Float3 halfSize(m_Rand.GetFloat(1.0f, 50.0f));
+        BvAxisAlignedBox box(center - halfSize, center + halfSize);
+
+        bool ok = CheckQuery(0,
+            [&](Vector<uint32_t>& result) { m_Tree.QueryBox(box, m_FilterMask, result); },
+            [&](Vector<uint32_t>& result)
+            {
+                LinearScan([&](ShadowPrimitive const& primitive)
+                {
+                    return primitive.bSphere ? BvBoxOverlapSphere(box, primitive.Sphere) : BvBoxOverlapBox(box, primitive.Box);
+                }, result);
+            });
+
+        BvSphere sphere(RandomPoint(WorldExtent), m_Rand.GetFloat(1.0f, 50.0f));
+
+        ok = ok && CheckQuery(1,
+            [&](Vector<uint32_t>& result) { m_Tree.QuerySphere(sphere, m_FilterMask, result); },
+            [&](Vector<uint32_t>& result)
+            {
+                LinearScan([&](ShadowPrimitive const& primitive)
+                {
+                    return primitive.bSphere ? BvSphereOverlapSphere(sphere, primitive.Sphere) : BvBoxOverlapSphere(primitive.Box, sphere);
+                }, result);
+            });
+
+        Float3 eye = RandomPoint(WorldExtent);
+        Float3 target = RandomPoint(WorldExtent);
+        Float4x4 projection = Float4x4::Perspective(Math::Radians(90.0f), Math::Radians(70.0f), 0.1f, 300.0f);
+        BvFrustum frustum;
+        frustum.FromMatrix(projection * Float4x4::LookAt(eye, target, Float3(0, 1, 0)));
+
+        ok = ok && CheckQuery(2,
+            [&](Vector<uint32_t>& result) { m_Tree.QueryFrustum(frustum, m_FilterMask, result); },
+            [&](Vector<uint32_t>& result)
+            {
+                LinearScan([&](ShadowPrimitive const& primitive)
+                {
+                    return primitive.bSphere ? frustum.IsSphereVisible(primitive.Sphere) : frustum.IsBoxVisible(primitive.Box);
+                }, result);
+            });
+
+        Float3 rayStart = RandomPoint(WorldExtent);
+        Float3 rayDir = (RandomPoint(WorldExtent) - rayStart).Normalized();
+        Float3 invRayDir(1.0f / rayDir.X, 1.0f / rayDir.Y, 1.0f / rayDir.Z);
+        float maxDistance = m_Rand.GetFloat(10.0f, WorldExtent * 2);
+
+        Vector<SpatialRaycastResult> hits;
+        bool sorted = true;
+
+        ok = ok && CheckQuery(3,
+            [&](Vector<uint32_t>& result)
+            {
+                m_Tree.Raycast(rayStart, rayDir, maxDistance, m_FilterMask, hits);
+                for (uint32_t i = 0; i < hits.Size(); i++)
+                {
+                    result.Add(hits[i].PrimitiveId);
+                    if (i > 0 && hits[i].Distance < hits[i - 1].Distance)
+                        sorted = false;
+                }
+            },
+            [&](Vector<uint32_t>& result)
+            {
+                LinearScan([&](ShadowPrimitive const& primitive)
+                {
+                    float boxMin, boxMax;
+                    bool hit = primitive.bSphere ? BvRayIntersectSphere(rayStart, rayDir, primitive.Sphere, boxMin, boxMax) : BvRayIntersectBox(rayStart, invRayDir, primitive.Box, boxMin, boxMax);
+                    return hit && Math::Max(boxMin, 0.0f) <= maxDistance;
+                }, result);
+            });
+
+        if (!sorted)
+        {
+            LOG("SpatialTree: raycast hits are not sorted by distance\n");
+            return false;
+        }
+
+        return ok;
+    }
+
+    double AverageTime(int64_t time) const
+    {
+        return m_NumQueries ? double(time) / m_NumQueries : 0.0;
+    }
+
+    SpatialTree             m_Tree;
+    Vector<ShadowPrimitive> m_Shadow;
+    Vector<uint32_t>        m_Ids;
+    MersenneTwisterRand     m_Rand{12345};
+    SPATIAL_MASK            m_FilterMask = SPATIAL_MASK_ALL;
+    int64_t                 m_TreeTime[4] = {};
+    int64_t                 m_LinearTime[4] = {};
+    uint64_t                m_NumResults[4] = {};
+    int                     m_NumQueries = 0;
+};
+
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkArguments args(argc, argv);
+
+    BenchmarkApplication app(args.GetPack());
+
+    SpatialTreeChecker checker;
+    if (!checker.Run())
+        return 1;
+
+    return app.ExitCode();
+}
@@ -0,0 +1,169 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+/*
+
+Measures the world transform update of World::Tick with com_TransformSIMD and
+com_ParallelTransforms set to 0 and 1.
+
+The world holds N dynamic roots, each with a child and a grandchild, so three
+hierarchy levels are updated. All roots are moved before every step, which
+makes the whole hierarchy dirty. The world has no components, so the time of
+the fixed step is the time of the transform update.
+
+The benchmark needs the job manager, so it runs inside a GameApplication and
+opens a window.
+
+*/
+
+#include "Benchmark.h"
+
+#include <Engine/GameApplication/GameApplication.h>
+#include <Engine/World/World.h>
+#include <Engine/Core/ConsoleVar.h>
+
+HK_NAMESPACE_BEGIN
+extern ConsoleVar com_TransformSIMD;
+extern ConsoleVar com_ParallelTransforms;
+HK_NAMESPACE_END
+
+using namespace Hk;
+
+namespace
+{
+
+const int WarmupFrames  = 10;
+const int MeasureFrames = 100;
+
+void CreateScene(World* world, int numRoots, Vector<GameObject*>& roots)
+{
+    roots.Clear();
+
+    for (int i = 0; i < numRoots; i++)
+    {
+        float t = i * 0.01f;
+
+        GameObjectDesc desc;
+        desc.Position  = Float3(Math::Sin(t) * 100, 0, Math::Cos(t) * 100);
+        desc.Rotation  = Quat::RotationY(t);
+        desc.Scale     = Float3(1.0f + (i & 3) * 0.25f);
+        desc.IsDynamic = true;
+
+        GameObject* root;
+        world->CreateObject(desc, root);
+        roots.Add(root);
+
+        GameObjectDesc childDesc;
+        childDesc.Parent        = root->GetHandle();
+        childDesc.Position      = Float3(0, 1, 2);
+        childDesc.Rotation      = Quat::RotationX(t * 3);
+        childDesc.Scale         = Float3(0.5f);
+        childDesc.AbsoluteScale = (i % 16) == 0;
+        childDesc.IsDynamic     = true;
+
+        GameObject* child;
+        world->CreateObject(childDesc, child);
+
+        childDesc.Parent = child->GetHandle();
+        world->CreateObject(childDesc);
+    }
+}
+
+void MoveRoots(Vector<GameObject*> const& roots, int frame)
+{
+    for (uint32_t i = 0; i < roots.Size(); i++)
+        roots[i]->SetRotation(Quat::RotationY(frame * 0.01f + i * 0.01f));
+}
+
+double MeasureTransforms(GameApplication& app, int numRoots, bool bSIMD, bool bParallel)
+{
+    com_TransformSIMD = bSIMD;
+    com_ParallelTransforms = bParallel;
+
+    World* world = app.CreateWorld();
+
+    Vector<GameObject*> roots;
+    CreateScene(world, numRoots, roots);
+
+    const float timeStep = 1.0f / world->GetSettings().FixedUpdateRate;
+
+    int frame = 0;
+    for (; frame < WarmupFrames; frame++)
+    {
+        MoveRoots(roots, frame);
+        world->Tick(timeStep);
+    }
+
+    int64_t time = 0;
+    for (int i = 0; i < MeasureFrames; i++, frame++)
+    {
+        MoveRoots(roots, frame);
+
+        int64_t startTime = Core::SysMicroseconds();
+        world->Tick(timeStep);
+        time += Core::SysMicroseconds() - startTime;
+    }
+
+    app.DestroyWorld(world);
+
+    // Nanoseconds per transform
+    return time * 1000.0 / MeasureFrames / (numRoots * 3);
+}
+
+void RunTransformBenchmark(GameApplication& app)
+{
+    const int counts[] = {64, 1024, 16384, 65536};
+
+    LOG("Worker threads: {}\n", GameApplication::GetAsyncJobManager().GetNumWorkerThreads());
+    LOG("  transforms | scalar ns | SIMD ns | scalar parallel ns | SIMD parallel ns\n");
+
+    for (int numRoots : counts)
+    {
+        double scalar = MeasureTransforms(app, numRoots, false, false);
+        double simd = MeasureTransforms(app, numRoots, true, false);
+        double scalarParallel = MeasureTransforms(app, numRoots, false, true);
+        double simdParallel = MeasureTransforms(app, numRoots, true, true);
+
+        LOG("  {:10} | {:9.2f} | {:7.2f} | {:18.2f} | {:16.2f}\n", numRoots * 3, scalar, simd, scalarParallel, simdParallel);
+    }
+}
+
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkArguments args(argc, argv);
+
+    GameApplication app(args.GetPack(), "Transform Benchmark");
+
+    RunTransformBenchmark(app);
+
+    return app.ExitCode();
+}
@@ -36,6 +36,7 @@ SOFTWARE.
 #include <Engine/Core/Containers/Hash.h>
 #include <Engine/Math/Transform.h>
 #include <Engine/Geometry/Skinning.h>
+#include <Engine/Geometry/AnimationCompression.h>
 #include <Engine/Geometry/VertexFormat.h>
 #include <Engine/Geometry/BV/BvAxisAlignedBox.h>
 #include <Engine/Geometry/TangentSpace.h>
@@ -2246,7 +2247,7 @@ void AssetImporter::WriteSkeleton2()
 
     m_SkeletonPath = "/Root/" + fileName;
 
-    stream.WriteUInt32(MakeResourceMagic(RESOURCE_SKELETON, 1));
+    stream.WriteUInt32(MakeResourceMagic(RESOURCE_SKELETON, 2));
     stream.WriteArray(m_Joints);
     stream.WriteObject(m_BindposeBounds);
 
@@ -2260,7 +2261,17 @@ void AssetImporter::WriteSkeleton2()
             stream.WriteFloat(animation.FrameDelta);
             stream.WriteUInt32(animation.FrameCount);
             stream.WriteArray(animation.Channels);
-            stream.WriteArray(animation.Transforms);
+            stream.WriteBool(m_Settings.bCompressAnimations);
+            if (m_Settings.bCompressAnimations)
+            {
+                CompressedAnimation compressed;
+                compressed.Compress(animation.FrameCount, animation.Transforms.ToPtr(), animation.Channels.ToPtr(), animation.Channels.Size(), m_Settings.AnimationCompression);
+                compressed.Write(stream);
+
+                LOG("Animation '{}': {} of {} keys, {} -> {} bytes\n", animation.Name, compressed.GetKeyFrameCount(), animation.FrameCount, animation.Transforms.Size() * sizeof(Transform), compressed.GetMemoryUsage());
+            }
+            else
+                stream.WriteArray(animation.Transforms);
             stream.WriteArray(animation.Bounds);
         }
     }
@@ -32,6 +32,7 @@ SOFTWARE.
 
 #include <Engine/Image/Image.h>
 #include <Engine/Math/Quat.h>
+#include <Engine/Geometry/AnimationCompression.h>
 
 HK_NAMESPACE_BEGIN
 
@@ -44,6 +45,7 @@ struct AssetImportSettings
         bImportSkinning   = true;
         bImportSkeleton   = true;
         bImportAnimations = true;
+        bCompressAnimations = true;
         bImportTextures   = true;
         bSingleModel      = true;
         bMergePrimitives  = true;
@@ -71,6 +73,7 @@ struct AssetImportSettings
     bool bImportSkinning;
     bool bImportSkeleton;
     bool bImportAnimations;
+    bool bCompressAnimations;
     bool bImportTextures;
     bool bImportSkybox;
     bool bImportSkyboxExplicit;
@@ -103,6 +106,9 @@ struct AssetImportSettings
 
     SkyboxImportSettings SkyboxImport;
 
+    /** Quantization and keyframe reduction settings. Used if bCompressAnimations is set. */
+    AnimationCompressionSettings AnimationCompression;
+
     bool bHork2Format{};
 };
 
@@ -36,11 +36,17 @@ SOFTWARE.
 #include <Engine/Core/Logger.h>
 #include <Engine/Core/IntrusiveLinkedListMacro.h>
 
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <algorithm>
+
 HK_NAMESPACE_BEGIN
 
 ConsoleVar Snd_MixAhead("Snd_MixAhead"s, "0.1"s);
 ConsoleVar Snd_VolumeRampSize("Snd_VolumeRampSize"s, "16"s);
 ConsoleVar Snd_HRTF("Snd_HRTF"s, "1"s);
+ConsoleVar Snd_BatchHRTF("Snd_BatchHRTF"s, "1"s, 0, "Convolve tracks with the same HRTF filter and a steady volume together"s);
+ConsoleVar Snd_MaxVoices("Snd_MaxVoices"s, "64"s, 0, "Max tracks rendered by the mixer. Less audible tracks are virtualized. Zero means no limit."s);
 
 #if 0
 ConsoleVar Rev_RoomSize( "Rev_RoomSize"s,"0.5"s );
@@ -254,6 +260,56 @@ void AudioMixer::UpdateAsync(uint8_t* transferBuffer, int transferBufferSizeInFr
     RenderTracks(endFrame);
 }
 
+void AudioMixer::UpdateVoices()
+{
+    int maxVoices = Snd_MaxVoices.GetInteger();
+
+    m_Voices.Clear();
+
+    for (AudioTrack* track = m_Tracks; track; track = track->Next)
+    {
+        track->bCulled = false;
+
+        if (maxVoices <= 0)
+            continue;
+
+        int volume;
+        bool bPaused;
+        {
+            SpinLockGuard guard(track->Lock);
+            volume = Math::Max(track->Volume_LOCK[0], track->Volume_LOCK[1]);
+            bPaused = track->bPaused_LOCK;
+        }
+
+        // Silent and paused tracks don't need a voice
+        if (volume <= 0 || bPaused)
+            continue;
+
+        volume = Math::Min(volume, 65535);
+
+        // Give a small advantage to tracks that are already playing to prevent them from toggling every update
+        if (!track->bVirtual)
+            volume += volume >> 3;
+
+        Voice& voice = m_Voices.Add();
+        voice.Track = track;
+        voice.Audibility = ((uint32_t)track->Priority << 24) | (uint32_t)volume;
+    }
+
+    if (m_Voices.Size() <= maxVoices)
+        return;
+
+    std::nth_element(m_Voices.Begin(), m_Voices.Begin() + maxVoices, m_Voices.End(), [](Voice const& a, Voice const& b)
+                     {
+                         return a.Audibility > b.Audibility;
+                     });
+
+    for (int i = maxVoices; i < m_Voices.Size(); i++)
+    {
+        m_Voices[i].Track->bCulled = true;
+    }
+}
+
 void AudioMixer::RenderTracks(int64_t endFrame)
 {
     int numActiveTracks = m_NumActiveTracks.Load();
@@ -265,6 +321,8 @@ void AudioMixer::RenderTracks(int64_t endFrame)
 
     AddPendingTracks();
 
+    UpdateVoices();
+
     while (m_RenderFrame < endFrame)
     {
         int64_t end = endFrame;
@@ -275,6 +333,8 @@ void AudioMixer::RenderTracks(int64_t endFrame)
 
         int frameCount = end - m_RenderFrame;
 
+        m_RenderFrameCount = frameCount;
+
         Core::ZeroMem(m_RenderBuffer, frameCount * sizeof(SamplePair));
 
         AudioTrack* next;
@@ -312,14 +372,18 @@ void AudioMixer::RenderTracks(int64_t endFrame)
                 track->pStream->SeekToFrame(m_PlaybackPos);
             }
 
-            if (m_NewVol[0] == 0 && m_NewVol[1] == 0 && track->Volume[0] == 0 && track->Volume[1] == 0)
+            if (track->bCulled || (m_NewVol[0] == 0 && m_NewVol[1] == 0 && track->Volume[0] == 0 && track->Volume[1] == 0))
             {
                 if (!track->bVirtual)
                 {
                     bool bLooped = track->GetLoopStart() >= 0;
-                    if (track->bVirtualizeWhenSilent || bLooped || m_TrackPaused)
+                    if (track->bCulled || track->bVirtualizeWhenSilent || bLooped || m_TrackPaused)
                     {
                         track->bVirtual = true;
+
+                        // Fade in when the track gets the voice back
+                        track->Volume[0] = 0;
+                        track->Volume[1] = 0;
                     }
                     else
                     {
@@ -372,20 +436,44 @@ void AudioMixer::RenderTracks(int64_t endFrame)
             track->PlaybackPos.Store(m_PlaybackPos);
         }
 
-        WriteToTransferBuffer((int const*)m_RenderBuffer, end);
+        RenderHrtfBatches();
+
+        WriteToTransferBuffer(m_RenderBuffer[0].Chan, end);
         m_RenderFrame = end;
     }
 
     m_NumActiveTracks.Store(numActiveTracks);
 }
 
+// Convert s16 samples to f32 format
+static void ConvertS16ToF32(int16_t const* inSamples, int count, float scale, float* outSamples)
+{
+    const __m128 vscale = _mm_set1_ps(scale);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i s = _mm_loadu_si128((__m128i const*)(inSamples + i));
+
+        // Sign extend to 32 bit
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+
+        _mm_storeu_ps(outSamples + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+        _mm_storeu_ps(outSamples + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+    }
+    for (; i < count; i++)
+    {
+        outSamples[i] = inSamples[i] * scale;
+    }
+}
+
 static void ConvertFramesToMonoF32(const void* inFrames, int frameCount, int sampleBits, int channels, float* outFrames)
 {
     if (sampleBits == 8)
     {
-        // Lookup at max volume
-        int const*  lookup     = SampleLookup8Bit.Data[31];
-        const float intToFloat = 1.0f / 256 / 32767;
+        int16_t const* lookup     = SampleLookup8Bit.ToShort;
+        const float    intToFloat = 1.0f / 32767;
 
         uint8_t const* frames = (uint8_t const*)inFrames;
 
@@ -402,7 +490,7 @@ static void ConvertFramesToMonoF32(const void* inFrames, int frameCount, int sam
         // Combine stereo channels
         for (int i = 0; i < frameCount; i++)
         {
-            outFrames[i] = (lookup[frames[0]] + lookup[frames[1]]) * (intToFloat * 0.5f); // average
+            outFrames[i] = ((int)lookup[frames[0]] + (int)lookup[frames[1]]) * (intToFloat * 0.5f); // average
             frames += 2;
         }
         return;
@@ -417,18 +505,25 @@ static void ConvertFramesToMonoF32(const void* inFrames, int frameCount, int sam
         // Mono
         if (channels == 1)
         {
-            for (int i = 0; i < frameCount; i++)
-            {
-                outFrames[i] = frames[i] * intToFloat;
-            }
+            ConvertS16ToF32(frames, frameCount, intToFloat, outFrames);
             return;
         }
 
         // Combine stereo channels
-        for (int i = 0; i < frameCount; i++)
+        const __m128i one    = _mm_set1_epi16(1);
+        const __m128  vscale = _mm_set1_ps(intToFloat * 0.5f);
+
+        int i = 0;
+        for (; i + 4 <= frameCount; i += 4)
         {
-            outFrames[i] = ((int)frames[0] + (int)frames[1]) * (intToFloat * 0.5f); // average
-            frames += 2;
+            // Sum of left and right channels for four frames
+            __m128i sum = _mm_madd_epi16(_mm_loadu_si128((__m128i const*)(frames + i * 2)), one);
+
+            _mm_storeu_ps(outFrames + i, _mm_mul_ps(_mm_cvtepi32_ps(sum), vscale));
+        }
+        for (; i < frameCount; i++)
+        {
+            outFrames[i] = ((int)frames[i * 2] + (int)frames[i * 2 + 1]) * (intToFloat * 0.5f); // average
         }
         return;
     }
@@ -445,18 +540,119 @@ static void ConvertFramesToMonoF32(const void* inFrames, int frameCount, int sam
         }
 
         // Combine stereo channels
-        for (int i = 0; i < frameCount; i++)
+        const __m128 half = _mm_set1_ps(0.5f);
+
+        int i = 0;
+        for (; i + 4 <= frameCount; i += 4)
         {
-            outFrames[i] = (frames[0] + frames[1]) * 0.5f; // average
-            frames += 2;
+            __m128 a = _mm_loadu_ps(frames + i * 2);
+            __m128 b = _mm_loadu_ps(frames + i * 2 + 4);
+
+            __m128 left  = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+            _mm_storeu_ps(outFrames + i, _mm_mul_ps(_mm_add_ps(left, right), half)); // average
+        }
+        for (; i < frameCount; i++)
+        {
+            outFrames[i] = (frames[i * 2] + frames[i * 2 + 1]) * 0.5f; // average
+        }
+        return;
+    }
+
+    // Should never happen, but just in case...
+    HK_ASSERT(0);
+}
+
+// Convert stereo frames to f32 format. Channels are kept interleaved.
+static void ConvertFramesToStereoF32(const void* inFrames, int frameCount, int sampleBits, float* outFrames)
+{
+    int sampleCount = frameCount * 2;
+
+    if (sampleBits == 8)
+    {
+        int16_t const* lookup     = SampleLookup8Bit.ToShort;
+        const float    intToFloat = 1.0f / 32767;
+
+        uint8_t const* samples = (uint8_t const*)inFrames;
+
+        for (int i = 0; i < sampleCount; i++)
+        {
+            outFrames[i] = lookup[samples[i]] * intToFloat;
         }
         return;
     }
 
+    if (sampleBits == 16)
+    {
+        ConvertS16ToF32((int16_t const*)inFrames, sampleCount, 1.0f / 32767, outFrames);
+        return;
+    }
+
+    if (sampleBits == 32)
+    {
+        Core::Memcpy(outFrames, inFrames, sampleCount * sizeof(float));
+        return;
+    }
+
     // Should never happen, but just in case...
     HK_ASSERT(0);
 }
 
+// Mix mono frames to the stereo output
+static void MixMonoF32(float const* inFrames, int frameCount, float const* volumeRampL, float const* volumeRampR, int volumeRampSize, float lvol, float rvol, float* outSamples)
+{
+    int i = 0;
+    for (; i < volumeRampSize; i++)
+    {
+        outSamples[i * 2] += inFrames[i] * volumeRampL[i];
+        outSamples[i * 2 + 1] += inFrames[i] * volumeRampR[i];
+    }
+
+    const __m128 vol = _mm_setr_ps(lvol, rvol, lvol, rvol);
+
+    for (; i + 4 <= frameCount; i += 4)
+    {
+        __m128 s = _mm_loadu_ps(inFrames + i);
+
+        float* out = outSamples + i * 2;
+
+        // Duplicate mono samples for both channels
+        _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(_mm_unpacklo_ps(s, s), vol)));
+        _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(_mm_unpackhi_ps(s, s), vol)));
+    }
+    for (; i < frameCount; i++)
+    {
+        outSamples[i * 2] += inFrames[i] * lvol;
+        outSamples[i * 2 + 1] += inFrames[i] * rvol;
+    }
+}
+
+// Mix stereo frames to the stereo output
+static void MixStereoF32(float const* inFrames, int frameCount, float const* volumeRampL, float const* volumeRampR, int volumeRampSize, float lvol, float rvol, float* outSamples)
+{
+    int i = 0;
+    for (; i < volumeRampSize; i++)
+    {
+        outSamples[i * 2] += inFrames[i * 2] * volumeRampL[i];
+        outSamples[i * 2 + 1] += inFrames[i * 2 + 1] * volumeRampR[i];
+    }
+
+    const __m128 vol = _mm_setr_ps(lvol, rvol, lvol, rvol);
+
+    for (; i + 2 <= frameCount; i += 2)
+    {
+        float* out = outSamples + i * 2;
+
+        _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(_mm_loadu_ps(inFrames + i * 2), vol)));
+    }
+    for (; i < frameCount; i++)
+    {
+        outSamples[i * 2] += inFrames[i * 2] * lvol;
+        outSamples[i * 2 + 1] += inFrames[i * 2 + 1] * rvol;
+    }
+}
+
 // Read frames from current playback position and convert to f32 format.
 void AudioMixer::ReadFramesF32(AudioTrack* track, int framesToRead, int historyExtraFrames, float* inFrames)
 {
@@ -676,7 +872,7 @@ void AudioMixer::RenderStream(AudioTrack* track, int64_t endFrame)
     }
 }
 
-void AudioMixer::MakeVolumeRamp(const int curVol[2], const int newVol[2], int frameCount, int scale)
+void AudioMixer::MakeVolumeRamp(const int curVol[2], const int newVol[2], int frameCount, float scale)
 {
     if (curVol[0] == newVol[0] && curVol[1] == newVol[1])
     {
@@ -691,11 +887,11 @@ void AudioMixer::MakeVolumeRamp(const int curVol[2], const int newVol[2], int fr
         return;
     }
 
-    float increment0 = (float)(newVol[0] - curVol[0]) / (m_VolumeRampSize * scale);
-    float increment1 = (float)(newVol[1] - curVol[1]) / (m_VolumeRampSize * scale);
+    float increment0 = (float)(newVol[0] - curVol[0]) * scale / m_VolumeRampSize;
+    float increment1 = (float)(newVol[1] - curVol[1]) * scale / m_VolumeRampSize;
 
-    float lvolf = (float)curVol[0] / scale;
-    float rvolf = (float)curVol[1] / scale;
+    float lvolf = (float)curVol[0] * scale;
+    float rvolf = (float)curVol[1] * scale;
 
     for (int i = 0; i < m_VolumeRampSize; i++)
     {
@@ -709,6 +905,9 @@ void AudioMixer::MakeVolumeRamp(const int curVol[2], const int newVol[2], int fr
 
 void AudioMixer::RenderFramesHRTF(AudioTrack* track, int frameCount, SamplePair* buffer)
 {
+    if (AddToHrtfBatch(track, frameCount, buffer))
+        return;
+
     int total = frameCount;
 
     // align length to block size
@@ -719,7 +918,7 @@ void AudioMixer::RenderFramesHRTF(AudioTrack* track, int frameCount, SamplePair*
         total         = numblocks * blocksize;
     }
 
-    int historyExtraFrames = m_Hrtf->GetFrameCount() - 1;
+    int historyExtraFrames = m_Hrtf->GetHistoryLength();
 
     // Read frames from current playback position and convert to f32 format
     m_FramesF32.ResizeInvalidate((total + historyExtraFrames) * sizeof(float));
@@ -757,17 +956,17 @@ void AudioMixer::RenderFramesHRTF(AudioTrack* track, int frameCount, SamplePair*
     // Adjust volume
     float vol = float( 65536 / 256 ) * m_NewVol[0] / m_Hrtf->GetFilterSize();
     for ( int i = 0; i < m_VolumeRampSize; i++ ) {
-        pStreamF32[i].Chanf[0] = pStreamF32[i].Chanf[0] * m_VolumeRampL[i];
-        pStreamF32[i].Chanf[1] = pStreamF32[i].Chanf[1] * m_VolumeRampL[i];
+        pStreamF32[i].Chan[0] = pStreamF32[i].Chan[0] * m_VolumeRampL[i];
+        pStreamF32[i].Chan[1] = pStreamF32[i].Chan[1] * m_VolumeRampL[i];
     }
     for ( int i = m_VolumeRampSize ; i < frameCount; i++ ) {
-        pStreamF32[i].Chanf[0] = pStreamF32[i].Chanf[0] * vol;
-        pStreamF32[i].Chanf[1] = pStreamF32[i].Chanf[1] * vol;
+        pStreamF32[i].Chan[0] = pStreamF32[i].Chan[0] * vol;
+        pStreamF32[i].Chan[1] = pStreamF32[i].Chan[1] * vol;
     }
 
     float * out = (float *)malloc( frameCount * 2 * sizeof( float ) );
 
-    ReverbFilter->ProcessReplace( &pStreamF32[0].Chanf[0], &pStreamF32[0].Chanf[1], &out[0], &out[1], frameCount, 2 );
+    ReverbFilter->ProcessReplace( &pStreamF32[0].Chan[0], &pStreamF32[0].Chan[1], &out[0], &out[1], frameCount, 2 );
 
     // Mix with output stream
     for ( int i = 0 ; i < frameCount; i++ ) {
@@ -779,406 +978,241 @@ void AudioMixer::RenderFramesHRTF(AudioTrack* track, int frameCount, SamplePair*
 #else
     // Mix with output stream
     float vol = float(65536 / 256) * m_NewVol[0] / m_Hrtf->GetFilterSize();
-    for (int i = 0; i < m_VolumeRampSize; i++)
-    {
-        buffer[i].Chan[0] += pStreamF32[i].Chanf[0] * m_VolumeRampL[i];
-        buffer[i].Chan[1] += pStreamF32[i].Chanf[1] * m_VolumeRampL[i];
-    }
-    for (int i = m_VolumeRampSize; i < frameCount; i++)
-    {
-        buffer[i].Chan[0] += pStreamF32[i].Chanf[0] * vol;
-        buffer[i].Chan[1] += pStreamF32[i].Chanf[1] * vol;
-    }
+    MixStereoF32(pStreamF32->Chan, frameCount, m_VolumeRampL, m_VolumeRampL, m_VolumeRampSize, vol, vol, buffer->Chan);
 #endif
 }
 
-void AudioMixer::RenderFrames(AudioTrack* track, const void* inFrames, int frameCount, SamplePair* buffer)
+bool AudioMixer::AddToHrtfBatch(AudioTrack* track, int frameCount, SamplePair* buffer)
 {
-    int sampleBits = track->SampleBits;
-    int channels = track->Channels;
-
-    // Render 8bit audio
-    if (sampleBits == 8)
-    {
-        uint8_t const* frames = (uint8_t const*)inFrames;
+    // Only tracks covering the whole render chunk at a steady volume and filter can share the convolution.
+    // Ramping tracks and tracks that loop or end inside the chunk are rendered one by one.
+    if (!Snd_BatchHRTF || buffer != m_RenderBuffer || frameCount != m_RenderFrameCount)
+        return false;
 
-#if 0
-        int lvol = Math::Min( m_NewVol[0] / 256, 255 );
-        int rvol = Math::Min( m_NewVol[1] / 256, 255 );
-
-        int const * ls = SampleLookup8Bit.Data[lvol >> 3];
-        int const * rs = SampleLookup8Bit.Data[rvol >> 3];
+    if (track->Volume[0] != m_NewVol[0] || track->Volume[1] != m_NewVol[1])
+        return false;
 
-        // Mono
-        if ( channels == 1 ) {
-            MakeVolumeRamp( track->Volume, m_NewVol, frameCount, 256 );
+    if (!m_Hrtf->IsFilterSteady(track->LocalDir, m_NewDir))
+        return false;
 
-            for ( int i = 0; i < m_VolumeRampSize; i++ ) {
-                buffer[i].Chan[0] += ls[frames[i]]*m_VolumeRampL[i];
-                buffer[i].Chan[1] += rs[frames[i]]*m_VolumeRampR[i];
-            }
+    uint32_t filterKey = m_Hrtf->GetFilterKey(m_NewDir);
 
-            for ( int i = m_VolumeRampSize ; i < frameCount; i++ ) {
-                buffer[i].Chan[0] += ls[frames[i]];
-                buffer[i].Chan[1] += rs[frames[i]];
-            }
-            return;
-        }
-#else
-        int lvol = m_NewVol[0];
-        int rvol = m_NewVol[1];
+    int total = (int)Align(frameCount, HRTF_BLOCK_LENGTH);
+    int historyExtraFrames = m_Hrtf->GetHistoryLength();
+    int batchFrames = total + historyExtraFrames;
 
-        // Mono
-        if (channels == 1)
+    HrtfBatch* batch = nullptr;
+    for (int i = 0; i < m_NumHrtfBatches; i++)
+    {
+        if (m_HrtfBatches[i].FilterKey == filterKey)
         {
-            lvol /= 256;
-            rvol /= 256;
-
-            MakeVolumeRamp(track->Volume, m_NewVol, frameCount, 256);
-
-            for (int i = 0; i < m_VolumeRampSize; i++)
-            {
-                buffer[i].Chan[0] += SampleLookup8Bit.ToShort[frames[i]] * m_VolumeRampL[i];
-                buffer[i].Chan[1] += SampleLookup8Bit.ToShort[frames[i]] * m_VolumeRampR[i];
-            }
-
-            for (int i = m_VolumeRampSize; i < frameCount; i++)
-            {
-                buffer[i].Chan[0] += SampleLookup8Bit.ToShort[frames[i]] * lvol;
-                buffer[i].Chan[1] += SampleLookup8Bit.ToShort[frames[i]] * rvol;
-            }
-            return;
+            batch = &m_HrtfBatches[i];
+            break;
         }
-#endif
-
-        // Spatialized stereo
-        if (m_SpatializedTrack)
-        {
-            // Combine stereo channels
-
-#if 0
-
-            MakeVolumeRamp( track->Volume, m_NewVol, frameCount, 512 );
-
-            for ( int i = 0; i < m_VolumeRampSize; i++ ) {
-                buffer[i].Chan[0] += ( ls[frames[0]] + ls[frames[1]] ) * m_VolumeRampL[i];
-                buffer[i].Chan[1] += ( rs[frames[0]] + rs[frames[1]] ) * m_VolumeRampR[i];
-
-                frames += 2;
-            }
-
-            for ( int i = m_VolumeRampSize ; i < frameCount; i++ ) {
-                buffer[i].Chan[0] += ( ls[frames[0]] + ls[frames[1]] ) / 2;
-                buffer[i].Chan[1] += ( rs[frames[0]] + rs[frames[1]] ) / 2;
+    }
 
-                frames += 2;
-            }
+    if (!batch)
+    {
+        if (m_NumHrtfBatches == m_HrtfBatches.Size())
+            m_HrtfBatches.Add();
+
+        batch = &m_HrtfBatches[m_NumHrtfBatches++];
+        batch->FilterKey = filterKey;
+        batch->Dir = m_NewDir;
+        batch->Frames.ResizeInvalidate(batchFrames);
+        Core::ZeroMem(batch->Frames.ToPtr(), batchFrames * sizeof(float));
+    }
 
-#else
+    m_FramesF32.ResizeInvalidate(batchFrames);
+    ReadFramesF32(track, total, historyExtraFrames, m_FramesF32.ToPtr());
 
-            lvol /= 512;
-            rvol /= 512;
+    // Convolution is linear: the filtered sum of the scaled inputs is the sum of the filtered tracks.
+    // Scaling in time domain is the same as scaling the input spectra, and it also shares the forward transforms.
+    float vol = float(65536 / 256) * m_NewVol[0] / m_Hrtf->GetFilterSize();
 
-            MakeVolumeRamp(track->Volume, m_NewVol, frameCount, 512);
+    float const* frames = m_FramesF32.ToPtr();
+    float* sum = batch->Frames.ToPtr();
+    for (int i = 0; i < batchFrames; i++)
+        sum[i] += frames[i] * vol;
 
-            for (int i = 0; i < m_VolumeRampSize; i++)
-            {
-                buffer[i].Chan[0] += (SampleLookup8Bit.ToShort[frames[0]] + SampleLookup8Bit.ToShort[frames[1]]) * m_VolumeRampL[i];
-                buffer[i].Chan[1] += (SampleLookup8Bit.ToShort[frames[0]] + SampleLookup8Bit.ToShort[frames[1]]) * m_VolumeRampR[i];
+    track->LocalDir = m_NewDir;
+    return true;
+}
 
-                frames += 2;
-            }
+void AudioMixer::RenderHrtfBatches()
+{
+    if (!m_NumHrtfBatches)
+        return;
 
-            for (int i = m_VolumeRampSize; i < frameCount; i++)
-            {
-                buffer[i].Chan[0] += (SampleLookup8Bit.ToShort[frames[0]] + SampleLookup8Bit.ToShort[frames[1]]) * lvol;
-                buffer[i].Chan[1] += (SampleLookup8Bit.ToShort[frames[0]] + SampleLookup8Bit.ToShort[frames[1]]) * rvol;
+    int total = (int)Align(m_RenderFrameCount, HRTF_BLOCK_LENGTH);
 
-                frames += 2;
-            }
-#endif
+    m_StreamF32.ResizeInvalidate(total);
 
-            return;
-        }
+    for (int i = 0; i < m_NumHrtfBatches; i++)
+    {
+        HrtfBatch const& batch = m_HrtfBatches[i];
 
-        // Background music/etc
-#if 0
-        MakeVolumeRamp( track->Volume, m_NewVol, frameCount, 256 );
-        for ( int i = 0; i < m_VolumeRampSize; i++ ) {
-            buffer[i].Chan[0] += ls[frames[0]] * m_VolumeRampL[i];
-            buffer[i].Chan[1] += rs[frames[1]] * m_VolumeRampR[i];
+        Float3 dir;
+        m_Hrtf->ApplyHRTF(batch.Dir, batch.Dir, batch.Frames.ToPtr(), total, (float*)m_StreamF32.ToPtr(), dir);
 
-            frames += 2;
-        }
-        for ( int i = m_VolumeRampSize ; i < frameCount; i++ ) {
-            buffer[i].Chan[0] += ls[frames[0]];
-            buffer[i].Chan[1] += rs[frames[1]];
+        MixStereoF32(m_StreamF32.ToPtr()->Chan, m_RenderFrameCount, nullptr, nullptr, 0, 1.0f, 1.0f, m_RenderBuffer[0].Chan);
+    }
 
-            frames += 2;
-        }
-#else
-        lvol /= 256;
-        rvol /= 256;
+    m_NumHrtfBatches = 0;
+}
 
-        MakeVolumeRamp(track->Volume, m_NewVol, frameCount, 256);
-        for (int i = 0; i < m_VolumeRampSize; i++)
-        {
-            buffer[i].Chan[0] += SampleLookup8Bit.ToShort[frames[0]] * m_VolumeRampL[i];
-            buffer[i].Chan[1] += SampleLookup8Bit.ToShort[frames[1]] * m_VolumeRampR[i];
+void AudioMixer::RenderFrames(AudioTrack* track, const void* inFrames, int frameCount, SamplePair* buffer)
+{
+    int sampleBits = track->SampleBits;
+    int channels = track->Channels;
 
-            frames += 2;
-        }
-        for (int i = m_VolumeRampSize; i < frameCount; i++)
-        {
-            buffer[i].Chan[0] += SampleLookup8Bit.ToShort[frames[0]] * lvol;
-            buffer[i].Chan[1] += SampleLookup8Bit.ToShort[frames[1]] * rvol;
+    // Spatialized stereo is combined to mono, background music/etc is mixed as is
+    bool bMono = channels == 1 || m_SpatializedTrack;
 
-            frames += 2;
-        }
-#endif
-        return;
+    float const* frames;
+    if (sampleBits == 32 && (channels == 1 || !bMono))
+    {
+        // Already in f32 format
+        frames = (float const*)inFrames;
     }
-
-    // Render 16bit audio
-    if (sampleBits == 16)
+    else
     {
-        int lvol = m_NewVol[0];
-        int rvol = m_NewVol[1];
-
-        int16_t const* frames = (int16_t const*)inFrames;
-
-        // Mono
-        if (channels == 1)
-        {
-            lvol /= 256;
-            rvol /= 256;
-
-            MakeVolumeRamp(track->Volume, m_NewVol, frameCount, 256);
-
-            for (int i = 0; i < m_VolumeRampSize; i++)
-            {
-                buffer[i].Chan[0] += frames[i] * m_VolumeRampL[i];
-                buffer[i].Chan[1] += frames[i] * m_VolumeRampR[i];
-            }
+        m_MixF32.ResizeInvalidate(bMono ? frameCount : frameCount * 2);
 
-            for (int i = m_VolumeRampSize; i < frameCount; i++)
-            {
-                buffer[i].Chan[0] += frames[i] * lvol;
-                buffer[i].Chan[1] += frames[i] * rvol;
-            }
-            return;
-        }
-
-        // Spatialized stereo
-        if (m_SpatializedTrack)
-        {
-            // Combine stereo channels
-
-            // Downscale the volume twice
-            lvol /= 512;
-            rvol /= 512;
-
-            MakeVolumeRamp(track->Volume, m_NewVol, frameCount, 512);
-
-            for (int i = 0; i < m_VolumeRampSize; i++)
-            {
-                buffer[i].Chan[0] += ((int)frames[0] + (int)frames[1]) * m_VolumeRampL[i];
-                buffer[i].Chan[1] += ((int)frames[0] + (int)frames[1]) * m_VolumeRampR[i];
-
-                frames += 2;
-            }
-
-            for (int i = m_VolumeRampSize; i < frameCount; i++)
-            {
-                buffer[i].Chan[0] += ((int)frames[0] + (int)frames[1]) * lvol;
-                buffer[i].Chan[1] += ((int)frames[0] + (int)frames[1]) * rvol;
+        if (bMono)
+            ConvertFramesToMonoF32(inFrames, frameCount, sampleBits, channels, m_MixF32.ToPtr());
+        else
+            ConvertFramesToStereoF32(inFrames, frameCount, sampleBits, m_MixF32.ToPtr());
 
-                frames += 2;
-            }
+        frames = m_MixF32.ToPtr();
+    }
 
-            return;
-        }
+    // Frames are normalized to [-1,1], the render buffer keeps samples in 16.8 fixed point scale
+    const float volumeScale = 32767.0f / 256;
 
-        // Background music/etc
-        lvol /= 256;
-        rvol /= 256;
-        MakeVolumeRamp(track->Volume, m_NewVol, frameCount, 256);
-        for (int i = 0; i < m_VolumeRampSize; i++)
-        {
-            buffer[i].Chan[0] += frames[0] * m_VolumeRampL[i];
-            buffer[i].Chan[1] += frames[1] * m_VolumeRampR[i];
+    MakeVolumeRamp(track->Volume, m_NewVol, frameCount, volumeScale);
 
-            frames += 2;
-        }
-        for (int i = m_VolumeRampSize; i < frameCount; i++)
-        {
-            buffer[i].Chan[0] += frames[0] * lvol;
-            buffer[i].Chan[1] += frames[1] * rvol;
+    float lvol = m_NewVol[0] * volumeScale;
+    float rvol = m_NewVol[1] * volumeScale;
 
-            frames += 2;
-        }
-        return;
-    }
+    if (bMono)
+        MixMonoF32(frames, frameCount, m_VolumeRampL, m_VolumeRampR, m_VolumeRampSize, lvol, rvol, buffer->Chan);
+    else
+        MixStereoF32(frames, frameCount, m_VolumeRampL, m_VolumeRampR, m_VolumeRampSize, lvol, rvol, buffer->Chan);
+}
 
-    // TODO: Add code pass for 32F ?
+// Render buffer keeps samples in 16.8 fixed point scale
+static HK_FORCEINLINE float ClampSample(float v, float minVal, float maxVal)
+{
+    return _mm_cvtss_f32(_mm_min_ss(_mm_max_ss(_mm_set_ss(v), _mm_set_ss(minVal)), _mm_set_ss(maxVal)));
 }
 
-static void WriteSamplesS8(int const* in, int8_t* out, int count)
+static void WriteSamplesS8(float const* in, int8_t* out, int count)
 {
-    int v;
+    const float scale = 1.0f / 256 / 256;
 
-    for (int i = 0; i < count; i += 2)
+    for (int i = 0; i < count; i++)
     {
-        v = in[i] / 256;
-        if (v > 32767)
-            v = 32767;
-        else if (v < -32768)
-            v = -32768;
-
-        out[i] = v / 256;
-
-        v = in[i + 1] / 256;
-        if (v > 32767)
-            v = 32767;
-        else if (v < -32768)
-            v = -32768;
-
-        out[i + 1] = v / 256;
+        out[i] = (int)ClampSample(in[i] * scale, -128, 127);
     }
 }
 
-static void WriteSamplesS8_Mono(int const* in, int8_t* out, int count)
+static void WriteSamplesS8_Mono(float const* in, int8_t* out, int count)
 {
-    int v;
+    const float scale = 1.0f / 256 / 256;
 
     while (count--)
     {
-        v = *in / 256;
-        if (v > 32767)
-            v = 32767;
-        else if (v < -32768)
-            v = -32768;
-        *out++ = v / 256;
+        *out++ = (int)ClampSample(*in * scale, -128, 127);
         in += 2;
     }
 }
 
-static void WriteSamplesU8(int const* in, uint8_t* out, int count)
+static void WriteSamplesU8(float const* in, uint8_t* out, int count)
 {
-    int v;
+    const float scale = 1.0f / 256 / 256;
 
-    for (int i = 0; i < count; i += 2)
+    for (int i = 0; i < count; i++)
     {
-        v = in[i] / 256;
-        if (v > 32767)
-            v = 32767;
-        else if (v < -32768)
-            v = -32768;
-
-        out[i] = (v / 256) + 128;
-
-        v = in[i + 1] / 256;
-        if (v > 32767)
-            v = 32767;
-        else if (v < -32768)
-            v = -32768;
-
-        out[i + 1] = (v / 256) + 128;
+        out[i] = (int)ClampSample(in[i] * scale, -128, 127) + 128;
     }
 }
 
-static void WriteSamplesU8_Mono(int const* in, uint8_t* out, int count)
+static void WriteSamplesU8_Mono(float const* in, uint8_t* out, int count)
 {
-    int v;
+    const float scale = 1.0f / 256 / 256;
 
     while (count--)
     {
-        v = *in / 256;
-        if (v > 32767)
-            v = 32767;
-        else if (v < -32768)
-            v = -32768;
-        *out++ = (v / 256) + 128;
+        *out++ = (int)ClampSample(*in * scale, -128, 127) + 128;
         in += 2;
     }
 }
 
-static void WriteSamples16(int const* in, short* out, int count)
+static void WriteSamples16(float const* in, short* out, int count)
 {
-    int v;
+    const float scale = 1.0f / 256;
 
-    for (int i = 0; i < count; i += 2)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 minVal = _mm_set1_ps(-32768.0f);
+    const __m128 maxVal = _mm_set1_ps(32767.0f);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
     {
-        v = in[i] / 256;
-        if (v > 32767)
-            out[i] = 32767;
-        else if (v < -32768)
-            out[i] = -32768;
-        else
-            out[i] = v;
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), vscale), minVal), maxVal);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), vscale), minVal), maxVal);
 
-        v = in[i + 1] / 256;
-        if (v > 32767)
-            out[i + 1] = 32767;
-        else if (v < -32768)
-            out[i + 1] = -32768;
-        else
-            out[i + 1] = v;
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+    }
+    for (; i < count; i++)
+    {
+        out[i] = (int)ClampSample(in[i] * scale, -32768, 32767);
     }
 }
 
-static void WriteSamples16_Mono(int const* in, short* out, int count)
+static void WriteSamples16_Mono(float const* in, short* out, int count)
 {
-    int v;
+    const float scale = 1.0f / 256;
 
     while (count--)
     {
-        v = *in / 256;
-        if (v > 32767)
-            v = 32767;
-        else if (v < -32768)
-            v = -32768;
-        *out++ = v;
+        *out++ = (int)ClampSample(*in * scale, -32768, 32767);
         in += 2;
     }
 }
 
-static void WriteSamples32(int const* in, float* out, int count)
+static void WriteSamples32(float const* in, float* out, int count)
 {
     const float scale = 1.0f / 256 / 32767;
 
-    __m128 minVal = _mm_set_ss(-1.0f);
-    __m128 maxVal = _mm_set_ss(1.0f);
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 minVal = _mm_set1_ps(-1.0f);
+    const __m128 maxVal = _mm_set1_ps(1.0f);
 
-    for (int i = 0; i < count; i += 2)
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
     {
-        float val1 = static_cast<float>(in[i]) * scale;
-        float val2 = static_cast<float>(in[i + 1]) * scale;
-
-        _mm_store_ss(&out[i], _mm_min_ss(_mm_max_ss(_mm_set_ss(val1), minVal), maxVal));
-        _mm_store_ss(&out[i + 1], _mm_min_ss(_mm_max_ss(_mm_set_ss(val2), minVal), maxVal));
+        _mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), vscale), minVal), maxVal));
+    }
+    for (; i < count; i++)
+    {
+        out[i] = ClampSample(in[i] * scale, -1.0f, 1.0f);
     }
 }
 
-static void WriteSamples32_Mono(int const* in, float* out, int count)
+static void WriteSamples32_Mono(float const* in, float* out, int count)
 {
     const float scale = 1.0f / 256 / 32767;
 
-    __m128 minVal = _mm_set_ss(-1.0f);
-    __m128 maxVal = _mm_set_ss(1.0f);
-
     while (count--)
     {
-        float val = static_cast<float>(*in) * scale;
-
-        _mm_store_ss(out, _mm_min_ss(_mm_max_ss(_mm_set_ss(val), minVal), maxVal));
-
-        out++;
+        *out++ = ClampSample(*in * scale, -1.0f, 1.0f);
         in += 2;
     }
 }
 
-void AudioMixer::WriteToTransferBuffer(int const* samples, int64_t endFrame)
+void AudioMixer::WriteToTransferBuffer(float const* samples, int64_t endFrame)
 {
     int64_t wrapMask = m_DeviceRawPtr->GetTransferBufferSizeInFrames() - 1;
 
@@ -104,11 +104,21 @@ public:
 private:
     struct SamplePair
     {
-        union
-        {
-            int32_t Chan[2];
-            float   Chanf[2];
-        };
+        float               Chan[2];
+    };
+
+    struct Voice
+    {
+        AudioTrack*         Track;
+        uint32_t            Audibility;
+    };
+
+    // Sum of volume-scaled inputs of the tracks that use the same HRTF filter
+    struct HrtfBatch
+    {
+        uint32_t            FilterKey;
+        Float3              Dir;
+        Vector<float>       Frames;
     };
 
     void                UpdateAsync(uint8_t* transferBuffer, int transferBufferSizeInFrames, int frameNum, int minFramesToRender);
@@ -116,13 +126,16 @@ private:
     // This fuction adds pending tracks to list
     void                AddPendingTracks();
     void                RejectTrack(AudioTrack* track);
+    void                UpdateVoices();
     void                RenderTracks(int64_t endFrame);
     void                RenderTrack(AudioTrack* track, int64_t endFrame);
     void                RenderStream(AudioTrack* track, int64_t endFrame);
     void                RenderFramesHRTF(AudioTrack* track, int frameCount, SamplePair* buffer);
+    bool                AddToHrtfBatch(AudioTrack* track, int frameCount, SamplePair* buffer);
+    void                RenderHrtfBatches();
     void                RenderFrames(AudioTrack* track, const void* frames, int frameCount, SamplePair* buffer);
-    void                WriteToTransferBuffer(int const* samples, int64_t endFrame);
-    void                MakeVolumeRamp(const int curVol[2], const int newVol[2], int frameCount, int scale);
+    void                WriteToTransferBuffer(float const* samples, int64_t endFrame);
+    void                MakeVolumeRamp(const int curVol[2], const int newVol[2], int frameCount, float scale);
     void                ReadFramesF32(AudioTrack* track, int framesToRead, int historyExtraFrames, float* frames);
 
     UniqueRef<class AudioHRTF> m_Hrtf;
@@ -136,6 +149,7 @@ private:
     uint8_t*                m_TransferBuffer;
     bool                    m_IsAsync;
     int64_t                 m_RenderFrame;
+    int                     m_RenderFrameCount = 0;
     AtomicInt               m_NumActiveTracks;
     AtomicInt               m_TotalTracks;
 
@@ -152,13 +166,21 @@ private:
     bool                    m_SpatializedTrack;
     bool                    m_TrackPaused;
     int                     m_PlaybackPos;
-    int                     m_VolumeRampL[1024];
-    int                     m_VolumeRampR[1024];
+    alignas(16) float       m_VolumeRampL[1024];
+    alignas(16) float       m_VolumeRampR[1024];
     int                     m_VolumeRampSize;
 
     Vector<uint8_t>         m_TempFrames;
     Vector<float>           m_FramesF32;
     Vector<SamplePair>      m_StreamF32;
+    Vector<float>           m_MixF32;
+
+    // Tracks competing for the voices
+    Vector<Voice>           m_Voices;
+
+    // HRTF batches of the current render chunk
+    Vector<HrtfBatch>       m_HrtfBatches;
+    int                     m_NumHrtfBatches = 0;
 };
 
 extern ConsoleVar Snd_HRTF;
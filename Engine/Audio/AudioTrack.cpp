@@ -57,8 +57,10 @@ AudioTrack::AudioTrack(AudioSource* inSource, int inStartFrame, int inLoopStart,
     Volume_LOCK[1] = 0;
     bVirtualizeWhenSilent = inVirtualizeWhenSilent;
     bVirtual = false;
+    bCulled = false;
     bPaused_LOCK = false;
     bSpatializedStereo_LOCK = false;
+    Priority = 0;
     Next = nullptr;
     Prev = nullptr;
 }
@@ -88,16 +88,23 @@ struct AudioTrack final : public Noncopyable
     /// Should mixer virtualize the channel or stop playing. Read only
     bool bVirtualizeWhenSilent : 1;
 
-    /// Track is playing, but mixer skip the samples from this track.
-    /// Only used by mixer thread (RW).
-    bool bVirtual : 1;
-
     /// Track is paused
     bool bPaused_LOCK : 1;
 
     /// If track is has stereo samples, it will be combined to mono and spatialized for 3D
     bool bSpatializedStereo_LOCK : 1;
 
+    // The flags below are written by the mixer thread without the lock, so they must not share
+    // a memory location with the bit fields above.
+
+    /// Track is playing, but mixer skip the samples from this track.
+    /// Only used by mixer thread (RW).
+    bool bVirtual;
+
+    /// Track lost its voice to more audible tracks and is virtualized by the mixer.
+    /// Only used by mixer thread (RW).
+    bool bCulled;
+
     /// The stop signal. It's setted by mixer thread. If it's true, main thread should reject to use this track and remove it.
     AtomicBool Stopped;
 
@@ -123,6 +130,9 @@ struct AudioTrack final : public Noncopyable
     /// Stride between frames in bytes. Read only.
     int SampleStride;
 
+    /// Voice priority. See AudioChannelPriority. Read only.
+    uint8_t Priority;
+
     /// Audio data. Just a wrapper to simplify access to audio buffer.
     /// For encoded audio returns nullptr.
     HK_FORCEINLINE const void* GetFrames() const
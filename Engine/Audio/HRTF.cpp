@@ -43,10 +43,20 @@ SOFTWARE.
 
 HK_NAMESPACE_BEGIN
 
-#define FILTER_SIZE_POW2
-
 ConsoleVar Snd_LerpHRTF("Snd_LerpHRTF"s, "1"s);
 
+namespace
+{
+
+// Regular direction grid with 15 degree steps (matches the measurements)
+constexpr int GRID_AZIMUTH_STEPS = 24;
+constexpr int GRID_ELEVATION_STEPS = 13; // From -90 to 90 degrees inclusive
+
+// Directions are quantized to 1/8 of grid cell to share cached filters between sources with similar directions
+constexpr int GRID_SUBDIVISION = 8;
+
+}
+
 AudioHRTF::AudioHRTF(int SampleRate)
 {
     File f = File::OpenRead("HRTF/IRC_1002_C.bin", GameApplication::GetEmbeddedArchive());
@@ -107,33 +117,22 @@ AudioHRTF::AudioHRTF(int SampleRate)
 
     m_Vertices.Resize(vertexCount);
 
+    // HRIRs in time domain, [vertex][ear][frame]
+    Vector<float> hrirs;
+
     if (sampleRateHRIR == SampleRate)
     {
         // There is no need for resampling, so we just read it as is
 
-        Vector<float> framesIn;
-        framesIn.Resize(m_FrameCount);
-
-        m_FilterSize = m_FrameCount - 1 + HRTF_BLOCK_LENGTH; // M - 1 + L
-#ifdef FILTER_SIZE_POW2
-        m_FilterSize = Math::ToGreaterPowerOfTwo(m_FilterSize);
-#endif
-        m_ForwardFFT = mufft_create_plan_1d_c2c(m_FilterSize, MUFFT_FORWARD, 0);
-        m_InverseFFT = mufft_create_plan_1d_c2c(m_FilterSize, MUFFT_INVERSE, 0);
-
-        m_hrtfL.Resize(vertexCount * m_FilterSize);
-        m_hrtfR.Resize(vertexCount * m_FilterSize);
+        hrirs.Resize(vertexCount * 2 * m_FrameCount);
 
         for (auto i = 0; i < vertexCount; i++)
         {
             f.ReadObject(m_Vertices[i]);
             m_Vertices[i].X = -m_Vertices[i].X;
 
-            f.ReadFloats(framesIn.ToPtr(), framesIn.Size());
-            GenerateHRTF(framesIn.ToPtr(), framesIn.Size(), m_hrtfL.ToPtr() + i * m_FilterSize);
-
-            f.ReadFloats(framesIn.ToPtr(), framesIn.Size());
-            GenerateHRTF(framesIn.ToPtr(), framesIn.Size(), m_hrtfR.ToPtr() + i * m_FilterSize);
+            f.ReadFloats(hrirs.ToPtr() + (i * 2 + 0) * m_FrameCount, m_FrameCount);
+            f.ReadFloats(hrirs.ToPtr() + (i * 2 + 1) * m_FrameCount, m_FrameCount);
         }
     }
     else
@@ -152,83 +151,71 @@ AudioHRTF::AudioHRTF(int SampleRate)
         Vector<float> framesIn;
         framesIn.Resize(frameCountIn);
 
-        Vector<float> framesOut;
-        framesOut.Resize(frameCountOut);
-
         m_FrameCount = frameCountOut;
-        m_FilterSize = m_FrameCount - 1 + HRTF_BLOCK_LENGTH; // M - 1 + L
-#ifdef FILTER_SIZE_POW2
-        m_FilterSize = Math::ToGreaterPowerOfTwo(m_FilterSize);
-#endif
-        m_ForwardFFT = mufft_create_plan_1d_c2c(m_FilterSize, MUFFT_FORWARD, 0);
-        m_InverseFFT = mufft_create_plan_1d_c2c(m_FilterSize, MUFFT_INVERSE, 0);
 
-        m_hrtfL.Resize(vertexCount * m_FilterSize);
-        m_hrtfR.Resize(vertexCount * m_FilterSize);
+        hrirs.Resize(vertexCount * 2 * m_FrameCount);
+        Core::ZeroMem(hrirs.ToPtr(), hrirs.Size() * sizeof(float));
 
         for (auto i = 0; i < vertexCount; i++)
         {
             f.ReadObject(m_Vertices[i]);
             m_Vertices[i].X = -m_Vertices[i].X;
 
-            f.ReadFloats(framesIn.ToPtr(), framesIn.Size());
-
-            // ma_resampler_process_pcm_frames overwrite frameCountIn and frameCountOut, so we restore them before each call
-            frameCountIn = framesIn.Size();
-            frameCountOut = framesOut.Size();
-            result = ma_resampler_process_pcm_frames(&resampler, framesIn.ToPtr(), &frameCountIn, framesOut.ToPtr(), &frameCountOut);
-            if (result != MA_SUCCESS)
+            for (int ear = 0; ear < 2; ear++)
             {
-                CoreApplication::TerminateWithError("Failed to resample HRTF data\n");
+                f.ReadFloats(framesIn.ToPtr(), framesIn.Size());
+
+                // ma_resampler_process_pcm_frames overwrite frameCountIn and frameCountOut, so we restore them before each call
+                frameCountIn = framesIn.Size();
+                frameCountOut = m_FrameCount;
+                result = ma_resampler_process_pcm_frames(&resampler, framesIn.ToPtr(), &frameCountIn, hrirs.ToPtr() + (i * 2 + ear) * m_FrameCount, &frameCountOut);
+                if (result != MA_SUCCESS)
+                {
+                    CoreApplication::TerminateWithError("Failed to resample HRTF data\n");
+                }
+                HK_ASSERT(frameCountOut <= m_FrameCount);
             }
-            HK_ASSERT(frameCountOut <= framesOut.Size());
-
-            GenerateHRTF(framesOut.ToPtr(), frameCountOut, m_hrtfL.ToPtr() + i * m_FilterSize);
-
-            f.ReadFloats(framesIn.ToPtr(), framesIn.Size());
-
-            // ma_resampler_process_pcm_frames overwrite frameCountIn and frameCountOut, so we restore them before each call
-            frameCountIn = framesIn.Size();
-            frameCountOut = framesOut.Size();
-            result = ma_resampler_process_pcm_frames(&resampler, framesIn.ToPtr(), &frameCountIn, framesOut.ToPtr(), &frameCountOut);
-            if (result != MA_SUCCESS)
-            {
-                CoreApplication::TerminateWithError("Failed to resample HRTF data\n");
-            }
-            HK_ASSERT(frameCountOut <= framesOut.Size());
-
-            GenerateHRTF(framesOut.ToPtr(), frameCountOut, m_hrtfR.ToPtr() + i * m_FilterSize);
         }
 
         ma_resampler_uninit(&resampler);
     }
 
+    // Overlap-save: each block is processed together with the previous one
+    m_FilterSize = HRTF_BLOCK_LENGTH * 2;
+    m_NumPartitions = (m_FrameCount + HRTF_BLOCK_LENGTH - 1) / HRTF_BLOCK_LENGTH;
+    m_NumBins = m_FilterSize / 2 + 1;
+
+    m_ForwardFFT = mufft_create_plan_1d_c2c(m_FilterSize, MUFFT_FORWARD, 0);
+    m_InverseFFT = mufft_create_plan_1d_c2c(m_FilterSize, MUFFT_INVERSE, 0);
+
     m_pFramesSourceFFT = (Complex*)mufft_calloc(m_FilterSize * sizeof(Complex));
     m_pFramesFreqFFT = (Complex*)mufft_alloc(m_FilterSize * sizeof(Complex));
-    m_pFramesFreqLeftFFT = (Complex*)mufft_alloc(m_FilterSize * sizeof(Complex));
-    m_pFramesFreqRightFFT = (Complex*)mufft_alloc(m_FilterSize * sizeof(Complex));
-    m_pFramesTimeLeftFFT = (Complex*)mufft_alloc(m_FilterSize * sizeof(Complex));
-    m_pFramesTimeRightFFT = (Complex*)mufft_alloc(m_FilterSize * sizeof(Complex));
+    m_pFramesPackedFFT = (Complex*)mufft_alloc(m_FilterSize * sizeof(Complex));
+    m_pFramesTimeFFT[0] = (Complex*)mufft_alloc(m_FilterSize * sizeof(Complex));
+    m_pFramesTimeFFT[1] = (Complex*)mufft_alloc(m_FilterSize * sizeof(Complex));
 
-    for (int i = 0; i < 4; i++)
+    BuildGrid(hrirs.ToPtr());
+
+    const int filterStride = 2 * m_NumPartitions * m_NumBins;
+
+    m_FilterCacheData.Resize(FILTER_CACHE_SIZE * filterStride);
+    for (int i = 0; i < FILTER_CACHE_SIZE; i++)
     {
-        m_pHRTFs[i] = (Complex*)mufft_alloc(sizeof(Complex) * m_FilterSize);
+        m_FilterCache[i].pFilter = m_FilterCacheData.ToPtr() + i * filterStride;
     }
+
+    m_DelayLine.Resize(m_NumPartitions * m_NumBins);
+    m_AccumL.Resize(m_NumBins);
+    m_AccumR.Resize(m_NumBins);
 }
 
 AudioHRTF::~AudioHRTF()
 {
-    for (int i = 0; i < 4; i++)
-    {
-        mufft_free(m_pHRTFs[i]);
-    }
-
     mufft_free(m_pFramesSourceFFT);
     mufft_free(m_pFramesFreqFFT);
-    mufft_free(m_pFramesFreqLeftFFT);
-    mufft_free(m_pFramesFreqRightFFT);
-    mufft_free(m_pFramesTimeLeftFFT);
-    mufft_free(m_pFramesTimeRightFFT);
+    mufft_free(m_pFramesPackedFFT);
+    mufft_free(m_pFramesTimeFFT[0]);
+    mufft_free(m_pFramesTimeFFT[1]);
 
     mufft_free_plan_1d((mufft_plan_1d*)m_ForwardFFT);
     mufft_free_plan_1d((mufft_plan_1d*)m_InverseFFT);
@@ -244,37 +231,29 @@ void AudioHRTF::IFFT(Complex const* pIn, Complex* pOut)
     mufft_execute_plan_1d((mufft_plan_1d*)m_InverseFFT, pOut, pIn);
 }
 
-void AudioHRTF::GenerateHRTF(const float* pFrames, int InFrameCount, Complex* pHRTF)
+void AudioHRTF::GeneratePartitions(const float* pHRIR, Complex* pPartitions)
 {
-    // MuFFT requires 64-bit aligned data. Therefore, we must use it's own allocators.
-    Complex* hrirComplex = (Complex*)mufft_alloc(sizeof(Complex) * m_FilterSize);
-    Complex* temp = (Complex*)mufft_alloc(sizeof(Complex) * m_FilterSize);
-
-    for (int i = 0; i < m_FilterSize; i++)
+    for (int partition = 0; partition < m_NumPartitions; partition++)
     {
-        if (i < InFrameCount)
-        {
-            hrirComplex[i].R = pFrames[i];
-        }
-        else
+        int first = partition * HRTF_BLOCK_LENGTH;
+
+        // Partition is zero padded to the filter size
+        for (int i = 0; i < m_FilterSize; i++)
         {
-            hrirComplex[i].R = 0;
-        }
-        hrirComplex[i].I = 0;
-    }
+            int frameNum = first + i;
 
-    FFT(hrirComplex, temp);
+            m_pFramesSourceFFT[i].R = (i < HRTF_BLOCK_LENGTH && frameNum < m_FrameCount) ? pHRIR[frameNum] : 0.0f;
+        }
 
-    Core::Memcpy(pHRTF, temp, sizeof(Complex) * m_FilterSize);
+        FFT(m_pFramesSourceFFT, m_pFramesFreqFFT);
 
-    mufft_free(temp);
-    mufft_free(hrirComplex);
+        // The spectrum of real signal is symmetric, so we keep only the first half
+        Core::Memcpy(pPartitions + partition * m_NumBins, m_pFramesFreqFFT, sizeof(Complex) * m_NumBins);
+    }
 }
 
-void AudioHRTF::SampleHRTF(Float3 const& Dir, Complex* pLeftHRTF, Complex* pRightHRTF) const
+void AudioHRTF::SampleHRIR(Float3 const& Dir, float const* pHRIRs, float* pLeftHRIR, float* pRightHRIR) const
 {
-    // TODO: optimize: create sphere with regular grid. Find sphere segment by azimuth and pitch. Perform raycast between two triangles of the segment.
-
     float d, u, v;
 
     for (int i = 0; i < m_Indices.Size(); i += 3)
@@ -293,98 +272,264 @@ void AudioHRTF::SampleHRTF(Float3 const& Dir, Complex* pLeftHRTF, Complex* pRigh
 
             if (w < 0.0f) w = 0.0f; // fix rounding issues
 
-            Complex const* a_left = m_hrtfL.ToPtr() + index0 * m_FilterSize;
-            Complex const* a_right = m_hrtfR.ToPtr() + index0 * m_FilterSize;
+            float const* a_left = pHRIRs + (index0 * 2 + 0) * m_FrameCount;
+            float const* a_right = pHRIRs + (index0 * 2 + 1) * m_FrameCount;
 
-            Complex const* b_left = m_hrtfL.ToPtr() + index1 * m_FilterSize;
-            Complex const* b_right = m_hrtfR.ToPtr() + index1 * m_FilterSize;
+            float const* b_left = pHRIRs + (index1 * 2 + 0) * m_FrameCount;
+            float const* b_right = pHRIRs + (index1 * 2 + 1) * m_FrameCount;
 
-            Complex const* c_left = m_hrtfL.ToPtr() + index2 * m_FilterSize;
-            Complex const* c_right = m_hrtfR.ToPtr() + index2 * m_FilterSize;
+            float const* c_left = pHRIRs + (index2 * 2 + 0) * m_FrameCount;
+            float const* c_right = pHRIRs + (index2 * 2 + 1) * m_FrameCount;
 
-            for (int n = 0; n < m_FilterSize; n++)
+            for (int n = 0; n < m_FrameCount; n++)
             {
-                pLeftHRTF[n].R = a_left[n].R * u + b_left[n].R * v + c_left[n].R * w;
-                pLeftHRTF[n].I = a_left[n].I * u + b_left[n].I * v + c_left[n].I * w;
-                pRightHRTF[n].R = a_right[n].R * u + b_right[n].R * v + c_right[n].R * w;
-                pRightHRTF[n].I = a_right[n].I * u + b_right[n].I * v + c_right[n].I * w;
+                pLeftHRIR[n] = a_left[n] * u + b_left[n] * v + c_left[n] * w;
+                pRightHRIR[n] = a_right[n] * u + b_right[n] * v + c_right[n] * w;
             }
 
             return;
         }
     }
 
-    Core::ZeroMem(pLeftHRTF, m_FilterSize * sizeof(Complex));
-    Core::ZeroMem(pRightHRTF, m_FilterSize * sizeof(Complex));
+    // Ray passed between the triangles due to rounding issues, use the closest vertex
+    int closest = 0;
+    float maxDot = -2.0f;
+    for (int i = 0; i < m_Vertices.Size(); i++)
+    {
+        float dot = Math::Dot(m_Vertices[i], Dir) / m_Vertices[i].Length();
+        if (dot > maxDot)
+        {
+            maxDot = dot;
+            closest = i;
+        }
+    }
+
+    Core::Memcpy(pLeftHRIR, pHRIRs + (closest * 2 + 0) * m_FrameCount, m_FrameCount * sizeof(float));
+    Core::Memcpy(pRightHRIR, pHRIRs + (closest * 2 + 1) * m_FrameCount, m_FrameCount * sizeof(float));
 }
 
-void AudioHRTF::ApplyHRTF(Float3 const& CurDir, Float3 const& NewDir, const float* pFrames, int InFrameCount, float* pStream, Float3& Dir)
+void AudioHRTF::BuildGrid(float const* pHRIRs)
 {
-    HK_ASSERT(InFrameCount > 0);
-    HK_ASSERT((InFrameCount % HRTF_BLOCK_LENGTH) == 0);
+    const int filterStride = 2 * m_NumPartitions * m_NumBins;
 
-    const int numBlocks = InFrameCount / HRTF_BLOCK_LENGTH;
-    const int hrtfLen = m_FrameCount - 1;
+    m_GridFilters.Resize(GRID_AZIMUTH_STEPS * GRID_ELEVATION_STEPS * filterStride);
 
-    Complex* filterL[2] = {
-        m_pHRTFs[0],
-        m_pHRTFs[1]};
-    Complex* filterR[2] = {
-        m_pHRTFs[2],
-        m_pHRTFs[3]};
+    Vector<float> left(m_FrameCount);
+    Vector<float> right(m_FrameCount);
 
-    Complex* pFramesLeft = m_pFramesTimeLeftFFT + hrtfLen;
-    Complex* pFramesRight = m_pFramesTimeRightFFT + hrtfLen;
+    for (int row = 0; row < GRID_ELEVATION_STEPS; row++)
+    {
+        float elevation = -Math::_HALF_PI + row * Math::_PI / (GRID_ELEVATION_STEPS - 1);
 
-    int curIndex = 1;
-    int newIndex = 0;
+        for (int col = 0; col < GRID_AZIMUTH_STEPS; col++)
+        {
+            float azimuth = col * Math::_2PI / GRID_AZIMUTH_STEPS;
 
-    bool bNoLerp = CurDir.LengthSqr() < 0.1f || !Snd_LerpHRTF;
-    Dir = bNoLerp ? NewDir : CurDir;
+            Float3 dir(std::cos(elevation) * std::sin(azimuth),
+                       std::sin(elevation),
+                       std::cos(elevation) * std::cos(azimuth));
 
-    SampleHRTF(Dir, filterL[curIndex], filterR[curIndex]);
+            SampleHRIR(dir, pHRIRs, left.ToPtr(), right.ToPtr());
 
-    const float* history = pFrames;
-    const float* frames = pFrames + hrtfLen;
+            Complex* filter = m_GridFilters.ToPtr() + (row * GRID_AZIMUTH_STEPS + col) * filterStride;
 
-    for (int blockNum = 0; blockNum < numBlocks; blockNum++)
+            GeneratePartitions(left.ToPtr(), filter);
+            GeneratePartitions(right.ToPtr(), filter + m_NumPartitions * m_NumBins);
+        }
+    }
+}
+
+uint32_t AudioHRTF::GetFilterKey(Float3 const& Dir) const
+{
+    const int azimuthSteps = GRID_AZIMUTH_STEPS * GRID_SUBDIVISION;
+    const int elevationSteps = (GRID_ELEVATION_STEPS - 1) * GRID_SUBDIVISION;
+
+    float azimuth = Math::Atan2(Dir.X, Dir.Z);
+    if (azimuth < 0.0f)
+        azimuth += Math::_2PI;
+
+    float elevation = std::asin(Math::Clamp(Dir.Y, -1.0f, 1.0f));
+
+    // Quantize direction
+    int qa = (int)Math::Round(azimuth / Math::_2PI * azimuthSteps) % azimuthSteps;
+    int qe = Math::Clamp((int)Math::Round((elevation + Math::_HALF_PI) / Math::_PI * elevationSteps), 0, elevationSteps);
+
+    return qa | (qe << 16);
+}
+
+bool AudioHRTF::IsFilterSteady(Float3 const& CurDir, Float3 const& NewDir) const
+{
+    if (CurDir.LengthSqr() < 0.1f || !Snd_LerpHRTF)
+        return true;
+
+    return GetFilterKey(CurDir) == GetFilterKey(NewDir);
+}
+
+Complex const* AudioHRTF::GetFilter(Float3 const& Dir, Complex const* pPinned)
+{
+    uint32_t key = GetFilterKey(Dir);
+
+    m_FilterCacheTimestamp++;
+
+    FilterCacheEntry* victim = nullptr;
+    for (FilterCacheEntry& entry : m_FilterCache)
     {
-        // Copy frames to m_pFramesSourceFFT
-        int n = 0, frameNum = 0;
-        while (n < hrtfLen)
+        if (entry.Key == key)
         {
-            // Restore previous frames from channel
-            m_pFramesSourceFFT[n].R = history[n];
-            n++;
+            entry.LastUsed = m_FilterCacheTimestamp;
+            return entry.pFilter;
         }
-        while (frameNum < HRTF_BLOCK_LENGTH)
+
+        if (entry.pFilter != pPinned && (!victim || entry.LastUsed < victim->LastUsed))
+            victim = &entry;
+    }
+
+    victim->Key = key;
+    victim->LastUsed = m_FilterCacheTimestamp;
+
+    int qa = key & 0xffff;
+    int qe = key >> 16;
+
+    // Bilinear interpolation between the grid points
+    int col0 = qa / GRID_SUBDIVISION;
+    int col1 = (col0 + 1) % GRID_AZIMUTH_STEPS;
+    int row0 = qe / GRID_SUBDIVISION;
+    float s = (float)(qa % GRID_SUBDIVISION) / GRID_SUBDIVISION;
+    float t = (float)(qe % GRID_SUBDIVISION) / GRID_SUBDIVISION;
+    if (row0 == GRID_ELEVATION_STEPS - 1)
+    {
+        row0--;
+        t = 1.0f;
+    }
+    int row1 = row0 + 1;
+
+    const int filterStride = 2 * m_NumPartitions * m_NumBins;
+
+    const int points[4] = {
+        row0 * GRID_AZIMUTH_STEPS + col0,
+        row0 * GRID_AZIMUTH_STEPS + col1,
+        row1 * GRID_AZIMUTH_STEPS + col0,
+        row1 * GRID_AZIMUTH_STEPS + col1};
+
+    const float weights[4] = {
+        (1.0f - s) * (1.0f - t),
+        s * (1.0f - t),
+        (1.0f - s) * t,
+        s * t};
+
+    Complex* filter = victim->pFilter;
+
+    Core::ZeroMem(filter, filterStride * sizeof(Complex));
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (weights[i] <= 0.0f)
+            continue;
+
+        Complex const* gridFilter = m_GridFilters.ToPtr() + points[i] * filterStride;
+        for (int n = 0; n < filterStride; n++)
         {
-            m_pFramesSourceFFT[n].R = frames[frameNum];
-            frameNum++;
-            n++;
+            filter[n] += gridFilter[n] * weights[i];
         }
+    }
 
-        // Perform FFT on source frames
-        FFT(m_pFramesSourceFFT, m_pFramesFreqFFT);
+    return filter;
+}
+
+void AudioHRTF::TransformBlock(const float* pFrames, Complex* pSpectrum)
+{
+    for (int n = 0; n < m_FilterSize; n++)
+    {
+        m_pFramesSourceFFT[n].R = pFrames[n];
+    }
+
+    FFT(m_pFramesSourceFFT, m_pFramesFreqFFT);
+
+    Core::Memcpy(pSpectrum, m_pFramesFreqFFT, sizeof(Complex) * m_NumBins);
+}
+
+void AudioHRTF::ConvolveBlock(int Head, Complex const* pFilter, Complex* pOut)
+{
+    Complex const* filterL = pFilter;
+    Complex const* filterR = pFilter + m_NumPartitions * m_NumBins;
+
+    Core::ZeroMem(m_AccumL.ToPtr(), m_NumBins * sizeof(Complex));
+    Core::ZeroMem(m_AccumR.ToPtr(), m_NumBins * sizeof(Complex));
+
+    // Sum of the delayed input spectra multiplied by the filter partitions
+    for (int partition = 0; partition < m_NumPartitions; partition++)
+    {
+        int slot = (Head - partition + m_NumPartitions) % m_NumPartitions;
 
-        // Apply HRTF
-        for (n = 0; n < m_FilterSize; n++)
+        Complex const* input = m_DelayLine.ToPtr() + slot * m_NumBins;
+        Complex const* partitionL = filterL + partition * m_NumBins;
+        Complex const* partitionR = filterR + partition * m_NumBins;
+
+        for (int n = 0; n < m_NumBins; n++)
         {
-            m_pFramesFreqLeftFFT[n] = m_pFramesFreqFFT[n] * filterL[curIndex][n];
-            m_pFramesFreqRightFFT[n] = m_pFramesFreqFFT[n] * filterR[curIndex][n];
+            m_AccumL[n] += input[n] * partitionL[n];
+            m_AccumR[n] += input[n] * partitionR[n];
         }
+    }
+
+    // Both ears are real signals, so they are packed into a single spectrum as L + i*R
+    // and converted to time domain with one inverse FFT.
+    for (int n = 0; n < m_NumBins; n++)
+    {
+        Complex const& l = m_AccumL[n];
+        Complex const& r = m_AccumR[n];
+
+        m_pFramesPackedFFT[n] = Complex(l.R - r.I, l.I + r.R);
+
+        // Restore the symmetric half: conj(L) + i*conj(R)
+        if (n > 0 && n < m_NumBins - 1)
+        {
+            m_pFramesPackedFFT[m_FilterSize - n] = Complex(l.R + r.I, r.R - l.I);
+        }
+    }
+
+    IFFT(m_pFramesPackedFFT, pOut);
+}
+
+void AudioHRTF::ApplyHRTF(Float3 const& CurDir, Float3 const& NewDir, const float* pFrames, int InFrameCount, float* pStream, Float3& Dir)
+{
+    HK_ASSERT(InFrameCount > 0);
+    HK_ASSERT((InFrameCount % HRTF_BLOCK_LENGTH) == 0);
+
+    const int numBlocks = InFrameCount / HRTF_BLOCK_LENGTH;
 
-        // Perform inverse FFT to convert result in time domain
-        IFFT(m_pFramesFreqLeftFFT, m_pFramesTimeLeftFFT);
-        IFFT(m_pFramesFreqRightFFT, m_pFramesTimeRightFFT);
+    bool bNoLerp = CurDir.LengthSqr() < 0.1f || !Snd_LerpHRTF;
+    Dir = bNoLerp ? NewDir : CurDir;
+
+    Complex const* filter = GetFilter(Dir, nullptr);
+
+    // Restore the delay line from the history frames
+    int head = 0;
+    for (int partition = 1; partition < m_NumPartitions; partition++)
+    {
+        TransformBlock(pFrames, m_DelayLine.ToPtr() + head * m_NumBins);
+
+        head = (head + 1) % m_NumPartitions;
+        pFrames += HRTF_BLOCK_LENGTH;
+    }
+
+    for (int blockNum = 0; blockNum < numBlocks; blockNum++)
+    {
+        // Previous and current blocks
+        TransformBlock(pFrames, m_DelayLine.ToPtr() + head * m_NumBins);
+
+        ConvolveBlock(head, filter, m_pFramesTimeFFT[0]);
+
+        // Overlap-save: first half of the block is aliased
+        Complex const* result = m_pFramesTimeFFT[0] + HRTF_BLOCK_LENGTH;
 
         float* blockStart = pStream;
 
         // Save block in output stream
-        for (n = 0; n < HRTF_BLOCK_LENGTH; n++)
+        for (int n = 0; n < HRTF_BLOCK_LENGTH; n++)
         {
-            pStream[0] = pFramesLeft[n].R;
-            pStream[1] = pFramesRight[n].R;
+            pStream[0] = result[n].R;
+            pStream[1] = result[n].I;
             pStream += 2;
         }
 
@@ -393,36 +538,33 @@ void AudioHRTF::ApplyHRTF(Float3 const& CurDir, Float3 const& NewDir, const floa
             Dir = Math::Lerp(CurDir, NewDir, (blockNum + 1) * 1.0f / numBlocks);
             Dir.NormalizeSelf();
 
-            SampleHRTF(Dir, filterL[newIndex], filterR[newIndex]);
+            Complex const* newFilter = GetFilter(Dir, filter);
 
-            // Apply HRTF
-            for (n = 0; n < m_FilterSize; n++)
+            // Same filter is returned for close directions
+            if (newFilter != filter)
             {
-                m_pFramesFreqLeftFFT[n] = m_pFramesFreqFFT[n] * filterL[newIndex][n];
-                m_pFramesFreqRightFFT[n] = m_pFramesFreqFFT[n] * filterR[newIndex][n];
-            }
+                ConvolveBlock(head, newFilter, m_pFramesTimeFFT[1]);
 
-            // Perform inverse FFT to convert result in time domain
-            IFFT(m_pFramesFreqLeftFFT, m_pFramesTimeLeftFFT);
-            IFFT(m_pFramesFreqRightFFT, m_pFramesTimeRightFFT);
+                result = m_pFramesTimeFFT[1] + HRTF_BLOCK_LENGTH;
 
-            pStream = blockStart;
+                pStream = blockStart;
 
-            // Save block in output stream
-            const float scale = 1.0f / HRTF_BLOCK_LENGTH;
-            for (n = 0; n < HRTF_BLOCK_LENGTH; n++)
-            {
-                float lerp = (float)n * scale;
-                pStream[0] = Math::Lerp(pStream[0], pFramesLeft[n].R, lerp);
-                pStream[1] = Math::Lerp(pStream[1], pFramesRight[n].R, lerp);
-                pStream += 2;
-            }
+                // Save block in output stream
+                const float scale = 1.0f / HRTF_BLOCK_LENGTH;
+                for (int n = 0; n < HRTF_BLOCK_LENGTH; n++)
+                {
+                    float lerp = (float)n * scale;
+                    pStream[0] = Math::Lerp(pStream[0], result[n].R, lerp);
+                    pStream[1] = Math::Lerp(pStream[1], result[n].I, lerp);
+                    pStream += 2;
+                }
 
-            std::swap(curIndex, newIndex);
+                filter = newFilter;
+            }
         }
 
-        frames += HRTF_BLOCK_LENGTH;
-        history += HRTF_BLOCK_LENGTH;
+        head = (head + 1) % m_NumPartitions;
+        pFrames += HRTF_BLOCK_LENGTH;
     }
 }
 
@@ -44,13 +44,17 @@ public:
     AudioHRTF(int SampleRate);
     ~AudioHRTF();
 
-    /// Gets a bilinearly interpolated HRTF
-    void SampleHRTF(Float3 const& Dir, Complex* pLeftHRTF, Complex* pRightHRTF) const;
-
-    /// Applies HRTF to input frames. Frames must also contain GetFrameCount()-1 of the previous frames.
+    /// Applies HRTF to input frames using uniformly partitioned overlap-save convolution.
+    /// Frames must also contain GetHistoryLength() of the previous frames.
     /// FrameCount must be multiples of HRTF_BLOCK_LENGTH
     void ApplyHRTF(Float3 const& CurDir, Float3 const& NewDir, const float* pFrames, int FrameCount, float* pStream, Float3& Dir);
 
+    /// Quantized direction. Directions with the same key use the same filter.
+    uint32_t GetFilterKey(Float3 const& Dir) const;
+
+    /// Returns true if ApplyHRTF uses a single filter for the whole call, i.e. doesn't interpolate from CurDir to NewDir.
+    bool IsFilterSteady(Float3 const& CurDir, Float3 const& NewDir) const;
+
     /// Sphere geometry vertics
     Vector<Float3> const& GetVertices() const { return m_Vertices; }
 
@@ -63,15 +67,46 @@ public:
         return m_FrameCount;
     }
 
+    /// Count of the previous frames required by ApplyHRTF
+    int GetHistoryLength() const
+    {
+        return m_NumPartitions * HRTF_BLOCK_LENGTH;
+    }
+
     /// HRTF FFT filter size in frames
     int GetFilterSize() const
     {
-        // Computed as power of two of FrameCount - 1 + HRTF_BLOCK_LENGTH
+        // Computed as two blocks of HRTF_BLOCK_LENGTH
         return m_FilterSize;
     }
 
 private:
-    void GenerateHRTF(const float* pFrames, int InFrameCount, Complex* pHRTF);
+    struct FilterCacheEntry
+    {
+        uint32_t Key = ~0u;
+        uint32_t LastUsed = 0;
+        Complex* pFilter = nullptr;
+    };
+
+    static constexpr int FILTER_CACHE_SIZE = 32;
+
+    // Gets a barycentric interpolated HRIR from the sphere geometry
+    void SampleHRIR(Float3 const& Dir, float const* pHRIRs, float* pLeftHRIR, float* pRightHRIR) const;
+
+    // Samples filters for each point of the direction grid
+    void BuildGrid(float const* pHRIRs);
+
+    // Splits HRIR to partitions and converts them to freq domain
+    void GeneratePartitions(const float* pHRIR, Complex* pPartitions);
+
+    // Gets a bilinearly interpolated filter from the direction grid. Pinned filter is never evicted from the cache.
+    Complex const* GetFilter(Float3 const& Dir, Complex const* pPinned);
+
+    // Converts two blocks of frames to freq domain
+    void TransformBlock(const float* pFrames, Complex* pSpectrum);
+
+    // Convolves the delay line with the filter. Left and right ears are returned in real and imaginary parts.
+    void ConvolveBlock(int Head, Complex const* pFilter, Complex* pOut);
 
     // Fast fourier transform (forward)
     void FFT(Complex const* pIn, Complex* pOut);
@@ -85,10 +120,29 @@ private:
     // HRTF FFT filter size in frames
     int m_FilterSize = 0;
 
+    // Count of HRTF_BLOCK_LENGTH partitions of HRIR
+    int m_NumPartitions = 0;
+
+    // Count of non-redundant bins of real signal spectrum
+    int m_NumBins = 0;
+
     Vector<uint32_t> m_Indices;
     Vector<Float3> m_Vertices;
-    Vector<Complex> m_hrtfL;
-    Vector<Complex> m_hrtfR;
+
+    // Partitioned filters for each direction of the grid, [point][ear][partition][bin]
+    Vector<Complex> m_GridFilters;
+
+    // Interpolated filters cached by quantized direction
+    FilterCacheEntry m_FilterCache[FILTER_CACHE_SIZE];
+    Vector<Complex> m_FilterCacheData;
+    uint32_t m_FilterCacheTimestamp = 0;
+
+    // Frequency-domain delay line, [partition][bin]
+    Vector<Complex> m_DelayLine;
+    // Accumulated spectrum for left ear
+    Vector<Complex> m_AccumL;
+    // Accumulated spectrum for right ear
+    Vector<Complex> m_AccumR;
 
     void* m_ForwardFFT = nullptr;
     void* m_InverseFFT = nullptr;
@@ -97,16 +151,10 @@ private:
     Complex* m_pFramesSourceFFT = nullptr;
     // Processing frames, freq domain
     Complex* m_pFramesFreqFFT = nullptr;
-    // Frames for left ear, freq domain
-    Complex* m_pFramesFreqLeftFFT = nullptr;
-    // Frames for right ear, freq domain
-    Complex* m_pFramesFreqRightFFT = nullptr;
-    // Frames for left ear, time domain
-    Complex* m_pFramesTimeLeftFFT = nullptr;
-    // Frames for right ear, time domain
-    Complex* m_pFramesTimeRightFFT = nullptr;
-
-    Complex* m_pHRTFs[4] = {nullptr, nullptr, nullptr, nullptr};
+    // Frames for both ears packed into single spectrum, freq domain
+    Complex* m_pFramesPackedFFT = nullptr;
+    // Frames for both ears (real part - left, imaginary part - right), time domain
+    Complex* m_pFramesTimeFFT[2] = {nullptr, nullptr};
 };
 
 HK_NAMESPACE_END
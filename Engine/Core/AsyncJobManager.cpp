@@ -27,7 +27,6 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 
 */
-
 #include "AsyncJobManager.h"
 #include "Logger.h"
 #include "Profiler.h"
@@ -36,6 +35,42 @@ HK_NAMESPACE_BEGIN
 
 constexpr int AsyncJobManager::MAX_WORKER_THREADS;
 constexpr int AsyncJobManager::MAX_JOB_LISTS;
+constexpr int AsyncJobManager::WORKER_QUEUE_SIZE;
+
+namespace
+{
+
+// How many times an idle thread tries to find a job before it goes to sleep
+constexpr int MAX_IDLE_SPINS = 256;
+
+// Max jobs that a worker moves from the injection queue to its own deque at once
+constexpr int GLOBAL_QUEUE_BATCH_SIZE = 32;
+
+// Sleep interval for threads that wait on a counter and have nothing to execute
+constexpr int WAIT_SLEEP_MICROSECONDS = 50;
+
+thread_local AsyncJobManager* tl_JobManager  = nullptr;
+thread_local int              tl_WorkerIndex = -1;
+
+// Steal seed for threads that are not workers
+thread_local uint32_t tl_ExternalStealSeed = 0;
+
+HK_FORCEINLINE uint32_t XorShift(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+} // namespace
+
+int AsyncJobManager::GetDefaultNumWorkerThreads()
+{
+    // Keep one hardware thread for the main thread, which also executes jobs while waiting.
+    int numThreads = Thread::NumHardwareThreads > 1 ? Thread::NumHardwareThreads - 1 : 1;
+    return numThreads > MAX_WORKER_THREADS ? MAX_WORKER_THREADS : numThreads;
+}
 
 AsyncJobManager::AsyncJobManager(int _NumWorkerThreads, int _NumJobLists)
 {
@@ -46,14 +81,14 @@ AsyncJobManager::AsyncJobManager(int _NumWorkerThreads, int _NumJobLists)
     }
     else if (_NumWorkerThreads <= 0)
     {
-        _NumWorkerThreads = MAX_WORKER_THREADS;
+        _NumWorkerThreads = GetDefaultNumWorkerThreads();
     }
 
     HK_ASSERT(_NumJobLists >= 1 && _NumJobLists <= MAX_JOB_LISTS);
 
     LOG("Initializing async job manager ( {} worker threads, {} job lists )\n", _NumWorkerThreads, _NumJobLists);
 
-    bTerminated = false;
+    bTerminated.Store(false);
 
     NumJobLists = _NumJobLists;
     for (int i = 0; i < NumJobLists; i++)
@@ -61,12 +96,15 @@ AsyncJobManager::AsyncJobManager(int _NumWorkerThreads, int _NumJobLists)
         JobList[i].JobManager = this;
     }
 
-    TotalJobs.Store(0);
-
     NumWorkerThreads = _NumWorkerThreads;
+    Workers          = new Worker[NumWorkerThreads];
     for (int i = 0; i < NumWorkerThreads; i++)
     {
-        WorkerThread[i] = Thread(
+        Workers[i].StealSeed = uint32_t(i + 1) * 2654435761u;
+    }
+    for (int i = 0; i < NumWorkerThreads; i++)
+    {
+        Workers[i].WorkerThread = Thread(
             [this](int ThreadId)
             {
                 _HK_PROFILER_THREAD("Worker");
@@ -80,119 +118,308 @@ AsyncJobManager::~AsyncJobManager()
 {
     LOG("Deinitializing async job manager\n");
 
-    NotifyThreads();
-
     for (int i = 0; i < NumJobLists; i++)
     {
         JobList[i].Wait();
         JobList[i].JobPool.Free();
     }
 
-    bTerminated = true;
-    NotifyThreads();
+    bTerminated.Store(true);
 
     for (int i = 0; i < NumWorkerThreads; i++)
     {
-        WorkerThread[i].Join();
+        Workers[i].EventNotify.Signal();
     }
+
+    for (int i = 0; i < NumWorkerThreads; i++)
+    {
+        Workers[i].WorkerThread.Join();
+    }
+
+    delete[] Workers;
+}
+
+int AsyncJobManager::GetCurrentWorkerIndex() const
+{
+    return tl_JobManager == this ? tl_WorkerIndex : -1;
+}
+
+uint32_t& AsyncJobManager::GetStealSeed(int workerIndex)
+{
+    if (workerIndex >= 0)
+        return Workers[workerIndex].StealSeed;
+
+    if (!tl_ExternalStealSeed)
+        tl_ExternalStealSeed = uint32_t(Thread::ThisThreadId()) | 1;
+    return tl_ExternalStealSeed;
 }
 
 void AsyncJobManager::NotifyThreads()
 {
+    WakeWorkers(NumWorkerThreads);
+}
+
+void AsyncJobManager::WakeWorkers(int count)
+{
+    // Pairs with the fence in WorkerThreadRoutine: either the worker sees the new jobs
+    // before it goes to sleep, or we see the worker sleeping.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (NumSleepingWorkers.Load() == 0)
+        return;
+
+    for (int i = 0; i < NumWorkerThreads && count > 0; i++)
+    {
+        if (Workers[i].bSleeping.Load())
+        {
+            Workers[i].EventNotify.Signal();
+            count--;
+        }
+    }
+}
+
+void AsyncJobManager::ExecuteJob(AsyncJob* job)
+{
+    // The job memory can be released by the waiting thread once the counter is decremented
+    AsyncJobCounter* counter = job->Counter;
+
+    job->Callback(job->Data);
+
+    if (counter)
+        counter->Decrement();
+}
+
+AsyncJob* AsyncJobManager::FetchGlobalJobs(int workerIndex)
+{
+    AsyncJob* job = nullptr;
+    int       numMoved = 0;
+
+    {
+        MutexGuard syncGuard(GlobalQueueSync);
+
+        AsyncJob** head = GlobalQueue.Pop();
+        if (!head)
+            return nullptr;
+
+        job = *head;
+
+        if (workerIndex >= 0)
+        {
+            // Take a share of the remaining jobs to our own deque, so the other workers steal them
+            // from us instead of hammering the injection queue lock.
+            auto& queue = Workers[workerIndex].Queue;
+
+            int share = GlobalQueue.Size() / NumWorkerThreads + 1;
+            if (share > GLOBAL_QUEUE_BATCH_SIZE)
+                share = GLOBAL_QUEUE_BATCH_SIZE;
+
+            // Only the owner pushes to the deque, so the free space can only grow meanwhile
+            int freeSpace = WORKER_QUEUE_SIZE - int(queue.SizeApprox());
+            if (share > freeSpace)
+                share = freeSpace;
+
+            while (numMoved < share)
+            {
+                AsyncJob** next = GlobalQueue.Pop();
+                if (!next)
+                    break;
+                queue.Push(*next);
+                numMoved++;
+            }
+        }
+
+        // Head and tail of the queue only grow, so rewind them whenever the queue drains
+        if (GlobalQueue.IsEmpty())
+            GlobalQueue.Clear();
+
+        NumGlobalJobs.Sub(numMoved + 1);
+    }
+
+    if (numMoved > 0)
+        WakeWorkers(numMoved);
+
+    return job;
+}
+
+AsyncJob* AsyncJobManager::FetchJob(int workerIndex, uint32_t& stealSeed)
+{
+    if (workerIndex >= 0)
+    {
+        if (AsyncJob* job = Workers[workerIndex].Queue.Pop())
+            return job;
+    }
+
+    if (NumGlobalJobs.Load() > 0)
+    {
+        if (AsyncJob* job = FetchGlobalJobs(workerIndex))
+            return job;
+    }
+
+    int victim = XorShift(stealSeed) % NumWorkerThreads;
     for (int i = 0; i < NumWorkerThreads; i++)
     {
-        EventNotify[i].Signal();
+        if (victim != workerIndex)
+        {
+            if (AsyncJob* job = Workers[victim].Queue.Steal())
+                return job;
+        }
+
+        if (++victim == NumWorkerThreads)
+            victim = 0;
     }
+
+    return nullptr;
 }
 
 void AsyncJobManager::WorkerThreadRoutine(int _ThreadId)
 {
-    AsyncJob job = {};
-    bool      haveJob;
+    Worker& worker = Workers[_ThreadId];
+    int     idleSpins = 0;
+
+    tl_JobManager  = this;
+    tl_WorkerIndex = _ThreadId;
 
 #ifdef HK_ACTIVE_THREADS_COUNTERS
     NumActiveThreads.Increment();
 #endif
 
-    while (!bTerminated)
+    while (!bTerminated.Load())
     {
-        HK_PROFILER_EVENT("Worker loop");
+        if (AsyncJob* job = FetchJob(_ThreadId, worker.StealSeed))
+        {
+            ExecuteJob(job);
+            idleSpins = 0;
+            continue;
+        }
+
+        if (++idleSpins < MAX_IDLE_SPINS)
+        {
+            YieldCPU();
+            continue;
+        }
+        idleSpins = 0;
+
+        worker.bSleeping.Store(true);
+        NumSleepingWorkers.Increment();
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // Check again: the jobs could be submitted before we marked ourselves as sleeping
+        AsyncJob* job = bTerminated.Load() ? nullptr : FetchJob(_ThreadId, worker.StealSeed);
+        if (!job && !bTerminated.Load())
+        {
+#ifdef HK_ACTIVE_THREADS_COUNTERS
+            NumActiveThreads.Decrement();
+#endif
+            HK_PROFILER_EVENT("Worker sleep");
+
+            worker.EventNotify.Wait();
 
 #ifdef HK_ACTIVE_THREADS_COUNTERS
-        NumActiveThreads.Decrement();
+            NumActiveThreads.Increment();
 #endif
+        }
 
-        //LOG( "Thread waiting {}\n", _ThreadId );
+        NumSleepingWorkers.Decrement();
+        worker.bSleeping.Store(false);
 
-        EventNotify[_ThreadId].Wait();
+        if (job)
+            ExecuteJob(job);
+    }
 
 #ifdef HK_ACTIVE_THREADS_COUNTERS
-        NumActiveThreads.Increment();
+    NumActiveThreads.Decrement();
 #endif
 
-        for (int currentList = 0; TotalJobs.Load() > 0; currentList++)
-        {
-            int fetchIndex = (_ThreadId + currentList) % NumJobLists;
+    tl_JobManager  = nullptr;
+    tl_WorkerIndex = -1;
 
-            AsyncJobList* jobList = &JobList[fetchIndex];
+    LOG("Terminating worker thread ({})\n", _ThreadId);
+}
 
-            // Check if list have a jobs
-            if (jobList->FetchCount.Load() > 0)
+void AsyncJobManager::SubmitJobs(AsyncJob* jobs, int count, AsyncJobCounter& counter)
+{
+    if (count <= 0)
+        return;
+
+    counter.Add(count);
+
+    for (int i = 0; i < count; i++)
+        jobs[i].Counter = &counter;
+
+    int workerIndex = GetCurrentWorkerIndex();
+    if (workerIndex >= 0)
+    {
+        auto& queue = Workers[workerIndex].Queue;
+        for (int i = 0; i < count; i++)
+        {
+            if (!queue.Push(&jobs[i]))
             {
-                haveJob = false;
-
-                // fetch job
-                {
-                    MutexGuard syncGuard(jobList->SubmitSync);
-
-                    //if ( jobList->FetchLock.Increment() == 1 )
-                    //{
-                    if (jobList->SubmittedJobs)
-                    {
-                        job                    = *jobList->SubmittedJobs;
-                        jobList->SubmittedJobs = job.Next;
-                        haveJob                = true;
-
-                        jobList->FetchCount.Decrement();
-                        TotalJobs.Decrement();
-                    }
-                    //    jobList->FetchLock.Decrement();
-                    //} else {
-                    //    jobList->FetchLock.Decrement();
-                    //}
-                }
-
-                if (haveJob)
-                {
-                    job.Callback(job.Data);
-
-                    // Check if this was last processed job in the list
-                    if (jobList->SubmittedJobsCount.Decrement() == 0)
-                    {
-                        MutexGuard syncGuard(jobList->SubmitSync);
-
-                        // Check for new submits
-                        if (!jobList->SubmittedJobs && jobList->SubmittedJobsCount.Load() == 0)
-                        {
-
-                            // Check if already signalled from other thread
-                            if (!jobList->bSignalled)
-                            {
-                                jobList->bSignalled = true;
-                                jobList->EventDone.Signal();
-                            }
-                        }
-                    }
-                }
+                // Deque overflow, don't block - just do the work
+                ExecuteJob(&jobs[i]);
             }
         }
     }
+    else
+    {
+        MutexGuard syncGuard(GlobalQueueSync);
 
-#ifdef HK_ACTIVE_THREADS_COUNTERS
-    NumActiveThreads.Decrement();
-#endif
+        for (int i = 0; i < count; i++)
+            *GlobalQueue.Push() = &jobs[i];
 
-    LOG("Terminating worker thread ({})\n", _ThreadId);
+        NumGlobalJobs.Add(count);
+    }
+
+    WakeWorkers(count);
+}
+
+void AsyncJobManager::WaitForCounter(AsyncJobCounter const& counter)
+{
+    int       workerIndex = GetCurrentWorkerIndex();
+    uint32_t& stealSeed   = GetStealSeed(workerIndex);
+    int       idleSpins   = 0;
+
+    while (!counter.IsDone())
+    {
+        if (AsyncJob* job = FetchJob(workerIndex, stealSeed))
+        {
+            ExecuteJob(job);
+            idleSpins = 0;
+            continue;
+        }
+
+        // The remaining jobs are being executed by other threads
+        if (++idleSpins < MAX_IDLE_SPINS)
+            YieldCPU();
+        else
+            Thread::WaitMicroseconds(WAIT_SLEEP_MICROSECONDS);
+    }
+}
+
+bool AsyncJobManager::ExecutePendingJob()
+{
+    int workerIndex = GetCurrentWorkerIndex();
+
+    AsyncJob* job = FetchJob(workerIndex, GetStealSeed(workerIndex));
+    if (!job)
+        return false;
+
+    ExecuteJob(job);
+    return true;
+}
+
+void AsyncJobManager::SubmitJobList(AsyncJobList* InJobList)
+{
+    if (!InJobList->NumPendingJobs)
+    {
+        return;
+    }
+
+    AsyncJob* headJob = &InJobList->JobPool[InJobList->JobPool.Size() - InJobList->NumPendingJobs];
+
+    SubmitJobs(headJob, InJobList->NumPendingJobs, InJobList->Counter);
+
+    InJobList->NumPendingJobs = 0;
 }
 
 AsyncJobList::AsyncJobList()
@@ -209,7 +436,7 @@ void AsyncJobList::SetMaxParallelJobs(int _MaxParallelJobs)
     HK_ASSERT(JobPool.IsEmpty());
 
     JobPool.Clear();
-    JobPool.Reserve(_MaxParallelJobs);    
+    JobPool.Reserve(_MaxParallelJobs);
 }
 
 void AsyncJobList::AddJob(void (*_Callback)(void*), void* _Data)
@@ -223,10 +450,9 @@ void AsyncJobList::AddJob(void (*_Callback)(void*), void* _Data)
     }
 
     AsyncJob& job = JobPool.Add();
-    job.Callback   = _Callback;
-    job.Data       = _Data;
-    job.Next       = JobList;
-    JobList        = &job;
+    job.Callback  = _Callback;
+    job.Data      = _Data;
+    job.Counter   = &Counter;
     NumPendingJobs++;
 }
 
@@ -235,62 +461,19 @@ void AsyncJobList::Submit()
     JobManager->SubmitJobList(this);
 }
 
-void AsyncJobManager::SubmitJobList(AsyncJobList* InJobList)
-{
-    if (!InJobList->NumPendingJobs)
-    {
-        return;
-    }
-
-    AsyncJob* headJob = &InJobList->JobPool[InJobList->JobPool.Size() - InJobList->NumPendingJobs];
-    HK_ASSERT(headJob->Next == nullptr);
-
-    // lock section
-    {
-        MutexGuard syncGuard(InJobList->SubmitSync);
-
-        headJob->Next            = InJobList->SubmittedJobs;
-        InJobList->SubmittedJobs = InJobList->JobList;
-
-        InJobList->SubmittedJobsCount.Add(InJobList->NumPendingJobs);
-        InJobList->FetchCount.Add(InJobList->NumPendingJobs);
-
-        TotalJobs.Add(InJobList->NumPendingJobs);
-
-        InJobList->bSignalled = false;
-    }
-
-    NotifyThreads();
-    InJobList->JobList        = nullptr;
-    InJobList->NumPendingJobs = 0;
-}
-
 void AsyncJobList::Wait()
 {
     int jobsCount = JobPool.Size() - NumPendingJobs;
 
     if (jobsCount > 0)
     {
-        while (!bSignalled)
-        {
-            EventDone.Wait();
-        }
-
-        HK_ASSERT(SubmittedJobsCount.Load() == 0);
-        HK_ASSERT(FetchCount.Load() == 0);
-        HK_ASSERT(SubmittedJobs == nullptr);
+        JobManager->WaitForCounter(Counter);
 
         if (NumPendingJobs > 0)
         {
             LOG("Warning: AsyncJobList::Wait: NumPendingJobs > 0\n");
 
             JobPool.RemoveRange(0, jobsCount);
-
-            JobList = JobPool.ToPtr() + size_t(NumPendingJobs - 1);
-            for (int i = 1; i < NumPendingJobs; i++)
-            {
-                JobPool[i].Next = &JobPool[i - 1];
-            }
         }
         else
         {
@@ -305,42 +488,4 @@ void AsyncJobList::SubmitAndWait()
     Wait();
 }
 
-//void FirstJob( void * _Data ) {
-//    for ( int i = 0 ; i < 32 ; i++ ) {
-//        GLogger.Printf( "FirstJob: Processing %d (%d) th %d\n", (size_t)_Data&0xf, i, (size_t)_Data>>16 );
-//        Thread::WaitMilliseconds(1);
-//    }
-//}
-
-//void SecondJob( void * _Data ) {
-//    for ( int i = 0 ; i < 32 ; i++ ) {
-//        GLogger.Printf( "SecondJob: Processing %d (%d) th %d\n", (size_t)_Data&0xf, i, (size_t)_Data>>16 );
-//        Thread::WaitMilliseconds(1);
-//    }
-//}
-
-//void AsyncJobManagerTest() {
-
-//    AsyncJobManager jobManager;
-
-//    jobManager.Initialize( 4, 2 );
-
-//    AsyncJobList * first = jobManager.GetAsyncJobList( 0 );
-//    AsyncJobList * second = jobManager.GetAsyncJobList( 1 );
-
-//    first->AddJob( FirstJob, ( void * )0 );
-//    first->AddJob( FirstJob, ( void * )1 );
-
-//    second->AddJob( SecondJob, ( void * )0 );
-//    second->AddJob( SecondJob, ( void * )1 );
-
-//    first->Submit();
-//    second->Submit();
-
-//    first->Wait();
-//    second->Wait();
-
-//    jobManager.Deinitialize();
-//}
-
 HK_NAMESPACE_END
@@ -27,30 +27,86 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 
 */
-
 #pragma once
 
 #include "Containers/Vector.h"
+#include "Containers/PodQueue.h"
+#include "Containers/WorkStealingDeque.h"
 #include "Ref.h"
 
 HK_NAMESPACE_BEGIN
 
 //#define HK_ACTIVE_THREADS_COUNTERS
 
-/** Job for job list */
+/**
+
+AsyncJobCounter
+
+Counts unfinished jobs. Jobs attached to a counter decrement it when they are done, so a thread can
+wait for exactly the jobs it is interested in. A counter may have a parent: the parent is incremented
+when the counter becomes non-zero and decremented when it drops back to zero, so waiting on the parent
+also waits for all child groups.
+
+*/
+class AsyncJobCounter final : public Noncopyable
+{
+public:
+    explicit AsyncJobCounter(AsyncJobCounter* parent = nullptr) :
+        m_Parent(parent)
+    {}
+
+    ~AsyncJobCounter()
+    {
+        HK_ASSERT(m_Count.Load() == 0);
+    }
+
+    /** Add pending jobs to the counter */
+    void Add(int count);
+
+    /** Mark one job as finished */
+    void Decrement();
+
+    /** Number of unfinished jobs */
+    int GetCount() const { return m_Count.Load(); }
+
+    bool IsDone() const { return m_Count.Load() == 0; }
+
+    AsyncJobCounter* GetParent() const { return m_Parent; }
+
+private:
+    AtomicInt        m_Count{0};
+    AsyncJobCounter* m_Parent;
+};
+
+HK_FORCEINLINE void AsyncJobCounter::Add(int count)
+{
+    HK_ASSERT(count > 0);
+    if (m_Count.FetchAdd(count) == 0 && m_Parent)
+        m_Parent->Add(1);
+}
+
+HK_FORCEINLINE void AsyncJobCounter::Decrement()
+{
+    // Keep parent on the stack: the counter may be destroyed by the waiting thread right after it reaches zero.
+    AsyncJobCounter* parent = m_Parent;
+    if (m_Count.Decrement() == 0 && parent)
+        parent->Decrement();
+}
+
+/** Job. The memory of the job is owned by the caller and must stay valid until the job is done. */
 struct AsyncJob
 {
     /** Callback for the job */
     void (*Callback)(void*);
     /** Data that will be passed for the job */
     void* Data;
-    /** Pointer to the next job in job list */
-    AsyncJob* Next;
+    /** Counter that will be decremented when the job is done (optional) */
+    AsyncJobCounter* Counter;
 };
 
 class AsyncJobManager;
 
-/** Job list */
+/** Job list. Adapter over the job manager that owns a pool of jobs and waits for all of them at once. */
 class AsyncJobList final : public Noncopyable
 {
     friend class AsyncJobManager;
@@ -68,7 +124,7 @@ public:
     /** Submit jobs to worker threads */
     void Submit();
 
-    /** Block current thread while jobs are in working threads */
+    /** Block current thread while jobs are in working threads. The calling thread helps to execute jobs. */
     void Wait();
 
     /** Submit jobs to worker threads and block current thread while jobs are in working threads */
@@ -81,18 +137,9 @@ private:
     AsyncJobManager* JobManager{nullptr};
 
     SmallVector<AsyncJob, 1024> JobPool;
-    AsyncJob*                    JobList{nullptr};
-    int                          NumPendingJobs{0};
+    int                         NumPendingJobs{0};
 
-    AsyncJob* SubmittedJobs{nullptr};
-    Mutex     SubmitSync;
-
-    AtomicInt SubmittedJobsCount{0};
-    AtomicInt FetchCount{0};
-    //AtomicInt FetchLock{0};
-
-    SyncEvent EventDone;
-    bool      bSignalled{false}; // FIXME: must be atomic?
+    AsyncJobCounter Counter;
 };
 
 HK_FORCEINLINE int AsyncJobList::GetMaxParallelJobs() const
@@ -100,18 +147,53 @@ HK_FORCEINLINE int AsyncJobList::GetMaxParallelJobs() const
     return JobPool.Capacity();
 }
 
-/** Job manager */
+/**
+
+AsyncJobManager
+
+Work-stealing job scheduler. Each worker thread owns a Chase-Lev deque: it pushes and pops jobs at the
+bottom without locks, idle workers steal from the top of other workers' deques. Threads that are not
+workers of the manager (e.g. the main thread) submit through a shared injection queue, which workers
+drain in batches. Waiting threads execute jobs while the counter they wait on is not zero.
+
+*/
 class AsyncJobManager final : public Noncopyable
 {
 public:
-    static constexpr int MAX_WORKER_THREADS = 4;
+    static constexpr int MAX_WORKER_THREADS = 64;
     static constexpr int MAX_JOB_LISTS      = 4;
 
-    /** Initialize job manager. Set worker threads count and create job lists */
+    /** Max jobs that can be queued by one worker thread before it starts to execute new jobs inline */
+    static constexpr int WORKER_QUEUE_SIZE = 4096;
+
+    /** Initialize job manager. Set worker threads count and create job lists. Pass _NumWorkerThreads <= 0 to pick the count from the hardware. */
     AsyncJobManager(int _NumWorkerThreads, int _NumJobLists);
 
     ~AsyncJobManager();
 
+    /** Number of worker threads to use on this machine: one per hardware thread, except the calling (main) thread. */
+    static int GetDefaultNumWorkerThreads();
+
+    /** Submit jobs. Counter is incremented by the number of jobs. Jobs must stay valid until the counter is done. */
+    void SubmitJobs(AsyncJob* jobs, int count, AsyncJobCounter& counter);
+
+    /** Submit single job */
+    void SubmitJob(AsyncJob& job, AsyncJobCounter& counter)
+    {
+        SubmitJobs(&job, 1, counter);
+    }
+
+    /** Block current thread until the counter reaches zero. The calling thread executes pending jobs meanwhile. */
+    void WaitForCounter(AsyncJobCounter const& counter);
+
+    /** Execute one pending job on the calling thread. Returns false if there was nothing to execute. */
+    bool ExecutePendingJob();
+
+    /** Split [0, count) into ranges of at least minBatchSize elements and call function(first, last) for each range
+    on worker threads. Blocks until all ranges are processed, the calling thread takes part in the work. */
+    template <typename Function>
+    void ParallelFor(uint32_t count, uint32_t minBatchSize, Function const& function);
+
     void SubmitJobList(AsyncJobList* InJobList);
 
     /** Wakeup worker threads for the new jobs */
@@ -127,6 +209,9 @@ public:
     /** Get worker threads count */
     int GetNumWorkerThreads() const { return NumWorkerThreads; }
 
+    /** Index of the current worker thread or -1 if the current thread is not a worker of this manager */
+    int GetCurrentWorkerIndex() const;
+
 #ifdef HK_ACTIVE_THREADS_COUNTERS
     int GetNumActiveThreads() const
     {
@@ -135,23 +220,105 @@ public:
 #endif
 
 private:
+    struct alignas(64) Worker
+    {
+        WorkStealingDeque<AsyncJob, WORKER_QUEUE_SIZE> Queue;
+        Thread    WorkerThread;
+        SyncEvent EventNotify;
+        AtomicBool bSleeping{false};
+        uint32_t   StealSeed{0};
+    };
+
     void WorkerThreadRoutine(int _ThreadId);
 
-    Thread WorkerThread[MAX_WORKER_THREADS];
-    int    NumWorkerThreads{0};
+    /** Wakeup up to count sleeping workers */
+    void WakeWorkers(int count);
+
+    AsyncJob* FetchJob(int workerIndex, uint32_t& stealSeed);
+
+    AsyncJob* FetchGlobalJobs(int workerIndex);
+
+    uint32_t& GetStealSeed(int workerIndex);
+
+    static void ExecuteJob(AsyncJob* job);
+
+    Worker* Workers{nullptr};
+    int     NumWorkerThreads{0};
 
 #ifdef HK_ACTIVE_THREADS_COUNTERS
     AtomicInt NumActiveThreads{0};
 #endif
 
-    SyncEvent EventNotify[MAX_WORKER_THREADS];
+    // Jobs submitted from non-worker threads
+    Mutex                          GlobalQueueSync;
+    PodQueue<AsyncJob*, 1024, true> GlobalQueue;
+    AtomicInt                      NumGlobalJobs{0};
+
+    AtomicInt NumSleepingWorkers{0};
 
     AsyncJobList JobList[MAX_JOB_LISTS];
     int          NumJobLists{0};
 
-    AtomicInt TotalJobs{0};
-
-    bool bTerminated{false};
+    AtomicBool bTerminated{false};
 };
 
+template <typename Function>
+HK_INLINE void AsyncJobManager::ParallelFor(uint32_t count, uint32_t minBatchSize, Function const& function)
+{
+    if (count == 0)
+        return;
+
+    if (minBatchSize == 0)
+        minBatchSize = 1;
+
+    // A few ranges per thread give the work stealing something to balance
+    uint32_t maxRanges = uint32_t(NumWorkerThreads + 1) * 4;
+    uint32_t numRanges = (count + minBatchSize - 1) / minBatchSize;
+    if (numRanges > maxRanges)
+        numRanges = maxRanges;
+
+    if (numRanges <= 1)
+    {
+        function(0u, count);
+        return;
+    }
+
+    struct Range
+    {
+        Function const* Func;
+        uint32_t        First;
+        uint32_t        Last;
+    };
+
+    SmallVector<Range, 64>    ranges;
+    SmallVector<AsyncJob, 64> jobs;
+
+    ranges.Resize(numRanges);
+    jobs.Resize(numRanges);
+
+    uint32_t step      = count / numRanges;
+    uint32_t remainder = count % numRanges;
+    uint32_t first     = 0;
+    for (uint32_t i = 0; i < numRanges; i++)
+    {
+        uint32_t size = i < remainder ? step + 1 : step;
+
+        ranges[i].Func  = &function;
+        ranges[i].First = first;
+        ranges[i].Last  = first + size;
+        first += size;
+
+        jobs[i].Callback = [](void* data)
+        {
+            Range* range = static_cast<Range*>(data);
+            (*range->Func)(range->First, range->Last);
+        };
+        jobs[i].Data = &ranges[i];
+    }
+
+    AsyncJobCounter counter;
+    SubmitJobs(jobs.ToPtr(), numRanges, counter);
+    WaitForCounter(counter);
+}
+
 HK_NAMESPACE_END
@@ -494,7 +494,7 @@ public:
     {
         using ElementType = typename T::ValueType;
 
-        static_assert(sizeof(ElementType) == 4 || sizeof(ElementType) == 8, "Unsupported integer");
+        static_assert(sizeof(ElementType) == 1 || sizeof(ElementType) == 2 || sizeof(ElementType) == 4 || sizeof(ElementType) == 8, "Unsupported integer");
 
         WriteUInt32(Array.Size());
 
@@ -0,0 +1,213 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <Engine/Core/BaseTypes.h>
+
+#include <atomic>
+#include <new>
+
+HK_NAMESPACE_BEGIN
+
+/**
+
+MPSCQueue
+
+Unbounded lock-free multi-producer single-consumer queue.
+
+Push can be called from any thread, TryPop only from the consumer thread.
+Every push allocates a node. Based on Dmitry Vyukov's non-intrusive MPSC node-based queue.
+A producer preempted in the middle of Push can briefly hide the elements pushed after it from the consumer.
+
+*/
+template <typename T>
+class MPSCQueue final : public Noncopyable
+{
+public:
+    using ValueType = T;
+
+    MPSCQueue()
+    {
+        Node* stub = new Node;
+        m_Head.store(stub, std::memory_order_relaxed);
+        m_Tail = stub;
+    }
+
+    ~MPSCQueue()
+    {
+        T value;
+        while (TryPop(value))
+        {}
+        delete m_Tail;
+    }
+
+    void Push(T const& value)
+    {
+        Node* node = new Node;
+        new (node->Storage) T(value);
+        PushNode(node);
+    }
+
+    void Push(T&& value)
+    {
+        Node* node = new Node;
+        new (node->Storage) T(std::move(value));
+        PushNode(node);
+    }
+
+    /** Consumer thread only. */
+    bool TryPop(T& value)
+    {
+        Node* tail = m_Tail;
+        Node* next = tail->Next.load(std::memory_order_acquire);
+        if (!next)
+            return false;
+
+        // The next node becomes the new stub, so its value is moved out and destroyed here
+        T* nextValue = next->GetValue();
+        value = std::move(*nextValue);
+        nextValue->~T();
+
+        m_Tail = next;
+        delete tail;
+        return true;
+    }
+
+    /** Consumer thread only. */
+    bool IsEmpty() const
+    {
+        return m_Tail->Next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> Next{nullptr};
+        alignas(T) byte Storage[sizeof(T)];
+
+        T* GetValue()
+        {
+            return std::launder(reinterpret_cast<T*>(Storage));
+        }
+    };
+
+    void PushNode(Node* node)
+    {
+        Node* prev = m_Head.exchange(node, std::memory_order_acq_rel);
+        prev->Next.store(node, std::memory_order_release);
+    }
+
+    // Head is written by producers, tail by the consumer
+    alignas(64) std::atomic<Node*> m_Head;
+    alignas(64) Node* m_Tail;
+};
+
+/**
+
+BoundedMPSCQueue
+
+Bounded lock-free multi-producer single-consumer ring buffer. Does not allocate.
+
+TryPush can be called from any thread and fails when the queue is full, TryPop only from the consumer thread.
+Based on Dmitry Vyukov's bounded MPMC queue with the consumer side simplified.
+
+*/
+template <typename T, uint32_t Capacity = 1024>
+class BoundedMPSCQueue final : public Noncopyable
+{
+public:
+    static_assert(IsPowerOfTwo(Capacity), "Queue capacity must be power of two");
+
+    using ValueType = T;
+
+    BoundedMPSCQueue()
+    {
+        for (uint32_t i = 0; i < Capacity; i++)
+            m_Cells[i].Sequence.store(i, std::memory_order_relaxed);
+    }
+
+    /** Returns false if the queue is full. */
+    bool TryPush(T const& value)
+    {
+        Cell* cell;
+        uint32_t pos = m_EnqueuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell = &m_Cells[pos & (Capacity - 1)];
+            uint32_t sequence = cell->Sequence.load(std::memory_order_acquire);
+            int32_t diff = int32_t(sequence - pos);
+            if (diff == 0)
+            {
+                if (m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // Full
+                return false;
+            }
+            else
+            {
+                pos = m_EnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->Value = value;
+        cell->Sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer thread only. */
+    bool TryPop(T& value)
+    {
+        Cell* cell = &m_Cells[m_DequeuePos & (Capacity - 1)];
+        if (cell->Sequence.load(std::memory_order_acquire) != m_DequeuePos + 1)
+            return false;
+
+        value = std::move(cell->Value);
+        cell->Sequence.store(m_DequeuePos + Capacity, std::memory_order_release);
+        m_DequeuePos++;
+        return true;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<uint32_t> Sequence;
+        T Value;
+    };
+
+    alignas(64) std::atomic<uint32_t> m_EnqueuePos{0};
+    alignas(64) uint32_t m_DequeuePos{0};
+    alignas(64) Cell m_Cells[Capacity];
+};
+
+HK_NAMESPACE_END
@@ -32,6 +32,7 @@ SOFTWARE.
 
 #include <Engine/Core/Handle.h>
 #include <Engine/Core/Allocators/PageAllocator.h>
+#include <Engine/Core/AsyncJobManager.h>
 
 HK_NAMESPACE_BEGIN
 
@@ -87,6 +88,11 @@ public:
     template <typename Visitor>
     void            IterateBatches(Visitor& visitor) const;
 
+    /// Visit batches on worker threads. Visitor::Visit(T* batch, uint32_t count) is called concurrently,
+    /// so it must not touch shared state without synchronization. The storage must not be modified until it returns.
+    template <typename Visitor>
+    void            ParallelIterateBatches(Visitor& visitor, AsyncJobManager& jobManager);
+
     struct Iterator
     {
     private:
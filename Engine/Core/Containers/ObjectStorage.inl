@@ -404,6 +404,38 @@ HK_FORCEINLINE void ObjectStorage<T, PageSize, StorageType>::IterateBatches(Visi
     const_cast<ObjectStorage<T, PageSize, StorageType>*>(this)->_IterateBatches<Visitor, true>(visitor);
 }
 
+template <typename T, uint32_t PageSize, ObjectStorageType StorageType>
+template <typename Visitor>
+HK_INLINE void ObjectStorage<T, PageSize, StorageType>::ParallelIterateBatches(Visitor& visitor, AsyncJobManager& jobManager)
+{
+    struct Batch
+    {
+        T*          Data;
+        uint32_t    Count;
+    };
+
+    struct BatchGatherer
+    {
+        SmallVector<Batch, 64> Batches;
+
+        HK_FORCEINLINE void Visit(T* data, uint32_t count)
+        {
+            Batches.Add({data, count});
+        }
+    };
+
+    BatchGatherer gatherer;
+    _IterateBatches<BatchGatherer, false>(gatherer);
+
+    auto& batches = gatherer.Batches;
+    jobManager.ParallelFor(batches.Size(), 1,
+        [&visitor, &batches](uint32_t first, uint32_t last)
+        {
+            for (uint32_t i = first; i < last; ++i)
+                visitor.Visit(batches[i].Data, batches[i].Count);
+        });
+}
+
 template <typename T, uint32_t PageSize, ObjectStorageType StorageType>
 HK_FORCEINLINE typename ObjectStorage<T, PageSize, StorageType>::Iterator ObjectStorage<T, PageSize, StorageType>::GetObjects()
 {
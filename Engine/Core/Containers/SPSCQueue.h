@@ -0,0 +1,107 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <Engine/Core/BaseTypes.h>
+
+#include <atomic>
+
+HK_NAMESPACE_BEGIN
+
+/**
+
+SPSCQueue
+
+Bounded lock-free single-producer single-consumer ring buffer. Does not allocate.
+
+Each side keeps a cached copy of the other side's index, so the shared cache lines
+are touched only when the queue looks full or empty.
+
+*/
+template <typename T, uint32_t Capacity = 1024>
+class SPSCQueue final : public Noncopyable
+{
+public:
+    static_assert(IsPowerOfTwo(Capacity), "Queue capacity must be power of two");
+
+    using ValueType = T;
+
+    /** Producer thread only. Returns false if the queue is full. */
+    bool TryPush(T const& value)
+    {
+        uint32_t head = m_Head.load(std::memory_order_relaxed);
+        if (head - m_CachedTail == Capacity)
+        {
+            m_CachedTail = m_Tail.load(std::memory_order_acquire);
+            if (head - m_CachedTail == Capacity)
+                return false;
+        }
+
+        m_Data[head & (Capacity - 1)] = value;
+        m_Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer thread only. */
+    bool TryPop(T& value)
+    {
+        uint32_t tail = m_Tail.load(std::memory_order_relaxed);
+        if (tail == m_CachedHead)
+        {
+            m_CachedHead = m_Head.load(std::memory_order_acquire);
+            if (tail == m_CachedHead)
+                return false;
+        }
+
+        value = std::move(m_Data[tail & (Capacity - 1)]);
+        m_Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer thread only. */
+    bool IsEmpty() const
+    {
+        return m_Tail.load(std::memory_order_relaxed) == m_Head.load(std::memory_order_acquire);
+    }
+
+private:
+    // Producer side
+    alignas(64) std::atomic<uint32_t> m_Head{0};
+    uint32_t m_CachedTail{0};
+
+    // Consumer side
+    alignas(64) std::atomic<uint32_t> m_Tail{0};
+    uint32_t m_CachedHead{0};
+
+    alignas(64) T m_Data[Capacity];
+};
+
+HK_NAMESPACE_END
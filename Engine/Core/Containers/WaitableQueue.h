@@ -32,36 +32,64 @@ SOFTWARE.
 
 #include <Engine/Core/Thread.h>
 
-#include <queue>
-
 HK_NAMESPACE_BEGIN
 
-template <typename T>
-class ThreadSafeQueue
+/**
+
+WaitableQueue
+
+Adds wait/notify to a single-consumer queue (MPSCQueue, BoundedMPSCQueue, SPSCQueue).
+Producers signal an event after pushing, so the consumer can sleep while the queue is empty.
+
+*/
+template <typename Queue>
+class WaitableQueue final : public Noncopyable
 {
 public:
-    void Push(T const& v)
+    using ValueType = typename Queue::ValueType;
+
+    void Push(ValueType const& value)
     {
-        MutexGuard lock(m_Mutex);
-        m_Data.push(v);
+        m_Queue.Push(value);
+        m_Event.Signal();
     }
 
-    bool TryPop(T& v)
+    bool TryPush(ValueType const& value)
     {
-        MutexGuard lock(m_Mutex);
-
-        if (m_Data.empty())
+        if (!m_Queue.TryPush(value))
             return false;
+        m_Event.Signal();
+        return true;
+    }
 
-        v = std::move(m_Data.front());
-        m_Data.pop();
+    /** Consumer thread only. */
+    bool TryPop(ValueType& value)
+    {
+        return m_Queue.TryPop(value);
+    }
 
-        return true;
+    /** Consumer thread only. Blocks until an element is available. */
+    void WaitPop(ValueType& value)
+    {
+        while (!m_Queue.TryPop(value))
+            m_Event.Wait();
+    }
+
+    /** Consumer thread only. Blocks until something is pushed or Notify is called. */
+    void Wait()
+    {
+        m_Event.Wait();
+    }
+
+    /** Wakes up the consumer. */
+    void Notify()
+    {
+        m_Event.Signal();
     }
 
 private:
-    std::queue<T> m_Data;
-    Mutex m_Mutex;
+    Queue m_Queue;
+    SyncEvent m_Event;
 };
 
 HK_NAMESPACE_END
@@ -0,0 +1,138 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#pragma once
+
+#include <Engine/Core/BaseTypes.h>
+
+#include <atomic>
+
+HK_NAMESPACE_BEGIN
+
+/**
+
+WorkStealingDeque
+
+Bounded Chase-Lev work-stealing deque of pointers.
+
+The owner thread pushes and pops at the bottom (LIFO), any other thread may steal from the top (FIFO).
+Based on "Correct and Efficient Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Nardelli, 2013).
+Memory orders matter here, so std::atomic is used directly instead of Hk::Atomic.
+
+*/
+template <typename T, int64_t Capacity = 4096>
+class WorkStealingDeque final : public Noncopyable
+{
+public:
+    static_assert(IsPowerOfTwo(Capacity), "Deque capacity must be power of two");
+
+    WorkStealingDeque()
+    {
+        for (auto& slot : m_Slots)
+            slot.store(nullptr, std::memory_order_relaxed);
+    }
+
+    /** Push to the bottom. Owner thread only. Returns false if the deque is full. */
+    bool Push(T* value)
+    {
+        int64_t b = m_Bottom.load(std::memory_order_relaxed);
+        int64_t t = m_Top.load(std::memory_order_acquire);
+
+        if (b - t >= Capacity)
+            return false;
+
+        m_Slots[b & (Capacity - 1)].store(value, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_Bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /** Pop from the bottom. Owner thread only. */
+    T* Pop()
+    {
+        int64_t b = m_Bottom.load(std::memory_order_relaxed) - 1;
+        m_Bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_Top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            // Empty
+            m_Bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T* value = m_Slots[b & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // Last element, race against thieves
+            if (!m_Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                value = nullptr;
+            m_Bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    /** Steal from the top. Can be called from any thread. Returns nullptr if empty or if lost the race. */
+    T* Steal()
+    {
+        int64_t t = m_Top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = m_Bottom.load(std::memory_order_acquire);
+
+        if (t >= b)
+            return nullptr;
+
+        T* value = m_Slots[t & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (!m_Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return value;
+    }
+
+    /** Approximate number of elements. */
+    int64_t SizeApprox() const
+    {
+        int64_t b = m_Bottom.load(std::memory_order_relaxed);
+        int64_t t = m_Top.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+
+    bool IsEmptyApprox() const
+    {
+        return SizeApprox() == 0;
+    }
+
+private:
+    // Keep top and bottom on separate cache lines: top is written by thieves, bottom by the owner.
+    alignas(64) std::atomic<int64_t> m_Top{0};
+    alignas(64) std::atomic<int64_t> m_Bottom{0};
+    alignas(64) std::atomic<T*> m_Slots[Capacity];
+};
+
+HK_NAMESPACE_END
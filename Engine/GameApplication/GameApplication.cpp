@@ -191,7 +191,7 @@ GameApplication::GameApplication(ArgumentPack const& args, StringView title) :
     if (!m_EmbeddedArchive)
         LOG("Failed to open embedded resources\n");
 
-    int jobManagerThreadCount = Thread::NumHardwareThreads ? Math::Min(Thread::NumHardwareThreads, AsyncJobManager::MAX_WORKER_THREADS) : AsyncJobManager::MAX_WORKER_THREADS;
+    int jobManagerThreadCount = AsyncJobManager::GetDefaultNumWorkerThreads();
     m_AsyncJobManager = MakeUnique<AsyncJobManager>(jobManagerThreadCount, MAX_RUNTIME_JOB_LISTS);
     m_RenderFrontendJobList = m_AsyncJobManager->GetAsyncJobList(RENDER_FRONTEND_JOB_LIST);
     //pRenderBackendJobList  = m_AsyncJobManager->GetAsyncJobList(RENDER_BACKEND_JOB_LIST);
@@ -666,7 +666,12 @@ void GameApplication::TakeScreenshot()
 
 World* GameApplication::CreateWorld()
 {
-    auto* world = new World;
+    return CreateWorld(WorldSettings{});
+}
+
+World* GameApplication::CreateWorld(WorldSettings const& settings)
+{
+    auto* world = new World(settings);
     m_Worlds.Add(world);
     return world;
 }
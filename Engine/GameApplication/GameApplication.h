@@ -48,6 +48,7 @@ SOFTWARE.
 HK_NAMESPACE_BEGIN
 
 class World;
+struct WorldSettings;
 class AsyncJobManager;
 class AsyncJobList;
 class AudioDevice;
@@ -60,6 +61,7 @@ public:
     ~GameApplication();
 
     World* CreateWorld();
+    World* CreateWorld(WorldSettings const& settings);
 
     void DestroyWorld(World* world);
 
@@ -158,6 +160,11 @@ public:
         return *static_cast<GameApplication*>(Instance())->m_RenderBackend.RawPtr();
     }
 
+    static AsyncJobManager& GetAsyncJobManager()
+    {
+        return *static_cast<GameApplication*>(Instance())->m_AsyncJobManager.RawPtr();
+    }
+
     static AsyncJobList* GetRenderFrontendJobList()
     {
         return static_cast<GameApplication*>(Instance())->m_RenderFrontendJobList;
@@ -0,0 +1,526 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "AnimationCompression.h"
+#include "Skinning.h"
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+HK_NAMESPACE_BEGIN
+
+namespace
+{
+
+constexpr uint16_t INVALID_CHANNEL = 0xffff;
+
+// Tracks are decoded in groups of four
+constexpr int GROUP_SIZE = 4;
+
+// Smallest three components of normalized quaternion are in range [-1/sqrt(2), 1/sqrt(2)]
+constexpr float SMALLEST_THREE_RANGE = 0.70710678f;
+constexpr float SMALLEST_THREE_MAX = 32767;
+
+constexpr float RANGE_MAX = 65535;
+
+HK_FORCEINLINE bool IsNearlyEqual(Float3 const& a, Float3 const& b, float tolerance)
+{
+    return Math::Abs(a.X - b.X) <= tolerance && Math::Abs(a.Y - b.Y) <= tolerance && Math::Abs(a.Z - b.Z) <= tolerance;
+}
+
+HK_FORCEINLINE bool IsNearlyEqual(Quat const& a, Quat b, float tolerance)
+{
+    // q and -q represent the same rotation
+    if (a.X * b.X + a.Y * b.Y + a.Z * b.Z + a.W * b.W < 0.0f)
+        b = -b;
+
+    return Math::Abs(a.X - b.X) <= tolerance && Math::Abs(a.Y - b.Y) <= tolerance && Math::Abs(a.Z - b.Z) <= tolerance && Math::Abs(a.W - b.W) <= tolerance;
+}
+
+// Same interpolation as the decoder uses
+Quat NLerp(Quat const& a, Quat b, float t)
+{
+    if (a.X * b.X + a.Y * b.Y + a.Z * b.Z + a.W * b.W < 0.0f)
+        b = -b;
+
+    Quat q;
+    q.X = Math::Lerp(a.X, b.X, t);
+    q.Y = Math::Lerp(a.Y, b.Y, t);
+    q.Z = Math::Lerp(a.Z, b.Z, t);
+    q.W = Math::Lerp(a.W, b.W, t);
+    q.NormalizeSelf();
+    return q;
+}
+
+void EncodeSmallestThree(Quat const& q, uint16_t* out, int stride)
+{
+    const float components[4] = {q.X, q.Y, q.Z, q.W};
+
+    int largest = 0;
+    for (int i = 1; i < 4; i++)
+    {
+        if (Math::Abs(components[i]) > Math::Abs(components[largest]))
+            largest = i;
+    }
+
+    // Largest component is restored as positive
+    const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+    uint32_t quantized[3];
+    int n = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        if (i == largest)
+            continue;
+
+        float v = Math::Clamp((components[i] * sign + SMALLEST_THREE_RANGE) / (2 * SMALLEST_THREE_RANGE), 0.0f, 1.0f);
+        quantized[n++] = (uint32_t)Math::Round(v * SMALLEST_THREE_MAX);
+    }
+
+    // Index of the largest component is stored in the high bits of the first two values
+    out[0] = quantized[0] | ((largest >> 1) << 15);
+    out[stride] = quantized[1] | ((largest & 1) << 15);
+    out[stride * 2] = quantized[2];
+}
+
+HK_FORCEINLINE uint16_t QuantizeRange(float v, float min, float scale)
+{
+    return scale > 0.0f ? (uint16_t)Math::Clamp(Math::Round((v - min) / scale), 0.0f, RANGE_MAX) : 0;
+}
+
+HK_FORCEINLINE __m128i LoadLanes(uint16_t const* data)
+{
+    return _mm_unpacklo_epi16(_mm_loadl_epi64((__m128i const*)data), _mm_setzero_si128());
+}
+
+HK_FORCEINLINE __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+    // mask ? a : b
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+HK_FORCEINLINE void DecodeSmallestThree(uint16_t const* data, __m128& x, __m128& y, __m128& z, __m128& w)
+{
+    const __m128i valueMask = _mm_set1_epi32(0x7fff);
+    const __m128 scale = _mm_set1_ps(2 * SMALLEST_THREE_RANGE / SMALLEST_THREE_MAX);
+    const __m128 offset = _mm_set1_ps(SMALLEST_THREE_RANGE);
+
+    __m128i qa = LoadLanes(data);
+    __m128i qb = LoadLanes(data + GROUP_SIZE);
+    __m128i qc = LoadLanes(data + GROUP_SIZE * 2);
+
+    __m128i largest = _mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(qa, 15), 1), _mm_srli_epi32(qb, 15));
+
+    __m128 a = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(qa, valueMask)), scale), offset);
+    __m128 b = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(qb, valueMask)), scale), offset);
+    __m128 c = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(qc), scale), offset);
+
+    __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b)), _mm_mul_ps(c, c));
+    __m128 l = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), sum), _mm_setzero_ps()));
+
+    __m128 is0 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(0)));
+    __m128 is1 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(1)));
+    __m128 is2 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(2)));
+    __m128 is3 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(3)));
+
+    x = Select(is0, l, a);
+    y = Select(is0, a, Select(is1, l, b));
+    z = Select(_mm_or_ps(is0, is1), b, Select(is2, l, c));
+    w = Select(is3, l, c);
+}
+
+} // namespace
+
+void CompressedAnimation::Compress(int frameCount, Transform const* transforms, AnimationChannel const* channels, int channelsCount, AnimationCompressionSettings const& settings)
+{
+    HK_ASSERT(frameCount > 0);
+    HK_ASSERT(channelsCount < INVALID_CHANNEL);
+
+    m_FrameCount = frameCount;
+
+    m_ConstantTransforms.ResizeInvalidate(channelsCount);
+    m_RotationChannels.Clear();
+    m_PositionChannels.Clear();
+    m_ScaleChannels.Clear();
+
+    // Strip constant tracks
+    for (int channelIndex = 0; channelIndex < channelsCount; channelIndex++)
+    {
+        Transform const* frames = transforms + channels[channelIndex].TransformOffset;
+
+        m_ConstantTransforms[channelIndex] = frames[0];
+
+        bool bConstantRotation = true;
+        bool bConstantPosition = true;
+        bool bConstantScale = true;
+
+        for (int frameIndex = 1; frameIndex < frameCount; frameIndex++)
+        {
+            bConstantRotation = bConstantRotation && IsNearlyEqual(frames[frameIndex].Rotation, frames[0].Rotation, settings.RotationTolerance);
+            bConstantPosition = bConstantPosition && IsNearlyEqual(frames[frameIndex].Position, frames[0].Position, settings.PositionTolerance);
+            bConstantScale = bConstantScale && IsNearlyEqual(frames[frameIndex].Scale, frames[0].Scale, settings.PositionTolerance);
+        }
+
+        if (!bConstantRotation)
+            m_RotationChannels.Add(channelIndex);
+        if (!bConstantPosition)
+            m_PositionChannels.Add(channelIndex);
+        if (!bConstantScale)
+            m_ScaleChannels.Add(channelIndex);
+    }
+
+    // Checks that frames between two keys can be restored by interpolation
+    auto canInterpolate = [&](int firstFrame, int lastFrame)
+    {
+        for (int frameIndex = firstFrame + 1; frameIndex < lastFrame; frameIndex++)
+        {
+            float t = (float)(frameIndex - firstFrame) / (lastFrame - firstFrame);
+
+            for (uint16_t channelIndex : m_RotationChannels)
+            {
+                Transform const* frames = transforms + channels[channelIndex].TransformOffset;
+                if (!IsNearlyEqual(NLerp(frames[firstFrame].Rotation, frames[lastFrame].Rotation, t), frames[frameIndex].Rotation, settings.RotationTolerance))
+                    return false;
+            }
+            for (uint16_t channelIndex : m_PositionChannels)
+            {
+                Transform const* frames = transforms + channels[channelIndex].TransformOffset;
+                if (!IsNearlyEqual(Math::Lerp(frames[firstFrame].Position, frames[lastFrame].Position, t), frames[frameIndex].Position, settings.PositionTolerance))
+                    return false;
+            }
+            for (uint16_t channelIndex : m_ScaleChannels)
+            {
+                Transform const* frames = transforms + channels[channelIndex].TransformOffset;
+                if (!IsNearlyEqual(Math::Lerp(frames[firstFrame].Scale, frames[lastFrame].Scale, t), frames[frameIndex].Scale, settings.PositionTolerance))
+                    return false;
+            }
+        }
+        return true;
+    };
+
+    // Select keyframes. Keys are shared between all tracks.
+    m_KeyFrames.Clear();
+    m_KeyFrames.Add(0);
+    if (frameCount > 1)
+    {
+        int lastKey = 0;
+        for (int frameIndex = 1; frameIndex < frameCount - 1; frameIndex++)
+        {
+            if (!settings.bReduceKeyframes || !canInterpolate(lastKey, frameIndex + 1))
+            {
+                m_KeyFrames.Add(frameIndex);
+                lastKey = frameIndex;
+            }
+        }
+        m_KeyFrames.Add(frameCount - 1);
+    }
+
+    // Pad tracks to groups
+    while (m_RotationChannels.Size() % GROUP_SIZE)
+        m_RotationChannels.Add(INVALID_CHANNEL);
+    while (m_PositionChannels.Size() % GROUP_SIZE)
+        m_PositionChannels.Add(INVALID_CHANNEL);
+    while (m_ScaleChannels.Size() % GROUP_SIZE)
+        m_ScaleChannels.Add(INVALID_CHANNEL);
+
+    const int numKeys = m_KeyFrames.Size();
+
+    // Quantize rotations
+    {
+        const int numGroups = m_RotationChannels.Size() / GROUP_SIZE;
+
+        m_RotationData.Resize(numKeys * numGroups * 3 * GROUP_SIZE);
+        m_RotationData.ZeroMem();
+
+        for (int key = 0; key < numKeys; key++)
+        {
+            for (int lane = 0; lane < m_RotationChannels.Size(); lane++)
+            {
+                uint16_t channelIndex = m_RotationChannels[lane];
+                if (channelIndex == INVALID_CHANNEL)
+                    continue;
+
+                Transform const& transform = transforms[channels[channelIndex].TransformOffset + m_KeyFrames[key]];
+
+                int group = lane / GROUP_SIZE;
+                uint16_t* data = m_RotationData.ToPtr() + (key * numGroups + group) * 3 * GROUP_SIZE + lane % GROUP_SIZE;
+
+                EncodeSmallestThree(transform.Rotation, data, GROUP_SIZE);
+            }
+        }
+    }
+
+    // Quantize positions and scales in per-track range
+    auto quantizeVectors = [&](Vector<uint16_t> const& trackChannels, Float3 Transform::*member, Vector<float>& ranges, Vector<uint16_t>& data)
+    {
+        const int numGroups = trackChannels.Size() / GROUP_SIZE;
+
+        ranges.Resize(numGroups * 6 * GROUP_SIZE);
+        ranges.ZeroMem();
+
+        data.Resize(numKeys * numGroups * 3 * GROUP_SIZE);
+        data.ZeroMem();
+
+        for (int lane = 0; lane < trackChannels.Size(); lane++)
+        {
+            uint16_t channelIndex = trackChannels[lane];
+            if (channelIndex == INVALID_CHANNEL)
+                continue;
+
+            Transform const* frames = transforms + channels[channelIndex].TransformOffset;
+
+            Float3 mins = frames[m_KeyFrames[0]].*member;
+            Float3 maxs = mins;
+            for (int key = 1; key < numKeys; key++)
+            {
+                mins = Math::Min(mins, frames[m_KeyFrames[key]].*member);
+                maxs = Math::Max(maxs, frames[m_KeyFrames[key]].*member);
+            }
+
+            Float3 scale = (maxs - mins) / RANGE_MAX;
+
+            float* range = ranges.ToPtr() + (lane / GROUP_SIZE) * 6 * GROUP_SIZE + lane % GROUP_SIZE;
+            for (int component = 0; component < 3; component++)
+            {
+                range[component * GROUP_SIZE] = mins[component];
+                range[(component + 3) * GROUP_SIZE] = scale[component];
+            }
+
+            for (int key = 0; key < numKeys; key++)
+            {
+                Float3 const& v = frames[m_KeyFrames[key]].*member;
+
+                uint16_t* dst = data.ToPtr() + (key * numGroups + lane / GROUP_SIZE) * 3 * GROUP_SIZE + lane % GROUP_SIZE;
+                for (int component = 0; component < 3; component++)
+                {
+                    dst[component * GROUP_SIZE] = QuantizeRange(v[component], mins[component], scale[component]);
+                }
+            }
+        }
+    };
+
+    quantizeVectors(m_PositionChannels, &Transform::Position, m_PositionRanges, m_PositionData);
+    quantizeVectors(m_ScaleChannels, &Transform::Scale, m_ScaleRanges, m_ScaleData);
+
+    UpdateFrameToKey();
+}
+
+void CompressedAnimation::UpdateFrameToKey()
+{
+    m_FrameToKey.ResizeInvalidate(m_FrameCount);
+
+    int key = 0;
+    for (int frameIndex = 0; frameIndex < m_FrameCount; frameIndex++)
+    {
+        while (key + 1 < m_KeyFrames.Size() && m_KeyFrames[key + 1] <= frameIndex)
+            key++;
+
+        m_FrameToKey[frameIndex] = key;
+    }
+}
+
+void CompressedAnimation::Sample(float frame, Transform* outTransforms) const
+{
+    HK_ASSERT(!IsEmpty());
+
+    Core::Memcpy(outTransforms, m_ConstantTransforms.ToPtr(), sizeof(Transform) * m_ConstantTransforms.Size());
+
+    frame = Math::Clamp(frame, 0.0f, (float)(m_FrameCount - 1));
+
+    int key0 = m_FrameToKey[(int)frame];
+    int key1 = Math::Min(key0 + 1, (int)m_KeyFrames.Size() - 1);
+
+    float blend = 0;
+    if (key1 != key0)
+        blend = (frame - m_KeyFrames[key0]) / (float)(m_KeyFrames[key1] - m_KeyFrames[key0]);
+
+    if (blend < 0.0001f)
+        key1 = key0;
+
+    DecodeRotations(key0, key1, blend, outTransforms);
+    DecodeVectors(m_PositionChannels, m_PositionRanges, m_PositionData, key0, key1, blend, &Transform::Position, outTransforms);
+    DecodeVectors(m_ScaleChannels, m_ScaleRanges, m_ScaleData, key0, key1, blend, &Transform::Scale, outTransforms);
+}
+
+void CompressedAnimation::DecodeRotations(int key0, int key1, float blend, Transform* outTransforms) const
+{
+    const int numGroups = m_RotationChannels.Size() / GROUP_SIZE;
+
+    uint16_t const* data0 = m_RotationData.ToPtr() + key0 * numGroups * 3 * GROUP_SIZE;
+    uint16_t const* data1 = m_RotationData.ToPtr() + key1 * numGroups * 3 * GROUP_SIZE;
+
+    const __m128 vblend = _mm_set1_ps(blend);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    alignas(16) float x[GROUP_SIZE], y[GROUP_SIZE], z[GROUP_SIZE], w[GROUP_SIZE];
+
+    for (int group = 0; group < numGroups; group++)
+    {
+        __m128 x0, y0, z0, w0;
+        DecodeSmallestThree(data0 + group * 3 * GROUP_SIZE, x0, y0, z0, w0);
+
+        if (key1 != key0)
+        {
+            __m128 x1, y1, z1, w1;
+            DecodeSmallestThree(data1 + group * 3 * GROUP_SIZE, x1, y1, z1, w1);
+
+            // Take the shortest path
+            __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, x1), _mm_mul_ps(y0, y1)), _mm_add_ps(_mm_mul_ps(z0, z1), _mm_mul_ps(w0, w1)));
+            __m128 sign = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), signBit);
+
+            x1 = _mm_xor_ps(x1, sign);
+            y1 = _mm_xor_ps(y1, sign);
+            z1 = _mm_xor_ps(z1, sign);
+            w1 = _mm_xor_ps(w1, sign);
+
+            x0 = _mm_add_ps(x0, _mm_mul_ps(_mm_sub_ps(x1, x0), vblend));
+            y0 = _mm_add_ps(y0, _mm_mul_ps(_mm_sub_ps(y1, y0), vblend));
+            z0 = _mm_add_ps(z0, _mm_mul_ps(_mm_sub_ps(z1, z0), vblend));
+            w0 = _mm_add_ps(w0, _mm_mul_ps(_mm_sub_ps(w1, w0), vblend));
+
+            __m128 lengthSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, x0), _mm_mul_ps(y0, y0)), _mm_add_ps(_mm_mul_ps(z0, z0), _mm_mul_ps(w0, w0)));
+            __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSqr));
+
+            x0 = _mm_mul_ps(x0, invLength);
+            y0 = _mm_mul_ps(y0, invLength);
+            z0 = _mm_mul_ps(z0, invLength);
+            w0 = _mm_mul_ps(w0, invLength);
+        }
+
+        _mm_store_ps(x, x0);
+        _mm_store_ps(y, y0);
+        _mm_store_ps(z, z0);
+        _mm_store_ps(w, w0);
+
+        uint16_t const* channels = m_RotationChannels.ToPtr() + group * GROUP_SIZE;
+        for (int lane = 0; lane < GROUP_SIZE; lane++)
+        {
+            if (channels[lane] == INVALID_CHANNEL)
+                continue;
+
+            Quat& rotation = outTransforms[channels[lane]].Rotation;
+            rotation.X = x[lane];
+            rotation.Y = y[lane];
+            rotation.Z = z[lane];
+            rotation.W = w[lane];
+        }
+    }
+}
+
+void CompressedAnimation::DecodeVectors(Vector<uint16_t> const& channels, Vector<float> const& ranges, Vector<uint16_t> const& data, int key0, int key1, float blend, Float3 Transform::*member, Transform* outTransforms) const
+{
+    const int numGroups = channels.Size() / GROUP_SIZE;
+
+    uint16_t const* data0 = data.ToPtr() + key0 * numGroups * 3 * GROUP_SIZE;
+    uint16_t const* data1 = data.ToPtr() + key1 * numGroups * 3 * GROUP_SIZE;
+
+    const __m128 vblend = _mm_set1_ps(blend);
+
+    alignas(16) float values[3][GROUP_SIZE];
+
+    for (int group = 0; group < numGroups; group++)
+    {
+        float const* range = ranges.ToPtr() + group * 6 * GROUP_SIZE;
+
+        for (int component = 0; component < 3; component++)
+        {
+            __m128 mins = _mm_loadu_ps(range + component * GROUP_SIZE);
+            __m128 scale = _mm_loadu_ps(range + (component + 3) * GROUP_SIZE);
+
+            int offset = (group * 3 + component) * GROUP_SIZE;
+
+            __m128 v = _mm_add_ps(mins, _mm_mul_ps(_mm_cvtepi32_ps(LoadLanes(data0 + offset)), scale));
+
+            if (key1 != key0)
+            {
+                __m128 v1 = _mm_add_ps(mins, _mm_mul_ps(_mm_cvtepi32_ps(LoadLanes(data1 + offset)), scale));
+
+                v = _mm_add_ps(v, _mm_mul_ps(_mm_sub_ps(v1, v), vblend));
+            }
+
+            _mm_store_ps(values[component], v);
+        }
+
+        uint16_t const* groupChannels = channels.ToPtr() + group * GROUP_SIZE;
+        for (int lane = 0; lane < GROUP_SIZE; lane++)
+        {
+            if (groupChannels[lane] == INVALID_CHANNEL)
+                continue;
+
+            Float3& dst = outTransforms[groupChannels[lane]].*member;
+            dst.X = values[0][lane];
+            dst.Y = values[1][lane];
+            dst.Z = values[2][lane];
+        }
+    }
+}
+
+size_t CompressedAnimation::GetMemoryUsage() const
+{
+    return m_KeyFrames.Size() * sizeof(uint32_t) +
+        m_ConstantTransforms.Size() * sizeof(Transform) +
+        (m_RotationChannels.Size() + m_PositionChannels.Size() + m_ScaleChannels.Size()) * sizeof(uint16_t) +
+        (m_PositionRanges.Size() + m_ScaleRanges.Size()) * sizeof(float) +
+        (m_RotationData.Size() + m_PositionData.Size() + m_ScaleData.Size()) * sizeof(uint16_t);
+}
+
+void CompressedAnimation::Read(IBinaryStreamReadInterface& stream)
+{
+    m_FrameCount = stream.ReadUInt32();
+    stream.ReadArray(m_KeyFrames);
+    stream.ReadArray(m_ConstantTransforms);
+    stream.ReadArray(m_RotationChannels);
+    stream.ReadArray(m_PositionChannels);
+    stream.ReadArray(m_ScaleChannels);
+    stream.ReadArray(m_PositionRanges);
+    stream.ReadArray(m_ScaleRanges);
+    stream.ReadArray(m_RotationData);
+    stream.ReadArray(m_PositionData);
+    stream.ReadArray(m_ScaleData);
+
+    UpdateFrameToKey();
+}
+
+void CompressedAnimation::Write(IBinaryStreamWriteInterface& stream) const
+{
+    stream.WriteUInt32(m_FrameCount);
+    stream.WriteArray(m_KeyFrames);
+    stream.WriteArray(m_ConstantTransforms);
+    stream.WriteArray(m_RotationChannels);
+    stream.WriteArray(m_PositionChannels);
+    stream.WriteArray(m_ScaleChannels);
+    stream.WriteArray(m_PositionRanges);
+    stream.WriteArray(m_ScaleRanges);
+    stream.WriteArray(m_RotationData);
+    stream.WriteArray(m_PositionData);
+    stream.WriteArray(m_ScaleData);
+}
+
+HK_NAMESPACE_END
@@ -0,0 +1,122 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <Engine/Core/Containers/Vector.h>
+#include <Engine/Math/Transform.h>
+
+HK_NAMESPACE_BEGIN
+
+struct AnimationChannel;
+
+/**
+
+AnimationCompressionSettings
+
+*/
+struct AnimationCompressionSettings
+{
+    /** Max position and scale error per component. Used to strip constant tracks and to reduce keyframes. */
+    float PositionTolerance = 0.0005f;
+
+    /** Max rotation error per quaternion component. Used to strip constant tracks and to reduce keyframes. */
+    float RotationTolerance = 0.0005f;
+
+    /** Remove frames that can be restored by interpolation of neighbour keys within the tolerance */
+    bool bReduceKeyframes = true;
+};
+
+/**
+
+CompressedAnimation
+
+Skeletal animation clip with quantized tracks:
+ - rotations are stored as smallest three components (15 bits each),
+ - positions and scales are stored as 16 bit values in per-track range,
+ - constant tracks are stripped and stored once,
+ - keyframes are shared between all tracks, so tracks are decoded in groups of four with SIMD.
+
+*/
+class CompressedAnimation
+{
+public:
+    /** Compress animation. Transforms of each channel are located at AnimationChannel::TransformOffset. */
+    void Compress(int frameCount, Transform const* transforms, AnimationChannel const* channels, int channelsCount, AnimationCompressionSettings const& settings);
+
+    /** Sample transforms of all channels. Frame is fractional frame index. */
+    void Sample(float frame, Transform* outTransforms) const;
+
+    bool IsEmpty() const { return m_KeyFrames.IsEmpty(); }
+
+    int GetChannelsCount() const { return m_ConstantTransforms.Size(); }
+
+    int GetKeyFrameCount() const { return m_KeyFrames.Size(); }
+
+    /** Size of compressed data in bytes */
+    size_t GetMemoryUsage() const;
+
+    void Read(IBinaryStreamReadInterface& stream);
+
+    void Write(IBinaryStreamWriteInterface& stream) const;
+
+private:
+    void UpdateFrameToKey();
+
+    void DecodeRotations(int key0, int key1, float blend, Transform* outTransforms) const;
+    void DecodeVectors(Vector<uint16_t> const& channels, Vector<float> const& ranges, Vector<uint16_t> const& data, int key0, int key1, float blend, Float3 Transform::*member, Transform* outTransforms) const;
+
+    int m_FrameCount = 0;
+
+    /** Source frame of each key */
+    Vector<uint32_t> m_KeyFrames;
+
+    /** Last key for each source frame. Not serialized. */
+    Vector<uint32_t> m_FrameToKey;
+
+    /** Values of constant tracks. Animated tracks are overwritten by decoder. */
+    Vector<Transform> m_ConstantTransforms;
+
+    /** Channel of each animated track. Padded to groups of four with 0xffff. */
+    Vector<uint16_t> m_RotationChannels;
+    Vector<uint16_t> m_PositionChannels;
+    Vector<uint16_t> m_ScaleChannels;
+
+    /** Ranges of animated tracks for each group: min[3][4], scale[3][4] */
+    Vector<float> m_PositionRanges;
+    Vector<float> m_ScaleRanges;
+
+    /** Quantized keys: [key][group][component][lane] */
+    Vector<uint16_t> m_RotationData;
+    Vector<uint16_t> m_PositionData;
+    Vector<uint16_t> m_ScaleData;
+};
+
+HK_NAMESPACE_END
@@ -30,6 +30,7 @@ SOFTWARE.
 
 #include "Image.h"
 #include "ImageEncoders.h"
+#include "MipmapGenerator.h"
 
 #include <Engine/Core/Logger.h>
 #include <Engine/Core/Color.h>
@@ -574,6 +575,14 @@ static stbir_datatype get_stbir_datatype(IMAGE_DATA_TYPE DataType)
     return STBIR_TYPE_UINT8;
 }
 
+static stbir_filter get_stbir_filter(IMAGE_RESAMPLE_FILTER Filter)
+{
+    // Kaiser is only implemented by the mipmap generator
+    if (Filter == IMAGE_RESAMPLE_FILTER_KAISER)
+        return STBIR_FILTER_CATMULLROM;
+    return (stbir_filter)Filter;
+}
+
 template <typename Decoder>
 static void GenerateMipmaps(ImageStorage& storage, uint32_t SliceIndex, IMAGE_RESAMPLE_EDGE_MODE ResampleMode, IMAGE_RESAMPLE_FILTER filter)
 {
@@ -622,7 +631,7 @@ static void GenerateMipmaps(ImageStorage& storage, uint32_t SliceIndex, IMAGE_RE
                      alphaChannel,
                      stbir_resize_flags,
                      (stbir_edge)ResampleMode, (stbir_edge)ResampleMode,
-                     (stbir_filter)filter, (stbir_filter)filter,
+                     get_stbir_filter(filter), get_stbir_filter(filter),
                      colorspace,
                      NULL);
 
@@ -650,6 +659,35 @@ bool ImageStorage::GenerateMipmaps(uint32_t SliceIndex, ImageMipmapConfig const&
     IMAGE_RESAMPLE_EDGE_MODE resampleMode   = MipmapConfig.EdgeMode;
     IMAGE_RESAMPLE_FILTER    resampleFilter = MipmapConfig.Filter;
 
+    MIPMAP_PIXEL_FORMAT pixelFormat;
+    if (GetMipmapPixelFormat(m_Desc.Format, pixelFormat))
+    {
+        MipmapChainDesc chainDesc;
+        chainDesc.Format                 = pixelFormat;
+        chainDesc.bHasAlpha              = info.bHasAlpha && !(m_Desc.Flags & IMAGE_STORAGE_NO_ALPHA);
+        chainDesc.bPremultipliedAlpha    = (m_Desc.Flags & IMAGE_STORAGE_ALPHA_PREMULTIPLIED) != 0;
+        chainDesc.bPreserveAlphaCoverage = MipmapConfig.bPreserveAlphaCoverage;
+        chainDesc.AlphaCoverageThreshold = MipmapConfig.AlphaCoverageThreshold;
+        chainDesc.EdgeMode               = resampleMode;
+        chainDesc.Filter                 = resampleFilter;
+
+        SmallVector<MipmapLevel, 16> levels;
+
+        ImageSubresourceDesc subres;
+        subres.SliceIndex = SliceIndex;
+        for (uint32_t i = 0; i < m_Desc.NumMipmaps; ++i)
+        {
+            subres.MipmapIndex = i;
+
+            ImageSubresource subresource = GetSubresource(subres);
+
+            levels.Add({subresource.GetData(), subresource.GetWidth(), subresource.GetHeight()});
+        }
+
+        GenerateMipmapChain(chainDesc, levels.ToPtr(), levels.Size());
+        return true;
+    }
+
     switch (DataType)
     {
         case IMAGE_DATA_TYPE_UNKNOWN:
@@ -737,7 +775,7 @@ bool ImageStorage::GenerateMipmaps(uint32_t SliceIndex, ImageMipmapConfig const&
                      alphaChannel,
                      stbir_resize_flags,
                      (stbir_edge)resampleMode, (stbir_edge)resampleMode,
-                     (stbir_filter)resampleFilter, (stbir_filter)resampleFilter,
+                     get_stbir_filter(resampleFilter), get_stbir_filter(resampleFilter),
                      colorspace,
                      NULL);
 
@@ -1661,7 +1699,7 @@ ImageStorage CreateImage(IBinaryStreamReadInterface& Stream, ImageMipmapConfig c
 
             ImageSubresource subresource = storage.GetSubresource(subres);
 
-            void (*CompressionRoutine)(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height);
+            void (*CompressionRoutine)(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces);
             switch (Format)
             {
                 case TEXTURE_FORMAT_BC1_UNORM:
@@ -1696,30 +1734,27 @@ ImageStorage CreateImage(IBinaryStreamReadInterface& Stream, ImageMipmapConfig c
                     break;
             }
 
-            CompressionRoutine(rawImage.GetData(), subresource.GetData(), subresource.GetWidth(), subresource.GetHeight());
+            SmallVector<BlockCompressionSurface, 16> surfaces;
+            surfaces.Add({rawImage.GetData(), subresource.GetData(), subresource.GetWidth(), subresource.GetHeight()});
+
+            // Resampled mips are kept until the whole chain is compressed in one parallel pass
+            HeapBlob mipData;
 
             if (pMipmapConfig)
             {
-                uint32_t curWidth  = subresource.GetWidth();
-                uint32_t curHeight = subresource.GetHeight();
-
-                HeapBlob blob(std::max<uint32_t>(info.BlockSize, curWidth >> 1) * std::max<uint32_t>(info.BlockSize, curHeight >> 1) * bpp);
+                size_t mipDataSize = 0;
+                for (uint32_t i = 1; i < desc.NumMipmaps; ++i)
+                {
+                    subres.MipmapIndex = i;
 
-                void* data = rawImage.GetData();
-                void* temp = blob.GetData();
+                    subresource = storage.GetSubresource(subres);
 
-                IMAGE_RESAMPLE_EDGE_MODE resampleMode   = pMipmapConfig->EdgeMode;
-                IMAGE_RESAMPLE_FILTER    resampleFilter = pMipmapConfig->Filter;
+                    mipDataSize += subresource.GetWidth() * subresource.GetHeight() * bpp;
+                }
 
-                int numChannels        = bpp;
-                int alphaChannel       = ((Flags & IMAGE_STORAGE_NO_ALPHA) || !info.bHasAlpha) ? STBIR_ALPHA_CHANNEL_NONE : numChannels - 1;
-                int stbir_resize_flags = alphaChannel != STBIR_ALPHA_CHANNEL_NONE && (Flags & IMAGE_STORAGE_ALPHA_PREMULTIPLIED) ? STBIR_FLAG_ALPHA_PREMULTIPLIED : 0;
+                mipData.Reset(mipDataSize);
 
-                stbir_datatype   datatype   = STBIR_TYPE_UINT8;
-                stbir_colorspace colorspace = Format == TEXTURE_FORMAT_BC1_UNORM_SRGB ||
-                    Format == TEXTURE_FORMAT_BC2_UNORM_SRGB ||
-                    Format == TEXTURE_FORMAT_BC3_UNORM_SRGB ||
-                    Format == TEXTURE_FORMAT_BC7_UNORM_SRGB ? STBIR_COLORSPACE_SRGB : STBIR_COLORSPACE_LINEAR;
+                uint8_t* temp = (uint8_t*)mipData.GetData();
 
                 for (uint32_t i = 1; i < desc.NumMipmaps; ++i)
                 {
@@ -1730,24 +1765,59 @@ ImageStorage CreateImage(IBinaryStreamReadInterface& Stream, ImageMipmapConfig c
                     uint32_t mipWidth  = subresource.GetWidth();
                     uint32_t mipHeight = subresource.GetHeight();
 
-                    stbir_resize(data, curWidth, curHeight, curWidth * bpp,
-                                 temp, mipWidth, mipHeight, mipWidth * bpp,
-                                 datatype,
-                                 numChannels,
-                                 alphaChannel,
-                                 stbir_resize_flags,
-                                 (stbir_edge)resampleMode, (stbir_edge)resampleMode,
-                                 (stbir_filter)resampleFilter, (stbir_filter)resampleFilter,
-                                 colorspace,
-                                 NULL);
-
-                    curWidth  = mipWidth;
-                    curHeight = mipHeight;
-                    Core::Swap(data, temp);
-
-                    CompressionRoutine(data, subresource.GetData(), mipWidth, mipHeight);
+                    surfaces.Add({temp, subresource.GetData(), mipWidth, mipHeight});
+
+                    temp += mipWidth * mipHeight * bpp;
+                }
+
+                bool bHasAlpha = info.bHasAlpha && !(Flags & IMAGE_STORAGE_NO_ALPHA);
+
+                if (bpp == 4)
+                {
+                    MipmapChainDesc chainDesc;
+                    chainDesc.Format                 = info.bSRGB ? MIPMAP_PIXEL_FORMAT_SRGBA8 : MIPMAP_PIXEL_FORMAT_RGBA8;
+                    chainDesc.bHasAlpha              = bHasAlpha;
+                    chainDesc.bPremultipliedAlpha    = (Flags & IMAGE_STORAGE_ALPHA_PREMULTIPLIED) != 0;
+                    chainDesc.bPreserveAlphaCoverage = pMipmapConfig->bPreserveAlphaCoverage;
+                    chainDesc.AlphaCoverageThreshold = pMipmapConfig->AlphaCoverageThreshold;
+                    chainDesc.EdgeMode               = pMipmapConfig->EdgeMode;
+                    chainDesc.Filter                 = pMipmapConfig->Filter;
+
+                    SmallVector<MipmapLevel, 16> levels;
+                    for (BlockCompressionSurface const& surface : surfaces)
+                        levels.Add({const_cast<void*>(surface.pSrc), surface.Width, surface.Height});
+
+                    GenerateMipmapChain(chainDesc, levels.ToPtr(), levels.Size());
+                }
+                else
+                {
+                    IMAGE_RESAMPLE_EDGE_MODE resampleMode   = pMipmapConfig->EdgeMode;
+                    IMAGE_RESAMPLE_FILTER    resampleFilter = pMipmapConfig->Filter;
+
+                    int numChannels        = bpp;
+                    int alphaChannel       = bHasAlpha ? numChannels - 1 : STBIR_ALPHA_CHANNEL_NONE;
+                    int stbir_resize_flags = alphaChannel != STBIR_ALPHA_CHANNEL_NONE && (Flags & IMAGE_STORAGE_ALPHA_PREMULTIPLIED) ? STBIR_FLAG_ALPHA_PREMULTIPLIED : 0;
+
+                    for (uint32_t i = 1; i < surfaces.Size(); ++i)
+                    {
+                        BlockCompressionSurface const& src = surfaces[i - 1];
+                        BlockCompressionSurface const& dst = surfaces[i];
+
+                        stbir_resize(src.pSrc, src.Width, src.Height, src.Width * bpp,
+                                     const_cast<void*>(dst.pSrc), dst.Width, dst.Height, dst.Width * bpp,
+                                     STBIR_TYPE_UINT8,
+                                     numChannels,
+                                     alphaChannel,
+                                     stbir_resize_flags,
+                                     (stbir_edge)resampleMode, (stbir_edge)resampleMode,
+                                     get_stbir_filter(resampleFilter), get_stbir_filter(resampleFilter),
+                                     STBIR_COLORSPACE_LINEAR,
+                                     NULL);
+                    }
                 }
             }
+
+            CompressionRoutine(surfaces.ToPtr(), surfaces.Size());
             return storage;
         }
         case TEXTURE_FORMAT_BC6H_UFLOAT:
@@ -1793,29 +1863,33 @@ ImageStorage CreateImage(IBinaryStreamReadInterface& Stream, ImageMipmapConfig c
             ImageSubresource subresource = storage.GetSubresource(subres);
 
             bool bSigned = (Format == TEXTURE_FORMAT_BC6H_SFLOAT);
-            CompressBC6h(rawImage.GetData(), subresource.GetData(), subresource.GetWidth(), subresource.GetHeight(), bSigned);
+
+            SmallVector<BlockCompressionSurface, 16> surfaces;
+            surfaces.Add({rawImage.GetData(), subresource.GetData(), subresource.GetWidth(), subresource.GetHeight()});
+
+            // Resampled mips are kept until the whole chain is compressed in one parallel pass
+            HeapBlob mipData;
 
             if (pMipmapConfig)
             {
-                uint32_t bpp = 4 * sizeof(float);
+                const uint32_t bpp = 4 * sizeof(float);
 
-                uint32_t curWidth  = subresource.GetWidth();
-                uint32_t curHeight = subresource.GetHeight();
+                SmallVector<MipmapLevel, 16> levels;
+                levels.Add({rawImage.GetData(), rawImage.GetWidth(), rawImage.GetHeight()});
 
-                HeapBlob blob(std::max<uint32_t>(info.BlockSize, curWidth >> 1) * std::max<uint32_t>(info.BlockSize, curHeight >> 1) * bpp);
+                size_t mipDataSize = 0;
+                for (uint32_t i = 1; i < desc.NumMipmaps; ++i)
+                {
+                    subres.MipmapIndex = i;
 
-                void* data = rawImage.GetData();
-                void* temp = blob.GetData();
+                    subresource = storage.GetSubresource(subres);
 
-                IMAGE_RESAMPLE_EDGE_MODE resampleMode   = pMipmapConfig->EdgeMode;
-                IMAGE_RESAMPLE_FILTER    resampleFilter = pMipmapConfig->Filter;
+                    mipDataSize += subresource.GetWidth() * subresource.GetHeight() * bpp;
+                }
 
-                const int numChannels        = 4;
-                const int alphaChannel       = STBIR_ALPHA_CHANNEL_NONE;
-                const int stbir_resize_flags = 0;
+                mipData.Reset(mipDataSize);
 
-                const stbir_datatype   datatype   = STBIR_TYPE_FLOAT;
-                const stbir_colorspace colorspace = STBIR_COLORSPACE_LINEAR;
+                uint8_t* temp = (uint8_t*)mipData.GetData();
 
                 for (uint32_t i = 1; i < desc.NumMipmaps; ++i)
                 {
@@ -1826,24 +1900,21 @@ ImageStorage CreateImage(IBinaryStreamReadInterface& Stream, ImageMipmapConfig c
                     uint32_t mipWidth  = subresource.GetWidth();
                     uint32_t mipHeight = subresource.GetHeight();
 
-                    stbir_resize(data, curWidth, curHeight, curWidth * bpp,
-                                 temp, mipWidth, mipHeight, mipWidth * bpp,
-                                 datatype,
-                                 numChannels,
-                                 alphaChannel,
-                                 stbir_resize_flags,
-                                 (stbir_edge)resampleMode, (stbir_edge)resampleMode,
-                                 (stbir_filter)resampleFilter, (stbir_filter)resampleFilter,
-                                 colorspace,
-                                 NULL);
-
-                    curWidth  = mipWidth;
-                    curHeight = mipHeight;
-                    Core::Swap(data, temp);
-
-                    CompressBC6h(data, subresource.GetData(), mipWidth, mipHeight, bSigned);
+                    levels.Add({temp, mipWidth, mipHeight});
+                    surfaces.Add({temp, subresource.GetData(), mipWidth, mipHeight});
+
+                    temp += mipWidth * mipHeight * bpp;
                 }
+
+                MipmapChainDesc chainDesc;
+                chainDesc.Format   = MIPMAP_PIXEL_FORMAT_RGBA32F;
+                chainDesc.EdgeMode = pMipmapConfig->EdgeMode;
+                chainDesc.Filter   = pMipmapConfig->Filter;
+
+                GenerateMipmapChain(chainDesc, levels.ToPtr(), levels.Size());
             }
+
+            CompressBC6h(surfaces.ToPtr(), surfaces.Size(), bSigned);
             return storage;
         }
         default:
@@ -2014,7 +2085,7 @@ static void ResampleImage(ImageResampleParams const& Desc, void* pDest)
                      alphaChannel,
                      stbir_resize_flags,
                      (stbir_edge)Desc.HorizontalEdgeMode, (stbir_edge)Desc.VerticalEdgeMode,
-                     (stbir_filter)Desc.HorizontalFilter, (stbir_filter)Desc.VerticalFilter,
+                     get_stbir_filter(Desc.HorizontalFilter), get_stbir_filter(Desc.VerticalFilter),
                      colorspace,
                      NULL);
 
@@ -2118,7 +2189,7 @@ bool ResampleImage(ImageResampleParams const& Desc, void* pDest)
                      alphaChannel,
                      Desc.bPremultipliedAlpha ? STBIR_FLAG_ALPHA_PREMULTIPLIED : 0,
                      (stbir_edge)Desc.HorizontalEdgeMode, (stbir_edge)Desc.VerticalEdgeMode,
-                     (stbir_filter)Desc.HorizontalFilter, (stbir_filter)Desc.VerticalFilter,
+                     get_stbir_filter(Desc.HorizontalFilter), get_stbir_filter(Desc.VerticalFilter),
                      info.bSRGB ? STBIR_COLORSPACE_SRGB : STBIR_COLORSPACE_LINEAR,
                      NULL);
 
@@ -2181,7 +2252,7 @@ RawImage ResampleRawImage(RawImage const& Source, RawImageResampleParams const&
                          (Desc.Flags & RAW_IMAGE_RESAMPLE_HAS_ALPHA) ? Source.NumChannels() - 1 : STBIR_ALPHA_CHANNEL_NONE,
                          (Desc.Flags & RAW_IMAGE_RESAMPLE_HAS_ALPHA) && (Desc.Flags & RAW_IMAGE_RESAMPLE_ALPHA_PREMULTIPLIED) ? STBIR_FLAG_ALPHA_PREMULTIPLIED : 0,
                          (stbir_edge)Desc.HorizontalEdgeMode, (stbir_edge)Desc.VerticalEdgeMode,
-                         (stbir_filter)Desc.HorizontalFilter, (stbir_filter)Desc.VerticalFilter,
+                         get_stbir_filter(Desc.HorizontalFilter), get_stbir_filter(Desc.VerticalFilter),
                          (Desc.Flags & RAW_IMAGE_RESAMPLE_COLORSPACE_SRGB) ? STBIR_COLORSPACE_SRGB : STBIR_COLORSPACE_LINEAR,
                          NULL);
 
@@ -345,7 +345,10 @@ enum IMAGE_RESAMPLE_FILTER
     /** An interpolating cubic spline */
     IMAGE_RESAMPLE_FILTER_CATMULLROM = 4,
     /** Mitchell-Netrevalli filter with B=1/3, C=1/3 */
-    IMAGE_RESAMPLE_FILTER_MITCHELL = 5
+    IMAGE_RESAMPLE_FILTER_MITCHELL = 5,
+    /** Kaiser windowed sinc (width 3, alpha 4). Sharp mipmaps with little ringing. Implemented by the mipmap generator,
+    other resampling paths fall back to Catmull-Rom. */
+    IMAGE_RESAMPLE_FILTER_KAISER = 6
 };
 
 /** Resampling filter for 3D textures (Not yet implemented. Reserved for future.) */
@@ -366,6 +369,12 @@ struct ImageMipmapConfig
 
     /** Resampling filter for 3D textures (Not yet implemented. Reserved for future.) */
     IMAGE_RESAMPLE_FILTER_3D Filter3D = IMAGE_RESAMPLE_FILTER_3D_AVERAGE;
+
+    /** Scale alpha of each mip to keep the fraction of pixels passing the alpha test. */
+    bool bPreserveAlphaCoverage = false;
+
+    /** Alpha test reference value used to measure coverage. */
+    float AlphaCoverageThreshold = 0.5f;
 };
 
 class ImageStorage final
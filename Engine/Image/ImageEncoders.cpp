@@ -30,6 +30,8 @@ SOFTWARE.
 
 #include "ImageEncoders.h"
 #include <Engine/Core/ScopedTimer.h>
+#include <Engine/Core/Platform.h>
+#include <Engine/Core/Thread.h>
 
 #include <bc7enc_rdo/rgbcx.h>
 #include <bc7enc_rdo/bc7decomp.h>
@@ -61,8 +63,14 @@ struct CompressionParams
             bc7enc_compress_block_params_init(&bc7_params[i]);
             bc7_params[i].m_uber_level = i;
         }
+
+        // Fast mode: lowest uber level and reduced partition search
+        bc7enc_compress_block_params_init(&bc7_fast_params);
+        bc7_fast_params.m_uber_level = 0;
+        bc7_fast_params.m_max_partitions = 16;
     }
     bc7enc_compress_block_params bc7_params[BC7ENC_MAX_UBER_LEVEL + 1];
+    bc7enc_compress_block_params bc7_fast_params;
 };
 
 CompressionParams compressionParams;
@@ -211,349 +219,277 @@ void Encode_BC7(void const* pSrc, void* pDest, uint32_t Level)
     bc7enc_compress_block(pDest, pSrc, &compressionParams.bc7_params[Level]);
 }
 
-// Input RGBA8 image, output BC1 compressed image
-void CompressBC1(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height)
+namespace
 {
-    uint8_t const* src = (uint8_t const*)pSrc;
-    uint8_t*       dst = (uint8_t*)pDest;
-    uint8_t        block[4 * 4 * 4];
-    const uint32_t blockWidth       = 4;
-    const uint32_t bpp              = 4;
-    const uint32_t blockRowStride   = blockWidth * bpp;
-    const size_t   blockSizeInBytes = 8;
-    uint32_t       numBlocksX       = Width / blockWidth;
-    uint32_t       numBlocksY       = Height / blockWidth;
-    size_t         rowStride        = Width * bpp;
-    for (uint32_t by = 0; by < numBlocksY; by++)
-    {
-        uint32_t pixY = by * blockWidth;
 
-        for (uint32_t bx = 0; bx < numBlocksX; bx++)
-        {
-            uint8_t const* p = src + pixY * rowStride + bx * (blockWidth * bpp);
+AtomicInt CompressionQuality{BLOCK_COMPRESSION_QUALITY_NORMAL};
 
-            memcpy(block + blockRowStride * 0, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 1, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 2, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 3, p, blockRowStride);
-
-            TextureBlockCompression::Encode_BC1(block, dst, 5 /*TextureBlockCompression::BC1_ENCODE_MAX_LEVEL*/, false, false);
-
-            dst += blockSizeInBytes;
-        }
-    }
+HK_FORCEINLINE BLOCK_COMPRESSION_QUALITY GetQuality()
+{
+    return (BLOCK_COMPRESSION_QUALITY)CompressionQuality.Load();
 }
 
-// Input RGBA8 image, output BC2 compressed image
-void CompressBC2(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height)
+HK_FORCEINLINE uint32_t GetRgbcxLevel(BLOCK_COMPRESSION_QUALITY quality)
 {
-    uint8_t const* src = (uint8_t const*)pSrc;
-    uint8_t*       dst = (uint8_t*)pDest;
-    uint8_t        block[4 * 4 * 4];
-    const uint32_t blockWidth       = 4;
-    const uint32_t bpp              = 4;
-    const uint32_t blockRowStride   = blockWidth * bpp;
-    const size_t   blockSizeInBytes = 16;
-    uint32_t       numBlocksX       = Width / blockWidth;
-    uint32_t       numBlocksY       = Height / blockWidth;
-    size_t         rowStride        = Width * bpp;
-    for (uint32_t by = 0; by < numBlocksY; by++)
+    switch (quality)
     {
-        uint32_t pixY = by * blockWidth;
+        case BLOCK_COMPRESSION_QUALITY_FAST:
+            return 2;
+        case BLOCK_COMPRESSION_QUALITY_BEST:
+            return BC1_ENCODE_MAX_LEVEL;
+        default:
+            return 5;
+    }
+}
 
-        for (uint32_t bx = 0; bx < numBlocksX; bx++)
-        {
-            uint8_t const* p = src + pixY * rowStride + bx * (blockWidth * bpp);
+// Max threads used to compress the images
+constexpr int MAX_COMPRESSION_THREADS = 64;
 
-            memcpy(block + blockRowStride * 0, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 1, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 2, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 3, p, blockRowStride);
+// Compress rows of 4x4 blocks of all surfaces on all hardware threads
+template <typename EncodeBlock>
+void CompressSurfaces(StringView name, BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces, uint32_t bpp, size_t blockSizeInBytes, EncodeBlock const& encodeBlock)
+{
+    const uint32_t blockWidth     = 4;
+    const uint32_t blockRowStride = blockWidth * bpp;
 
-            TextureBlockCompression::Encode_BC2(block, dst, 5 /*TextureBlockCompression::BC2_ENCODE_MAX_LEVEL*/);
+    // First row of each surface in the common row list
+    SmallVector<uint32_t, 16> firstRow;
+    firstRow.Resize(NumSurfaces + 1);
 
-            dst += blockSizeInBytes;
-        }
+    uint64_t numPixels = 0;
+    uint32_t numRows   = 0;
+    for (uint32_t i = 0; i < NumSurfaces; i++)
+    {
+        firstRow[i] = numRows;
+        numRows += pSurfaces[i].Height / blockWidth;
+        numPixels += uint64_t(pSurfaces[i].Width) * pSurfaces[i].Height;
     }
-}
+    firstRow[NumSurfaces] = numRows;
 
-// Input RGBA8 image, output BC3 compressed image
-void CompressBC3(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height)
-{
-    uint8_t const* src = (uint8_t const*)pSrc;
-    uint8_t*       dst = (uint8_t*)pDest;
-    uint8_t        block[4 * 4 * 4];
-    const uint32_t blockWidth       = 4;
-    const uint32_t bpp              = 4;
-    const uint32_t blockRowStride   = blockWidth * bpp;
-    const size_t   blockSizeInBytes = 16;
-    uint32_t       numBlocksX       = Width / blockWidth;
-    uint32_t       numBlocksY       = Height / blockWidth;
-    size_t         rowStride        = Width * bpp;
-    for (uint32_t by = 0; by < numBlocksY; by++)
+    if (!numRows)
+        return;
+
+    int64_t startTime = Core::SysMicroseconds();
+
+    AtomicInt nextRow{0};
+
+    auto worker = [&]()
     {
-        uint32_t pixY = by * blockWidth;
+        alignas(16) uint8_t block[4 * 4 * 4 * sizeof(float)];
+        uint32_t surfaceIndex = 0;
 
-        for (uint32_t bx = 0; bx < numBlocksX; bx++)
+        for (;;)
         {
-            uint8_t const* p = src + pixY * rowStride + bx * (blockWidth * bpp);
+            uint32_t row = (uint32_t)nextRow.FetchIncrement();
+            if (row >= numRows)
+                break;
 
-            memcpy(block + blockRowStride * 0, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 1, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 2, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 3, p, blockRowStride);
+            // Rows are fetched in increasing order
+            while (row >= firstRow[surfaceIndex + 1])
+                surfaceIndex++;
 
-            TextureBlockCompression::Encode_BC3(block, dst, 5 /*TextureBlockCompression::BC3_ENCODE_MAX_LEVEL*/, true);
+            BlockCompressionSurface const& surface = pSurfaces[surfaceIndex];
 
-            dst += blockSizeInBytes;
-        }
-    }
-}
+            uint32_t numBlocksX = surface.Width / blockWidth;
+            uint32_t by         = row - firstRow[surfaceIndex];
+            size_t   rowStride  = surface.Width * bpp;
 
-// Input R8 image, output BC4 compressed image
-void CompressBC4(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height)
-{
-    uint8_t const* src = (uint8_t const*)pSrc;
-    uint8_t*       dst = (uint8_t*)pDest;
-    uint8_t        block[4 * 4];
-    const uint32_t blockWidth       = 4;
-    const uint32_t bpp              = 1;
-    const uint32_t blockRowStride   = blockWidth * bpp;
-    const size_t   blockSizeInBytes = 8;
-    uint32_t       numBlocksX       = Width / blockWidth;
-    uint32_t       numBlocksY       = Height / blockWidth;
-    size_t         rowStride        = Width * bpp;
-    for (uint32_t by = 0; by < numBlocksY; by++)
-    {
-        uint32_t pixY = by * blockWidth;
+            uint8_t const* src = (uint8_t const*)surface.pSrc + by * blockWidth * rowStride;
+            uint8_t*       dst = (uint8_t*)surface.pDest + by * numBlocksX * blockSizeInBytes;
 
-        for (uint32_t bx = 0; bx < numBlocksX; bx++)
-        {
-            uint8_t const* p = src + pixY * rowStride + bx * (blockWidth * bpp);
+            for (uint32_t bx = 0; bx < numBlocksX; bx++)
+            {
+                uint8_t const* p = src + bx * blockRowStride;
 
-            memcpy(block + blockRowStride * 0, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 1, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 2, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 3, p, blockRowStride);
+                memcpy(block + blockRowStride * 0, p, blockRowStride);
+                p += rowStride;
+                memcpy(block + blockRowStride * 1, p, blockRowStride);
+                p += rowStride;
+                memcpy(block + blockRowStride * 2, p, blockRowStride);
+                p += rowStride;
+                memcpy(block + blockRowStride * 3, p, blockRowStride);
 
-            TextureBlockCompression::Encode_BC4(block, dst, true);
+                encodeBlock(block, dst);
 
-            dst += blockSizeInBytes;
+                dst += blockSizeInBytes;
+            }
         }
-    }
-}
+    };
 
-// Input RG8 image, output BC5 compressed image
-void CompressBC5(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height)
-{
-    uint8_t const* src = (uint8_t const*)pSrc;
-    uint8_t*       dst = (uint8_t*)pDest;
-    uint8_t        block[4 * 4 * 2];
-    const uint32_t blockWidth       = 4;
-    const uint32_t bpp              = 2;
-    const uint32_t blockRowStride   = blockWidth * bpp;
-    const size_t   blockSizeInBytes = 16;
-    uint32_t       numBlocksX       = Width / blockWidth;
-    uint32_t       numBlocksY       = Height / blockWidth;
-    size_t         rowStride        = Width * bpp;
-    for (uint32_t by = 0; by < numBlocksY; by++)
-    {
-        uint32_t pixY = by * blockWidth;
+    // Don't start threads for small images
+    const uint32_t minRowsPerThread = 8;
 
-        for (uint32_t bx = 0; bx < numBlocksX; bx++)
-        {
-            uint8_t const* p = src + pixY * rowStride + bx * (blockWidth * bpp);
+    int numThreads = Math::Min(Math::Min(Thread::NumHardwareThreads, MAX_COMPRESSION_THREADS), int(numRows / minRowsPerThread));
+    if (numThreads > 1)
+    {
+        Thread threads[MAX_COMPRESSION_THREADS - 1];
+        for (int i = 0; i < numThreads - 1; i++)
+            threads[i] = Thread(worker);
 
-            memcpy(block + blockRowStride * 0, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 1, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 2, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 3, p, blockRowStride);
+        worker();
 
-            TextureBlockCompression::Encode_BC5(block, dst, true);
+        for (int i = 0; i < numThreads - 1; i++)
+            threads[i].Join();
+    }
+    else
+    {
+        worker();
+    }
 
-            dst += blockSizeInBytes;
-        }
+    // Report throughput for big images only
+    if (numPixels >= 1024 * 1024)
+    {
+        double seconds = Math::Max<double>(Core::SysMicroseconds() - startTime, 1) * 0.000001;
+        LOG("{}: {} MPix compressed in {:.2f} s on {} threads, {:.1f} MPix/s\n", name, numPixels / 1000000.0, seconds, Math::Max(numThreads, 1), numPixels / 1000000.0 / seconds);
     }
 }
 
-// Input RGBA32_FLOAT image, output BC6 compressed image
-void CompressBC6h(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height, bool bSigned)
-{
-    ScopedTimer timer("CompressBC6h");
-
-    //uint8_t const* src = (uint8_t const*)pSrc;
-    //uint8_t*       dst = (uint8_t*)pDest;
-    //uint8_t        block[4 * 4 * 4 * sizeof(float)];
-    const uint32_t blockWidth = 4;
-    const uint32_t bpp        = 4 * sizeof(float);
-    //const uint32_t blockRowStride   = blockWidth * bpp;
-    //const size_t   blockSizeInBytes = 16;
-    uint32_t numBlocksX = Width / blockWidth;
-    uint32_t numBlocksY = Height / blockWidth;
-    size_t   rowStride  = Width * bpp;
+} // namespace
 
-    const int num_threads = 16;
+void SetCompressionQuality(BLOCK_COMPRESSION_QUALITY Quality)
+{
+    CompressionQuality.Store(Quality);
+}
 
-    Thread threads[num_threads];
+BLOCK_COMPRESSION_QUALITY GetCompressionQuality()
+{
+    return GetQuality();
+}
 
-    struct ThreadData
-    {
-        uint32_t    firstBlock;
-        uint32_t    numBlocks;
-        uint32_t    numBlocksX;
-        uint32_t    numBlocksY;
-        size_t      rowStride;
-        void const* pSrc;
-        void*       pDest;
-        bool        bSigned;
-    };
+void CompressBC1(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces)
+{
+    uint32_t level = GetRgbcxLevel(GetQuality());
 
-    uint32_t numBlocks       = numBlocksX * numBlocksY;
-    uint32_t blocksPerThread = numBlocks / num_threads;
-    uint32_t firstBlock      = 0;
+    CompressSurfaces("BC1", pSurfaces, NumSurfaces, 4, 8,
+                     [level](void const* block, void* dst)
+                     {
+                         Encode_BC1(block, dst, level, false, false);
+                     });
+}
 
-    AtomicInt counter{};
+void CompressBC2(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces)
+{
+    uint32_t level = GetRgbcxLevel(GetQuality());
 
-    ThreadData data[num_threads];
-    for (int i = 0; i < num_threads; i++)
-    {
-        data[i].firstBlock = firstBlock;
-        data[i].numBlocks  = blocksPerThread;
-        data[i].numBlocksX = numBlocksX;
-        data[i].numBlocksY = numBlocksY;
-        data[i].rowStride  = rowStride;
-        data[i].pSrc       = pSrc;
-        data[i].pDest      = pDest;
-        data[i].bSigned    = bSigned;
-        firstBlock += blocksPerThread;
+    CompressSurfaces("BC2", pSurfaces, NumSurfaces, 4, 16,
+                     [level](void const* block, void* dst)
+                     {
+                         Encode_BC2(block, dst, level);
+                     });
+}
 
-        threads[i] = Thread(
-            [](ThreadData& data, uint32_t numBlocks, AtomicInt& counter)
-            {
-                uint8_t block[4 * 4 * 4 * sizeof(float)];
+void CompressBC3(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces)
+{
+    BLOCK_COMPRESSION_QUALITY quality = GetQuality();
 
-                const uint32_t blockWidth       = 4;
-                const uint32_t bpp              = 4 * sizeof(float);
-                const uint32_t blockRowStride   = blockWidth * bpp;
-                const size_t   blockSizeInBytes = 16;
+    uint32_t level       = GetRgbcxLevel(quality);
+    bool     bMaxQuality = quality != BLOCK_COMPRESSION_QUALITY_FAST;
 
-                for (uint32_t blockIndex = 0; blockIndex < data.numBlocks; blockIndex++)
-                {
-                    uint32_t i = blockIndex + data.firstBlock;
+    CompressSurfaces("BC3", pSurfaces, NumSurfaces, 4, 16,
+                     [level, bMaxQuality](void const* block, void* dst)
+                     {
+                         Encode_BC3(block, dst, level, bMaxQuality);
+                     });
+}
 
-                    uint32_t bx = i % data.numBlocksX;
-                    uint32_t by = i / data.numBlocksX;
+void CompressBC4(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces)
+{
+    bool bMaxQuality = GetQuality() != BLOCK_COMPRESSION_QUALITY_FAST;
 
-                    uint8_t*       dst = (uint8_t*)data.pDest + i * blockSizeInBytes;
-                    uint8_t const* p   = (uint8_t const*)data.pSrc + by * blockWidth * data.rowStride + bx * (blockWidth * bpp);
+    CompressSurfaces("BC4", pSurfaces, NumSurfaces, 1, 8,
+                     [bMaxQuality](void const* block, void* dst)
+                     {
+                         Encode_BC4(block, dst, bMaxQuality);
+                     });
+}
 
-                    memcpy(block + blockRowStride * 0, p, blockRowStride);
-                    p += data.rowStride;
-                    memcpy(block + blockRowStride * 1, p, blockRowStride);
-                    p += data.rowStride;
-                    memcpy(block + blockRowStride * 2, p, blockRowStride);
-                    p += data.rowStride;
-                    memcpy(block + blockRowStride * 3, p, blockRowStride);
+void CompressBC5(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces)
+{
+    bool bMaxQuality = GetQuality() != BLOCK_COMPRESSION_QUALITY_FAST;
 
-                    TextureBlockCompression::Encode_BC6h_f32(block, dst, data.bSigned);
+    CompressSurfaces("BC5", pSurfaces, NumSurfaces, 2, 16,
+                     [bMaxQuality](void const* block, void* dst)
+                     {
+                         Encode_BC5(block, dst, bMaxQuality);
+                     });
+}
 
-                    int n = counter.Increment();
-                    if (!(n % 512))
-                        LOG("Blocks processed {} from {}\n", n, numBlocks);
-                }
-            },
-            std::ref(data[i]), numBlocks, std::ref(counter));
-    }
+void CompressBC6h(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces, bool bSigned)
+{
+    CompressSurfaces("BC6h", pSurfaces, NumSurfaces, 4 * sizeof(float), 16,
+                     [bSigned](void const* block, void* dst)
+                     {
+                         Encode_BC6h_f32(block, dst, bSigned);
+                     });
+}
 
-    for (int i = 0; i < num_threads; i++)
+void CompressBC7(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces)
+{
+    bc7enc_compress_block_params const* params;
+    switch (GetQuality())
     {
-        threads[i].Join();
+        case BLOCK_COMPRESSION_QUALITY_FAST:
+            params = &compressionParams.bc7_fast_params;
+            break;
+        default:
+            params = &compressionParams.bc7_params[BC7_ENCODE_MAX_LEVEL];
+            break;
     }
 
-    #if 0
-    uint8_t const* src = (uint8_t const*)pSrc;
-    uint8_t*       dst = (uint8_t*)pDest;
-    uint8_t        block[4 * 4 * 4 * sizeof(float)];
-    const uint32_t blockWidth = 4;
-    const uint32_t bpp        = 4 * sizeof(float);
-    const uint32_t blockRowStride   = blockWidth * bpp;
-    const size_t   blockSizeInBytes = 16;
-    uint32_t numBlocksX = Width / blockWidth;
-    uint32_t numBlocksY = Height / blockWidth;
-    size_t   rowStride  = Width * bpp;
-    for (uint32_t by = 0; by < numBlocksY; by++)
-    {
-        uint32_t pixY = by * blockWidth;
-
-        for (uint32_t bx = 0; bx < numBlocksX; bx++)
-        {
-            uint8_t const* p = src + pixY * rowStride + bx * (blockWidth * bpp);
-
-            memcpy(block + blockRowStride * 0, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 1, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 2, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 3, p, blockRowStride);
+    CompressSurfaces("BC7", pSurfaces, NumSurfaces, 4, 16,
+                     [params](void const* block, void* dst)
+                     {
+                         bc7enc_compress_block(dst, block, params);
+                     });
+}
 
-            TextureBlockCompression::Encode_BC6h_f32(block, dst, bSigned);
+// Input RGBA8 image, output BC1 compressed image
+void CompressBC1(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height)
+{
+    BlockCompressionSurface surface{pSrc, pDest, Width, Height};
+    CompressBC1(&surface, 1);
+}
 
-            dst += blockSizeInBytes;
-        }
-    }
-    #endif
+// Input RGBA8 image, output BC2 compressed image
+void CompressBC2(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height)
+{
+    BlockCompressionSurface surface{pSrc, pDest, Width, Height};
+    CompressBC2(&surface, 1);
 }
 
-// Input RGBA8 image, output BC7 compressed image
-void CompressBC7(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height)
+// Input RGBA8 image, output BC3 compressed image
+void CompressBC3(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height)
 {
-    uint8_t const* src = (uint8_t const*)pSrc;
-    uint8_t*       dst = (uint8_t*)pDest;
-    uint8_t        block[4 * 4 * 4];
-    const uint32_t blockWidth       = 4;
-    const uint32_t bpp              = 4;
-    const uint32_t blockRowStride   = blockWidth * bpp;
-    const size_t   blockSizeInBytes = 16;
-    uint32_t       numBlocksX       = Width / blockWidth;
-    uint32_t       numBlocksY       = Height / blockWidth;
-    size_t         rowStride        = Width * bpp;
-    for (uint32_t by = 0; by < numBlocksY; by++)
-    {
-        uint32_t pixY = by * blockWidth;
+    BlockCompressionSurface surface{pSrc, pDest, Width, Height};
+    CompressBC3(&surface, 1);
+}
 
-        for (uint32_t bx = 0; bx < numBlocksX; bx++)
-        {
-            uint8_t const* p = src + pixY * rowStride + bx * (blockWidth * bpp);
+// Input R8 image, output BC4 compressed image
+void CompressBC4(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height)
+{
+    BlockCompressionSurface surface{pSrc, pDest, Width, Height};
+    CompressBC4(&surface, 1);
+}
 
-            memcpy(block + blockRowStride * 0, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 1, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 2, p, blockRowStride);
-            p += rowStride;
-            memcpy(block + blockRowStride * 3, p, blockRowStride);
+// Input RG8 image, output BC5 compressed image
+void CompressBC5(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height)
+{
+    BlockCompressionSurface surface{pSrc, pDest, Width, Height};
+    CompressBC5(&surface, 1);
+}
 
-            TextureBlockCompression::Encode_BC7(block, dst, BC7_ENCODE_MAX_LEVEL);
+// Input RGBA32_FLOAT image, output BC6 compressed image
+void CompressBC6h(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height, bool bSigned)
+{
+    BlockCompressionSurface surface{pSrc, pDest, Width, Height};
+    CompressBC6h(&surface, 1, bSigned);
+}
 
-            dst += blockSizeInBytes;
-        }
-    }
+// Input RGBA8 image, output BC7 compressed image
+void CompressBC7(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height)
+{
+    BlockCompressionSurface surface{pSrc, pDest, Width, Height};
+    CompressBC7(&surface, 1);
 }
 
 #if 0
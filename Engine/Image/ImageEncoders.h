@@ -63,6 +63,39 @@ void Encode_BC6h_f16(void const* pSrc, void* pDest, bool bSigned);
 void Encode_BC6h_f32(void const* pSrc, void* pDest, bool bSigned);
 void Encode_BC7(void const* pSrc, void* pDest, uint32_t Level);
 
+enum BLOCK_COMPRESSION_QUALITY
+{
+    /** Lowest encoder levels, BC7 uses bc7enc fast mode */
+    BLOCK_COMPRESSION_QUALITY_FAST,
+    /** Default quality */
+    BLOCK_COMPRESSION_QUALITY_NORMAL,
+    /** Highest encoder levels. Much slower for BC1-BC3. */
+    BLOCK_COMPRESSION_QUALITY_BEST
+};
+
+/** Set quality/speed tier of CompressBC* functions. Thread safe. */
+void SetCompressionQuality(BLOCK_COMPRESSION_QUALITY Quality);
+
+BLOCK_COMPRESSION_QUALITY GetCompressionQuality();
+
+/** Image to compress. A whole mip chain can be compressed in one parallel pass. */
+struct BlockCompressionSurface
+{
+    void const* pSrc;
+    void*       pDest;
+    uint32_t    Width;
+    uint32_t    Height;
+};
+
+// Compress several surfaces at once. Rows of blocks of all surfaces are distributed across hardware threads.
+void CompressBC1(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces);
+void CompressBC2(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces);
+void CompressBC3(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces);
+void CompressBC4(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces);
+void CompressBC5(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces);
+void CompressBC6h(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces, bool bSigned);
+void CompressBC7(BlockCompressionSurface const* pSurfaces, uint32_t NumSurfaces);
+
 // Input RGBA8 image, output BC1 compressed image
 void CompressBC1(void const* pSrc, void* pDest, uint32_t Width, uint32_t Height);
 
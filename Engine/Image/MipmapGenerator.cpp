@@ -0,0 +1,746 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "MipmapGenerator.h"
+
+#include <Engine/Core/Color.h>
+#include <Engine/Core/Thread.h>
+#include <Engine/Core/Containers/Vector.h>
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+HK_NAMESPACE_BEGIN
+
+namespace
+{
+
+constexpr int MAX_MIPMAP_THREADS = 64;
+
+// Destination rows fetched by a thread at once. Consecutive rows share source rows, so
+// bigger chunks hit the decoded row cache more often.
+constexpr uint32_t ROWS_PER_CHUNK = 16;
+
+constexpr float KAISER_WIDTH = 3.0f;
+constexpr float KAISER_ALPHA = 4.0f;
+
+uint32_t GetBytesPerPixel(MIPMAP_PIXEL_FORMAT Format)
+{
+    switch (Format)
+    {
+        case MIPMAP_PIXEL_FORMAT_RGBA8:
+        case MIPMAP_PIXEL_FORMAT_SRGBA8:
+            return 4;
+        case MIPMAP_PIXEL_FORMAT_RGBA16F:
+            return 8;
+        case MIPMAP_PIXEL_FORMAT_RGBA32F:
+            return 16;
+    }
+    HK_ASSERT(0);
+    return 0;
+}
+
+/** Filter radius in destination pixels */
+float GetFilterSupport(IMAGE_RESAMPLE_FILTER Filter)
+{
+    switch (Filter)
+    {
+        case IMAGE_RESAMPLE_FILTER_BOX:
+            return 0.5f;
+        case IMAGE_RESAMPLE_FILTER_TRIANGLE:
+            return 1.0f;
+        case IMAGE_RESAMPLE_FILTER_KAISER:
+            return KAISER_WIDTH;
+        default:
+            return 2.0f;
+    }
+}
+
+/** Mitchell-Netravali family of cubic filters */
+float Cubic(float X, float B, float C)
+{
+    X = Math::Abs(X);
+    if (X < 1.0f)
+        return ((12 - 9 * B - 6 * C) * X * X * X + (-18 + 12 * B + 6 * C) * X * X + (6 - 2 * B)) * (1.0f / 6.0f);
+    if (X < 2.0f)
+        return ((-B - 6 * C) * X * X * X + (6 * B + 30 * C) * X * X + (-12 * B - 48 * C) * X + (8 * B + 24 * C)) * (1.0f / 6.0f);
+    return 0.0f;
+}
+
+/** Zero order modified Bessel function of the first kind */
+float BesselI0(float X)
+{
+    float sum  = 1.0f;
+    float term = 1.0f;
+    float halfX = X * 0.5f;
+    for (int k = 1; k < 32; k++)
+    {
+        term *= halfX / k;
+        float t2 = term * term;
+        sum += t2;
+        if (t2 < sum * 1e-8f)
+            break;
+    }
+    return sum;
+}
+
+/** Kaiser windowed sinc */
+float Kaiser(float X)
+{
+    float t = X / KAISER_WIDTH;
+    if (Math::Abs(t) >= 1.0f)
+        return 0.0f;
+
+    float sinc = 1.0f;
+    if (X != 0.0f)
+    {
+        float px = Math::_PI * X;
+        sinc = Math::Sin(px) / px;
+    }
+    return sinc * BesselI0(KAISER_ALPHA * Math::Sqrt(1.0f - t * t)) / BesselI0(KAISER_ALPHA);
+}
+
+float EvaluateFilter(IMAGE_RESAMPLE_FILTER Filter, float X)
+{
+    switch (Filter)
+    {
+        case IMAGE_RESAMPLE_FILTER_TRIANGLE:
+            return Math::Max(0.0f, 1.0f - Math::Abs(X));
+        case IMAGE_RESAMPLE_FILTER_CUBICBSPLINE:
+            return Cubic(X, 1.0f, 0.0f);
+        case IMAGE_RESAMPLE_FILTER_CATMULLROM:
+            return Cubic(X, 0.0f, 0.5f);
+        case IMAGE_RESAMPLE_FILTER_MITCHELL:
+            return Cubic(X, 1.0f / 3.0f, 1.0f / 3.0f);
+        case IMAGE_RESAMPLE_FILTER_KAISER:
+            return Kaiser(X);
+        default:
+            HK_ASSERT(0);
+            return 0.0f;
+    }
+}
+
+/** Returns source index for the edge mode or -1 if the sample is outside and must be ignored */
+int ResolveEdge(int Index, int Size, IMAGE_RESAMPLE_EDGE_MODE EdgeMode)
+{
+    if (Index >= 0 && Index < Size)
+        return Index;
+
+    switch (EdgeMode)
+    {
+        case IMAGE_RESAMPLE_EDGE_CLAMP:
+            return Math::Clamp(Index, 0, Size - 1);
+        case IMAGE_RESAMPLE_EDGE_REFLECT:
+            Index = Index < 0 ? -Index - 1 : 2 * Size - Index - 1;
+            return Math::Clamp(Index, 0, Size - 1);
+        case IMAGE_RESAMPLE_EDGE_WRAP:
+            Index %= Size;
+            return Index < 0 ? Index + Size : Index;
+        case IMAGE_RESAMPLE_EDGE_ZERO:
+        default:
+            return -1;
+    }
+}
+
+/** Precomputed filter taps for one axis of a level */
+struct FilterTaps
+{
+    uint32_t      NumTaps = 0;
+    Vector<int>   Index;
+    Vector<float> Weight;
+
+    void Build(uint32_t SrcSize, uint32_t DstSize, IMAGE_RESAMPLE_FILTER Filter, IMAGE_RESAMPLE_EDGE_MODE EdgeMode)
+    {
+        if (SrcSize == DstSize)
+        {
+            NumTaps = 1;
+            Index.Resize(DstSize);
+            Weight.Resize(DstSize);
+            for (uint32_t i = 0; i < DstSize; i++)
+            {
+                Index[i]  = i;
+                Weight[i] = 1.0f;
+            }
+            return;
+        }
+
+        const float scale   = float(SrcSize) / DstSize;
+        const float support = GetFilterSupport(Filter) * scale;
+
+        NumTaps = uint32_t(Math::Ceil(support * 2)) + 1;
+
+        Index.Resize(DstSize * NumTaps);
+        Weight.Resize(DstSize * NumTaps);
+
+        uint32_t maxTaps = 1;
+
+        for (uint32_t i = 0; i < DstSize; i++)
+        {
+            int*   pIndex  = &Index[i * NumTaps];
+            float* pWeight = &Weight[i * NumTaps];
+
+            const float center = (i + 0.5f) * scale;
+
+            int first = int(Math::Floor(center - support));
+            int last  = int(Math::Ceil(center + support));
+
+            float    totalWeight = 0;
+            uint32_t n           = 0;
+
+            for (int j = first; j < last && n < NumTaps; j++)
+            {
+                float w;
+                if (Filter == IMAGE_RESAMPLE_FILTER_BOX)
+                {
+                    // Pixel footprint overlap
+                    float lo = Math::Max(float(j), center - support);
+                    float hi = Math::Min(float(j + 1), center + support);
+                    w        = Math::Max(0.0f, hi - lo);
+                }
+                else
+                    w = EvaluateFilter(Filter, (j + 0.5f - center) / scale);
+
+                // Samples outside the image in zero edge mode still count for normalization
+                totalWeight += w;
+
+                int index = ResolveEdge(j, SrcSize, EdgeMode);
+                if (w == 0.0f || index < 0)
+                    continue;
+
+                pIndex[n]  = index;
+                pWeight[n] = w;
+                n++;
+            }
+
+            float norm = totalWeight != 0.0f ? 1.0f / totalWeight : 0.0f;
+            for (uint32_t k = 0; k < n; k++)
+                pWeight[k] *= norm;
+
+            for (uint32_t k = n; k < NumTaps; k++)
+            {
+                pIndex[k]  = n ? pIndex[0] : 0;
+                pWeight[k] = 0.0f;
+            }
+
+            maxTaps = Math::Max(maxTaps, n);
+        }
+
+        // Drop trailing zero taps. The new stride is not greater than the old one, so compact in place.
+        if (maxTaps < NumTaps)
+        {
+            for (uint32_t i = 0; i < DstSize; i++)
+            {
+                for (uint32_t k = 0; k < maxTaps; k++)
+                {
+                    Index[i * maxTaps + k]  = Index[i * NumTaps + k];
+                    Weight[i * maxTaps + k] = Weight[i * NumTaps + k];
+                }
+            }
+            NumTaps = maxTaps;
+        }
+    }
+};
+
+HK_FORCEINLINE __m128 Premultiply(__m128 Pixel)
+{
+    const __m128 alphaMask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+    const __m128 one       = _mm_set1_ps(1.0f);
+
+    __m128 alpha  = _mm_shuffle_ps(Pixel, Pixel, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128 factor = _mm_or_ps(_mm_andnot_ps(alphaMask, alpha), _mm_and_ps(alphaMask, one));
+    return _mm_mul_ps(Pixel, factor);
+}
+
+HK_FORCEINLINE __m128 Unpremultiply(__m128 Pixel)
+{
+    const __m128 alphaMask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+    const __m128 one       = _mm_set1_ps(1.0f);
+
+    __m128 alpha = _mm_shuffle_ps(Pixel, Pixel, _MM_SHUFFLE(3, 3, 3, 3));
+    // Transparent pixels become black
+    __m128 rcp    = _mm_and_ps(_mm_cmpgt_ps(alpha, _mm_setzero_ps()), _mm_div_ps(one, alpha));
+    __m128 factor = _mm_or_ps(_mm_andnot_ps(alphaMask, rcp), _mm_and_ps(alphaMask, one));
+    return _mm_mul_ps(Pixel, factor);
+}
+
+/** Converts a row to linear float RGBA */
+void DecodeRow(MIPMAP_PIXEL_FORMAT Format, void const* pSrc, float* pDest, uint32_t Width, bool bPremultiply)
+{
+    switch (Format)
+    {
+        case MIPMAP_PIXEL_FORMAT_RGBA8: {
+            const __m128i zero  = _mm_setzero_si128();
+            const __m128  scale = _mm_set1_ps(1.0f / 255.0f);
+
+            uint8_t const* src = (uint8_t const*)pSrc;
+            for (uint32_t x = 0; x < Width; x++, src += 4)
+            {
+                int packed;
+                memcpy(&packed, src, 4);
+
+                __m128i v = _mm_cvtsi32_si128(packed);
+                v         = _mm_unpacklo_epi8(v, zero);
+                v         = _mm_unpacklo_epi16(v, zero);
+
+                _mm_storeu_ps(pDest + x * 4, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+            }
+            break;
+        }
+        case MIPMAP_PIXEL_FORMAT_SRGBA8: {
+            uint8_t const* src = (uint8_t const*)pSrc;
+            for (uint32_t x = 0; x < Width; x++, src += 4)
+            {
+                float* dst = pDest + x * 4;
+                dst[0]     = LinearFromSRGB_UChar(src[0]);
+                dst[1]     = LinearFromSRGB_UChar(src[1]);
+                dst[2]     = LinearFromSRGB_UChar(src[2]);
+                dst[3]     = src[3] * (1.0f / 255.0f);
+            }
+            break;
+        }
+        case MIPMAP_PIXEL_FORMAT_RGBA16F: {
+            uint16_t const* src = (uint16_t const*)pSrc;
+            for (uint32_t x = 0, count = Width * 4; x < count; x++)
+                pDest[x] = f16tof32(src[x]);
+            break;
+        }
+        case MIPMAP_PIXEL_FORMAT_RGBA32F:
+            memcpy(pDest, pSrc, Width * 4 * sizeof(float));
+            break;
+    }
+
+    if (bPremultiply)
+    {
+        for (uint32_t x = 0; x < Width; x++)
+            _mm_storeu_ps(pDest + x * 4, Premultiply(_mm_loadu_ps(pDest + x * 4)));
+    }
+}
+
+/** Converts a row of linear float RGBA to the pixel format */
+void EncodeRow(MIPMAP_PIXEL_FORMAT Format, float const* pSrc, void* pDest, uint32_t Width, bool bUnpremultiply, float AlphaScale)
+{
+    const __m128 zero     = _mm_setzero_ps();
+    const __m128 one      = _mm_set1_ps(1.0f);
+    const __m128 scale    = _mm_setr_ps(1.0f, 1.0f, 1.0f, AlphaScale);
+    const bool   bScale   = AlphaScale != 1.0f;
+    const __m128 maxValue = _mm_setr_ps(Math::_INFINITY, Math::_INFINITY, Math::_INFINITY, 1.0f);
+
+    for (uint32_t x = 0; x < Width; x++)
+    {
+        __m128 pixel = _mm_loadu_ps(pSrc + x * 4);
+
+        if (bUnpremultiply)
+            pixel = Unpremultiply(pixel);
+
+        if (bScale)
+            pixel = _mm_min_ps(_mm_mul_ps(pixel, scale), maxValue);
+
+        switch (Format)
+        {
+            case MIPMAP_PIXEL_FORMAT_RGBA8: {
+                pixel = _mm_min_ps(_mm_max_ps(pixel, zero), one);
+
+                __m128i v = _mm_cvtps_epi32(_mm_mul_ps(pixel, _mm_set1_ps(255.0f)));
+                v         = _mm_packs_epi32(v, v);
+                v         = _mm_packus_epi16(v, v);
+
+                int packed = _mm_cvtsi128_si32(v);
+                memcpy((uint8_t*)pDest + x * 4, &packed, 4);
+                break;
+            }
+            case MIPMAP_PIXEL_FORMAT_SRGBA8: {
+                alignas(16) float c[4];
+                _mm_store_ps(c, pixel);
+
+                uint8_t* dst = (uint8_t*)pDest + x * 4;
+                dst[0]       = LinearToSRGB_UChar(c[0]);
+                dst[1]       = LinearToSRGB_UChar(c[1]);
+                dst[2]       = LinearToSRGB_UChar(c[2]);
+                dst[3]       = uint8_t(Math::Clamp(c[3], 0.0f, 1.0f) * 255.0f + 0.5f);
+                break;
+            }
+            case MIPMAP_PIXEL_FORMAT_RGBA16F: {
+                alignas(16) float c[4];
+                _mm_store_ps(c, pixel);
+
+                uint16_t* dst = (uint16_t*)pDest + x * 4;
+                dst[0]        = f32tof16(c[0]);
+                dst[1]        = f32tof16(c[1]);
+                dst[2]        = f32tof16(c[2]);
+                dst[3]        = f32tof16(c[3]);
+                break;
+            }
+            case MIPMAP_PIXEL_FORMAT_RGBA32F:
+                _mm_storeu_ps((float*)pDest + x * 4, pixel);
+                break;
+        }
+    }
+}
+
+/** 2x2 box downsampling of two source rows */
+void DownsampleRow2x2(float const* pRow0, float const* pRow1, float* pDest, uint32_t DestWidth)
+{
+    const __m128 quarter = _mm_set1_ps(0.25f);
+
+    for (uint32_t x = 0; x < DestWidth; x++)
+    {
+        __m128 a = _mm_loadu_ps(pRow0 + x * 8);
+        __m128 b = _mm_loadu_ps(pRow0 + x * 8 + 4);
+        __m128 c = _mm_loadu_ps(pRow1 + x * 8);
+        __m128 d = _mm_loadu_ps(pRow1 + x * 8 + 4);
+
+        _mm_storeu_ps(pDest + x * 4, _mm_mul_ps(_mm_add_ps(_mm_add_ps(a, b), _mm_add_ps(c, d)), quarter));
+    }
+}
+
+/** Accumulates a weighted source row for the vertical pass */
+void AccumulateRow(float const* pRow, float Weight, float* pAccum, uint32_t Width, bool bFirst)
+{
+    const __m128 w = _mm_set1_ps(Weight);
+
+    if (bFirst)
+    {
+        for (uint32_t x = 0; x < Width; x++)
+            _mm_storeu_ps(pAccum + x * 4, _mm_mul_ps(_mm_loadu_ps(pRow + x * 4), w));
+    }
+    else
+    {
+        for (uint32_t x = 0; x < Width; x++)
+            _mm_storeu_ps(pAccum + x * 4, _mm_add_ps(_mm_loadu_ps(pAccum + x * 4), _mm_mul_ps(_mm_loadu_ps(pRow + x * 4), w)));
+    }
+}
+
+/** Horizontal pass */
+void FilterRow(float const* pAccum, FilterTaps const& Taps, float* pDest, uint32_t DestWidth)
+{
+    const uint32_t numTaps = Taps.NumTaps;
+
+    for (uint32_t x = 0; x < DestWidth; x++)
+    {
+        int const*   index  = &Taps.Index[x * numTaps];
+        float const* weight = &Taps.Weight[x * numTaps];
+
+        __m128 sum = _mm_mul_ps(_mm_loadu_ps(pAccum + index[0] * 4), _mm_set1_ps(weight[0]));
+        for (uint32_t k = 1; k < numTaps; k++)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pAccum + index[k] * 4), _mm_set1_ps(weight[k])));
+
+        _mm_storeu_ps(pDest + x * 4, sum);
+    }
+}
+
+/** Fraction of pixels that pass the alpha test */
+float ComputeAlphaCoverage(float const* pPixels, size_t NumPixels, float Threshold, float Scale)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < NumPixels; i++)
+    {
+        if (pPixels[i * 4 + 3] * Scale > Threshold)
+            count++;
+    }
+    return float(count) / NumPixels;
+}
+
+float ComputeBaseAlphaCoverage(MIPMAP_PIXEL_FORMAT Format, void const* pPixels, size_t NumPixels, float Threshold)
+{
+    size_t count = 0;
+    switch (Format)
+    {
+        case MIPMAP_PIXEL_FORMAT_RGBA8:
+        case MIPMAP_PIXEL_FORMAT_SRGBA8: {
+            uint8_t const* src = (uint8_t const*)pPixels;
+            for (size_t i = 0; i < NumPixels; i++)
+                if (src[i * 4 + 3] * (1.0f / 255.0f) > Threshold)
+                    count++;
+            break;
+        }
+        case MIPMAP_PIXEL_FORMAT_RGBA16F: {
+            uint16_t const* src = (uint16_t const*)pPixels;
+            for (size_t i = 0; i < NumPixels; i++)
+                if (f16tof32(src[i * 4 + 3]) > Threshold)
+                    count++;
+            break;
+        }
+        case MIPMAP_PIXEL_FORMAT_RGBA32F: {
+            float const* src = (float const*)pPixels;
+            for (size_t i = 0; i < NumPixels; i++)
+                if (src[i * 4 + 3] > Threshold)
+                    count++;
+            break;
+        }
+    }
+    return float(count) / NumPixels;
+}
+
+/** Binary search for the alpha scale that gives the desired coverage */
+float FindAlphaScale(float const* pPixels, size_t NumPixels, float Threshold, float DesiredCoverage)
+{
+    float minScale = 0.0f;
+    float maxScale = 4.0f;
+    float scale    = 1.0f;
+
+    for (int i = 0; i < 10; i++)
+    {
+        float coverage = ComputeAlphaCoverage(pPixels, NumPixels, Threshold, scale);
+
+        if (coverage < DesiredCoverage)
+            minScale = scale;
+        else if (coverage > DesiredCoverage)
+            maxScale = scale;
+        else
+            break;
+
+        scale = (minScale + maxScale) * 0.5f;
+    }
+    return scale;
+}
+
+/** Runs Fn(ThreadIndex, FirstRow, LastRow) for chunks of rows on up to NumThreads threads */
+template <typename Fn>
+void ParallelRows(uint32_t NumRows, int NumThreads, Fn const& fn)
+{
+    const uint32_t numChunks = (NumRows + ROWS_PER_CHUNK - 1) / ROWS_PER_CHUNK;
+
+    AtomicInt nextChunk{0};
+
+    auto worker = [&](int threadIndex)
+    {
+        for (;;)
+        {
+            uint32_t chunk = (uint32_t)nextChunk.FetchIncrement();
+            if (chunk >= numChunks)
+                break;
+
+            uint32_t firstRow = chunk * ROWS_PER_CHUNK;
+            fn(threadIndex, firstRow, Math::Min(firstRow + ROWS_PER_CHUNK, NumRows));
+        }
+    };
+
+    NumThreads = Math::Min<int>(NumThreads, numChunks);
+    if (NumThreads > 1)
+    {
+        Thread threads[MAX_MIPMAP_THREADS - 1];
+        for (int i = 0; i < NumThreads - 1; i++)
+            threads[i] = Thread([&worker, i]() { worker(i + 1); });
+
+        worker(0);
+
+        for (int i = 0; i < NumThreads - 1; i++)
+            threads[i].Join();
+    }
+    else
+    {
+        worker(0);
+    }
+}
+
+/** Per-thread scratch memory */
+struct MipmapThreadContext
+{
+    /** Ring of decoded rows of the base level */
+    float*   pRowCache;
+    int*     pCachedRow;
+    uint32_t NumCachedRows;
+    /** Result of the vertical pass */
+    float*   pAccum;
+};
+
+} // namespace
+
+bool GetMipmapPixelFormat(TEXTURE_FORMAT Format, MIPMAP_PIXEL_FORMAT& PixelFormat)
+{
+    switch (Format)
+    {
+        case TEXTURE_FORMAT_RGBA8_UNORM:
+        case TEXTURE_FORMAT_BGRA8_UNORM:
+            PixelFormat = MIPMAP_PIXEL_FORMAT_RGBA8;
+            return true;
+        case TEXTURE_FORMAT_SRGBA8_UNORM:
+        case TEXTURE_FORMAT_SBGRA8_UNORM:
+            PixelFormat = MIPMAP_PIXEL_FORMAT_SRGBA8;
+            return true;
+        case TEXTURE_FORMAT_RGBA16_FLOAT:
+            PixelFormat = MIPMAP_PIXEL_FORMAT_RGBA16F;
+            return true;
+        case TEXTURE_FORMAT_RGBA32_FLOAT:
+            PixelFormat = MIPMAP_PIXEL_FORMAT_RGBA32F;
+            return true;
+        default:
+            return false;
+    }
+}
+
+void GenerateMipmapChain(MipmapChainDesc const& Desc, MipmapLevel const* pLevels, uint32_t NumLevels)
+{
+    if (NumLevels < 2)
+        return;
+
+    const MIPMAP_PIXEL_FORMAT format = Desc.Format;
+    const uint32_t bpp = GetBytesPerPixel(format);
+
+    const bool bAlphaWeighted    = Desc.bHasAlpha && !Desc.bPremultipliedAlpha;
+    const bool bPreserveCoverage = Desc.bHasAlpha && Desc.bPreserveAlphaCoverage;
+
+    MipmapLevel const& base = pLevels[0];
+
+    float baseCoverage = 0;
+    if (bPreserveCoverage)
+        baseCoverage = ComputeBaseAlphaCoverage(format, base.pData, size_t(base.Width) * base.Height, Desc.AlphaCoverageThreshold);
+
+    FilterTaps horizontalTaps;
+    FilterTaps verticalTaps;
+
+    // The base level is the only one that is decoded, so the row cache only has to hold its vertical footprint
+    verticalTaps.Build(base.Height, pLevels[1].Height, Desc.Filter, Desc.EdgeMode);
+
+    const uint32_t numCachedRows = Math::Max(2u, verticalTaps.NumTaps);
+
+    int numThreads = Math::Min(Thread::NumHardwareThreads, MAX_MIPMAP_THREADS);
+    numThreads     = Math::Max(1, Math::Min<int>(numThreads, (pLevels[1].Height + ROWS_PER_CHUNK - 1) / ROWS_PER_CHUNK));
+
+    // Filtered levels are kept in linear float so that the next level is not decoded again.
+    // Two buffers are enough: level N reads from one and writes to the other.
+    size_t linearSize[2];
+    linearSize[0] = size_t(pLevels[1].Width) * pLevels[1].Height * 4;
+    linearSize[1] = NumLevels > 2 ? size_t(pLevels[2].Width) * pLevels[2].Height * 4 : 0;
+
+    const size_t threadScratchSize = size_t(numCachedRows + 1) * base.Width * 4;
+
+    HeapBlob scratch((linearSize[0] + linearSize[1] + threadScratchSize * numThreads) * sizeof(float) + numCachedRows * numThreads * sizeof(int));
+
+    float* pLinear[2];
+    pLinear[0] = (float*)scratch.GetData();
+    pLinear[1] = pLinear[0] + linearSize[0];
+
+    MipmapThreadContext contexts[MAX_MIPMAP_THREADS];
+    float* pThreadScratch = pLinear[1] + linearSize[1];
+    int*   pCachedRows    = (int*)(pThreadScratch + threadScratchSize * numThreads);
+    for (int i = 0; i < numThreads; i++)
+    {
+        MipmapThreadContext& context = contexts[i];
+
+        context.pRowCache     = pThreadScratch + threadScratchSize * i;
+        context.pAccum        = context.pRowCache + numCachedRows * base.Width * 4;
+        context.pCachedRow    = pCachedRows + numCachedRows * i;
+        context.NumCachedRows = numCachedRows;
+
+        for (uint32_t row = 0; row < numCachedRows; row++)
+            context.pCachedRow[row] = -1;
+    }
+
+    // Current source level. pSrcLinear is null for the base level.
+    float const* pSrcLinear = nullptr;
+    uint32_t     srcWidth   = base.Width;
+    uint32_t     srcHeight  = base.Height;
+
+    for (uint32_t level = 1; level < NumLevels; level++)
+    {
+        MipmapLevel const& dest = pLevels[level];
+
+        float* pDestLinear = pLinear[(level - 1) & 1];
+
+        const bool bBox2x2 = Desc.Filter == IMAGE_RESAMPLE_FILTER_BOX && srcWidth == dest.Width * 2 && srcHeight == dest.Height * 2;
+        if (!bBox2x2)
+        {
+            horizontalTaps.Build(srcWidth, dest.Width, Desc.Filter, Desc.EdgeMode);
+            if (level > 1)
+                verticalTaps.Build(srcHeight, dest.Height, Desc.Filter, Desc.EdgeMode);
+        }
+
+        // Alpha coverage needs the whole level before the alpha scale is known, so encoding is done in a separate pass
+        const bool bEncodeRows = !bPreserveCoverage;
+
+        ParallelRows(dest.Height, numThreads,
+                     [&](int threadIndex, uint32_t firstRow, uint32_t lastRow)
+                     {
+                         MipmapThreadContext& context = contexts[threadIndex];
+
+                         auto getRow = [&](uint32_t y) -> float const*
+                         {
+                             if (pSrcLinear)
+                                 return pSrcLinear + size_t(y) * srcWidth * 4;
+
+                             uint32_t slot = y % context.NumCachedRows;
+                             float*   row  = context.pRowCache + size_t(slot) * srcWidth * 4;
+                             if (context.pCachedRow[slot] != int(y))
+                             {
+                                 DecodeRow(format, (uint8_t const*)base.pData + size_t(y) * srcWidth * bpp, row, srcWidth, bAlphaWeighted);
+                                 context.pCachedRow[slot] = int(y);
+                             }
+                             return row;
+                         };
+
+                         for (uint32_t y = firstRow; y < lastRow; y++)
+                         {
+                             float* pDestRow = pDestLinear + size_t(y) * dest.Width * 4;
+
+                             if (bBox2x2)
+                             {
+                                 float const* row0 = getRow(y * 2);
+                                 float const* row1 = getRow(y * 2 + 1);
+
+                                 DownsampleRow2x2(row0, row1, pDestRow, dest.Width);
+                             }
+                             else
+                             {
+                                 const uint32_t numTaps = verticalTaps.NumTaps;
+
+                                 int const*   index  = &verticalTaps.Index[y * numTaps];
+                                 float const* weight = &verticalTaps.Weight[y * numTaps];
+
+                                 for (uint32_t k = 0; k < numTaps; k++)
+                                     AccumulateRow(getRow(index[k]), weight[k], context.pAccum, srcWidth, k == 0);
+
+                                 FilterRow(context.pAccum, horizontalTaps, pDestRow, dest.Width);
+                             }
+
+                             if (bEncodeRows)
+                                 EncodeRow(format, pDestRow, (uint8_t*)dest.pData + size_t(y) * dest.Width * bpp, dest.Width, bAlphaWeighted, 1.0f);
+                         }
+                     });
+
+        if (!bEncodeRows)
+        {
+            float alphaScale = FindAlphaScale(pDestLinear, size_t(dest.Width) * dest.Height, Desc.AlphaCoverageThreshold, baseCoverage);
+
+            ParallelRows(dest.Height, numThreads,
+                         [&](int, uint32_t firstRow, uint32_t lastRow)
+                         {
+                             for (uint32_t y = firstRow; y < lastRow; y++)
+                                 EncodeRow(format, pDestLinear + size_t(y) * dest.Width * 4, (uint8_t*)dest.pData + size_t(y) * dest.Width * bpp, dest.Width, bAlphaWeighted, alphaScale);
+                         });
+        }
+
+        pSrcLinear = pDestLinear;
+        srcWidth   = dest.Width;
+        srcHeight  = dest.Height;
+    }
+}
+
+HK_NAMESPACE_END
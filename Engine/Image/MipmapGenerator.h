@@ -0,0 +1,86 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "Image.h"
+
+HK_NAMESPACE_BEGIN
+
+/** Pixel layouts supported by the mipmap generator. */
+enum MIPMAP_PIXEL_FORMAT
+{
+    /** 8-bit unorm, four channels. Also used for BGRA8 since channels are filtered independently. */
+    MIPMAP_PIXEL_FORMAT_RGBA8,
+    /** 8-bit unorm with sRGB color and linear alpha. Filtered in linear space. */
+    MIPMAP_PIXEL_FORMAT_SRGBA8,
+    /** 16-bit float, four channels. */
+    MIPMAP_PIXEL_FORMAT_RGBA16F,
+    /** 32-bit float, four channels. */
+    MIPMAP_PIXEL_FORMAT_RGBA32F
+};
+
+struct MipmapChainDesc
+{
+    /** Pixel format of all levels */
+    MIPMAP_PIXEL_FORMAT Format = MIPMAP_PIXEL_FORMAT_RGBA8;
+    /** Is image has alpha. If enabled, the fourth channel is interpreted as alpha. */
+    bool bHasAlpha = false;
+    /** Set this flag if your image has premultiplied alpha. Otherwise, will be
+    used alpha-weighted resampling. */
+    bool bPremultipliedAlpha = false;
+    /** Scale alpha of each mip so that the fraction of pixels passing the alpha test
+    matches the base level. Useful for alpha tested foliage and fences. */
+    bool bPreserveAlphaCoverage = false;
+    /** Alpha test reference value used to measure coverage */
+    float AlphaCoverageThreshold = 0.5f;
+    /** Edge mode */
+    IMAGE_RESAMPLE_EDGE_MODE EdgeMode = IMAGE_RESAMPLE_EDGE_WRAP;
+    /** Downsampling filter */
+    IMAGE_RESAMPLE_FILTER Filter = IMAGE_RESAMPLE_FILTER_BOX;
+};
+
+struct MipmapLevel
+{
+    /** Tightly packed pixels of the level */
+    void* pData = nullptr;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+};
+
+/** Returns true and writes the matching pixel format if the mipmap generator can handle the texture format. */
+bool GetMipmapPixelFormat(TEXTURE_FORMAT Format, MIPMAP_PIXEL_FORMAT& PixelFormat);
+
+/** Generates a mip chain. pLevels[0] is the source level, levels 1..NumLevels-1 are written.
+Each level is filtered from the previous one in linear float space, so the chain is decoded
+only once. Rows are processed on all hardware threads. */
+void GenerateMipmapChain(MipmapChainDesc const& Desc, MipmapLevel const* pLevels, uint32_t NumLevels);
+
+HK_NAMESPACE_END
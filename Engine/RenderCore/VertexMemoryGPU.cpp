@@ -33,6 +33,24 @@ SOFTWARE.
 
 HK_NAMESPACE_BEGIN
 
+namespace
+{
+
+// Size of per-thread blocks for AllocateJointThreadSafe
+constexpr size_t STREAMED_MEMORY_GPU_THREAD_BLOCK_SIZE = 64 << 10;
+
+struct StreamedThreadBlock
+{
+    StreamedMemoryGPU const* Owner;
+    uint32_t FrameIndex;
+    size_t Offset;
+    size_t End;
+};
+
+thread_local StreamedThreadBlock tl_StreamedThreadBlock;
+
+}
+
 VertexMemoryGPU::VertexMemoryGPU(RenderCore::IDevice* pDevice) :
     m_pDevice(pDevice)
 {
@@ -440,6 +458,8 @@ StreamedMemoryGPU::StreamedMemoryGPU(RenderCore::IDevice* pDevice) :
     m_BufferIndex = 0;
     m_MaxMemoryUsage = 0;
     m_LastAllocatedBlockSize = 0;
+    m_LastAllocatedBlockEnd = 0;
+    m_FrameIndex = 0;
 
     m_VertexBufferAlignment = 32; // TODO: Get from driver!!!
     m_IndexBufferAlignment = 16;  // TODO: Get from driver!!!
@@ -477,6 +497,37 @@ size_t StreamedMemoryGPU::AllocateJoint(size_t _SizeInBytes, const void* _Data)
     return Allocate(_SizeInBytes, m_ConstantBufferAlignment, _Data);
 }
 
+size_t StreamedMemoryGPU::AllocateJointThreadSafe(size_t _SizeInBytes, const void* _Data)
+{
+    HK_ASSERT(_SizeInBytes > 0);
+
+    StreamedThreadBlock& block = tl_StreamedThreadBlock;
+
+    size_t alignedOffset = Align(block.Offset, m_ConstantBufferAlignment);
+
+    // Blocks are invalidated on Swap
+    if (block.Owner != this || block.FrameIndex != m_FrameIndex || alignedOffset + _SizeInBytes > block.End)
+    {
+        size_t blockSize = Math::Max(STREAMED_MEMORY_GPU_THREAD_BLOCK_SIZE, _SizeInBytes);
+
+        block.Owner = this;
+        block.FrameIndex = m_FrameIndex;
+        block.Offset = AllocateBlock(blockSize, m_ConstantBufferAlignment);
+        block.End = block.Offset + blockSize;
+
+        alignedOffset = block.Offset;
+    }
+
+    block.Offset = alignedOffset + _SizeInBytes;
+
+    if (_Data)
+    {
+        Core::Memcpy((byte*)m_pMappedMemory + alignedOffset, _Data, _SizeInBytes);
+    }
+
+    return alignedOffset;
+}
+
 size_t StreamedMemoryGPU::AllocateConstant(size_t _SizeInBytes, const void* _Data)
 {
     return Allocate(_SizeInBytes, m_ConstantBufferAlignment, _Data);
@@ -531,6 +582,9 @@ void StreamedMemoryGPU::Swap()
     m_ChainBuffer[m_BufferIndex].UsedMemory = 0;
 
     m_LastAllocatedBlockSize = 0;
+    m_LastAllocatedBlockEnd = 0;
+
+    m_FrameIndex++;
 }
 
 size_t StreamedMemoryGPU::Allocate(size_t _SizeInBytes, int _Alignment, const void* _Data)
@@ -543,6 +597,23 @@ size_t StreamedMemoryGPU::Allocate(size_t _SizeInBytes, int _Alignment, const vo
         _SizeInBytes = 1;
     }
 
+    size_t alignedOffset = AllocateBlock(_SizeInBytes, _Alignment);
+
+    m_LastAllocatedBlockSize = _SizeInBytes;
+    m_LastAllocatedBlockEnd = alignedOffset + _SizeInBytes;
+
+    if (_Data)
+    {
+        Core::Memcpy((byte*)m_pMappedMemory + alignedOffset, _Data, _SizeInBytes);
+    }
+
+    return alignedOffset;
+}
+
+size_t StreamedMemoryGPU::AllocateBlock(size_t _SizeInBytes, int _Alignment)
+{
+    SpinLockGuard lock(m_AllocatorLock);
+
     ChainBuffer* pChainBuffer = &m_ChainBuffer[m_BufferIndex];
 
     size_t alignedOffset = Align(pChainBuffer->UsedMemory, _Alignment);
@@ -552,29 +623,28 @@ size_t StreamedMemoryGPU::Allocate(size_t _SizeInBytes, int _Alignment, const vo
         CoreApplication::TerminateWithError("StreamedMemoryGPU::Allocate: failed on allocation of {} bytes\nIncrease STREAMED_MEMORY_GPU_BLOCK_SIZE\n", _SizeInBytes);
     }
 
-    m_LastAllocatedBlockSize = _SizeInBytes;
-
     pChainBuffer->UsedMemory = alignedOffset + _SizeInBytes;
     pChainBuffer->HandlesCount++;
 
-    alignedOffset += m_BufferIndex * STREAMED_MEMORY_GPU_BLOCK_SIZE;
-
-    if (_Data)
-    {
-        Core::Memcpy((byte*)m_pMappedMemory + alignedOffset, _Data, _SizeInBytes);
-    }
-
-    return alignedOffset;
+    return alignedOffset + m_BufferIndex * STREAMED_MEMORY_GPU_BLOCK_SIZE;
 }
 
 void StreamedMemoryGPU::ShrinkLastAllocatedMemoryBlock(size_t _SizeInBytes)
 {
     HK_ASSERT(_SizeInBytes <= m_LastAllocatedBlockSize);
 
+    SpinLockGuard lock(m_AllocatorLock);
+
     ChainBuffer* pChainBuffer = &m_ChainBuffer[m_BufferIndex];
+
+    // Some thread could allocate after the last block
+    if (pChainBuffer->UsedMemory + m_BufferIndex * STREAMED_MEMORY_GPU_BLOCK_SIZE != m_LastAllocatedBlockEnd)
+        return;
+
     pChainBuffer->UsedMemory = pChainBuffer->UsedMemory - m_LastAllocatedBlockSize + _SizeInBytes;
 
     m_LastAllocatedBlockSize = _SizeInBytes;
+    m_LastAllocatedBlockEnd = pChainBuffer->UsedMemory + m_BufferIndex * STREAMED_MEMORY_GPU_BLOCK_SIZE;
 }
 
 HK_NAMESPACE_END
@@ -196,13 +196,17 @@ public:
     /** Allocate joint data. Return stream handle. Stream handle is actual during current frame. */
     size_t AllocateJoint(size_t _SizeInBytes, const void* _Data = nullptr);
 
+    /** Allocate joint data from a block owned by the calling thread. Can be called from worker threads concurrently.
+    Return stream handle. Stream handle is actual during current frame. */
+    size_t AllocateJointThreadSafe(size_t _SizeInBytes, const void* _Data = nullptr);
+
     /** Allocate constant data. Return stream handle. Stream handle is actual during current frame. */
     size_t AllocateConstant(size_t _SizeInBytes, const void* _Data = nullptr);
 
     /** Allocate data with custum alignment. Return stream handle. Stream handle is actual during current frame. */
     size_t AllocateWithCustomAlignment(size_t _SizeInBytes, int _Alignment, const void* _Data = nullptr);
 
-    /** Change size of last allocated memory block */
+    /** Change size of last allocated memory block. Does nothing if other block was allocated after it. */
     void ShrinkLastAllocatedMemoryBlock(size_t _SizeInBytes);
 
     /** Map data. Mapped data is actual during current frame. */
@@ -241,6 +245,8 @@ public:
 private:
     size_t Allocate(size_t _SizeInBytes, int _Alignment, const void* _Data);
 
+    size_t AllocateBlock(size_t _SizeInBytes, int _Alignment);
+
     void Wait(RenderCore::SyncObject Sync);
 
     struct ChainBuffer
@@ -258,6 +264,9 @@ private:
     int                       m_BufferIndex;
     size_t                    m_MaxMemoryUsage;
     size_t                    m_LastAllocatedBlockSize;
+    size_t                    m_LastAllocatedBlockEnd;
+    uint32_t                  m_FrameIndex;
+    SpinLock                  m_AllocatorLock;
     int                       m_VertexBufferAlignment;
     int                       m_IndexBufferAlignment;
     int                       m_ConstantBufferAlignment;
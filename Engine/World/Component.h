@@ -118,6 +118,15 @@ namespace ComponentMeta
     {
         return ObjectStorageType::Compact;
     }
+
+    /// Return true to run Update, FixedUpdate and LateUpdate of the component on worker threads.
+    /// The tick methods must only touch the component itself (and data nobody else writes during the tick):
+    /// no creating or destroying objects and components, no changes to hierarchy, no events.
+    template <typename ComponentType>
+    constexpr bool ThreadSafeUpdate()
+    {
+        return false;
+    }
 }
 
 HK_NAMESPACE_END
@@ -32,12 +32,19 @@ SOFTWARE.
 #include "World.h"
 #include "Component.h"
 
+#include <Engine/GameApplication/GameApplication.h>
+
 HK_NAMESPACE_BEGIN
 
 ComponentManagerBase::ComponentManagerBase(World* world, ComponentTypeID componentTypeID) :
     m_World(world), m_ComponentTypeID(componentTypeID)
 {}
 
+AsyncJobManager& ComponentManagerBase::GetJobManager()
+{
+    return GameApplication::GetAsyncJobManager();
+}
+
 void ComponentManagerBase::RegisterTickFunction(TickFunction const& tickFunc)
 {
     m_World->RegisterTickFunction(tickFunc);
@@ -81,6 +81,8 @@ protected:
     void                    InvokeBeginPlay(Component* component);
     void                    InvokeEndPlay(Component* component);
 
+    static AsyncJobManager& GetJobManager();
+
     World*                  m_World;
     ComponentTypeID         m_ComponentTypeID;
     Delegate<void(Component*)> m_OnBeginPlay;
@@ -126,6 +128,10 @@ public:
     template <typename Visitor>
     void                    IterateComponentBatches(Visitor& visitor);
 
+    /// Visit component batches (pages) on worker threads. See ObjectStorage::ParallelIterateBatches.
+    template <typename Visitor>
+    void                    ParallelIterateComponentBatches(Visitor& visitor);
+
 private:
     explicit                ComponentManager(World* world);
 
@@ -145,6 +151,9 @@ private:
     void                    LateUpdate();
     void                    DrawDebug(DebugRenderer& renderer);
 
+    template <typename Method>
+    void                    InvokeTick(Method method);
+
     void                    OnBeginOverlap(ComponentHandle handle, class BodyComponent* body);
     void                    OnEndOverlap(ComponentHandle handle, class BodyComponent* body);
 
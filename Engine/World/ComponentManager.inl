@@ -98,6 +98,7 @@ HK_FORCEINLINE ComponentManager<ComponentType>::ComponentManager(World* world) :
     if constexpr (HK_HAS_METHOD(ComponentType, Update))
     {
         TickFunction tickFunc;
+        tickFunc.Desc.ThreadSafe = ComponentMeta::ThreadSafeUpdate<ComponentType>();
         TickGroup_Update::InitializeTickFunction<ComponentType>(tickFunc.Desc);
         tickFunc.Group = TickGroup::Update;
         tickFunc.Delegate.Bind(this, &ComponentManager<ComponentType>::Update);
@@ -109,6 +110,7 @@ HK_FORCEINLINE ComponentManager<ComponentType>::ComponentManager(World* world) :
     if constexpr (HK_HAS_METHOD(ComponentType, FixedUpdate))
     {
         TickFunction tickFunc;
+        tickFunc.Desc.ThreadSafe = ComponentMeta::ThreadSafeUpdate<ComponentType>();
         TickGroup_FixedUpdate::InitializeTickFunction<ComponentType>(tickFunc.Desc);
         tickFunc.Group = TickGroup::FixedUpdate;
         tickFunc.Delegate.Bind(this, &ComponentManager<ComponentType>::FixedUpdate);
@@ -142,6 +144,7 @@ HK_FORCEINLINE ComponentManager<ComponentType>::ComponentManager(World* world) :
     if constexpr (HK_HAS_METHOD(ComponentType, LateUpdate))
     {
         TickFunction tickFunc;
+        tickFunc.Desc.ThreadSafe = ComponentMeta::ThreadSafeUpdate<ComponentType>();
         TickGroup_LateUpdate::InitializeTickFunction<ComponentType>(tickFunc.Desc);
         tickFunc.Group = TickGroup::LateUpdate;
         tickFunc.Delegate.Bind(this, &ComponentManager<ComponentType>::LateUpdate);
@@ -256,6 +259,13 @@ HK_FORCEINLINE void ComponentManager<ComponentType>::IterateComponentBatches(Vis
     m_ComponentStorage.IterateBatches(visitor);
 }
 
+template <typename ComponentType>
+template <typename Visitor>
+HK_FORCEINLINE void ComponentManager<ComponentType>::ParallelIterateComponentBatches(Visitor& visitor)
+{
+    m_ComponentStorage.ParallelIterateBatches(visitor, GetJobManager());
+}
+
 template <typename ComponentType>
 HK_FORCEINLINE ComponentHandle ComponentManager<ComponentType>::ConstructComponent(Component*& component)
 {
@@ -299,43 +309,64 @@ HK_INLINE void ComponentManager<ComponentType>::EndPlay(Component* component)
 }
 
 template <typename ComponentType>
-HK_INLINE void ComponentManager<ComponentType>::Update()
+template <typename Method>
+HK_FORCEINLINE void ComponentManager<ComponentType>::InvokeTick(Method method)
 {
-    if constexpr (HK_HAS_METHOD(ComponentType, Update))
+    if constexpr (ComponentMeta::ThreadSafeUpdate<ComponentType>())
     {
         struct Visitor
         {
-            HK_FORCEINLINE void Visit(ComponentType& component)
+            Method m_Method;
+
+            HK_FORCEINLINE void Visit(ComponentType* batch, uint32_t count)
             {
-                if (component.IsInitialized())
-                    component.Update();
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    if (batch[i].IsInitialized())
+                        (batch[i].*m_Method)();
+                }
             }
         };
 
-        Visitor visitor;
-        m_ComponentStorage.Iterate(visitor);
+        Visitor visitor{method};
+        m_ComponentStorage.ParallelIterateBatches(visitor, GetJobManager());
     }
-}
-
-template <typename ComponentType>
-HK_INLINE void ComponentManager<ComponentType>::FixedUpdate()
-{
-    if constexpr (HK_HAS_METHOD(ComponentType, FixedUpdate))
+    else
     {
         struct Visitor
         {
+            Method m_Method;
+
             HK_FORCEINLINE void Visit(ComponentType& component)
             {
                 if (component.IsInitialized())
-                    component.FixedUpdate();
+                    (component.*m_Method)();
             }
         };
 
-        Visitor visitor;
+        Visitor visitor{method};
         m_ComponentStorage.Iterate(visitor);
     }
 }
 
+template <typename ComponentType>
+HK_INLINE void ComponentManager<ComponentType>::Update()
+{
+    if constexpr (HK_HAS_METHOD(ComponentType, Update))
+    {
+        InvokeTick(&ComponentType::Update);
+    }
+}
+
+template <typename ComponentType>
+HK_INLINE void ComponentManager<ComponentType>::FixedUpdate()
+{
+    if constexpr (HK_HAS_METHOD(ComponentType, FixedUpdate))
+    {
+        InvokeTick(&ComponentType::FixedUpdate);
+    }
+}
+
 template <typename ComponentType>
 HK_INLINE void ComponentManager<ComponentType>::PhysicsUpdate()
 {
@@ -379,17 +410,7 @@ HK_INLINE void ComponentManager<ComponentType>::LateUpdate()
 {
     if constexpr (HK_HAS_METHOD(ComponentType, LateUpdate))
     {
-        struct Visitor
-        {
-            HK_FORCEINLINE void Visit(ComponentType& component)
-            {
-                if (component.IsInitialized())
-                    component.LateUpdate();
-            }
-        };
-
-        Visitor visitor;
-        m_ComponentStorage.Iterate(visitor);
+        InvokeTick(&ComponentType::LateUpdate);
     }
 }
 
@@ -75,6 +75,7 @@ void GameObject::SetDynamic(bool dynamic)
 void GameObject::SetLockWorldPositionAndRotation(bool lock)
 {
     m_TransformData->LockWorldPositionAndRotation = lock;
+    m_TransformData->Dirty = true;
 }
 
 void GameObject::AddComponent(Component* component)
@@ -165,6 +166,7 @@ void GameObject::LinkToParent()
         parent->m_ChildCount++;
 
         m_TransformData->Parent = parent->m_TransformData;
+        m_TransformData->Dirty = true;
     }
 }
 
@@ -188,6 +190,7 @@ void GameObject::UnlinkFromParent()
         m_Parent = {};
 
         m_TransformData->Parent = nullptr;
+        m_TransformData->Dirty = true;
     }
 }
 
@@ -110,6 +110,36 @@ public:
         KeepWorld
     };
 
+    /// Transform state of the object. Stored in the transform hierarchy of the world.
+    struct TransformData
+    {
+        GameObject*         Owner{};
+        TransformData*      Parent{};
+        bool                LockWorldPositionAndRotation{};
+        bool                AbsolutePosition{};
+        bool                AbsoluteRotation{};
+        bool                AbsoluteScale{};
+        /// Local state has changed since the last transform update
+        bool                Dirty = true;
+        /// Index of the last transform update that changed the world transform
+        uint32_t            UpdateIndex{};
+
+        Float3              Position;
+        Quat                Rotation;
+        Float3              Scale = Float3(1.0f);
+
+        Float3              WorldPosition;
+        Quat                WorldRotation;
+        Float3              WorldScale = Float3(1.0f);
+        Float3x4            WorldTransform;
+
+        void                UpdateWorldTransformMatrix();
+
+        void                UpdateWorldTransform_r();
+
+        void                UpdateWorldTransform();
+    };
+
     void                    SetParent(GameObjectHandle handle, TransformRule transformRule = TransformRule::KeepRelative);
     void                    SetParent(GameObject* parent, TransformRule transformRule = TransformRule::KeepRelative);
     GameObject*             GetParent();
@@ -261,31 +291,6 @@ private:
     uint16_t                m_ChildCount = 0;
     uint16_t                m_HierarchyLevel = 0;
 
-    struct TransformData
-    {
-        GameObject*         Owner{};
-        TransformData*      Parent{};
-        bool                LockWorldPositionAndRotation{};
-        bool                AbsolutePosition{};
-        bool                AbsoluteRotation{};
-        bool                AbsoluteScale{};
-
-        Float3              Position;
-        Quat                Rotation;
-        Float3              Scale = Float3(1.0f);
-
-        Float3              WorldPosition;
-        Quat                WorldRotation;
-        Float3              WorldScale = Float3(1.0f);
-        Float3x4            WorldTransform;
-
-        void                UpdateWorldTransformMatrix();
-
-        void                UpdateWorldTransform_r();
-
-        void                UpdateWorldTransform();
-    };
-
     TransformData*          m_TransformData{};
 
     ComponentVector         m_Components;
@@ -174,27 +174,32 @@ HK_FORCEINLINE bool GameObject::ConstChildIterator::IsValid() const
 
 HK_FORCEINLINE void GameObject::SetPosition(Float3 const& position)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->Position = position;
 }
 
 HK_FORCEINLINE void GameObject::SetRotation(Quat const& rotation)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->Rotation = rotation;
 }
 
 HK_FORCEINLINE void GameObject::SetScale(Float3 const& scale)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->Scale = scale;
 }
 
 HK_FORCEINLINE void GameObject::SetPositionAndRotation(Float3 const& position, Quat const& rotation)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->Position = position;
     m_TransformData->Rotation = rotation;
 }
 
 HK_FORCEINLINE void GameObject::SetTransform(Float3 const& position, Quat const& rotation, Float3 const& scale)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->Position = position;
     m_TransformData->Rotation = rotation;
     m_TransformData->Scale = scale;
@@ -202,6 +207,7 @@ HK_FORCEINLINE void GameObject::SetTransform(Float3 const& position, Quat const&
 
 HK_FORCEINLINE void GameObject::SetTransform(Transform const& transform)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->Position = transform.Position;
     m_TransformData->Rotation = transform.Rotation;
     m_TransformData->Scale = transform.Scale;
@@ -209,6 +215,7 @@ HK_FORCEINLINE void GameObject::SetTransform(Transform const& transform)
 
 HK_FORCEINLINE void GameObject::SetAngles(Angl const& angles)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->Rotation = angles.ToQuat();
 }
 
@@ -219,6 +226,7 @@ HK_FORCEINLINE void GameObject::SetDirection(Float3 const& direction)
 
 HK_FORCEINLINE void GameObject::SetWorldPosition(Float3 const& position)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->WorldPosition = position;
     m_TransformData->UpdateWorldTransformMatrix();
 
@@ -234,6 +242,7 @@ HK_FORCEINLINE void GameObject::SetWorldPosition(Float3 const& position)
 
 HK_FORCEINLINE void GameObject::SetWorldRotation(Quat const& rotation)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->WorldRotation = rotation;
     m_TransformData->UpdateWorldTransformMatrix();
 
@@ -249,6 +258,7 @@ HK_FORCEINLINE void GameObject::SetWorldRotation(Quat const& rotation)
 
 HK_FORCEINLINE void GameObject::SetWorldScale(Float3 const& scale)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->WorldScale = scale;
     m_TransformData->UpdateWorldTransformMatrix();
 
@@ -264,6 +274,7 @@ HK_FORCEINLINE void GameObject::SetWorldScale(Float3 const& scale)
 
 HK_FORCEINLINE void GameObject::SetWorldPositionAndRotation(Float3 const& position, Quat const& rotation)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->WorldPosition = position;
     m_TransformData->WorldRotation = rotation;
     m_TransformData->UpdateWorldTransformMatrix();
@@ -282,6 +293,7 @@ HK_FORCEINLINE void GameObject::SetWorldPositionAndRotation(Float3 const& positi
 
 HK_FORCEINLINE void GameObject::SetWorldTransform(Float3 const& position, Quat const& rotation, Float3 const& scale)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->WorldPosition = position;
     m_TransformData->WorldRotation = rotation;
     m_TransformData->WorldScale    = scale;
@@ -318,16 +330,19 @@ HK_FORCEINLINE void GameObject::SetWorldDirection(Float3 const& direction)
 
 HK_FORCEINLINE void GameObject::SetAbsolutePosition(bool absolutePosition)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->AbsolutePosition = absolutePosition;
 }
 
 HK_FORCEINLINE void GameObject::SetAbsoluteRotation(bool absoluteRotation)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->AbsoluteRotation = absoluteRotation;
 }
 
 HK_FORCEINLINE void GameObject::SetAbsoluteScale(bool absoluteScale)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->AbsoluteScale = absoluteScale;
 }
 
@@ -463,6 +478,8 @@ HK_FORCEINLINE void GameObject::GetWorldVectors(Float3* right, Float3* up, Float
 
 HK_FORCEINLINE void GameObject::Rotate(float degrees, Float3 const& normalizedAxis)
 {
+    m_TransformData->Dirty = true;
+
     float s, c;
 
     Math::DegSinCos(degrees * 0.5f, s, c);
@@ -473,6 +490,7 @@ HK_FORCEINLINE void GameObject::Rotate(float degrees, Float3 const& normalizedAx
 
 HK_FORCEINLINE void GameObject::Move(Float3 const& dir)
 {
+    m_TransformData->Dirty = true;
     m_TransformData->Position += dir;
 }
 
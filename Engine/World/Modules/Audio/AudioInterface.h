@@ -52,7 +52,8 @@ enum class AudioDistanceModel
 };
 
 /// Priority to play the sound.
-/// NOTE: Not used now. Reserved for future to pick a free channel.
+/// When there are more sounds than Snd_MaxVoices, the mixer keeps the voices for sounds with higher priority
+/// and virtualizes the rest.
 enum class AudioChannelPriority : uint8_t
 {
     OneShot  = 0,
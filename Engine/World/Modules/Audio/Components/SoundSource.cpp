@@ -150,6 +150,7 @@ void SoundSource::PlayOneShot(SoundHandle inSound, float inVolumeScale, int inSt
 
     PlayOneShotData& one_shot = m_PlayOneShot.EmplaceBack();
     one_shot.Track.Attach(new AudioTrack(source, inStartFrame, -1, 0, m_VirtualizeWhenSilent));
+    one_shot.Track->Priority = (uint8_t)m_Priority;
     one_shot.NeedToSubmit = true;
     one_shot.VolumeScale = Math::Saturate(inVolumeScale);
 }
@@ -201,6 +202,7 @@ bool SoundSource::StartPlay(SoundHandle inSound, int inStartFrame, int inLoopSta
     m_SoundHandle = inSound;
 
     m_Track.Attach(new AudioTrack(source, inStartFrame, inLoopStart, loops_count, m_VirtualizeWhenSilent));
+    m_Track->Priority = (uint8_t)m_Priority;
     m_NeedToSubmit = true;
  
     return true;
@@ -276,6 +278,11 @@ void SoundSource::SetVirtualizeWhenSilent(bool inVirtualizeWhenSilent)
     m_VirtualizeWhenSilent = inVirtualizeWhenSilent;
 }
 
+void SoundSource::SetPriority(AudioChannelPriority inPriority)
+{
+    m_Priority = inPriority;
+}
+
 void SoundSource::SetVolume(float inVolume)
 {
     m_Volume = Math::Saturate(inVolume);
@@ -128,6 +128,12 @@ public:
     /// Virtualize sound when silent. Looped sounds has this by default.
     bool                    ShouldVirtualizeWhenSilent() const { return m_VirtualizeWhenSilent; }
 
+    /// Sounds with higher priority keep their voices when the mixer runs out of them
+    void                    SetPriority(AudioChannelPriority inPriority);
+
+    /// Sounds with higher priority keep their voices when the mixer runs out of them
+    AudioChannelPriority    GetPriority() const { return m_Priority; }
+
     /// Audio volume scale
     void                    SetVolume(float inVolume);
 
@@ -199,6 +205,7 @@ private:
     GameObjectHandle        m_TargetListener;
     uint32_t                m_ListenerMask = ~0u;
     SoundSourceType         m_SourceType = SoundSourceType::Point;
+    AudioChannelPriority    m_Priority = AudioChannelPriority::OneShot;
     SoundHandle             m_SoundHandle;
     Ref<AudioTrack>        m_Track;
     float                   m_Volume = 1.0f;
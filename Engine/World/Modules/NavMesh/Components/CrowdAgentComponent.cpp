@@ -0,0 +1,138 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "CrowdAgentComponent.h"
+#include <Engine/World/World.h>
+
+HK_NAMESPACE_BEGIN
+
+void CrowdAgentComponent::SetParams(CrowdAgentParams const& params)
+{
+    m_Params = params;
+
+    if (m_Agent != -1)
+        m_Crowd->SetAgentParams(m_Agent, m_Params);
+}
+
+bool CrowdAgentComponent::MoveTo(Float3 const& target)
+{
+    if (m_Agent == -1)
+        return false;
+
+    m_Crowd->RequestMoveTarget(m_Agent, target);
+    return true;
+}
+
+bool CrowdAgentComponent::SetVelocity(Float3 const& velocity)
+{
+    if (m_Agent == -1)
+        return false;
+
+    m_Crowd->RequestMoveVelocity(m_Agent, velocity);
+    return true;
+}
+
+void CrowdAgentComponent::Stop()
+{
+    if (m_Agent != -1)
+        m_Crowd->ResetMoveTarget(m_Agent);
+}
+
+void CrowdAgentComponent::Teleport(Float3 const& position)
+{
+    if (m_Agent != -1)
+        m_Crowd->SetAgentPosition(m_Agent, position);
+    else
+        GetOwner()->SetWorldPosition(position);
+}
+
+CrowdAgentState CrowdAgentComponent::GetAgentState() const
+{
+    if (m_Agent == -1)
+        return CrowdAgentState::Invalid;
+
+    return m_Crowd->GetAgentState(m_Agent);
+}
+
+CrowdMoveState CrowdAgentComponent::GetMoveState() const
+{
+    if (m_Agent == -1)
+        return CrowdMoveState::None;
+
+    return m_Crowd->GetMoveState(m_Agent);
+}
+
+bool CrowdAgentComponent::IsPathPartial() const
+{
+    if (m_Agent == -1)
+        return false;
+
+    return m_Crowd->IsPathPartial(m_Agent);
+}
+
+Float3 CrowdAgentComponent::GetTargetPosition() const
+{
+    if (m_Agent == -1)
+        return GetOwner()->GetWorldPosition();
+
+    return m_Crowd->GetTargetPosition(m_Agent);
+}
+
+Float3 CrowdAgentComponent::GetVelocity() const
+{
+    if (m_Agent == -1)
+        return {};
+
+    return m_Crowd->GetVelocity(m_Agent);
+}
+
+Float3 CrowdAgentComponent::GetDesiredVelocity() const
+{
+    if (m_Agent == -1)
+        return {};
+
+    return m_Crowd->GetDesiredVelocity(m_Agent);
+}
+
+void CrowdAgentComponent::BeginPlay()
+{
+    m_Crowd = &GetWorld()->GetInterface<CrowdInterface>();
+    m_Agent = m_Crowd->AddAgent(GetHandle(), GetOwner()->GetWorldPosition(), m_Params);
+}
+
+void CrowdAgentComponent::EndPlay()
+{
+    if (m_Agent != -1)
+        m_Crowd->RemoveAgent(m_Agent);
+    m_Agent = -1;
+    m_Crowd = nullptr;
+}
+
+HK_NAMESPACE_END
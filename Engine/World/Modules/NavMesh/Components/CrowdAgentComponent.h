@@ -0,0 +1,103 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <Engine/World/Modules/NavMesh/CrowdInterface.h>
+#include <Engine/World/Component.h>
+
+HK_NAMESPACE_BEGIN
+
+/// Moves the owner object along the navmesh, avoiding the other agents. See CrowdInterface.
+class CrowdAgentComponent final : public Component
+{
+    friend class CrowdInterface;
+
+public:
+    //
+    // Meta info
+    //
+
+    static constexpr ComponentMode Mode = ComponentMode::Dynamic;
+
+    //
+    // Properties
+    //
+
+    /// Rotate the owner object around the Y axis to face the movement direction
+    bool                    OrientToVelocity = true;
+
+    /// Agent parameters. Changes are applied on the next crowd update.
+    void                    SetParams(CrowdAgentParams const& params);
+    CrowdAgentParams const& GetParams() const { return m_Params; }
+
+    //
+    // Movement
+    //
+
+    /// Find a path to the target and move along it
+    bool                    MoveTo(Float3 const& target);
+
+    /// Move with the specified velocity, the agent is still constrained to the navmesh
+    bool                    SetVelocity(Float3 const& velocity);
+
+    /// Stop moving
+    void                    Stop();
+
+    /// Place the agent to the specified position
+    void                    Teleport(Float3 const& position);
+
+    CrowdAgentState         GetAgentState() const;
+
+    CrowdMoveState          GetMoveState() const;
+
+    /// The path leads to the closest reachable point, not to the requested target
+    bool                    IsPathPartial() const;
+
+    /// Target position of the path, constrained to the navmesh
+    Float3                  GetTargetPosition() const;
+
+    /// Actual velocity of the agent
+    Float3                  GetVelocity() const;
+
+    /// Velocity the agent wants to move with before the avoidance is applied
+    Float3                  GetDesiredVelocity() const;
+
+    // Internal
+    void                    BeginPlay();
+    void                    EndPlay();
+
+private:
+    CrowdAgentParams        m_Params;
+    CrowdInterface*         m_Crowd{};
+    int                     m_Agent = -1;
+};
+
+HK_NAMESPACE_END
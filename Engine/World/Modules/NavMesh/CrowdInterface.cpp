@@ -0,0 +1,1323 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "CrowdInterface.h"
+#include "Components/CrowdAgentComponent.h"
+
+#include <Engine/Core/ConsoleVar.h>
+#include <Engine/Core/Logger.h>
+#include <Engine/World/World.h>
+#include <Engine/World/DebugRenderer.h>
+#include <Engine/GameApplication/GameApplication.h>
+
+#undef malloc
+#undef free
+
+#include <Detour/DetourNavMesh.h>
+#include <Detour/DetourNavMeshQuery.h>
+#include <Detour/DetourCommon.h>
+#include <Detour/DetourPathCorridor.h>
+#include <Detour/DetourLocalBoundary.h>
+#include <Detour/DetourObstacleAvoidance.h>
+#include <Detour/DetourPathQueue.h>
+#include <Detour/DetourProximityGrid.h>
+
+HK_NAMESPACE_BEGIN
+
+ConsoleVar com_ParallelCrowd("com_ParallelCrowd"s, "1"s, 0, "Update crowd agents on worker threads"s);
+ConsoleVar com_CrowdPathIterations("com_CrowdPathIterations"s, "100"s, 0, "Max A* iterations per frame for the crowd path queue"s);
+ConsoleVar com_DrawCrowdAgents("com_DrawCrowdAgents"s, "0"s, CVAR_CHEAT);
+
+namespace
+{
+
+constexpr int   MAX_NEIGHBOURS = 6;
+constexpr int   MAX_NEIGHBOUR_QUERY = 32;
+constexpr int   MAX_CORNERS = 4;
+constexpr int   MAX_PATH_RESULT = 256;
+constexpr int   MAX_QUICK_SEARCH_RESULT = 32;
+constexpr int   MAX_QUICK_SEARCH_ITERATIONS = 20;
+constexpr int   MAX_PATH_QUEUE_NODES = 4096;
+constexpr int   MAX_COMMON_NODES = 512;
+constexpr int   MAX_PATH_REQUESTS_PER_UPDATE = 8;
+constexpr int   PATH_CHECK_LOOKAHEAD = 10;
+constexpr int   COLLISION_ITERATIONS = 4;
+constexpr float COLLISION_RESOLVE_FACTOR = 0.7f;
+constexpr float TOPOLOGY_OPTIMIZATION_TIME = 0.5f;
+constexpr float TARGET_REPLAN_DELAY = 1.0f;
+
+// Same settings as in the Detour crowd sample, indexed by CrowdAvoidanceQuality
+const dtObstacleAvoidanceParams AvoidanceParams[] =
+{
+    {0.4f, 2.0f, 0.75f, 0.75f, 2.5f, 2.5f, 33, 5, 2, 1},
+    {0.4f, 2.0f, 0.75f, 0.75f, 2.5f, 2.5f, 33, 5, 2, 2},
+    {0.4f, 2.0f, 0.75f, 0.75f, 2.5f, 2.5f, 33, 7, 2, 3},
+    {0.4f, 2.0f, 0.75f, 0.75f, 2.5f, 2.5f, 33, 7, 3, 3}
+};
+
+HK_FORCEINLINE Float3 ToFloat3(const float* v)
+{
+    return Float3(v[0], v[1], v[2]);
+}
+
+HK_FORCEINLINE float Tween(float t, float t0, float t1)
+{
+    return Math::Saturate((t - t0) / (t1 - t0));
+}
+
+} // namespace
+
+struct CrowdNeighbour
+{
+    uint32_t                Agent;
+    float                   DistSqr;
+};
+
+struct CrowdAgent
+{
+    bool                    IsUsed = false;
+    bool                    IsFullUpdate = false;
+    bool                    IsPartial = false;
+    CrowdAgentState         State = CrowdAgentState::Invalid;
+
+    ComponentHandle         Component;
+    CrowdAgentParams        Params;
+    /// Refers to the area costs of Params.Filter. Agents are never deallocated before the crowd is destroyed,
+    /// so the path queue can keep a pointer to the filter after the agent is removed.
+    dtQueryFilter           Filter;
+
+    dtPathCorridor          Corridor;
+    dtLocalBoundary         Boundary;
+    float                   TopologyOptTime = 0;
+
+    CrowdNeighbour          Neighbours[MAX_NEIGHBOURS];
+    int                     NumNeighbours = 0;
+
+    float                   DesiredSpeed = 0;
+    Float3                  NewVelocity;
+    Float3                  Displacement;
+
+    Float3                  CornerVerts[MAX_CORNERS];
+    uint8_t                 CornerFlags[MAX_CORNERS];
+    dtPolyRef               CornerPolys[MAX_CORNERS];
+    int                     NumCorners = 0;
+
+    CrowdMoveState          TargetState = CrowdMoveState::None;
+    /// The target is set, but not yet placed on the navmesh
+    bool                    PlaceTarget = false;
+    bool                    TargetReplan = false;
+    dtPolyRef               TargetRef = 0;
+    /// Target position or velocity for CrowdMoveState::Velocity
+    Float3                  TargetPos;
+    dtPathQueueRef          TargetPathQueueRef = DT_PATHQ_INVALID;
+    float                   TargetReplanTime = 0;
+
+    // Off-mesh link traversal
+    Float3                  AnimInitPos;
+    Float3                  AnimStartPos;
+    Float3                  AnimEndPos;
+    float                   AnimTime = 0;
+    float                   AnimDuration = 0;
+
+    /// Steering and avoidance are updated every UpdateInterval frames
+    uint32_t                UpdateInterval = 1;
+
+    void SetMoveTarget(dtPolyRef ref, Float3 const& pos, bool replan)
+    {
+        TargetRef = ref;
+        TargetPos = pos;
+        TargetPathQueueRef = DT_PATHQ_INVALID;
+        TargetReplan = replan;
+        TargetState = ref ? CrowdMoveState::Requesting : CrowdMoveState::Failed;
+    }
+
+    bool HasTarget() const
+    {
+        return TargetState != CrowdMoveState::None && TargetState != CrowdMoveState::Velocity;
+    }
+
+    bool IsOverOffMeshConnection(Float3 const& position, float radius) const
+    {
+        if (!NumCorners)
+            return false;
+
+        if (!(CornerFlags[NumCorners - 1] & DT_STRAIGHTPATH_OFFMESH_CONNECTION))
+            return false;
+
+        return dtVdist2DSqr(position.ToPtr(), CornerVerts[NumCorners - 1].ToPtr()) < radius * radius;
+    }
+
+    float GetDistanceToGoal(Float3 const& position, float range) const
+    {
+        if (!NumCorners)
+            return range;
+
+        if (CornerFlags[NumCorners - 1] & DT_STRAIGHTPATH_END)
+            return Math::Min(dtVdist2D(position.ToPtr(), CornerVerts[NumCorners - 1].ToPtr()), range);
+
+        return range;
+    }
+
+    Float3 CalcSmoothSteerDirection(Float3 const& position) const
+    {
+        if (!NumCorners)
+            return {};
+
+        Float3 dir0 = CornerVerts[0] - position;
+        Float3 dir1 = CornerVerts[Math::Min(1, NumCorners - 1)] - position;
+        dir0.Y = 0;
+        dir1.Y = 0;
+
+        float len0 = dir0.Length();
+        float len1 = dir1.Length();
+        if (len1 > 0.001f)
+            dir1 /= len1;
+
+        Float3 dir(dir0.X - dir1.X * len0 * 0.5f, 0, dir0.Z - dir1.Z * len0 * 0.5f);
+        dir.NormalizeSelf();
+        return dir;
+    }
+
+    Float3 CalcStraightSteerDirection(Float3 const& position) const
+    {
+        if (!NumCorners)
+            return {};
+
+        Float3 dir = CornerVerts[0] - position;
+        dir.Y = 0;
+        dir.NormalizeSelf();
+        return dir;
+    }
+
+    void AddNeighbour(uint32_t agent, float distSqr)
+    {
+        // Keep the neighbours sorted by distance
+        int i = NumNeighbours;
+        if (i == MAX_NEIGHBOURS)
+        {
+            if (distSqr >= Neighbours[MAX_NEIGHBOURS - 1].DistSqr)
+                return;
+            --i;
+        }
+        else
+            ++NumNeighbours;
+
+        for (; i > 0 && Neighbours[i - 1].DistSqr > distSqr; --i)
+            Neighbours[i] = Neighbours[i - 1];
+
+        Neighbours[i].Agent = agent;
+        Neighbours[i].DistSqr = distSqr;
+    }
+};
+
+struct CrowdThreadContext
+{
+    dtNavMeshQuery*             NavQuery{};
+    dtObstacleAvoidanceQuery*   AvoidanceQuery{};
+
+    ~CrowdThreadContext()
+    {
+        dtFreeNavMeshQuery(NavQuery);
+        dtFreeObstacleAvoidanceQuery(AvoidanceQuery);
+    }
+};
+
+CrowdInterface::CrowdInterface()
+{}
+
+void CrowdInterface::Initialize()
+{
+    TickFunction tickFunc;
+    tickFunc.Desc.Name.FromString("Update Crowd");
+    tickFunc.Desc.TickEvenWhenPaused = false;
+    tickFunc.Group = TickGroup::FixedUpdate;
+    tickFunc.Delegate.Bind(this, &CrowdInterface::Update);
+    tickFunc.OwnerTypeID = GetInterfaceTypeID() | (1 << 31);
+    RegisterTickFunction(tickFunc);
+
+    RegisterDebugDrawFunction({this, &CrowdInterface::DrawDebug});
+}
+
+void CrowdInterface::Deinitialize()
+{
+    m_ThreadContexts.Clear();
+    m_PathQueue.Reset();
+    m_NavMesh = nullptr;
+
+    if (m_Grid)
+    {
+        dtFreeProximityGrid(m_Grid);
+        m_Grid = nullptr;
+    }
+}
+
+int CrowdInterface::AddAgent(ComponentHandle inComponent, Float3 const& inPosition, CrowdAgentParams const& inParams)
+{
+    if (m_NumAgents >= MaxAgents)
+    {
+        LOG("CrowdInterface::AddAgent: Too many agents, max {}\n", MaxAgents);
+        return -1;
+    }
+
+    uint32_t index;
+    if (!m_FreeAgents.IsEmpty())
+    {
+        index = m_FreeAgents.Last();
+        m_FreeAgents.RemoveLast();
+    }
+    else
+    {
+        index = m_Agents.Size();
+
+        UniqueRef<CrowdAgent> agent = MakeUnique<CrowdAgent>();
+        agent->Corridor.init(MAX_PATH_RESULT);
+        m_Agents.Add(std::move(agent));
+
+        m_Positions.Add();
+        m_Velocities.Add();
+        m_DesiredVelocities.Add();
+        m_AgentRadius.Add();
+        m_AgentHeight.Add();
+    }
+
+    CrowdAgent& agent = *m_Agents[index];
+    agent.IsUsed = true;
+    agent.Component = inComponent;
+    agent.TopologyOptTime = 0;
+    agent.TargetState = CrowdMoveState::None;
+    agent.PlaceTarget = false;
+    agent.TargetRef = 0;
+    agent.TargetPos.Clear();
+    agent.TargetReplanTime = 0;
+
+    SetAgentParams(index, inParams);
+
+    m_Positions[index] = inPosition;
+
+    // The agent is placed on the navmesh by the next update
+    ResetAgent(index);
+
+    m_NumAgents++;
+    return index;
+}
+
+void CrowdInterface::RemoveAgent(int inAgent)
+{
+    CrowdAgent& agent = *m_Agents[inAgent];
+
+    HK_ASSERT(agent.IsUsed);
+
+    agent.IsUsed = false;
+    agent.Component = {};
+    agent.TargetState = CrowdMoveState::None;
+    agent.TargetPathQueueRef = DT_PATHQ_INVALID;
+
+    m_FreeAgents.Add(inAgent);
+    m_NumAgents--;
+}
+
+void CrowdInterface::SetAgentParams(int inAgent, CrowdAgentParams const& inParams)
+{
+    CrowdAgent& agent = *m_Agents[inAgent];
+
+    agent.Params = inParams;
+    agent.Params.Radius = Math::Max(agent.Params.Radius, 0.01f);
+    agent.Params.CollisionQueryRange = Math::Max(agent.Params.CollisionQueryRange, agent.Params.Radius);
+    agent.Filter = dtQueryFilter(agent.Params.Filter.GetAreaCosts().ToPtr(), agent.Params.Filter.GetAreaMask());
+
+    m_AgentRadius[inAgent] = agent.Params.Radius;
+    m_AgentHeight[inAgent] = agent.Params.Height;
+}
+
+void CrowdInterface::SetAgentPosition(int inAgent, Float3 const& inPosition)
+{
+    m_Positions[inAgent] = inPosition;
+
+    // The agent is placed on the navmesh again and the path is replanned from the new position
+    ResetAgent(inAgent);
+}
+
+void CrowdInterface::RequestMoveTarget(int inAgent, Float3 const& inPosition)
+{
+    CrowdAgent& agent = *m_Agents[inAgent];
+
+    agent.TargetState = CrowdMoveState::Requesting;
+    agent.TargetRef = 0;
+    agent.TargetPos = inPosition;
+    agent.TargetPathQueueRef = DT_PATHQ_INVALID;
+    agent.TargetReplan = false;
+    agent.PlaceTarget = true;
+}
+
+void CrowdInterface::RequestMoveVelocity(int inAgent, Float3 const& inVelocity)
+{
+    CrowdAgent& agent = *m_Agents[inAgent];
+
+    agent.TargetState = CrowdMoveState::Velocity;
+    agent.TargetRef = 0;
+    agent.TargetPos = inVelocity;
+    agent.TargetPathQueueRef = DT_PATHQ_INVALID;
+    agent.TargetReplan = false;
+    agent.PlaceTarget = false;
+}
+
+void CrowdInterface::ResetMoveTarget(int inAgent)
+{
+    CrowdAgent& agent = *m_Agents[inAgent];
+
+    agent.TargetState = CrowdMoveState::None;
+    agent.TargetRef = 0;
+    agent.TargetPos.Clear();
+    agent.TargetPathQueueRef = DT_PATHQ_INVALID;
+    agent.TargetReplan = false;
+    agent.PlaceTarget = false;
+    agent.NewVelocity.Clear();
+
+    m_DesiredVelocities[inAgent].Clear();
+}
+
+CrowdAgentState CrowdInterface::GetAgentState(int inAgent) const
+{
+    return m_Agents[inAgent]->State;
+}
+
+CrowdMoveState CrowdInterface::GetMoveState(int inAgent) const
+{
+    return m_Agents[inAgent]->TargetState;
+}
+
+bool CrowdInterface::IsPathPartial(int inAgent) const
+{
+    return m_Agents[inAgent]->IsPartial;
+}
+
+Float3 CrowdInterface::GetTargetPosition(int inAgent) const
+{
+    CrowdAgent const& agent = *m_Agents[inAgent];
+
+    if (agent.TargetState == CrowdMoveState::Velocity || agent.TargetState == CrowdMoveState::None)
+        return m_Positions[inAgent];
+
+    return agent.TargetPos;
+}
+
+void CrowdInterface::ResetAgent(int inAgent)
+{
+    CrowdAgent& agent = *m_Agents[inAgent];
+
+    agent.State = CrowdAgentState::Invalid;
+    agent.IsPartial = false;
+    agent.Corridor.reset(0, m_Positions[inAgent].ToPtr());
+    agent.Boundary.reset();
+    agent.NumNeighbours = 0;
+    agent.NumCorners = 0;
+    agent.NewVelocity.Clear();
+    agent.Displacement.Clear();
+    agent.TargetPathQueueRef = DT_PATHQ_INVALID;
+
+    // Polygon references may be invalid now, so the target is placed again
+    if (agent.HasTarget())
+    {
+        agent.TargetState = CrowdMoveState::Requesting;
+        agent.TargetRef = 0;
+        agent.PlaceTarget = true;
+    }
+
+    m_Velocities[inAgent].Clear();
+    m_DesiredVelocities[inAgent].Clear();
+}
+
+bool CrowdInterface::UpdateNavMesh()
+{
+    NavMeshInterface& navMeshInterface = GetWorld()->GetInterface<NavMeshInterface>();
+
+    if (m_NavMesh == navMeshInterface.m_NavMesh && m_NavMeshGeneration == navMeshInterface.m_Generation)
+        return !m_ThreadContexts.IsEmpty();
+
+    m_NavMesh = navMeshInterface.m_NavMesh;
+    m_NavMeshGeneration = navMeshInterface.m_Generation;
+
+    m_ThreadContexts.Clear();
+    m_PathQueue.Reset();
+
+    for (uint32_t i = 0; i < m_Agents.Size(); ++i)
+    {
+        if (m_Agents[i]->IsUsed)
+            ResetAgent(i);
+    }
+
+    if (!m_NavMesh)
+        return false;
+
+    int numThreads = GameApplication::GetAsyncJobManager().GetNumWorkerThreads() + 1;
+    for (int i = 0; i < numThreads; ++i)
+    {
+        UniqueRef<CrowdThreadContext> context = MakeUnique<CrowdThreadContext>();
+
+        context->NavQuery = dtAllocNavMeshQuery();
+        context->AvoidanceQuery = dtAllocObstacleAvoidanceQuery();
+
+        if (!context->NavQuery || dtStatusFailed(context->NavQuery->init(m_NavMesh, MAX_COMMON_NODES)) ||
+            !context->AvoidanceQuery || !context->AvoidanceQuery->init(MAX_NEIGHBOURS, 8))
+        {
+            LOG("CrowdInterface::UpdateNavMesh: Failed to create queries\n");
+            m_ThreadContexts.Clear();
+            return false;
+        }
+
+        m_ThreadContexts.Add(std::move(context));
+    }
+
+    m_PathQueue = MakeUnique<dtPathQueue>();
+    if (!m_PathQueue->init(MAX_PATH_RESULT, MAX_PATH_QUEUE_NODES, m_NavMesh))
+    {
+        LOG("CrowdInterface::UpdateNavMesh: Failed to create path queue\n");
+        m_ThreadContexts.Clear();
+        m_PathQueue.Reset();
+        return false;
+    }
+
+    return true;
+}
+
+CrowdThreadContext& CrowdInterface::GetThreadContext()
+{
+    int threadIndex = GameApplication::GetAsyncJobManager().GetCurrentWorkerIndex();
+    if (threadIndex < 0)
+        threadIndex = m_ThreadContexts.Size() - 1;
+    return *m_ThreadContexts[threadIndex];
+}
+
+template <typename Function>
+void CrowdInterface::ForEachAgent(Vector<uint32_t> const& inAgents, Function const& inFunction)
+{
+    auto process = [this, &inAgents, &inFunction](uint32_t first, uint32_t last)
+    {
+        CrowdThreadContext& context = GetThreadContext();
+        for (uint32_t i = first; i < last; ++i)
+        {
+            uint32_t index = inAgents[i];
+            inFunction(*m_Agents[index], index, context);
+        }
+    };
+
+    if (com_ParallelCrowd)
+        GameApplication::GetAsyncJobManager().ParallelFor(inAgents.Size(), AGENTS_PER_JOB, process);
+    else
+        process(0, inAgents.Size());
+}
+
+void CrowdInterface::UpdateMoveRequest(CrowdAgent& agent, uint32_t index, CrowdThreadContext& context, float timeStep)
+{
+    dtNavMeshQuery* navQuery = context.NavQuery;
+    Float3& position = m_Positions[index];
+
+    if (agent.State == CrowdAgentState::Invalid)
+    {
+        // The navmesh could be missing under the agent when it was added
+        dtPolyRef ref = 0;
+        Float3 nearest = position;
+        navQuery->findNearestPoly(position.ToPtr(), PlacementExtents.ToPtr(), &agent.Filter, &ref, nearest.ToPtr());
+        if (!ref)
+            return;
+
+        position = nearest;
+        agent.Corridor.reset(ref, position.ToPtr());
+        agent.Boundary.reset();
+        agent.IsPartial = false;
+        agent.State = CrowdAgentState::Walking;
+    }
+    else if (agent.IsFullUpdate)
+        CheckPathValidity(agent, index, context, timeStep);
+
+    if (agent.State != CrowdAgentState::Walking)
+        return;
+
+    if (agent.PlaceTarget)
+    {
+        agent.PlaceTarget = false;
+
+        dtPolyRef ref = 0;
+        Float3 nearest = agent.TargetPos;
+        navQuery->findNearestPoly(agent.TargetPos.ToPtr(), PlacementExtents.ToPtr(), &agent.Filter, &ref, nearest.ToPtr());
+        agent.SetMoveTarget(ref, nearest, false);
+    }
+
+    if (agent.TargetState != CrowdMoveState::Requesting)
+        return;
+
+    // Quick search towards the target, the rest of the path is searched by the path queue
+    dtPolyRef const* path = agent.Corridor.getPath();
+    const int pathCount = agent.Corridor.getPathCount();
+    HK_ASSERT(pathCount);
+
+    dtPolyRef requestPath[MAX_QUICK_SEARCH_RESULT];
+    int requestPathCount = 0;
+    Float3 requestPos;
+
+    navQuery->initSlicedFindPath(path[0], agent.TargetRef, position.ToPtr(), agent.TargetPos.ToPtr(), &agent.Filter);
+    navQuery->updateSlicedFindPath(MAX_QUICK_SEARCH_ITERATIONS, nullptr);
+
+    dtStatus status;
+    if (agent.TargetReplan)
+    {
+        // Try to keep the existing path during replan
+        status = navQuery->finalizeSlicedFindPathPartial(path, pathCount, requestPath, &requestPathCount, MAX_QUICK_SEARCH_RESULT);
+    }
+    else
+    {
+        // Start moving towards the new target right away
+        status = navQuery->finalizeSlicedFindPath(requestPath, &requestPathCount, MAX_QUICK_SEARCH_RESULT);
+    }
+
+    if (!dtStatusFailed(status) && requestPathCount > 0)
+    {
+        if (requestPath[requestPathCount - 1] != agent.TargetRef)
+        {
+            // Partial path, constrain the target position inside the last polygon
+            status = navQuery->closestPointOnPoly(requestPath[requestPathCount - 1], agent.TargetPos.ToPtr(), requestPos.ToPtr(), nullptr);
+            if (dtStatusFailed(status))
+                requestPathCount = 0;
+        }
+        else
+            requestPos = agent.TargetPos;
+    }
+    else
+        requestPathCount = 0;
+
+    if (!requestPathCount)
+    {
+        // Could not find a path, start the request from the current location
+        requestPos = position;
+        requestPath[0] = path[0];
+        requestPathCount = 1;
+    }
+
+    agent.Corridor.setCorridor(requestPos.ToPtr(), requestPath, requestPathCount);
+    agent.Boundary.reset();
+    agent.IsPartial = false;
+
+    if (requestPath[requestPathCount - 1] == agent.TargetRef)
+    {
+        agent.TargetState = CrowdMoveState::Valid;
+        agent.TargetReplanTime = 0;
+    }
+    else
+    {
+        // The path is longer or unreachable, wait for the full search
+        agent.TargetState = CrowdMoveState::WaitingForQueue;
+    }
+}
+
+void CrowdInterface::CheckPathValidity(CrowdAgent& agent, uint32_t index, CrowdThreadContext& context, float timeStep)
+{
+    if (agent.State != CrowdAgentState::Walking)
+        return;
+
+    dtNavMeshQuery* navQuery = context.NavQuery;
+    Float3& position = m_Positions[index];
+
+    agent.TargetReplanTime += timeStep * agent.UpdateInterval;
+
+    bool replan = false;
+
+    // First check that the current location is valid
+    dtPolyRef agentRef = agent.Corridor.getFirstPoly();
+    if (!navQuery->isValidPolyRef(agentRef, &agent.Filter))
+    {
+        // Current location is not valid, try to reposition
+        Float3 nearest = position;
+        agentRef = 0;
+        navQuery->findNearestPoly(position.ToPtr(), PlacementExtents.ToPtr(), &agent.Filter, &agentRef, nearest.ToPtr());
+        if (!agentRef)
+        {
+            // Could not find a location on the navmesh
+            agent.Corridor.reset(0, position.ToPtr());
+            agent.IsPartial = false;
+            agent.Boundary.reset();
+            agent.State = CrowdAgentState::Invalid;
+            return;
+        }
+
+        position = nearest;
+        agent.Corridor.fixPathStart(agentRef, position.ToPtr());
+        agent.Boundary.reset();
+        replan = true;
+    }
+
+    if (!agent.HasTarget() || agent.PlaceTarget)
+        return;
+
+    // Try to recover the move request position
+    if (agent.TargetState != CrowdMoveState::Failed)
+    {
+        if (!navQuery->isValidPolyRef(agent.TargetRef, &agent.Filter))
+        {
+            Float3 nearest = agent.TargetPos;
+            agent.TargetRef = 0;
+            navQuery->findNearestPoly(agent.TargetPos.ToPtr(), PlacementExtents.ToPtr(), &agent.Filter, &agent.TargetRef, nearest.ToPtr());
+            agent.TargetPos = nearest;
+            replan = true;
+        }
+        if (!agent.TargetRef)
+        {
+            // Failed to reposition the target, the agent stops
+            agent.Corridor.reset(agentRef, position.ToPtr());
+            agent.IsPartial = false;
+            agent.TargetState = CrowdMoveState::None;
+        }
+    }
+
+    // If the path is blocked by a changed navmesh, replan
+    if (!agent.Corridor.isValid(PATH_CHECK_LOOKAHEAD, navQuery, &agent.Filter))
+        replan = true;
+
+    // If the end of the path is near and it is not the requested location, replan
+    if (agent.TargetState == CrowdMoveState::Valid)
+    {
+        if (agent.TargetReplanTime > TARGET_REPLAN_DELAY &&
+            agent.Corridor.getPathCount() < PATH_CHECK_LOOKAHEAD &&
+            agent.Corridor.getLastPoly() != agent.TargetRef)
+            replan = true;
+    }
+
+    if (replan && agent.TargetState != CrowdMoveState::None)
+        agent.SetMoveTarget(agent.TargetRef, agent.TargetPos, true);
+}
+
+void CrowdInterface::UpdatePathQueue()
+{
+    // Agents waiting the longest go first
+    CrowdAgent* queue[MAX_PATH_REQUESTS_PER_UPDATE];
+    int queueSize = 0;
+
+    for (uint32_t index : m_ActiveAgents)
+    {
+        CrowdAgent* agent = m_Agents[index].RawPtr();
+        if (agent->State == CrowdAgentState::Invalid || agent->TargetState != CrowdMoveState::WaitingForQueue)
+            continue;
+
+        int slot = queueSize;
+        if (queueSize == MAX_PATH_REQUESTS_PER_UPDATE)
+        {
+            if (agent->TargetReplanTime <= queue[queueSize - 1]->TargetReplanTime)
+                continue;
+            --slot;
+        }
+        else
+            ++queueSize;
+
+        for (; slot > 0 && queue[slot - 1]->TargetReplanTime < agent->TargetReplanTime; --slot)
+            queue[slot] = queue[slot - 1];
+        queue[slot] = agent;
+    }
+
+    for (int i = 0; i < queueSize; ++i)
+    {
+        CrowdAgent* agent = queue[i];
+        agent->TargetPathQueueRef = m_PathQueue->request(agent->Corridor.getLastPoly(), agent->TargetRef,
+                                                         agent->Corridor.getTarget(), agent->TargetPos.ToPtr(), &agent->Filter);
+        if (agent->TargetPathQueueRef != DT_PATHQ_INVALID)
+            agent->TargetState = CrowdMoveState::WaitingForPath;
+    }
+
+    m_PathQueue->update(Math::Max(com_CrowdPathIterations.GetInteger(), 1));
+
+    dtNavMeshQuery* navQuery = GetThreadContext().NavQuery;
+    dtPolyRef result[MAX_PATH_RESULT];
+
+    for (uint32_t index : m_ActiveAgents)
+    {
+        CrowdAgent& agent = *m_Agents[index];
+        if (agent.TargetState != CrowdMoveState::WaitingForPath)
+            continue;
+
+        dtStatus status = m_PathQueue->getRequestStatus(agent.TargetPathQueueRef);
+        if (dtStatusFailed(status))
+        {
+            // Path search failed, retry if the target location is still valid
+            agent.TargetPathQueueRef = DT_PATHQ_INVALID;
+            agent.TargetState = agent.TargetRef ? CrowdMoveState::Requesting : CrowdMoveState::Failed;
+            agent.TargetReplanTime = 0;
+        }
+        else if (dtStatusSucceed(status))
+        {
+            dtPolyRef const* path = agent.Corridor.getPath();
+            const int pathCount = agent.Corridor.getPathCount();
+            HK_ASSERT(pathCount);
+
+            Float3 targetPos = agent.TargetPos;
+
+            int resultCount = 0;
+            status = m_PathQueue->getPathResult(agent.TargetPathQueueRef, result, &resultCount, MAX_PATH_RESULT);
+            bool valid = !dtStatusFailed(status) && resultCount;
+
+            agent.IsPartial = dtStatusDetail(status, DT_PARTIAL_RESULT);
+
+            // The agent might have moved while the request was processed, so the result is merged with the
+            // current corridor. The end of the corridor is where the request was issued.
+            if (valid && path[pathCount - 1] != result[0])
+                valid = false;
+
+            if (valid)
+            {
+                if (pathCount > 1)
+                {
+                    if ((pathCount - 1) + resultCount > MAX_PATH_RESULT)
+                        resultCount = MAX_PATH_RESULT - (pathCount - 1);
+
+                    memmove(result + pathCount - 1, result, sizeof(dtPolyRef) * resultCount);
+                    memcpy(result, path, sizeof(dtPolyRef) * (pathCount - 1));
+                    resultCount += pathCount - 1;
+
+                    // Remove trackbacks
+                    for (int j = 1; j < resultCount - 1; ++j)
+                    {
+                        if (result[j - 1] == result[j + 1])
+                        {
+                            memmove(result + (j - 1), result + (j + 1), sizeof(dtPolyRef) * (resultCount - (j + 1)));
+                            resultCount -= 2;
+                            j = Math::Max(j - 2, 0);
+                        }
+                    }
+                }
+
+                if (result[resultCount - 1] != agent.TargetRef)
+                {
+                    // Partial path, constrain the target position inside the last polygon
+                    Float3 nearest;
+                    if (dtStatusSucceed(navQuery->closestPointOnPoly(result[resultCount - 1], targetPos.ToPtr(), nearest.ToPtr(), nullptr)))
+                        targetPos = nearest;
+                    else
+                        valid = false;
+                }
+            }
+
+            if (valid)
+            {
+                agent.Corridor.setCorridor(targetPos.ToPtr(), result, resultCount);
+                agent.Boundary.reset();
+                agent.TargetState = CrowdMoveState::Valid;
+            }
+            else
+                agent.TargetState = CrowdMoveState::Failed;
+
+            agent.TargetReplanTime = 0;
+        }
+    }
+}
+
+void CrowdInterface::UpdateTopologyOptimization()
+{
+    CrowdAgent* candidate = nullptr;
+
+    for (uint32_t index : m_ActiveAgents)
+    {
+        CrowdAgent& agent = *m_Agents[index];
+        if (agent.State != CrowdAgentState::Walking)
+            continue;
+        if (agent.TargetState == CrowdMoveState::None || agent.TargetState == CrowdMoveState::Velocity)
+            continue;
+        if (!(agent.Params.Flags & CrowdAgentFlags::OptimizeTopology))
+            continue;
+
+        agent.TopologyOptTime += GetWorld()->GetTick().FixedTimeStep;
+        if (agent.TopologyOptTime >= TOPOLOGY_OPTIMIZATION_TIME && (!candidate || agent.TopologyOptTime > candidate->TopologyOptTime))
+            candidate = &agent;
+    }
+
+    // One agent per update, the optimization is expensive
+    if (candidate)
+    {
+        candidate->Corridor.optimizePathTopology(GetThreadContext().NavQuery, &candidate->Filter);
+        candidate->TopologyOptTime = 0;
+    }
+}
+
+void CrowdInterface::UpdateProximityGrid()
+{
+    float maxRadius = 0;
+    for (uint32_t index : m_ActiveAgents)
+        maxRadius = Math::Max(maxRadius, m_AgentRadius[index]);
+
+    // An agent overlaps at most four cells when the cell size is larger than the agent diameter.
+    // AddAgent limits the agent count, so the pool always fits all of them.
+    static_assert(MaxAgents * 4 <= 0xffff, "The proximity grid pool is indexed with unsigned short");
+    HK_ASSERT(m_ActiveAgents.Size() <= MaxAgents);
+
+    float cellSize = maxRadius * 3;
+    int poolSize = Math::Max<int>(m_ActiveAgents.Size() * 4, 64);
+
+    if (!m_Grid || poolSize > m_GridPoolSize || cellSize != m_GridCellSize)
+    {
+        if (!m_Grid)
+            m_Grid = dtAllocProximityGrid();
+
+        m_GridPoolSize = Math::Min(Math::Max(poolSize, m_GridPoolSize * 2), 0xffff);
+        m_GridCellSize = cellSize;
+
+        if (!m_Grid->init(m_GridPoolSize, m_GridCellSize))
+            LOG("CrowdInterface::UpdateProximityGrid: Failed to initialize the grid\n");
+    }
+
+    m_Grid->clear();
+
+    for (uint32_t i = 0; i < m_ActiveAgents.Size(); ++i)
+    {
+        uint32_t index = m_ActiveAgents[i];
+        Float3 const& p = m_Positions[index];
+        const float r = m_AgentRadius[index];
+        m_Grid->addItem(static_cast<unsigned short>(i), p.X - r, p.Z - r, p.X + r, p.Z + r);
+    }
+}
+
+void CrowdInterface::FindNeighbours(CrowdAgent& agent, uint32_t index)
+{
+    Float3 const& position = m_Positions[index];
+    const float range = agent.Params.CollisionQueryRange;
+
+    unsigned short ids[MAX_NEIGHBOUR_QUERY];
+    int count = m_Grid->queryItems(position.X - range, position.Z - range, position.X + range, position.Z + range, ids, MAX_NEIGHBOUR_QUERY);
+
+    agent.NumNeighbours = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        uint32_t other = m_ActiveAgents[ids[i]];
+        if (other == index)
+            continue;
+
+        Float3 diff = position - m_Positions[other];
+        if (Math::Abs(diff.Y) >= (agent.Params.Height + m_AgentHeight[other]) * 0.5f)
+            continue;
+
+        diff.Y = 0;
+        float distSqr = diff.LengthSqr();
+        if (distSqr > range * range)
+            continue;
+
+        agent.AddNeighbour(other, distSqr);
+    }
+}
+
+void CrowdInterface::UpdateSteering(CrowdAgent& agent, uint32_t index, CrowdThreadContext& context)
+{
+    if (agent.State != CrowdAgentState::Walking)
+        return;
+
+    dtNavMeshQuery* navQuery = context.NavQuery;
+    Float3 const& position = m_Positions[index];
+
+    // Update the collision boundary after the agent has moved far enough
+    const float updateThreshold = agent.Params.CollisionQueryRange * 0.25f;
+    if (dtVdist2DSqr(position.ToPtr(), agent.Boundary.getCenter()) > Math::Square(updateThreshold) ||
+        !agent.Boundary.isValid(navQuery, &agent.Filter))
+    {
+        agent.Boundary.update(agent.Corridor.getFirstPoly(), position.ToPtr(), agent.Params.CollisionQueryRange, navQuery, &agent.Filter);
+    }
+
+    FindNeighbours(agent, index);
+
+    if (!agent.HasTarget())
+    {
+        agent.NumCorners = 0;
+    }
+    else
+    {
+        agent.NumCorners = agent.Corridor.findCorners(agent.CornerVerts[0].ToPtr(), agent.CornerFlags, agent.CornerPolys, MAX_CORNERS, navQuery, &agent.Filter);
+
+        // Shortcut the path when the second corner is visible
+        if (!!(agent.Params.Flags & CrowdAgentFlags::OptimizeVisibility) && agent.NumCorners > 0)
+        {
+            Float3 const& target = agent.CornerVerts[Math::Min(1, agent.NumCorners - 1)];
+            agent.Corridor.optimizePathVisibility(target.ToPtr(), agent.Params.PathOptimizationRange, navQuery, &agent.Filter);
+        }
+
+        // Start traversing the off-mesh link when the agent is close enough
+        const float triggerRadius = agent.Params.Radius * 2.25f;
+        if (agent.IsOverOffMeshConnection(position, triggerRadius))
+        {
+            dtPolyRef refs[2];
+            if (agent.Corridor.moveOverOffmeshConnection(agent.CornerPolys[agent.NumCorners - 1], refs, agent.AnimStartPos.ToPtr(), agent.AnimEndPos.ToPtr(), navQuery))
+            {
+                agent.AnimInitPos = position;
+                agent.AnimTime = 0;
+                agent.AnimDuration = dtVdist2D(agent.AnimStartPos.ToPtr(), agent.AnimEndPos.ToPtr()) / agent.Params.MaxSpeed * 0.5f;
+                agent.State = CrowdAgentState::OffMeshLink;
+                agent.NumCorners = 0;
+                agent.NumNeighbours = 0;
+                return;
+            }
+        }
+    }
+
+    if (agent.TargetState == CrowdMoveState::None)
+        return;
+
+    Float3 desiredVelocity;
+    if (agent.TargetState == CrowdMoveState::Velocity)
+    {
+        desiredVelocity = agent.TargetPos;
+        agent.DesiredSpeed = desiredVelocity.Length();
+    }
+    else
+    {
+        Float3 dir = !!(agent.Params.Flags & CrowdAgentFlags::AnticipateTurns) ? agent.CalcSmoothSteerDirection(position) : agent.CalcStraightSteerDirection(position);
+
+        // Slow down at the end of the path
+        const float slowDownRadius = agent.Params.Radius * 2;
+        const float speedScale = agent.GetDistanceToGoal(position, slowDownRadius) / slowDownRadius;
+
+        agent.DesiredSpeed = agent.Params.MaxSpeed;
+        desiredVelocity = dir * (agent.DesiredSpeed * speedScale);
+    }
+
+    if (!!(agent.Params.Flags & CrowdAgentFlags::Separation))
+    {
+        const float separationDist = agent.Params.CollisionQueryRange;
+        const float invSeparationDist = 1.0f / separationDist;
+
+        float w = 0;
+        Float3 displacement;
+
+        for (int i = 0; i < agent.NumNeighbours; ++i)
+        {
+            Float3 diff = position - m_Positions[agent.Neighbours[i].Agent];
+            diff.Y = 0;
+
+            const float distSqr = diff.LengthSqr();
+            if (distSqr < 0.00001f || distSqr > Math::Square(separationDist))
+                continue;
+
+            const float dist = std::sqrt(distSqr);
+            const float weight = agent.Params.SeparationWeight * (1.0f - Math::Square(dist * invSeparationDist));
+
+            displacement += diff * (weight / dist);
+            w += 1.0f;
+        }
+
+        if (w > 0.0001f)
+        {
+            desiredVelocity += displacement * (1.0f / w);
+
+            // Clamp the desired velocity to the desired speed
+            const float speedSqr = desiredVelocity.LengthSqr();
+            const float desiredSqr = Math::Square(agent.DesiredSpeed);
+            if (speedSqr > desiredSqr)
+                desiredVelocity *= desiredSqr / speedSqr;
+        }
+    }
+
+    m_DesiredVelocities[index] = desiredVelocity;
+}
+
+void CrowdInterface::PlanVelocity(CrowdAgent& agent, uint32_t index, CrowdThreadContext& context)
+{
+    if (agent.State != CrowdAgentState::Walking)
+        return;
+
+    if (!(agent.Params.Flags & CrowdAgentFlags::ObstacleAvoidance))
+    {
+        agent.NewVelocity = m_DesiredVelocities[index];
+        return;
+    }
+
+    Float3 const& position = m_Positions[index];
+    dtObstacleAvoidanceQuery* avoidance = context.AvoidanceQuery;
+
+    avoidance->reset();
+
+    for (int i = 0; i < agent.NumNeighbours; ++i)
+    {
+        uint32_t other = agent.Neighbours[i].Agent;
+        avoidance->addCircle(m_Positions[other].ToPtr(), m_AgentRadius[other], m_Velocities[other].ToPtr(), m_DesiredVelocities[other].ToPtr());
+    }
+
+    for (int i = 0; i < agent.Boundary.getSegmentCount(); ++i)
+    {
+        const float* s = agent.Boundary.getSegment(i);
+        // Skip the segments the agent is behind
+        if (dtTriArea2D(position.ToPtr(), s, s + 3) < 0.0f)
+            continue;
+        avoidance->addSegment(s, s + 3);
+    }
+
+    avoidance->sampleVelocityAdaptive(position.ToPtr(), agent.Params.Radius, agent.DesiredSpeed,
+                                      m_Velocities[index].ToPtr(), m_DesiredVelocities[index].ToPtr(), agent.NewVelocity.ToPtr(),
+                                      &AvoidanceParams[static_cast<int>(agent.Params.AvoidanceQuality)]);
+}
+
+void CrowdInterface::Integrate(CrowdAgent& agent, uint32_t index, float timeStep)
+{
+    if (agent.State != CrowdAgentState::Walking)
+        return;
+
+    Float3& velocity = m_Velocities[index];
+
+    // Limit the acceleration
+    const float maxDelta = agent.Params.MaxAcceleration * timeStep;
+    Float3 dv = agent.NewVelocity - velocity;
+    const float ds = dv.Length();
+    if (ds > maxDelta)
+        dv *= maxDelta / ds;
+    velocity += dv;
+
+    if (velocity.LengthSqr() > Math::Square(0.0001f))
+        m_Positions[index] += velocity * timeStep;
+    else
+        velocity.Clear();
+}
+
+void CrowdInterface::CalcCollisionDisplacement(CrowdAgent& agent, uint32_t index)
+{
+    agent.Displacement.Clear();
+
+    if (agent.State != CrowdAgentState::Walking)
+        return;
+
+    Float3 const& position = m_Positions[index];
+    float w = 0;
+
+    for (int i = 0; i < agent.NumNeighbours; ++i)
+    {
+        uint32_t other = agent.Neighbours[i].Agent;
+
+        Float3 diff = position - m_Positions[other];
+        diff.Y = 0;
+
+        const float radius = agent.Params.Radius + m_AgentRadius[other];
+        float dist = diff.LengthSqr();
+        if (dist > radius * radius)
+            continue;
+
+        dist = std::sqrt(dist);
+        float penetration;
+        if (dist < 0.0001f)
+        {
+            // Agents on top of each other, try to choose diverging separation directions
+            Float3 const& desiredVelocity = m_DesiredVelocities[index];
+            if (index > other)
+                diff = Float3(-desiredVelocity.Z, 0, desiredVelocity.X);
+            else
+                diff = Float3(desiredVelocity.Z, 0, -desiredVelocity.X);
+            penetration = 0.01f;
+        }
+        else
+            penetration = (1.0f / dist) * ((radius - dist) * 0.5f) * COLLISION_RESOLVE_FACTOR;
+
+        agent.Displacement += diff * penetration;
+        w += 1.0f;
+    }
+
+    if (w > 0.0001f)
+        agent.Displacement /= w;
+}
+
+void CrowdInterface::MoveAlongNavMesh(CrowdAgent& agent, uint32_t index, CrowdThreadContext& context, float timeStep)
+{
+    Float3& position = m_Positions[index];
+
+    if (agent.State == CrowdAgentState::OffMeshLink)
+    {
+        agent.AnimTime += timeStep;
+        if (agent.AnimTime > agent.AnimDuration)
+        {
+            agent.State = CrowdAgentState::Walking;
+            return;
+        }
+
+        // Approach the start of the link, then move to the end
+        const float t0 = agent.AnimDuration * 0.15f;
+        if (agent.AnimTime < t0)
+            position = Math::Lerp(agent.AnimInitPos, agent.AnimStartPos, Tween(agent.AnimTime, 0.0f, t0));
+        else
+            position = Math::Lerp(agent.AnimStartPos, agent.AnimEndPos, Tween(agent.AnimTime, t0, agent.AnimDuration));
+
+        m_Velocities[index].Clear();
+        m_DesiredVelocities[index].Clear();
+        return;
+    }
+
+    if (agent.State != CrowdAgentState::Walking)
+        return;
+
+    // Constrain the position to the navmesh
+    agent.Corridor.movePosition(position.ToPtr(), context.NavQuery, &agent.Filter);
+    position = ToFloat3(agent.Corridor.getPos());
+
+    // Without a target the corridor only tracks the agent position
+    if (!agent.HasTarget())
+    {
+        agent.Corridor.reset(agent.Corridor.getFirstPoly(), position.ToPtr());
+        agent.IsPartial = false;
+    }
+}
+
+void CrowdInterface::WriteTransforms()
+{
+    World* world = GetWorld();
+
+    for (uint32_t index : m_ActiveAgents)
+    {
+        CrowdAgent const& agent = *m_Agents[index];
+        if (agent.State == CrowdAgentState::Invalid)
+            continue;
+
+        CrowdAgentComponent* component = world->GetComponent(Handle32<CrowdAgentComponent>(agent.Component));
+        if (!component)
+            continue;
+
+        GameObject* owner = component->GetOwner();
+
+        Float3 const& velocity = m_Velocities[index];
+        if (component->OrientToVelocity && velocity.X * velocity.X + velocity.Z * velocity.Z > 0.0001f)
+            owner->SetWorldPositionAndRotation(m_Positions[index], Quat::RotationY(Math::Atan2(-velocity.X, -velocity.Z)));
+        else
+            owner->SetWorldPosition(m_Positions[index]);
+    }
+}
+
+void CrowdInterface::Update()
+{
+    if (!UpdateNavMesh())
+        return;
+
+    const float timeStep = GetWorld()->GetTick().FixedTimeStep;
+
+    m_FrameIndex++;
+
+    // Distant agents run the expensive steps less often
+    const float lodDistSqr0 = Math::Square(LodDistance0);
+    const float lodDistSqr1 = Math::Square(LodDistance1);
+
+    m_ActiveAgents.Clear();
+    m_FullUpdateAgents.Clear();
+    for (uint32_t i = 0; i < m_Agents.Size(); ++i)
+    {
+        CrowdAgent& agent = *m_Agents[i];
+        if (!agent.IsUsed)
+            continue;
+
+        const float distSqr = m_Positions[i].DistSqr(m_LodOrigin);
+        agent.UpdateInterval = distSqr < lodDistSqr0 ? 1 : (distSqr < lodDistSqr1 ? 2 : 4);
+        agent.IsFullUpdate = ((m_FrameIndex + i) & (agent.UpdateInterval - 1)) == 0;
+
+        m_ActiveAgents.Add(i);
+        if (agent.IsFullUpdate)
+            m_FullUpdateAgents.Add(i);
+    }
+
+    if (m_ActiveAgents.IsEmpty())
+        return;
+
+    // Place the agents, check the paths and start the new move requests
+    ForEachAgent(m_ActiveAgents, [this, timeStep](CrowdAgent& agent, uint32_t index, CrowdThreadContext& context)
+    {
+        UpdateMoveRequest(agent, index, context, timeStep);
+    });
+
+    // Shared state, updated on this thread
+    UpdatePathQueue();
+    UpdateTopologyOptimization();
+    UpdateProximityGrid();
+
+    // Neighbours, corners and desired velocities. Reads the neighbour positions only.
+    ForEachAgent(m_FullUpdateAgents, [this](CrowdAgent& agent, uint32_t index, CrowdThreadContext& context)
+    {
+        UpdateSteering(agent, index, context);
+    });
+
+    // Obstacle avoidance reads the desired velocities of the neighbours, so it runs after all of them are known
+    ForEachAgent(m_FullUpdateAgents, [this](CrowdAgent& agent, uint32_t index, CrowdThreadContext& context)
+    {
+        PlanVelocity(agent, index, context);
+    });
+
+    ForEachAgent(m_ActiveAgents, [this, timeStep](CrowdAgent& agent, uint32_t index, CrowdThreadContext&)
+    {
+        Integrate(agent, index, timeStep);
+    });
+
+    for (int iteration = 0; iteration < COLLISION_ITERATIONS; ++iteration)
+    {
+        ForEachAgent(m_FullUpdateAgents, [this](CrowdAgent& agent, uint32_t index, CrowdThreadContext&)
+        {
+            CalcCollisionDisplacement(agent, index);
+        });
+
+        for (uint32_t index : m_FullUpdateAgents)
+            m_Positions[index] += m_Agents[index]->Displacement;
+    }
+
+    ForEachAgent(m_ActiveAgents, [this, timeStep](CrowdAgent& agent, uint32_t index, CrowdThreadContext& context)
+    {
+        MoveAlongNavMesh(agent, index, context, timeStep);
+    });
+
+    WriteTransforms();
+}
+
+void CrowdInterface::DrawDebug(DebugRenderer& renderer)
+{
+    if (!com_DrawCrowdAgents)
+        return;
+
+    renderer.SetDepthTest(false);
+
+    for (uint32_t i = 0; i < m_Agents.Size(); ++i)
+    {
+        CrowdAgent const& agent = *m_Agents[i];
+        if (!agent.IsUsed)
+            continue;
+
+        Float3 const& position = m_Positions[i];
+
+        switch (agent.State)
+        {
+            case CrowdAgentState::Invalid:
+                renderer.SetColor(Color4(1, 0, 0, 1));
+                break;
+            case CrowdAgentState::OffMeshLink:
+                renderer.SetColor(Color4(1, 1, 0, 1));
+                break;
+            default:
+                renderer.SetColor(agent.TargetState == CrowdMoveState::Failed ? Color4(1, 0.5f, 0, 1) : Color4(0, 1, 0, 1));
+                break;
+        }
+        renderer.DrawCircle(position, Float3(0, 1, 0), agent.Params.Radius);
+
+        renderer.SetColor(Color4(0, 0.5f, 1, 1));
+        renderer.DrawLine(position, position + m_Velocities[i]);
+
+        renderer.SetColor(Color4(1, 1, 1, 1));
+        renderer.DrawLine(position, position + m_DesiredVelocities[i]);
+    }
+}
+
+HK_NAMESPACE_END
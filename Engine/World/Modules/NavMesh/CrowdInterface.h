@@ -0,0 +1,224 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "NavMeshInterface.h"
+
+#include <Engine/World/Component.h>
+
+class dtProximityGrid;
+class dtPathQueue;
+
+HK_NAMESPACE_BEGIN
+
+enum class CrowdAgentFlags : uint8_t
+{
+    None                = 0,
+    /// Smooth the steering by anticipating the next corner of the path
+    AnticipateTurns     = HK_BIT(0),
+    /// Sample the velocity to avoid the neighbour agents and the walls
+    ObstacleAvoidance   = HK_BIT(1),
+    /// Keep distance from the neighbour agents
+    Separation          = HK_BIT(2),
+    /// Shortcut the path when the corner after the next one is visible
+    OptimizeVisibility  = HK_BIT(3),
+    /// Periodically replan the path locally to find a shorter corridor
+    OptimizeTopology    = HK_BIT(4),
+
+    Default             = AnticipateTurns | ObstacleAvoidance | Separation | OptimizeVisibility | OptimizeTopology
+};
+
+HK_FLAG_ENUM_OPERATORS(CrowdAgentFlags)
+
+/// Number of velocity samples used for the obstacle avoidance
+enum class CrowdAvoidanceQuality : uint8_t
+{
+    Low,
+    Medium,
+    High,
+    Ultra
+};
+
+enum class CrowdAgentState : uint8_t
+{
+    /// The agent is not on the navmesh
+    Invalid,
+    /// The agent moves on the navmesh
+    Walking,
+    /// The agent traverses an off-mesh link
+    OffMeshLink
+};
+
+enum class CrowdMoveState : uint8_t
+{
+    /// No target, the agent stands still
+    None,
+    /// The path to the target could not be found
+    Failed,
+    /// The agent moves to the target
+    Valid,
+    /// The path is being requested
+    Requesting,
+    /// The agent waits for its turn in the path queue
+    WaitingForQueue,
+    /// The path is being searched
+    WaitingForPath,
+    /// The agent is controlled by velocity
+    Velocity
+};
+
+struct CrowdAgentParams
+{
+    float                   Radius = 0.6f;
+
+    float                   Height = 2.0f;
+
+    float                   MaxAcceleration = 8.0f;
+
+    float                   MaxSpeed = 3.5f;
+
+    /// Neighbour agents and walls within this range are avoided
+    float                   CollisionQueryRange = 7.2f;
+
+    /// How far ahead the path is shortcut with OptimizeVisibility
+    float                   PathOptimizationRange = 18.0f;
+
+    /// How strongly the agent keeps distance from the neighbours with Separation
+    float                   SeparationWeight = 2.0f;
+
+    CrowdAgentFlags         Flags = CrowdAgentFlags::Default;
+
+    CrowdAvoidanceQuality   AvoidanceQuality = CrowdAvoidanceQuality::Medium;
+
+    NavQueryFilter          Filter;
+};
+
+/// Steering and local avoidance for the CrowdAgentComponent's. Agents are updated on worker threads. Agents far
+/// from the LOD origin run steering, avoidance and collisions less often, between these updates they keep
+/// moving along the navmesh with their last velocity.
+class CrowdInterface : public WorldInterfaceBase
+{
+public:
+    /// Max agents in the crowd. The proximity grid pool has 16-bit indices and an agent takes up to four items of it.
+    static constexpr int    MaxAgents = 0xffff / 4;
+
+    /// Search distance along each axis to place the agents and their targets on the navmesh
+    Float3                  PlacementExtents{2.0f, 4.0f, 2.0f};
+
+    /// Agents closer than LodDistance0 to the LOD origin are updated every frame, closer than LodDistance1
+    /// every second frame and the rest every fourth frame.
+    float                   LodDistance0 = 30.0f;
+    float                   LodDistance1 = 60.0f;
+
+                            CrowdInterface();
+
+    /// Agents near this position (usually the camera or the player) are updated every frame
+    void                    SetLodOrigin(Float3 const& inPosition) { m_LodOrigin = inPosition; }
+    Float3 const&           GetLodOrigin() const { return m_LodOrigin; }
+
+    int                     GetAgentCount() const { return m_NumAgents; }
+
+protected:
+    virtual void            Initialize() override;
+    virtual void            Deinitialize() override;
+
+private:
+    friend class CrowdAgentComponent;
+
+    int                     AddAgent(ComponentHandle inComponent, Float3 const& inPosition, CrowdAgentParams const& inParams);
+    void                    RemoveAgent(int inAgent);
+    void                    SetAgentParams(int inAgent, CrowdAgentParams const& inParams);
+    void                    SetAgentPosition(int inAgent, Float3 const& inPosition);
+    void                    RequestMoveTarget(int inAgent, Float3 const& inPosition);
+    void                    RequestMoveVelocity(int inAgent, Float3 const& inVelocity);
+    void                    ResetMoveTarget(int inAgent);
+
+    CrowdAgentState         GetAgentState(int inAgent) const;
+    CrowdMoveState          GetMoveState(int inAgent) const;
+    bool                    IsPathPartial(int inAgent) const;
+    Float3                  GetTargetPosition(int inAgent) const;
+    Float3 const&           GetVelocity(int inAgent) const { return m_Velocities[inAgent]; }
+    Float3 const&           GetDesiredVelocity(int inAgent) const { return m_DesiredVelocities[inAgent]; }
+
+    bool                    UpdateNavMesh();
+    void                    ResetAgent(int inAgent);
+    void                    UpdateMoveRequest(struct CrowdAgent& agent, uint32_t index, struct CrowdThreadContext& context, float timeStep);
+    void                    CheckPathValidity(struct CrowdAgent& agent, uint32_t index, struct CrowdThreadContext& context, float timeStep);
+    void                    UpdatePathQueue();
+    void                    UpdateTopologyOptimization();
+    void                    UpdateProximityGrid();
+    void                    FindNeighbours(struct CrowdAgent& agent, uint32_t index);
+    void                    UpdateSteering(struct CrowdAgent& agent, uint32_t index, struct CrowdThreadContext& context);
+    void                    PlanVelocity(struct CrowdAgent& agent, uint32_t index, struct CrowdThreadContext& context);
+    void                    Integrate(struct CrowdAgent& agent, uint32_t index, float timeStep);
+    void                    CalcCollisionDisplacement(struct CrowdAgent& agent, uint32_t index);
+    void                    MoveAlongNavMesh(struct CrowdAgent& agent, uint32_t index, struct CrowdThreadContext& context, float timeStep);
+    void                    WriteTransforms();
+    void                    Update();
+    void                    DrawDebug(DebugRenderer& renderer);
+
+    struct CrowdThreadContext& GetThreadContext();
+
+    template <typename Function>
+    void                    ForEachAgent(Vector<uint32_t> const& inAgents, Function const& inFunction);
+
+    /// Minimum number of agents updated by one job
+    static constexpr uint32_t AGENTS_PER_JOB = 32;
+
+    Vector<UniqueRef<struct CrowdAgent>> m_Agents;
+    Vector<uint32_t>        m_FreeAgents;
+    int                     m_NumAgents = 0;
+
+    // Hot per agent data read by the neighbours, indexed like m_Agents
+    Vector<Float3>          m_Positions;
+    Vector<Float3>          m_Velocities;
+    Vector<Float3>          m_DesiredVelocities;
+    Vector<float>           m_AgentRadius;
+    Vector<float>           m_AgentHeight;
+
+    // Agents updated in the current frame. Proximity grid items refer to m_ActiveAgents.
+    Vector<uint32_t>        m_ActiveAgents;
+    Vector<uint32_t>        m_FullUpdateAgents;
+
+    dtNavMesh*              m_NavMesh{};
+    uint32_t                m_NavMeshGeneration{};
+    dtProximityGrid*        m_Grid{};
+    int                     m_GridPoolSize{};
+    float                   m_GridCellSize{};
+    UniqueRef<dtPathQueue>  m_PathQueue;
+    // One per worker thread and one for the updating thread
+    Vector<UniqueRef<struct CrowdThreadContext>> m_ThreadContexts;
+
+    Float3                  m_LodOrigin;
+    uint32_t                m_FrameIndex{};
+};
+
+HK_NAMESPACE_END
@@ -36,6 +36,7 @@ SOFTWARE.
 #include <Engine/Core/ConsoleVar.h>
 #include <Engine/Core/Containers/ArrayView.h>
 #include <Engine/Core/Containers/BitMask.h>
+#include <Engine/Core/Containers/MPSCQueue.h>
 #include <Engine/Geometry/BV/BvIntersect.h>
 
 #include <Engine/World/Modules/NavMesh/Components/NavMeshObstacleComponent.h>
@@ -43,6 +44,7 @@ SOFTWARE.
 #include <Engine/World/Modules/NavMesh/Components/OffMeshLinkComponent.h>
 #include <Engine/World/Modules/Physics/Components/StaticBodyComponent.h>
 #include <Engine/World/Modules/Physics/Components/HeightFieldComponent.h>
+#include <Engine/World/Resources/ResourceManager.h>
 
 #include <Engine/GameApplication/GameApplication.h>
 
@@ -69,6 +71,8 @@ ConsoleVar com_DrawNavMeshNodes("com_DrawNavMeshNodes"s, "0"s, CVAR_CHEAT);
 ConsoleVar com_DrawNavMesh("com_DrawNavMesh"s, "0"s, CVAR_CHEAT);
 ConsoleVar com_DrawNavMeshTileBounds("com_DrawNavMeshTileBounds"s, "0"s, CVAR_CHEAT);
 ConsoleVar com_DrawOffMeshLinks("com_DrawOffMeshLinks"s, "0"s, CVAR_CHEAT);
+ConsoleVar com_NavMeshBuildBudget("com_NavMeshBuildBudget"s, "2"s, 0, "Max time in milliseconds per frame to gather geometry for and add asynchronously built navmesh tiles"s);
+ConsoleVar com_NavPathIterations("com_NavPathIterations"s, "128"s, 0, "Max A* iterations per path query per frame. A query runs several searches if they complete within the budget"s);
 
 HK_VALIDATE_TYPE_SIZE(NavPolyRef, sizeof(dtPolyRef));
 
@@ -178,6 +182,10 @@ public:
                 m_Vertices.Add(p2);
 
                 m_BoundingBox.AddAABB(triangleBounds);
+
+                // Add the triangle once even if it overlaps several crop boxes (one box per navigation volume).
+                // Duplicates were rasterized again for nothing, and a chunk overlaps more volumes than a tile did.
+                break;
             }
         }
     }
@@ -213,6 +221,8 @@ public:
 
     Vector<Float3> const& GetVertices() const { return m_Vertices; }
 
+    void SwapVertices(Vector<Float3>& vertices) { m_Vertices.Swap(vertices); }
+
 private:
     Vector<Float3>      m_Vertices;
     BvAxisAlignedBox    m_BoundingBox = BvAxisAlignedBox::Empty();
@@ -220,17 +230,141 @@ private:
     SmallVector<BvAxisAlignedBox, 8> m_CropBoxes;
 };
 
+/// Off-mesh link snapshot. Taken on the main thread, can be read from worker threads.
+struct OffMeshLinkDesc
+{
+    Float3                  StartPoint;
+    Float3                  EndPoint;
+    float                   Radius;
+    uint8_t                 Dir;
+    uint8_t                 AreaType;
+    uint32_t                ID;
+};
+
+/// Off-mesh connections of one tile in the layout of dtNavMeshCreateParams
+struct OffMeshConnections
+{
+    Vector<Float3>          m_Verts;
+    Vector<float>           m_Rads;
+    Vector<uint8_t>         m_Dirs;
+    Vector<uint8_t>         m_Areas;
+    Vector<uint16_t>        m_Flags;
+    Vector<uint32_t>        m_ID;
+
+    void Build(ArrayView<OffMeshLinkDesc> links, BvAxisAlignedBox const& clipBounds)
+    {
+        m_Verts.Clear();
+        m_Rads.Clear();
+        m_Dirs.Clear();
+        m_Areas.Clear();
+        m_Flags.Clear();
+        m_ID.Clear();
+
+        const float MARGIN = 0.2f;
+
+        for (OffMeshLinkDesc const& link : links)
+        {
+            BvAxisAlignedBox linkBounds =
+            {
+                {Math::Min(link.StartPoint.X, link.EndPoint.X), Math::Min(link.StartPoint.Y, link.EndPoint.Y), Math::Min(link.StartPoint.Z, link.EndPoint.Z)},
+                {Math::Max(link.StartPoint.X, link.EndPoint.X), Math::Max(link.StartPoint.Y, link.EndPoint.Y), Math::Max(link.StartPoint.Z, link.EndPoint.Z)}
+            };
+
+            linkBounds.Mins -= MARGIN;
+            linkBounds.Maxs += MARGIN;
+
+            if (!BvBoxOverlapBox(clipBounds, linkBounds))
+            {
+                // Connection is outside of clip bounds
+                continue;
+            }
+
+            m_Verts.Add(link.StartPoint);
+            m_Verts.Add(link.EndPoint);
+            m_Rads.Add(link.Radius);
+            m_Dirs.Add(link.Dir);
+            m_Areas.Add(link.AreaType);
+            m_Flags.Add(0);
+            m_ID.Add(link.ID);
+        }
+    }
+
+    void Apply(struct dtNavMeshCreateParams* params)
+    {
+        // Pass in off-mesh connections.
+        params->offMeshConVerts = (float*)m_Verts.ToPtr();
+        params->offMeshConRad = m_Rads.ToPtr();
+        params->offMeshConDir = m_Dirs.ToPtr();
+        params->offMeshConAreas = m_Areas.ToPtr();
+        params->offMeshConFlags = m_Flags.ToPtr();
+        params->offMeshConUserID = m_ID.ToPtr();
+        params->offMeshConCount = m_Rads.Size();
+    }
+};
+
+namespace
+{
+
+void GatherOffMeshLinks(World* world, Vector<OffMeshLinkDesc>& outLinks)
+{
+    struct Visitor
+    {
+        World* m_World;
+        Vector<OffMeshLinkDesc>& m_Links;
+
+        void Visit(OffMeshLinkComponent& component)
+        {
+            auto destination = m_World->GetObject(component.GetDestination());
+            if (!destination)
+                return;
+
+            OffMeshLinkDesc& link = m_Links.Add();
+            link.StartPoint = component.GetOwner()->GetWorldPosition();
+            link.EndPoint = destination->GetWorldPosition();
+            link.Radius = component.GetRadius();
+            link.Dir = component.IsBidirectional() ? DT_OFFMESH_CON_BIDIR : 0;
+            link.AreaType = component.GetAreaType();
+            link.ID = component.GetHandle().ToUInt32();
+        }
+    };
+
+    outLinks.Clear();
+
+    Visitor visitor{world, outLinks};
+    world->GetComponentManager<OffMeshLinkComponent>().IterateComponents(visitor);
+}
+
+void SetupPolyAreas(struct dtNavMeshCreateParams* params, unsigned char* polyAreas, unsigned short* polyFlags)
+{
+    for (int i = 0; i < params->polyCount; ++i)
+    {
+        if (polyAreas[i] == DT_TILECACHE_WALKABLE_AREA)
+            polyAreas[i] = NAV_MESH_AREA_GROUND;
+
+#if 0
+        if (polyAreas[i] == NAV_MESH_AREA_GROUND || polyAreas[i] == NAV_MESH_AREA_GRASS || polyAreas[i] == NAV_MESH_AREA_ROAD)
+        {
+            polyFlags[i] = NAV_MESH_FLAGS_WALK;
+        }
+        else if (polyAreas[i] == NAV_MESH_AREA_WATER)
+        {
+            polyFlags[i] = NAV_MESH_FLAGS_SWIM;
+        }
+        else if (polyAreas[i] == NAV_MESH_AREA_DOOR)
+        {
+            polyFlags[i] = NAV_MESH_FLAGS_WALK | NAV_MESH_FLAGS_DOOR;
+        }
+#endif
+    }
+}
+
+} // namespace
+
 struct DetourMeshProcess final : public dtTileCacheMeshProcess
 {
     NavMeshInterface*       m_NavMeshInterface;
-    Vector<Float3>          m_OffMeshConVerts;
-    Vector<float>           m_OffMeshConRads;
-    Vector<uint8_t>         m_OffMeshConDirs;
-    Vector<uint8_t>         m_OffMeshConAreas;
-    Vector<uint16_t>        m_OffMeshConFlags;
-    Vector<uint32_t>        m_OffMeshConID;
-    int                     m_OffMeshConCount;
-    BvAxisAlignedBox        m_ClipBounds;
+    Vector<OffMeshLinkDesc> m_OffMeshLinks;
+    OffMeshConnections      m_OffMeshConnections;
 
     void* operator new(size_t sizeInBytes)
     {
@@ -244,93 +378,269 @@ struct DetourMeshProcess final : public dtTileCacheMeshProcess
 
     void process(struct dtNavMeshCreateParams* params, unsigned char* polyAreas, unsigned short* polyFlags) override
     {
-        for (int i = 0; i < params->polyCount; ++i)
-        {
-            if (polyAreas[i] == DT_TILECACHE_WALKABLE_AREA)
-                polyAreas[i] = NAV_MESH_AREA_GROUND;
+        SetupPolyAreas(params, polyAreas, polyFlags);
 
-#if 0
-            if (polyAreas[i] == NAV_MESH_AREA_GROUND || polyAreas[i] == NAV_MESH_AREA_GRASS || polyAreas[i] == NAV_MESH_AREA_ROAD)
-            {
-                polyFlags[i] = NAV_MESH_FLAGS_WALK;
-            }
-            else if (polyAreas[i] == NAV_MESH_AREA_WATER)
-            {
-                polyFlags[i] = NAV_MESH_FLAGS_SWIM;
-            }
-            else if (polyAreas[i] == NAV_MESH_AREA_DOOR)
-            {
-                polyFlags[i] = NAV_MESH_FLAGS_WALK | NAV_MESH_FLAGS_DOOR;
-            }
-#endif
-        }
+        BvAxisAlignedBox clipBounds;
+        rcVcopy(clipBounds.Mins.ToPtr(), params->bmin);
+        rcVcopy(clipBounds.Maxs.ToPtr(), params->bmax);
 
-        rcVcopy(m_ClipBounds.Mins.ToPtr(), params->bmin);
-        rcVcopy(m_ClipBounds.Maxs.ToPtr(), params->bmax);
+        GatherOffMeshLinks(m_NavMeshInterface->GetWorld(), m_OffMeshLinks);
 
-        m_OffMeshConVerts.Clear();
-        m_OffMeshConVerts.Clear();
-        m_OffMeshConRads.Clear();
-        m_OffMeshConDirs.Clear();
-        m_OffMeshConAreas.Clear();
-        m_OffMeshConFlags.Clear();
-        m_OffMeshConID.Clear();
-        m_OffMeshConCount = 0;
+        m_OffMeshConnections.Build(m_OffMeshLinks, clipBounds);
+        m_OffMeshConnections.Apply(params);
+    }
+};
 
-        auto& links = m_NavMeshInterface->GetWorld()->GetComponentManager<OffMeshLinkComponent>();
-        links.IterateComponents(*this);
+struct DetourLinearAllocator final : public dtTileCacheAlloc
+{
+    LinearAllocator<> Allocator;
 
-        // Pass in off-mesh connections.
-        params->offMeshConVerts = (float*)m_OffMeshConVerts.ToPtr();
-        params->offMeshConRad = m_OffMeshConRads.ToPtr();
-        params->offMeshConDir = m_OffMeshConDirs.ToPtr();
-        params->offMeshConAreas = m_OffMeshConAreas.ToPtr();
-        params->offMeshConFlags = m_OffMeshConFlags.ToPtr();
-        params->offMeshConUserID = m_OffMeshConID.ToPtr();
-        params->offMeshConCount = m_OffMeshConCount;
+    void* operator new(size_t sizeInBytes)
+    {
+        return Core::GetHeapAllocator<HEAP_NAVIGATION>().Alloc(sizeInBytes);
     }
 
-    void Visit(OffMeshLinkComponent& component)
+    void operator delete(void* ptr)
     {
-        auto destination = m_NavMeshInterface->GetWorld()->GetObject(component.GetDestination());
-        if (!destination)
-            return;
+        Core::GetHeapAllocator<HEAP_NAVIGATION>().Free(ptr);
+    }
 
-        Float3 startPoint = component.GetOwner()->GetWorldPosition();
-        Float3 endPoint = destination->GetWorldPosition();
+    void reset() override
+    {
+        Allocator.Reset();
+    }
 
-        const float MARGIN = 0.2f;
+    void* alloc(const size_t size) override
+    {
+        return Allocator.Allocate(size);
+    }
 
-        BvAxisAlignedBox linkBounds =
-        {
-            {Math::Min(startPoint.X, endPoint.X), Math::Min(startPoint.Y, endPoint.Y), Math::Min(startPoint.Z, endPoint.Z)},
-            {Math::Max(startPoint.X, endPoint.X), Math::Max(startPoint.Y, endPoint.Y), Math::Max(startPoint.Z, endPoint.Z)}
-        };
+    void free(void*) override
+    {
+    }
+};
+
+namespace
+{
 
-        linkBounds.Mins -= MARGIN;
-        linkBounds.Maxs += MARGIN;
+class RecastContext : public rcContext
+{
+public:
+    RecastContext()
+    {
+        enableLog(RECAST_ENABLE_LOGGING);
+        enableTimer(RECAST_ENABLE_TIMINGS);
+    }
 
-        if (!BvBoxOverlapBox(m_ClipBounds, linkBounds))
+protected:
+    // Virtual functions override
+    void doResetLog() override {}
+    void doLog(const rcLogCategory category, const char* msg, const int len) override
+    {
+        switch (category)
         {
-            // Connection is outside of clip bounds
-            return;
+        case RC_LOG_PROGRESS:
+            LOG(msg);
+            break;
+        case RC_LOG_WARNING:
+            LOG(msg);
+            break;
+        case RC_LOG_ERROR:
+            LOG(msg);
+            break;
+        default:
+            LOG(msg);
+            break;
         }
+    }
+    void doResetTimers() override {}
+    void doStartTimer(const rcTimerLabel label) override {}
+    void doStopTimer(const rcTimerLabel label) override {}
+    int doGetAccumulatedTime(const rcTimerLabel label) const override { return -1; }
+};
+
+// The context has no state besides the log/timer switches, so it is shared by the tile jobs
+RecastContext s_RecastContext;
+
+} // namespace
+
+/// NavMeshAreaComponent snapshot. Taken on the main thread, can be read from worker threads.
+struct NavMeshAreaDesc
+{
+    NavMeshAreaShape        Shape;
+    NAV_MESH_AREA           AreaType;
+    BvAxisAlignedBox        Bounds;
+    Float3                  WorldPosition;
+    float                   Height;
+    float                   CylinderRadius;
+    StaticVector<Float2, NavMeshAreaComponent::MaxVolumeVerts> VolumeContour;
+};
+
+namespace
+{
+
+/// 64-bit hash built from two Murmur3 hashes with different seeds
+struct Hash64
+{
+    uint32_t                A = 0x9e3779b9;
+    uint32_t                B = 0;
+
+    void Add(const void* data, size_t size)
+    {
+        A = HashTraits::Murmur3Hash(static_cast<const char*>(data), size, A);
+        B = HashTraits::Murmur3Hash(static_cast<const char*>(data), size, B ^ 0x85ebca6b);
+    }
+
+    template <typename T>
+    void Add(T const& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Value check");
+        Add(&value, sizeof(value));
+    }
+
+    uint64_t Get() const
+    {
+        return (uint64_t(A) << 32) | B;
+    }
+};
+
+/// Hash of the tile build input. The order of the triangles, areas and links does not change the hash, because
+/// it depends on the order of the physics queries and the component iteration.
+struct TileInputHash
+{
+    uint64_t                Sum = 0;
+    uint32_t                Count = 0;
+
+    void Add(Hash64 const& hash)
+    {
+        Sum += hash.Get();
+        Count++;
+    }
+
+    void AddTriangle(Float3 const* tri)
+    {
+        Hash64 hash;
+        hash.Add(tri, sizeof(Float3) * 3);
+        Add(hash);
+    }
+
+    void AddArea(NavMeshAreaDesc const& area)
+    {
+        Hash64 hash;
+        hash.Add(uint32_t(area.Shape));
+        hash.Add(uint32_t(area.AreaType));
+        hash.Add(area.Bounds.Mins);
+        hash.Add(area.Bounds.Maxs);
+        hash.Add(area.WorldPosition);
+        hash.Add(area.Height);
+        hash.Add(area.CylinderRadius);
+        hash.Add(area.VolumeContour.ToPtr(), area.VolumeContour.Size() * sizeof(Float2));
+        Add(hash);
+    }
 
-        m_OffMeshConVerts.Add(startPoint);
-        m_OffMeshConVerts.Add(endPoint);
-        m_OffMeshConRads.Add(component.GetRadius());
-        m_OffMeshConDirs.Add(component.IsBidirectional() ? DT_OFFMESH_CON_BIDIR : 0);
-        m_OffMeshConAreas.Add(component.GetAreaType());
-        m_OffMeshConFlags.Add(0);
-        m_OffMeshConID.Add(component.GetHandle().ToUInt32());
+    void AddOffMeshLink(OffMeshLinkDesc const& link)
+    {
+        Hash64 hash;
+        hash.Add(link.StartPoint);
+        hash.Add(link.EndPoint);
+        hash.Add(link.Radius);
+        hash.Add(link.Dir);
+        hash.Add(link.AreaType);
+        hash.Add(link.ID);
+        Add(hash);
+    }
 
-        m_OffMeshConCount++;
+    uint64_t Get() const
+    {
+        Hash64 hash;
+        hash.Add(Sum);
+        hash.Add(Count);
+        // Zero means the tile has no hash
+        return Math::Max<uint64_t>(hash.Get(), 1);
     }
 };
 
-struct DetourLinearAllocator final : public dtTileCacheAlloc
+HK_FORCEINLINE uint32_t MakeTileKey(int x, int z)
 {
-    LinearAllocator<> Allocator;
+    return uint32_t(x) | (uint32_t(z) << 16);
+}
+
+} // namespace
+
+/// Tile built on a worker thread. The data is added to the navmesh on the main thread.
+struct NavMeshTileBuild
+{
+    struct CacheLayer
+    {
+        byte*               Data;
+        int                 Size;
+    };
+
+    int                     X;
+    int                     Z;
+    bool                    IsBuilt = false;
+    bool                    IsEmpty = false;
+    /// CacheLayers point to the baked resource data
+    bool                    IsShared = false;
+    /// Hash of the tile input geometry, zero if the tile has no navigation volume
+    uint64_t                GeometryHash = 0;
+
+    /// Compressed tile cache layers (dynamic navmesh)
+    Vector<CacheLayer>      CacheLayers;
+
+    /// Detour tile data (static navmesh)
+    byte*                   NavData = nullptr;
+    int                     NavDataSize = 0;
+
+    struct NavMeshBuildTask* Task;
+
+    void FreeData()
+    {
+        if (!IsShared)
+        {
+            for (CacheLayer& layer : CacheLayers)
+                dtFree(layer.Data);
+        }
+        CacheLayers.Clear();
+
+        dtFree(NavData);
+        NavData = nullptr;
+        NavDataSize = 0;
+    }
+};
+
+/// Build of one chunk of tiles
+struct NavMeshBuildTask
+{
+    NavMeshInterface*       Interface;
+    Int2                    Mins;
+    Int2                    Maxs;
+    Float3                  Origin;
+    float                   TileWidth;
+    /// Tile padding in world units
+    float                   TileBorder;
+
+    /// Triangle soup gathered once for the whole chunk
+    Vector<Float3>          Vertices;
+
+    /// Triangles of tile i are TileTriangles[TileTriangleOffsets[i]] .. TileTriangles[TileTriangleOffsets[i + 1] - 1]
+    Vector<uint32_t>        TileTriangleOffsets;
+    Vector<uint32_t>        TileTriangles;
+
+    Vector<BvAxisAlignedBox> NavigationVolumes;
+    Vector<NavMeshAreaDesc> Areas;
+    Vector<OffMeshLinkDesc> OffMeshLinks;
+
+    /// Tiles with unchanged input are taken from here
+    NavMeshResource const*  BakedTiles = nullptr;
+
+    Vector<NavMeshTileBuild> Tiles;
+    Vector<AsyncJob>        TileJobs;
+    MPSCQueue<uint32_t>     FinishedTiles;
+    uint32_t                NumCommittedTiles = 0;
+
+    AsyncJob                BinJob;
+    AsyncJobCounter         Counter;
 
     void* operator new(size_t sizeInBytes)
     {
@@ -342,18 +652,82 @@ struct DetourLinearAllocator final : public dtTileCacheAlloc
         Core::GetHeapAllocator<HEAP_NAVIGATION>().Free(ptr);
     }
 
-    void reset() override
+    ~NavMeshBuildTask()
     {
-        Allocator.Reset();
+        HK_ASSERT(Counter.IsDone());
+
+        for (NavMeshTileBuild& tile : Tiles)
+            tile.FreeData();
     }
 
-    void* alloc(const size_t size) override
+    void BinTriangles()
     {
-        return Allocator.Allocate(size);
+        const int numTilesX = Maxs.X - Mins.X + 1;
+        const int numTilesZ = Maxs.Y - Mins.Y + 1;
+        const uint32_t triangleCount = Vertices.Size() / 3;
+
+        auto getTileRange = [&](uint32_t triangle, Int2& outMins, Int2& outMaxs)
+        {
+            Float3 const* tri = &Vertices[triangle * 3];
+
+            float minX = Math::Min3(tri[0].X, tri[1].X, tri[2].X) - TileBorder - Origin.X;
+            float minZ = Math::Min3(tri[0].Z, tri[1].Z, tri[2].Z) - TileBorder - Origin.Z;
+            float maxX = Math::Max3(tri[0].X, tri[1].X, tri[2].X) + TileBorder - Origin.X;
+            float maxZ = Math::Max3(tri[0].Z, tri[1].Z, tri[2].Z) + TileBorder - Origin.Z;
+
+            outMins.X = Math::Max((int)Math::Floor(minX / TileWidth), Mins.X) - Mins.X;
+            outMins.Y = Math::Max((int)Math::Floor(minZ / TileWidth), Mins.Y) - Mins.Y;
+            outMaxs.X = Math::Min((int)Math::Floor(maxX / TileWidth), Maxs.X) - Mins.X;
+            outMaxs.Y = Math::Min((int)Math::Floor(maxZ / TileWidth), Maxs.Y) - Mins.Y;
+        };
+
+        // Count triangles of each tile
+        TileTriangleOffsets.Resize(numTilesX * numTilesZ + 1);
+        TileTriangleOffsets.ZeroMem();
+
+        Int2 mins, maxs;
+        for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            getTileRange(triangle, mins, maxs);
+            for (int z = mins.Y; z <= maxs.Y; ++z)
+                for (int x = mins.X; x <= maxs.X; ++x)
+                    TileTriangleOffsets[z * numTilesX + x + 1]++;
+        }
+
+        for (uint32_t i = 1; i < TileTriangleOffsets.Size(); ++i)
+            TileTriangleOffsets[i] += TileTriangleOffsets[i - 1];
+
+        // Fill triangle lists
+        Vector<uint32_t> cursor(TileTriangleOffsets.ToPtr(), TileTriangleOffsets.ToPtr() + numTilesX * numTilesZ);
+
+        TileTriangles.Resize(TileTriangleOffsets.Last());
+        for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            getTileRange(triangle, mins, maxs);
+            for (int z = mins.Y; z <= maxs.Y; ++z)
+                for (int x = mins.X; x <= maxs.X; ++x)
+                    TileTriangles[cursor[z * numTilesX + x]++] = triangle;
+        }
     }
 
-    void free(void*) override
+    static void BinTrianglesJob(void* data)
+    {
+        NavMeshBuildTask* task = static_cast<NavMeshBuildTask*>(data);
+
+        task->BinTriangles();
+
+        // The tile jobs are added to the counter before this job is done, so waiting on the counter waits for the whole task
+        GameApplication::GetAsyncJobManager().SubmitJobs(task->TileJobs.ToPtr(), task->TileJobs.Size(), task->Counter);
+    }
+
+    static void BuildTileJob(void* data)
     {
+        NavMeshTileBuild* tile = static_cast<NavMeshTileBuild*>(data);
+        NavMeshBuildTask* task = tile->Task;
+
+        tile->IsBuilt = task->Interface->BuildTile(*task, *tile);
+
+        task->FinishedTiles.Push(uint32_t(tile - task->Tiles.ToPtr()));
     }
 };
 
@@ -363,6 +737,32 @@ NavQueryFilter::NavQueryFilter()
         m_AreaCost[i] = 1.0f;
 }
 
+struct NavPathQuery
+{
+    static constexpr uint32_t InvalidSearch = ~0u;
+
+    dtNavMeshQuery*         Query{};
+    uint32_t                Search = InvalidSearch;
+    bool                    IsStarted{};
+    // Searches completed on this frame, finished on the main thread
+    Vector<uint32_t>        Completed;
+
+    // Sliced search keeps the pointer to the filter, so the filter is copied from the search
+    NavQueryFilter          Filter;
+    dtQueryFilter           DetourFilter;
+    NavPolyRef              EndRef{};
+
+    NavPolyRef              Polys[MAX_POLYS];
+    NavPolyRef              PathPolys[MAX_POLYS];
+    alignas(16) Float3      PathPoints[MAX_POLYS];
+    unsigned char           PathFlags[MAX_POLYS];
+
+    ~NavPathQuery()
+    {
+        dtFreeNavMeshQuery(Query);
+    }
+};
+
 NavMeshInterface::NavMeshInterface()
 {
     static bool InitializeAllocators = true;
@@ -526,6 +926,24 @@ bool NavMeshInterface::Create()
         return false;
     }
 
+    // One query per thread that can run path searches
+    int numPathQueries = GameApplication::GetAsyncJobManager().GetNumWorkerThreads() + 1;
+    m_PathQueries.Reserve(numPathQueries);
+    for (int i = 0; i < numPathQueries; ++i)
+    {
+        UniqueRef<NavPathQuery> pathQuery = MakeUnique<NavPathQuery>();
+
+        pathQuery->Query = dtAllocNavMeshQuery();
+        if (!pathQuery->Query || dtStatusFailed(pathQuery->Query->init(m_NavMesh, MAX_NODES)))
+        {
+            Purge();
+            LOG("NavMeshInterface::Create: Could not initialize path query\n");
+            return false;
+        }
+
+        m_PathQueries.Add(std::move(pathQuery));
+    }
+
     m_MeshProcess = MakeUnique<DetourMeshProcess>();
     m_MeshProcess->m_NavMeshInterface = this;
 
@@ -564,11 +982,18 @@ bool NavMeshInterface::Create()
         }
     }
 
+    m_Generation++;
+
     return true;
 }
 
 void NavMeshInterface::Purge()
 {
+    CancelBuild();
+
+    DiscardPathRequests();
+    m_PathQueries.Clear();
+
     dtFreeNavMeshQuery(m_NavQuery);
     m_NavQuery = nullptr;
 
@@ -586,6 +1011,10 @@ void NavMeshInterface::Purge()
 
     m_NumTilesX = 0;
     m_NumTilesZ = 0;
+
+    m_TileHashes.Clear();
+
+    m_Generation++;
 }
 
 void NavMeshInterface::Clear()
@@ -593,6 +1022,8 @@ void NavMeshInterface::Clear()
     if (!m_NavMesh)
         return;
 
+    m_TileHashes.Clear();
+
     if (m_IsDynamic)
     {
         HK_ASSERT(m_TileCache);
@@ -627,6 +1058,8 @@ void NavMeshInterface::ClearTile(int inX, int inZ)
     if (!m_NavMesh)
         return;
 
+    m_TileHashes.Erase(MakeTileKey(inX, inZ));
+
     if (m_IsDynamic)
     {
         HK_ASSERT(m_TileCache);
@@ -635,11 +1068,8 @@ void NavMeshInterface::ClearTile(int inX, int inZ)
         int count = m_TileCache->getTilesAt(inX, inZ, compressedTiles, m_MaxLayers);
         for (int i = 0; i < count; i++)
         {
-            byte* data = nullptr;
-            dtStatus status = m_TileCache->removeTile(compressedTiles[i], &data, nullptr);
-            if (dtStatusFailed(status))
-                continue;
-            dtFree(data);
+            // Own tiles are freed by the tile cache. Tiles without DT_COMPRESSEDTILE_FREE_DATA refer to the baked resource.
+            m_TileCache->removeTile(compressedTiles[i], nullptr, nullptr);
         }
     }
     else
@@ -688,6 +1118,28 @@ bool NavMeshInterface::Build(Int2 const& inMins, Int2 const& inMaxs)
         return false;
     }
 
+    BuildAsync(inMins, inMaxs);
+
+    return CompleteBuild();
+}
+
+bool NavMeshInterface::Build(BvAxisAlignedBox const& inBoundingBox)
+{
+    Int2 mins, maxs;
+    if (!GetTileRange(inBoundingBox, mins, maxs))
+        return false;
+
+    return Build(mins, maxs);
+}
+
+void NavMeshInterface::BuildAsync(Int2 const& inMins, Int2 const& inMaxs)
+{
+    if (!m_NavMesh)
+    {
+        LOG("NavMeshInterface::BuildAsync: navmesh must be initialized\n");
+        return;
+    }
+
     Int2 clampedMins;
     Int2 clampedMaxs;
 
@@ -696,28 +1148,240 @@ bool NavMeshInterface::Build(Int2 const& inMins, Int2 const& inMaxs)
     clampedMaxs.X = Math::Clamp<int>(inMaxs.X, 0, m_NumTilesX - 1);
     clampedMaxs.Y = Math::Clamp<int>(inMaxs.Y, 0, m_NumTilesZ - 1);
 
-    unsigned int count = 0;
-    for (int z = clampedMins[1]; z <= clampedMaxs[1]; z++)
-        for (int x = clampedMins[0]; x <= clampedMaxs[0]; x++)
-            if (BuildTile(x, z))
-                count++;
-    return count > 0;
+    for (int z = clampedMins.Y; z <= clampedMaxs.Y; z += BuildChunkSize)
+    {
+        for (int x = clampedMins.X; x <= clampedMaxs.X; x += BuildChunkSize)
+        {
+            BuildChunk& chunk = m_PendingBuildChunks.Add();
+            chunk.Mins = Int2(x, z);
+            chunk.Maxs = Int2(Math::Min(x + BuildChunkSize - 1, clampedMaxs.X), Math::Min(z + BuildChunkSize - 1, clampedMaxs.Y));
+        }
+    }
+}
+
+void NavMeshInterface::BuildAsync(BvAxisAlignedBox const& inBoundingBox)
+{
+    Int2 mins, maxs;
+    if (GetTileRange(inBoundingBox, mins, maxs))
+        BuildAsync(mins, maxs);
 }
 
-bool NavMeshInterface::Build(BvAxisAlignedBox const& inBoundingBox)
+bool NavMeshInterface::GetTileRange(BvAxisAlignedBox const& inBoundingBox, Int2& outMins, Int2& outMaxs) const
 {
     if (m_TileWidth == 0.0f)
         return false;
 
-    Int2 mins((inBoundingBox.Mins.X - m_BoundingBox.Mins.X) / m_TileWidth,
+    outMins = Int2((inBoundingBox.Mins.X - m_BoundingBox.Mins.X) / m_TileWidth,
         (inBoundingBox.Mins.Z - m_BoundingBox.Mins.Z) / m_TileWidth);
-    Int2 maxs((inBoundingBox.Maxs.X - m_BoundingBox.Mins.X) / m_TileWidth,
+    outMaxs = Int2((inBoundingBox.Maxs.X - m_BoundingBox.Mins.X) / m_TileWidth,
         (inBoundingBox.Maxs.Z - m_BoundingBox.Mins.Z) / m_TileWidth);
-
-    return Build(mins, maxs);
+    return true;
 }
 
-void NavMeshInterface::SetAreaCost(NAV_MESH_AREA inAreaType, float inCost)
+bool NavMeshInterface::CompleteBuild()
+{
+    auto& jobManager = GameApplication::GetAsyncJobManager();
+
+    uint32_t numBuiltTiles = 0;
+
+    StartBuildTasks();
+
+    while (!m_BuildTasks.IsEmpty())
+    {
+        NavMeshBuildTask& task = *m_BuildTasks[0];
+
+        jobManager.WaitForCounter(task.Counter);
+
+        uint32_t tileIndex;
+        while (task.FinishedTiles.TryPop(tileIndex))
+        {
+            if (CommitTile(task.Tiles[tileIndex]))
+                numBuiltTiles++;
+        }
+
+        m_BuildTasks.RemoveFirst();
+
+        // Gather geometry for the next chunk while the workers build the tiles of the remaining task
+        StartBuildTasks();
+    }
+
+    return numBuiltTiles > 0;
+}
+
+void NavMeshInterface::CancelBuild()
+{
+    m_PendingBuildChunks.Clear();
+
+    for (auto& task : m_BuildTasks)
+        GameApplication::GetAsyncJobManager().WaitForCounter(task->Counter);
+
+    m_BuildTasks.Clear();
+}
+
+void NavMeshInterface::StartBuildTasks(int64_t timeLimit)
+{
+    auto& jobManager = GameApplication::GetAsyncJobManager();
+
+    NavMeshResource const* bakedTiles = nullptr;
+    if (!m_PendingBuildChunks.IsEmpty() && BakedTiles)
+    {
+        bakedTiles = GameApplication::GetResourceManager().TryGet(BakedTiles);
+        if (bakedTiles && (bakedTiles->GetSettingsHash() != CalcSettingsHash() || bakedTiles->IsDynamic() != m_IsDynamic))
+        {
+            LOG("NavMeshInterface::StartBuildTasks: Baked tiles are built with other settings\n");
+            bakedTiles = nullptr;
+        }
+    }
+
+    while (!m_PendingBuildChunks.IsEmpty() && m_BuildTasks.Size() < MaxBuildTasks)
+    {
+        // Geometry is gathered on this thread. Out of time, start the chunk on a later frame, unless the workers have nothing to do.
+        if (timeLimit && !m_BuildTasks.IsEmpty() && Core::SysMicroseconds() >= timeLimit)
+            break;
+
+        BuildChunk chunk = m_PendingBuildChunks[0];
+        m_PendingBuildChunks.RemoveFirst();
+
+        UniqueRef<NavMeshBuildTask> task = MakeUnique<NavMeshBuildTask>();
+
+        rcConfig config;
+        InitTileConfig(config);
+
+        task->Interface = this;
+        task->Mins = chunk.Mins;
+        task->Maxs = chunk.Maxs;
+        task->Origin = m_BoundingBox.Mins;
+        task->TileWidth = m_TileWidth;
+        task->TileBorder = config.borderSize * config.cs;
+        task->NavigationVolumes = NavigationVolumes;
+        task->BakedTiles = bakedTiles;
+
+        // Gather geometry once for all tiles of the chunk
+        BvAxisAlignedBox chunkBounds = GetTileWorldBounds(chunk.Mins.X, chunk.Mins.Y);
+        chunkBounds.AddAABB(GetTileWorldBounds(chunk.Maxs.X, chunk.Maxs.Y));
+
+        chunkBounds.Mins.X -= task->TileBorder;
+        chunkBounds.Mins.Z -= task->TileBorder;
+        chunkBounds.Maxs.X += task->TileBorder;
+        chunkBounds.Maxs.Z += task->TileBorder;
+
+        NavigationGeometry geometry;
+
+        BvAxisAlignedBox intersection;
+        for (auto& navigationVolume : NavigationVolumes)
+        {
+            if (BvGetBoxIntersection(chunkBounds, navigationVolume, intersection))
+                geometry.AddCropBox(intersection);
+        }
+
+        if (!geometry.GetMaxCropBox().IsEmpty())
+        {
+            GatherNavigationGeometry(geometry);
+            geometry.SwapVertices(task->Vertices);
+        }
+
+        // Take snapshots of the components, the tile jobs must not touch the world
+        struct AreaVisitor
+        {
+            Vector<NavMeshAreaDesc>& m_Areas;
+
+            void Visit(NavMeshAreaComponent& area)
+            {
+                NavMeshAreaDesc& desc = m_Areas.Add();
+                desc.Shape = area.GetShape();
+                desc.AreaType = area.GetAreaType();
+                desc.Bounds = area.CalcBoundingBox();
+                desc.WorldPosition = area.GetOwner()->GetWorldPosition();
+                desc.Height = area.GetHeight();
+                desc.CylinderRadius = area.GetCylinderRadius();
+                desc.VolumeContour = area.GetVolumeContour();
+            }
+        };
+        AreaVisitor areaVisitor{task->Areas};
+        GetWorld()->GetComponentManager<NavMeshAreaComponent>().IterateComponents(areaVisitor);
+
+        // Dynamic navmesh gets off-mesh links from the tile cache mesh process on the main thread
+        if (!m_IsDynamic)
+            GatherOffMeshLinks(GetWorld(), task->OffMeshLinks);
+
+        const int numTilesX = chunk.Maxs.X - chunk.Mins.X + 1;
+        const int numTilesZ = chunk.Maxs.Y - chunk.Mins.Y + 1;
+
+        task->Tiles.Resize(numTilesX * numTilesZ);
+        task->TileJobs.Resize(task->Tiles.Size());
+
+        for (int z = 0; z < numTilesZ; ++z)
+        {
+            for (int x = 0; x < numTilesX; ++x)
+            {
+                int index = z * numTilesX + x;
+
+                NavMeshTileBuild& tile = task->Tiles[index];
+                tile.X = chunk.Mins.X + x;
+                tile.Z = chunk.Mins.Y + z;
+                tile.Task = task.RawPtr();
+
+                AsyncJob& job = task->TileJobs[index];
+                job.Callback = NavMeshBuildTask::BuildTileJob;
+                job.Data = &tile;
+            }
+        }
+
+        task->BinJob.Callback = NavMeshBuildTask::BinTrianglesJob;
+        task->BinJob.Data = task.RawPtr();
+
+        jobManager.SubmitJob(task->BinJob, task->Counter);
+
+        m_BuildTasks.Add(std::move(task));
+    }
+}
+
+bool NavMeshInterface::SaveBakedTiles(IBinaryStreamWriteInterface& stream) const
+{
+    if (!m_NavMesh)
+    {
+        LOG("NavMeshInterface::SaveBakedTiles: navmesh must be initialized\n");
+        return false;
+    }
+
+    if (IsBuildInProgress())
+        LOG("NavMeshInterface::SaveBakedTiles: Tiles of the unfinished asynchronous build are not saved\n");
+
+    NavMeshResource resource(CalcSettingsHash(), m_IsDynamic);
+
+    Vector<ArrayView<uint8_t>> layers;
+    for (auto const& it : m_TileHashes)
+    {
+        const int x = it.first & 0xffff;
+        const int z = it.first >> 16;
+
+        layers.Clear();
+        if (m_IsDynamic)
+        {
+            dtCompressedTileRef compressedTiles[MaxAllowedLayers];
+            int count = m_TileCache->getTilesAt(x, z, compressedTiles, m_MaxLayers);
+            for (int i = 0; i < count; i++)
+            {
+                dtCompressedTile const* tile = m_TileCache->getTileByRef(compressedTiles[i]);
+                if (tile && tile->header)
+                    layers.Add(ArrayView<uint8_t>(tile->data, tile->dataSize));
+            }
+        }
+        else
+        {
+            dtMeshTile const* tile = m_NavMesh->getTileAt(x, z, 0);
+            if (tile && tile->header)
+                layers.Add(ArrayView<uint8_t>(tile->data, tile->dataSize));
+        }
+
+        resource.AddTile(x, z, it.second, layers);
+    }
+
+    resource.Write(stream);
+    return true;
+}
+
+void NavMeshInterface::SetAreaCost(NAV_MESH_AREA inAreaType, float inCost)
 {
     m_QueryFilter.SetAreaCost(inAreaType, inCost);
 }
@@ -736,8 +1400,43 @@ void NavMeshInterface::Update()
         Build();
     }
 
+    if (IsBuildInProgress())
+    {
+        int64_t timeLimit = Core::SysMicroseconds() + int64_t(com_NavMeshBuildBudget.GetFloat() * 1000);
+
+        // Add finished tiles of the oldest task first. At least one tile is added per frame.
+        bool outOfTime = false;
+        while (!m_BuildTasks.IsEmpty() && !outOfTime)
+        {
+            NavMeshBuildTask& task = *m_BuildTasks[0];
+
+            uint32_t tileIndex;
+            while (task.FinishedTiles.TryPop(tileIndex))
+            {
+                CommitTile(task.Tiles[tileIndex]);
+                task.NumCommittedTiles++;
+
+                if (Core::SysMicroseconds() >= timeLimit)
+                {
+                    outOfTime = true;
+                    break;
+                }
+            }
+
+            if (task.NumCommittedTiles < task.Tiles.Size() || !task.Counter.IsDone())
+                break;
+
+            m_BuildTasks.RemoveFirst();
+        }
+
+        // Gathering the geometry of new chunks counts against the same budget
+        StartBuildTasks(timeLimit);
+    }
+
     if (m_TileCache)
         m_TileCache->update(GetWorld()->GetTick().FixedTimeStep, m_NavMesh);
+
+    UpdatePathRequests();
 }
 
 void NavMeshInterface::AddObstacle(NavMeshObstacleComponent* inObstacle)
@@ -1087,64 +1786,494 @@ bool NavMeshInterface::FindPath(Float3 const& inStartPos, Float3 const& inEndPos
     if (!FindPath(startRef, endRef, inFilter, TmpPolys, numPolys, MAX_POLYS))
         return false;
 
-    Float3 closestLocalEnd = inEndPos;
+    Float3 closestLocalEnd = inEndPos;
+
+    if (TmpPolys[numPolys - 1] != endRef.PolyRef)
+        m_NavQuery->closestPointOnPoly(TmpPolys[numPolys - 1], inEndPos.ToPtr(), closestLocalEnd.ToPtr(), 0);
+
+    int pathLen;
+    m_NavQuery->findStraightPath(inStartPos.ToPtr(), closestLocalEnd.ToPtr(), TmpPolys, numPolys, TmpPathPoints[0].ToPtr(), TmpPathFlags, TmpPathPolys, &pathLen, MAX_POLYS);
+
+    outPathPoints.Resize(pathLen);
+    for (int i = 0; i < pathLen; ++i)
+    {
+        outPathPoints[i].Position = TmpPathPoints[i];
+        outPathPoints[i].Flags = NavMeshPathFlags(TmpPathFlags[i]);
+    }
+
+    return true;
+}
+
+bool NavMeshInterface::FindPath(Float3 const& inStartPos, Float3 const& inEndPos, Float3 const& inExtents, Vector<NavMeshPathPoint>& outPathPoints) const
+{
+    return FindPath(inStartPos, inEndPos, inExtents, m_QueryFilter, outPathPoints);
+}
+
+bool NavMeshInterface::FindPath(Float3 const& inStartPos, Float3 const& inEndPos, Float3 const& inExtents, NavQueryFilter const& inFilter, Vector<Float3>& outPathPoints) const
+{
+    NavPointRef startRef;
+    NavPointRef endRef;
+
+    if (!QueryNearestPoly(inStartPos, inExtents, inFilter, startRef.PolyRef))
+        return false;
+
+    if (!QueryNearestPoly(inEndPos, inExtents, inFilter, endRef.PolyRef))
+        return false;
+
+    startRef.Position = inStartPos;
+    endRef.Position = inEndPos;
+
+    int numPolys;
+    if (!FindPath(startRef, endRef, inFilter, TmpPolys, numPolys, MAX_POLYS))
+        return false;
+
+    Float3 closestLocalEnd = inEndPos;
+
+    if (TmpPolys[numPolys - 1] != endRef.PolyRef)
+        m_NavQuery->closestPointOnPoly(TmpPolys[numPolys - 1], inEndPos.ToPtr(), closestLocalEnd.ToPtr(), 0);
+
+    int pathLen;
+    m_NavQuery->findStraightPath(inStartPos.ToPtr(), closestLocalEnd.ToPtr(), TmpPolys, numPolys, TmpPathPoints[0].ToPtr(), TmpPathFlags, TmpPathPolys, &pathLen, MAX_POLYS);
+
+    outPathPoints.Resize(pathLen);
+    Core::Memcpy(outPathPoints.ToPtr(), TmpPathPoints, sizeof(Float3) * pathLen);
+
+    return true;
+}
+
+bool NavMeshInterface::FindPath(Float3 const& inStartPos, Float3 const& inEndPos, Float3 const& inExtents, Vector<Float3>& outPathPoints) const
+{
+    return FindPath(inStartPos, inEndPos, inExtents, m_QueryFilter, outPathPoints);
+}
+
+NavPathHandle NavMeshInterface::RequestPath(NavPathRequest const& inRequest)
+{
+    if (m_PathQueries.IsEmpty())
+        return {};
+
+    if (m_FreePathRequests.IsEmpty() && m_PathRequests.Size() >= NavPathHandle::MAX_ID)
+    {
+        LOG("NavMeshInterface::RequestPath: Too many path requests\n");
+        return {};
+    }
+
+    // Requests that start and end in the same cells are served by the same search
+    const Float3 invCellSize(1.0f / m_CellSize, 1.0f / m_CellHeight, 1.0f / m_CellSize);
+    int32_t cells[6];
+    for (int i = 0; i < 3; ++i)
+    {
+        cells[i] = int32_t(Math::Floor(inRequest.StartPos[i] * invCellSize[i]));
+        cells[i + 3] = int32_t(Math::Floor(inRequest.EndPos[i] * invCellSize[i]));
+    }
+
+    NavQueryFilter::AreaCostArray const& areaCosts = inRequest.Filter.GetAreaCosts();
+
+    uint32_t hash = HashTraits::Murmur3Hash(reinterpret_cast<const char*>(cells), sizeof(cells));
+    hash = HashTraits::Murmur3Hash(reinterpret_cast<const char*>(inRequest.Extents.ToPtr()), sizeof(Float3), hash);
+    hash = HashTraits::Murmur3Hash(reinterpret_cast<const char*>(areaCosts.ToPtr()), sizeof(float) * areaCosts.Size(), hash);
+    hash = HashTraits::HashCombine(hash, inRequest.Filter.GetAreaMask());
+
+    auto isSameSearch = [&](PathSearch const& search)
+    {
+        if (memcmp(search.Cells, cells, sizeof(cells)) != 0 || search.Extents != inRequest.Extents)
+            return false;
+        if (search.Filter.GetAreaMask() != inRequest.Filter.GetAreaMask())
+            return false;
+        return memcmp(search.Filter.GetAreaCosts().ToPtr(), areaCosts.ToPtr(), sizeof(float) * areaCosts.Size()) == 0;
+    };
+
+    uint32_t searchIndex;
+
+    auto it = m_PathSearchLookup.Find(hash);
+    if (it != m_PathSearchLookup.End() && isSameSearch(m_PathSearches[it->second]))
+    {
+        searchIndex = it->second;
+
+        PathSearch& search = m_PathSearches[searchIndex];
+        if (inRequest.Priority > search.Priority)
+        {
+            search.Priority = inRequest.Priority;
+            if (search.Query == -1)
+                m_SortPendingPathSearches = true;
+        }
+    }
+    else
+    {
+        if (!m_FreePathSearches.IsEmpty())
+        {
+            searchIndex = m_FreePathSearches.Last();
+            m_FreePathSearches.RemoveLast();
+        }
+        else
+        {
+            searchIndex = m_PathSearches.Size();
+            m_PathSearches.Add();
+        }
+
+        PathSearch& search = m_PathSearches[searchIndex];
+        search.StartPos = inRequest.StartPos;
+        search.EndPos = inRequest.EndPos;
+        search.Extents = inRequest.Extents;
+        search.Filter = inRequest.Filter;
+        search.Priority = inRequest.Priority;
+        Core::Memcpy(search.Cells, cells, sizeof(cells));
+        search.Hash = hash;
+        search.Order = m_PathSearchOrder++;
+        search.Status = NavPathStatus::Pending;
+        search.Query = -1;
+
+        m_PendingPathSearches.Add(searchIndex);
+        m_SortPendingPathSearches = true;
+
+        // On hash collision the existing search keeps the slot
+        if (it == m_PathSearchLookup.End())
+            m_PathSearchLookup[hash] = searchIndex;
+    }
+
+    uint32_t requestIndex;
+    if (!m_FreePathRequests.IsEmpty())
+    {
+        requestIndex = m_FreePathRequests.Last();
+        m_FreePathRequests.RemoveLast();
+    }
+    else
+    {
+        requestIndex = m_PathRequests.Size();
+        m_PathRequests.Add().Version = 1;
+    }
+
+    PathRequestRecord& record = m_PathRequests[requestIndex];
+    record.Search = searchIndex;
+    record.IsUsed = true;
+    record.Callback = inRequest.Callback;
+
+    PathSearch& search = m_PathSearches[searchIndex];
+    search.RefCount++;
+    search.Requests.Add(requestIndex);
+
+    return NavPathHandle(requestIndex, record.Version);
+}
+
+bool NavMeshInterface::IsPathRequestValid(NavPathHandle inHandle) const
+{
+    uint32_t requestIndex = inHandle.GetID();
+    if (requestIndex >= m_PathRequests.Size())
+        return false;
+
+    PathRequestRecord const& record = m_PathRequests[requestIndex];
+    return record.IsUsed && record.Version == inHandle.GetVersion();
+}
+
+NavPathStatus NavMeshInterface::GetPathStatus(NavPathHandle inHandle) const
+{
+    if (!IsPathRequestValid(inHandle))
+        return NavPathStatus::Invalid;
+
+    return m_PathSearches[m_PathRequests[inHandle.GetID()].Search].Status;
+}
+
+NavPathStatus NavMeshInterface::GetPathResult(NavPathHandle inHandle, Vector<NavMeshPathPoint>& outPathPoints)
+{
+    if (!IsPathRequestValid(inHandle))
+        return NavPathStatus::Invalid;
+
+    PathSearch const& search = m_PathSearches[m_PathRequests[inHandle.GetID()].Search];
+
+    NavPathStatus status = search.Status;
+    if (status == NavPathStatus::Pending)
+        return status;
+
+    outPathPoints = search.Path;
+
+    ReleasePathRequest(inHandle);
+    return status;
+}
+
+void NavMeshInterface::CancelPathRequest(NavPathHandle inHandle)
+{
+    if (IsPathRequestValid(inHandle))
+        ReleasePathRequest(inHandle);
+}
+
+void NavMeshInterface::ReleasePathRequest(NavPathHandle inHandle)
+{
+    uint32_t requestIndex = inHandle.GetID();
+
+    PathRequestRecord& record = m_PathRequests[requestIndex];
+    uint32_t searchIndex = record.Search;
+
+    record.IsUsed = false;
+    record.Callback.Clear();
+    record.Version = (record.Version + 1) % NavPathHandle::MAX_VERSION;
+    if (record.Version == 0)
+        record.Version = 1;
+    m_FreePathRequests.Add(requestIndex);
+
+    PathSearch& search = m_PathSearches[searchIndex];
+    auto index = search.Requests.IndexOf(requestIndex);
+    if (index != Core::NPOS)
+        search.Requests.RemoveUnsorted(index);
+
+    ReleasePathSearch(searchIndex);
+}
+
+void NavMeshInterface::ReleasePathSearch(uint32_t inSearchIndex)
+{
+    PathSearch& search = m_PathSearches[inSearchIndex];
+    HK_ASSERT(search.RefCount > 0);
+
+    if (--search.RefCount > 0)
+        return;
+
+    // The search may still be assigned to a query even if it is completed: callbacks of another search finished
+    // on the same frame can cancel it before UpdatePathRequests gets to it.
+    if (search.Query != -1)
+    {
+        // The sliced search state is simply overwritten by the next search
+        NavPathQuery& query = *m_PathQueries[search.Query];
+        if (query.Search == inSearchIndex)
+            query.Search = NavPathQuery::InvalidSearch;
+        search.Query = -1;
+    }
+    else if (search.Status == NavPathStatus::Pending)
+    {
+        auto index = m_PendingPathSearches.IndexOf(inSearchIndex);
+        if (index != Core::NPOS)
+            m_PendingPathSearches.Remove(index);
+    }
+
+    auto it = m_PathSearchLookup.Find(search.Hash);
+    if (it != m_PathSearchLookup.End() && it->second == inSearchIndex)
+        m_PathSearchLookup.Erase(it);
+
+    search.Status = NavPathStatus::Invalid;
+    search.Requests.Clear();
+    search.Path.Clear();
+
+    m_FreePathSearches.Add(inSearchIndex);
+}
+
+void NavMeshInterface::DiscardPathRequests()
+{
+    for (uint32_t requestIndex = 0; requestIndex < m_PathRequests.Size(); ++requestIndex)
+    {
+        PathRequestRecord const& record = m_PathRequests[requestIndex];
+        if (record.IsUsed)
+            ReleasePathRequest(NavPathHandle(requestIndex, record.Version));
+    }
+
+    m_ActivePathQueries.Clear();
+}
+
+void NavMeshInterface::UpdatePathRequests()
+{
+    if (m_PathQueries.IsEmpty())
+        return;
+
+    if (m_SortPendingPathSearches)
+    {
+        // The search with the highest priority and the oldest request goes last
+        std::sort(m_PendingPathSearches.Begin(), m_PendingPathSearches.End(), [this](uint32_t a, uint32_t b)
+        {
+            PathSearch const& searchA = m_PathSearches[a];
+            PathSearch const& searchB = m_PathSearches[b];
+            if (searchA.Priority != searchB.Priority)
+                return searchA.Priority < searchB.Priority;
+            return searchA.Order > searchB.Order;
+        });
+        m_SortPendingPathSearches = false;
+    }
+
+    // Idle queries take pending searches from the end of the list while they have iterations left
+    const bool hasPendingSearches = !m_PendingPathSearches.IsEmpty();
+
+    m_ActivePathQueries.Clear();
+    for (uint32_t queryIndex = 0; queryIndex < m_PathQueries.Size(); ++queryIndex)
+    {
+        if (hasPendingSearches || m_PathQueries[queryIndex]->Search != NavPathQuery::InvalidSearch)
+            m_ActivePathQueries.Add(queryIndex);
+    }
+
+    if (m_ActivePathQueries.IsEmpty())
+        return;
+
+    const int maxIterations = Math::Max(com_NavPathIterations.GetInteger(), 1);
+
+    m_NumTakenPathSearches.Store(0);
+
+    GameApplication::GetAsyncJobManager().ParallelFor(m_ActivePathQueries.Size(), 1, [this, maxIterations](uint32_t first, uint32_t last)
+    {
+        for (uint32_t i = first; i < last; ++i)
+            RunPathQuery(m_ActivePathQueries[i], maxIterations);
+    });
+
+    uint32_t numTaken = Math::Min<uint32_t>(m_NumTakenPathSearches.Load(), m_PendingPathSearches.Size());
+    m_PendingPathSearches.Resize(m_PendingPathSearches.Size() - numTaken);
+
+    for (uint32_t i = 0; i < m_ActivePathQueries.Size(); ++i)
+    {
+        uint32_t queryIndex = m_ActivePathQueries[i];
+        NavPathQuery& query = *m_PathQueries[queryIndex];
+
+        for (uint32_t searchIndex : query.Completed)
+        {
+            // Callbacks may cancel the searches completed by this or the other queries. Released searches
+            // are detached from the query.
+            if (m_PathSearches[searchIndex].Query != int(queryIndex))
+                continue;
+
+            m_PathSearches[searchIndex].Query = -1;
+
+            FinishPathSearch(searchIndex);
+        }
+        query.Completed.Clear();
+    }
+}
+
+void NavMeshInterface::RunPathQuery(uint32_t inQueryIndex, int inMaxIterations)
+{
+    NavPathQuery& query = *m_PathQueries[inQueryIndex];
+
+    int iterations = inMaxIterations;
+    while (iterations > 0)
+    {
+        if (query.Search == NavPathQuery::InvalidSearch)
+        {
+            // Called from worker threads, so the pending searches are taken through the atomic counter
+            uint32_t taken = m_NumTakenPathSearches.FetchIncrement();
+            if (taken >= m_PendingPathSearches.Size())
+                break;
+
+            query.Search = m_PendingPathSearches[m_PendingPathSearches.Size() - 1 - taken];
+            query.IsStarted = false;
+
+            m_PathSearches[query.Search].Query = inQueryIndex;
+        }
+
+        iterations -= UpdatePathSearch(query, iterations);
+
+        if (m_PathSearches[query.Search].Status == NavPathStatus::Pending)
+            break;
+
+        query.Completed.Add(query.Search);
+        query.Search = NavPathQuery::InvalidSearch;
+    }
+}
+
+int NavMeshInterface::UpdatePathSearch(NavPathQuery& inQuery, int inMaxIterations)
+{
+    PathSearch& search = m_PathSearches[inQuery.Search];
+    dtNavMeshQuery* navQuery = inQuery.Query;
+
+    if (!inQuery.IsStarted)
+    {
+        inQuery.IsStarted = true;
+        inQuery.Filter = search.Filter;
+        inQuery.DetourFilter = dtQueryFilter(inQuery.Filter.GetAreaCosts().ToPtr(), inQuery.Filter.GetAreaMask());
+
+        dtPolyRef startRef{}, endRef{};
+        navQuery->findNearestPoly(search.StartPos.ToPtr(), search.Extents.ToPtr(), &inQuery.DetourFilter, &startRef, nullptr);
+        navQuery->findNearestPoly(search.EndPos.ToPtr(), search.Extents.ToPtr(), &inQuery.DetourFilter, &endRef, nullptr);
+        if (!startRef || !endRef)
+        {
+            search.Status = NavPathStatus::Failed;
+            return 1;
+        }
+
+        inQuery.EndRef = endRef;
+
+        if (dtStatusFailed(navQuery->initSlicedFindPath(startRef, endRef, search.StartPos.ToPtr(), search.EndPos.ToPtr(), &inQuery.DetourFilter)))
+        {
+            search.Status = NavPathStatus::Failed;
+            return 1;
+        }
+    }
+
+    int doneIterations = 0;
+    dtStatus status = navQuery->updateSlicedFindPath(inMaxIterations, &doneIterations);
+
+    // Count at least one iteration so a query can't loop over the searches that fail right away
+    doneIterations = Math::Max(doneIterations, 1);
+
+    if (dtStatusInProgress(status))
+        return doneIterations;
+
+    int numPolys = 0;
+    if (dtStatusSucceed(status))
+        status = navQuery->finalizeSlicedFindPath(inQuery.Polys, &numPolys, MAX_POLYS);
+
+    if (dtStatusFailed(status) || numPolys == 0)
+    {
+        search.Status = NavPathStatus::Failed;
+        return doneIterations;
+    }
+
+    Float3 closestLocalEnd = search.EndPos;
 
-    if (TmpPolys[numPolys - 1] != endRef.PolyRef)
-        m_NavQuery->closestPointOnPoly(TmpPolys[numPolys - 1], inEndPos.ToPtr(), closestLocalEnd.ToPtr(), 0);
+    if (inQuery.Polys[numPolys - 1] != inQuery.EndRef)
+        navQuery->closestPointOnPoly(inQuery.Polys[numPolys - 1], search.EndPos.ToPtr(), closestLocalEnd.ToPtr(), 0);
 
-    int pathLen;
-    m_NavQuery->findStraightPath(inStartPos.ToPtr(), closestLocalEnd.ToPtr(), TmpPolys, numPolys, TmpPathPoints[0].ToPtr(), TmpPathFlags, TmpPathPolys, &pathLen, MAX_POLYS);
+    int pathLen = 0;
+    status = navQuery->findStraightPath(search.StartPos.ToPtr(), closestLocalEnd.ToPtr(), inQuery.Polys, numPolys, inQuery.PathPoints[0].ToPtr(), inQuery.PathFlags, inQuery.PathPolys, &pathLen, MAX_POLYS);
+    if (dtStatusFailed(status))
+    {
+        search.Status = NavPathStatus::Failed;
+        return doneIterations;
+    }
 
-    outPathPoints.Resize(pathLen);
+    search.Path.Resize(pathLen);
     for (int i = 0; i < pathLen; ++i)
     {
-        outPathPoints[i].Position = TmpPathPoints[i];
-        outPathPoints[i].Flags = NavMeshPathFlags(TmpPathFlags[i]);
+        search.Path[i].Position = inQuery.PathPoints[i];
+        search.Path[i].Flags = NavMeshPathFlags(inQuery.PathFlags[i]);
     }
 
-    return true;
-}
-
-bool NavMeshInterface::FindPath(Float3 const& inStartPos, Float3 const& inEndPos, Float3 const& inExtents, Vector<NavMeshPathPoint>& outPathPoints) const
-{
-    return FindPath(inStartPos, inEndPos, inExtents, m_QueryFilter, outPathPoints);
+    search.Status = NavPathStatus::Succeeded;
+    return doneIterations;
 }
 
-bool NavMeshInterface::FindPath(Float3 const& inStartPos, Float3 const& inEndPos, Float3 const& inExtents, NavQueryFilter const& inFilter, Vector<Float3>& outPathPoints) const
+void NavMeshInterface::FinishPathSearch(uint32_t inSearchIndex)
 {
-    NavPointRef startRef;
-    NavPointRef endRef;
+    PathSearch& search = m_PathSearches[inSearchIndex];
 
-    if (!QueryNearestPoly(inStartPos, inExtents, inFilter, startRef.PolyRef))
-        return false;
+    // New requests must not join the finished search
+    auto it = m_PathSearchLookup.Find(search.Hash);
+    if (it != m_PathSearchLookup.End() && it->second == inSearchIndex)
+        m_PathSearchLookup.Erase(it);
 
-    if (!QueryNearestPoly(inEndPos, inExtents, inFilter, endRef.PolyRef))
-        return false;
+    // Callbacks may add new requests and reallocate the searches, so the search is kept alive
+    // and the path is moved out of it for the time of the callbacks.
+    NavPathStatus status = search.Status;
+    Vector<uint32_t> requests = std::move(search.Requests);
+    Vector<NavMeshPathPoint> path = std::move(search.Path);
+    search.RefCount++;
 
-    startRef.Position = inStartPos;
-    endRef.Position = inEndPos;
+    for (uint32_t requestIndex : requests)
+    {
+        PathRequestRecord& record = m_PathRequests[requestIndex];
 
-    int numPolys;
-    if (!FindPath(startRef, endRef, inFilter, TmpPolys, numPolys, MAX_POLYS))
-        return false;
+        // The request could be canceled from the previous callback
+        if (!record.IsUsed || record.Search != inSearchIndex)
+            continue;
 
-    Float3 closestLocalEnd = inEndPos;
+        if (record.Callback.IsEmpty())
+        {
+            // Keep the request until the result is taken
+            m_PathSearches[inSearchIndex].Requests.Add(requestIndex);
+            continue;
+        }
 
-    if (TmpPolys[numPolys - 1] != endRef.PolyRef)
-        m_NavQuery->closestPointOnPoly(TmpPolys[numPolys - 1], inEndPos.ToPtr(), closestLocalEnd.ToPtr(), 0);
+        NavPathHandle handle(requestIndex, record.Version);
+        NavPathCallback callback = record.Callback;
 
-    int pathLen;
-    m_NavQuery->findStraightPath(inStartPos.ToPtr(), closestLocalEnd.ToPtr(), TmpPolys, numPolys, TmpPathPoints[0].ToPtr(), TmpPathFlags, TmpPathPolys, &pathLen, MAX_POLYS);
+        ReleasePathRequest(handle);
 
-    outPathPoints.Resize(pathLen);
-    Core::Memcpy(outPathPoints.ToPtr(), TmpPathPoints, sizeof(Float3) * pathLen);
+        callback.Invoke(handle, status, path);
+    }
 
-    return true;
-}
+    m_PathSearches[inSearchIndex].Path = std::move(path);
 
-bool NavMeshInterface::FindPath(Float3 const& inStartPos, Float3 const& inEndPos, Float3 const& inExtents, Vector<Float3>& outPathPoints) const
-{
-    return FindPath(inStartPos, inEndPos, inExtents, m_QueryFilter, outPathPoints);
+    ReleasePathSearch(inSearchIndex);
 }
 
 bool NavMeshInterface::FindStraightPath(Float3 const& inStartPos, Float3 const& inEndPos, NavPolyRef const* inPath, int inPathSize, Float3* outStraightPath, NavMeshPathFlags* outStraightPathFlags, NavPolyRef* outStraightPathRefs, int& outStraightPathCount, int inMaxStraightPath, NavMeshCrossings inStraightPathCrossing) const
@@ -1502,7 +2631,7 @@ namespace
         }
     }
 #else
-    void MarkWalkableTriangles(float inSlopeAngleDeg, Float3 const* inVertices, int inTriangleCount, int inFirstTriangle/*, BitMask<> const& inWalkableMask*/, unsigned char* outAreas)
+    void MarkWalkableTriangles(float inSlopeAngleDeg, Float3 const* inVertices, int const* inIndices, int inTriangleCount/*, BitMask<> const& inWalkableMask*/, unsigned char* outAreas)
     {
         Float3 perpendicular;
         float perpendicularLength;
@@ -1511,12 +2640,11 @@ namespace
 
         for (int i = 0; i < inTriangleCount; ++i)
         {
-            int triangle = inFirstTriangle + i;
             //if (inWalkableMask.IsMarked(triangle))
             {
-                Float3 const* tri = &inVertices[triangle * 3];
+                int const* tri = &inIndices[i * 3];
 
-                perpendicular = Math::Cross(tri[1] - tri[0], tri[2] - tri[0]);
+                perpendicular = Math::Cross(inVertices[tri[1]] - inVertices[tri[0]], inVertices[tri[2]] - inVertices[tri[0]]);
                 perpendicularLength = perpendicular.Length();
                 if (perpendicularLength > 0 && perpendicular[1] > threshold * perpendicularLength)
                 {
@@ -1544,44 +2672,54 @@ namespace
 
 } // namespace
 
-bool NavMeshInterface::BuildTile(int inX, int inZ)
+void NavMeshInterface::InitTileConfig(rcConfig& config) const
 {
-    class RecastContext : public rcContext
-    {
-    public:
-        RecastContext()
-        {
-            enableLog(RECAST_ENABLE_LOGGING);
-            enableTimer(RECAST_ENABLE_TIMINGS);
-        }
+    config = {};
+    config.cs = m_CellSize;
+    config.ch = m_CellHeight;
+    config.walkableSlopeAngle = m_WalkableSlopeAngle;
+    config.walkableHeight = (int)Math::Ceil(m_WalkableHeight / config.ch);
+    config.walkableClimb = (int)Math::Floor(m_WalkableClimb / config.ch);
+    config.walkableRadius = (int)Math::Ceil(m_WalkableRadius / config.cs);
+    config.maxEdgeLen = (int)(m_EdgeMaxLength / m_CellSize);
+    config.maxSimplificationError = m_EdgeMaxError;
+    config.minRegionArea = (int)rcSqr(m_MinRegionSize);        // Note: area = size*size
+    config.mergeRegionArea = (int)rcSqr(m_MergeRegionSize); // Note: area = size*size
+    config.detailSampleDist = m_DetailSampleDist < 0.9f ? 0 : m_CellSize * m_DetailSampleDist;
+    config.detailSampleMaxError = m_CellHeight * m_DetailSampleMaxError;
+    config.tileSize = m_TileSize;
+    config.borderSize = config.walkableRadius + 3; // radius + padding
+    config.width = config.tileSize + config.borderSize * 2;
+    config.height = config.tileSize + config.borderSize * 2;
+    config.maxVertsPerPoly = m_VertsPerPoly;
+}
 
-    protected:
-        // Virtual functions override
-        void doResetLog() override {}
-        void doLog(const rcLogCategory category, const char* msg, const int len) override
-        {
-            switch (category)
-            {
-            case RC_LOG_PROGRESS:
-                LOG(msg);
-                break;
-            case RC_LOG_WARNING:
-                LOG(msg);
-                break;
-            case RC_LOG_ERROR:
-                LOG(msg);
-                break;
-            default:
-                LOG(msg);
-                break;
-            }
-        }
-        void doResetTimers() override {}
-        void doStartTimer(const rcTimerLabel label) override {}
-        void doStopTimer(const rcTimerLabel label) override {}
-        int doGetAccumulatedTime(const rcTimerLabel label) const override { return -1; }
-    };
+uint64_t NavMeshInterface::CalcSettingsHash() const
+{
+    Hash64 hash;
+    hash.Add(m_WalkableHeight);
+    hash.Add(m_WalkableRadius);
+    hash.Add(m_WalkableClimb);
+    hash.Add(m_WalkableSlopeAngle);
+    hash.Add(m_CellSize);
+    hash.Add(m_CellHeight);
+    hash.Add(m_EdgeMaxLength);
+    hash.Add(m_EdgeMaxError);
+    hash.Add(m_MinRegionSize);
+    hash.Add(m_MergeRegionSize);
+    hash.Add(m_DetailSampleDist);
+    hash.Add(m_DetailSampleMaxError);
+    hash.Add(m_VertsPerPoly);
+    hash.Add(m_TileSize);
+    hash.Add(m_MaxLayers);
+    hash.Add(uint32_t(m_PartitionMethod));
+    // Tile coordinates are relative to the navmesh origin
+    hash.Add(m_BoundingBox.Mins);
+    return hash.Get();
+}
 
+bool NavMeshInterface::BuildTile(NavMeshBuildTask const& inTask, NavMeshTileBuild& ioTile) const
+{
     struct TemportalData
     {
         rcHeightfield*         Heightfield;
@@ -1607,32 +2745,10 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
         }
     };
 
-    static RecastContext s_RecastContext;
-
-    HK_ASSERT(m_NavMesh);
-
-    ClearTile(inX, inZ);
-
-    rcConfig config = {};
-    config.cs = m_CellSize;
-    config.ch = m_CellHeight;
-    config.walkableSlopeAngle = m_WalkableSlopeAngle;
-    config.walkableHeight = (int)Math::Ceil(m_WalkableHeight / config.ch);
-    config.walkableClimb = (int)Math::Floor(m_WalkableClimb / config.ch);
-    config.walkableRadius = (int)Math::Ceil(m_WalkableRadius / config.cs);
-    config.maxEdgeLen = (int)(m_EdgeMaxLength / m_CellSize);
-    config.maxSimplificationError = m_EdgeMaxError;
-    config.minRegionArea = (int)rcSqr(m_MinRegionSize);        // Note: area = size*size
-    config.mergeRegionArea = (int)rcSqr(m_MergeRegionSize); // Note: area = size*size
-    config.detailSampleDist = m_DetailSampleDist < 0.9f ? 0 : m_CellSize * m_DetailSampleDist;
-    config.detailSampleMaxError = m_CellHeight * m_DetailSampleMaxError;
-    config.tileSize = m_TileSize;
-    config.borderSize = config.walkableRadius + 3; // radius + padding
-    config.width = config.tileSize + config.borderSize * 2;
-    config.height = config.tileSize + config.borderSize * 2;
-    config.maxVertsPerPoly = m_VertsPerPoly;
+    rcConfig config;
+    InitTileConfig(config);
 
-    BvAxisAlignedBox tileBounds = GetTileWorldBounds(inX, inZ);
+    BvAxisAlignedBox tileBounds = GetTileWorldBounds(ioTile.X, ioTile.Z);
     BvAxisAlignedBox tileBoundsWithPad = tileBounds;
 
     tileBoundsWithPad.Mins.X -= config.borderSize * config.cs;
@@ -1640,34 +2756,151 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
     tileBoundsWithPad.Maxs.X += config.borderSize * config.cs;
     tileBoundsWithPad.Maxs.Z += config.borderSize * config.cs;
 
-    NavigationGeometry geometry;
+    SmallVector<BvAxisAlignedBox, 8> cropBoxes;
+    BvAxisAlignedBox maxCropBox = BvAxisAlignedBox::Empty();
 
     BvAxisAlignedBox intersection;
-    for (auto& navigationVolume : NavigationVolumes)
+    for (auto& navigationVolume : inTask.NavigationVolumes)
     {
         if (BvGetBoxIntersection(tileBoundsWithPad, navigationVolume, intersection))
-            geometry.AddCropBox(intersection);
+        {
+            cropBoxes.Add(intersection);
+            maxCropBox.AddAABB(intersection);
+        }
     }
 
-    if (geometry.GetMaxCropBox().IsEmpty())
+    if (maxCropBox.IsEmpty())
+    {
+        ioTile.IsEmpty = true;
         return true;
+    }
+
+    // Select triangles of the chunk geometry that overlap the tile
+    auto& vertices = inTask.Vertices;
+
+    Vector<int> triangles;
+    BvAxisAlignedBox geometryBounds = BvAxisAlignedBox::Empty();
+
+    const int tileIndex = (ioTile.Z - inTask.Mins.Y) * (inTask.Maxs.X - inTask.Mins.X + 1) + (ioTile.X - inTask.Mins.X);
+    for (uint32_t i = inTask.TileTriangleOffsets[tileIndex], end = inTask.TileTriangleOffsets[tileIndex + 1]; i < end; ++i)
+    {
+        const int firstVertex = inTask.TileTriangles[i] * 3;
+        Float3 const* tri = &vertices[firstVertex];
+
+        BvAxisAlignedBox triangleBounds;
+
+        triangleBounds.Mins.X = Math::Min3(tri[0].X, tri[1].X, tri[2].X);
+        triangleBounds.Mins.Y = Math::Min3(tri[0].Y, tri[1].Y, tri[2].Y);
+        triangleBounds.Mins.Z = Math::Min3(tri[0].Z, tri[1].Z, tri[2].Z);
+
+        triangleBounds.Maxs.X = Math::Max3(tri[0].X, tri[1].X, tri[2].X);
+        triangleBounds.Maxs.Y = Math::Max3(tri[0].Y, tri[1].Y, tri[2].Y);
+        triangleBounds.Maxs.Z = Math::Max3(tri[0].Z, tri[1].Z, tri[2].Z);
+
+        for (BvAxisAlignedBox const& cropBox : cropBoxes)
+        {
+            if (BvBoxOverlapBox(cropBox, triangleBounds))
+            {
+                triangles.Add(firstVertex);
+                triangles.Add(firstVertex + 1);
+                triangles.Add(firstVertex + 2);
+
+                geometryBounds.AddAABB(triangleBounds);
+                break;
+            }
+        }
+    }
+
+    // Take the baked tile if the input is unchanged
+    TileInputHash inputHash;
+    for (BvAxisAlignedBox const& cropBox : cropBoxes)
+    {
+        Hash64 hash;
+        hash.Add(cropBox.Mins);
+        hash.Add(cropBox.Maxs);
+        inputHash.Add(hash);
+    }
+    for (uint32_t i = 0; i < triangles.Size(); i += 3)
+        inputHash.AddTriangle(&vertices[triangles[i]]);
+    for (NavMeshAreaDesc const& area : inTask.Areas)
+    {
+        if (!area.Bounds.IsEmpty() && BvBoxOverlapBox(tileBoundsWithPad, area.Bounds))
+            inputHash.AddArea(area);
+    }
+    for (OffMeshLinkDesc const& link : inTask.OffMeshLinks)
+    {
+        BvAxisAlignedBox linkBounds = BvAxisAlignedBox::Empty();
+        linkBounds.AddPoint(link.StartPoint);
+        linkBounds.AddPoint(link.EndPoint);
+        linkBounds.Mins -= link.Radius + 0.2f;
+        linkBounds.Maxs += link.Radius + 0.2f;
+        if (BvBoxOverlapBox(tileBoundsWithPad, linkBounds))
+            inputHash.AddOffMeshLink(link);
+    }
+    ioTile.GeometryHash = inputHash.Get();
 
-    GatherNavigationGeometry(geometry);
+    if (inTask.BakedTiles)
+    {
+        NavMeshResource::Tile const* bakedTile = inTask.BakedTiles->FindTile(ioTile.X, ioTile.Z);
+        if (bakedTile && bakedTile->GeometryHash == ioTile.GeometryHash)
+        {
+            Vector<NavMeshResource::Layer> const& layers = inTask.BakedTiles->GetLayers();
+
+            ioTile.IsEmpty = bakedTile->NumLayers == 0;
+
+            if (m_IsDynamic)
+            {
+                // Compressed layers are only read by the tile cache, so they are used in place
+                ioTile.IsShared = true;
+                for (uint32_t i = 0; i < bakedTile->NumLayers; ++i)
+                {
+                    NavMeshResource::Layer const& layer = layers[bakedTile->FirstLayer + i];
+
+                    NavMeshTileBuild::CacheLayer& cacheLayer = ioTile.CacheLayers.Add();
+                    cacheLayer.Data = const_cast<byte*>(inTask.BakedTiles->GetLayerData(layer));
+                    cacheLayer.Size = layer.Size;
+                }
+            }
+            else if (bakedTile->NumLayers)
+            {
+                // Detour writes the tile links to the tile data, so the navmesh gets a copy
+                NavMeshResource::Layer const& layer = layers[bakedTile->FirstLayer];
+
+                ioTile.NavData = (byte*)dtAlloc(layer.Size, DT_ALLOC_PERM);
+                if (!ioTile.NavData)
+                {
+                    LOG("Could not load baked navmesh tile - out of memory\n");
+                    return false;
+                }
+                Core::Memcpy(ioTile.NavData, inTask.BakedTiles->GetLayerData(layer), layer.Size);
+                ioTile.NavDataSize = layer.Size;
+            }
+            return true;
+        }
+    }
 
-    geometry.Finalize();
+    // Shrink bounding box to clipping box
+    for (int i = 0; i < 3; ++i)
+    {
+        if (geometryBounds.Mins[i] < maxCropBox.Mins[i])
+            geometryBounds.Mins[i] = maxCropBox.Mins[i];
+        if (geometryBounds.Maxs[i] > maxCropBox.Maxs[i])
+            geometryBounds.Maxs[i] = maxCropBox.Maxs[i];
+    }
 
     // Empty tile
-    if (geometry.IsEmpty())
+    if (triangles.IsEmpty() || geometryBounds.IsEmpty())
+    {
+        ioTile.IsEmpty = true;
         return true;
+    }
+
+    tileBoundsWithPad.Mins.Y = geometryBounds.Mins.Y;
+    tileBoundsWithPad.Maxs.Y = geometryBounds.Maxs.Y;
 
-    tileBoundsWithPad.Mins.Y = geometry.GetBoundingBox().Mins.Y;
-    tileBoundsWithPad.Maxs.Y = geometry.GetBoundingBox().Maxs.Y;
-    
     rcVcopy(config.bmin, tileBoundsWithPad.Mins.ToPtr());
     rcVcopy(config.bmax, tileBoundsWithPad.Maxs.ToPtr());
 
-    auto& vertices = geometry.GetVertices();
-
     TemportalData temporal;
 
     // Allocate voxel heightfield where we rasterize our input data to.
@@ -1685,15 +2918,15 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
         return false;
     }
 
-    int triangleCount = vertices.Size() / 3;
+    int triangleCount = triangles.Size() / 3;
 
     // Allocate array that can hold triangle area types.
     unsigned char* triangleAreaTypes = (unsigned char*)Core::GetHeapAllocator<HEAP_TEMP>().Alloc(triangleCount, 16, MALLOC_ZERO);
 
     // Find triangles which are walkable based on their slope and rasterize them.
-    MarkWalkableTriangles(config.walkableSlopeAngle, vertices.ToPtr(), triangleCount, 0, triangleAreaTypes);
+    MarkWalkableTriangles(config.walkableSlopeAngle, vertices.ToPtr(), triangles.ToPtr(), triangleCount, triangleAreaTypes);
 
-    bool rasterized = rcRasterizeTriangles(&s_RecastContext, &vertices.ToPtr()->X, triangleAreaTypes, triangleCount, *temporal.Heightfield, config.walkableClimb);
+    bool rasterized = rcRasterizeTriangles(&s_RecastContext, &vertices.ToPtr()->X, vertices.Size(), triangles.ToPtr(), triangleAreaTypes, triangleCount, *temporal.Heightfield, config.walkableClimb);
 
     Core::GetHeapAllocator<HEAP_TEMP>().Free(triangleAreaTypes);
 
@@ -1743,9 +2976,9 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
 
         Visitor(rcCompactHeightfield& chf, BvAxisAlignedBox const& tileBoundsWithPad) : chf(chf), tileBoundsWithPad(tileBoundsWithPad) {}
 
-        void Visit(NavMeshAreaComponent& area)
+        void Visit(NavMeshAreaDesc const& area)
         {
-            BvAxisAlignedBox areaBounds = area.CalcBoundingBox();
+            BvAxisAlignedBox const& areaBounds = area.Bounds;
             if (areaBounds.IsEmpty())
             {
                 // Invalid bounding box
@@ -1758,17 +2991,17 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
                 return;
             }
 
-            switch (area.GetShape())
+            switch (area.Shape)
             {
                 case NavMeshAreaShape::Box:
-                    rcMarkBoxArea(&s_RecastContext, areaBounds.Mins.ToPtr(), areaBounds.Maxs.ToPtr(), area.GetAreaType(), chf);
+                    rcMarkBoxArea(&s_RecastContext, areaBounds.Mins.ToPtr(), areaBounds.Maxs.ToPtr(), area.AreaType, chf);
                     break;
                 case NavMeshAreaShape::Cylinder:
                 {
-                    Float3 worldPosition = area.GetOwner()->GetWorldPosition();
-                    float height = area.GetHeight();
+                    Float3 worldPosition = area.WorldPosition;
+                    float height = area.Height;
                     worldPosition.Y -= height * 0.5f;
-                    rcMarkCylinderArea(&s_RecastContext, worldPosition.ToPtr(), area.GetCylinderRadius(), height, area.GetAreaType(), chf);
+                    rcMarkCylinderArea(&s_RecastContext, worldPosition.ToPtr(), area.CylinderRadius, height, area.AreaType, chf);
                     break;
                 }
                 case NavMeshAreaShape::ConvexVolume:
@@ -1791,7 +3024,7 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
                     if (minz < 0) minz = 0;
                     if (maxz >= chf.height) maxz = chf.height - 1;
 
-                    Float3 worldPosition = area.GetOwner()->GetWorldPosition();
+                    Float3 const& worldPosition = area.WorldPosition;
 
                     for (int z = minz; z <= maxz; ++z)
                     {
@@ -1809,11 +3042,11 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
                                     p[0] = chf.bmin[0] + (x + 0.5f) * chf.cs - worldPosition.X;
                                     p[1] = chf.bmin[2] + (z + 0.5f) * chf.cs - worldPosition.Z;
 
-                                    auto& contour = area.GetVolumeContour();
+                                    auto& contour = area.VolumeContour;
 
                                     if (PointInPoly2D(contour.Size(), contour[0].ToPtr(), p))
                                     {
-                                        chf.areas[i] = area.GetAreaType();
+                                        chf.areas[i] = area.AreaType;
                                     }
                                 }
                             }
@@ -1826,8 +3059,8 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
     };
 
     Visitor visitor(*temporal.CompactHeightfield, tileBoundsWithPad);
-    auto& areas = GetWorld()->GetComponentManager<NavMeshAreaComponent>();
-    areas.IterateComponents(visitor);
+    for (NavMeshAreaDesc const& area : inTask.Areas)
+        visitor.Visit(area);
 
     // Partition the heightfield so that we can use simple algorithm later to triangulate the walkable areas.
     // There are 3 partitioning methods, each with some pros and cons:
@@ -1898,30 +3131,6 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
 
     if (m_IsDynamic)
     {
-        // Add obstacles inside tile
-        struct ObstacleVisitor
-        {
-            NavMeshInterface* m_Interface;
-            BvAxisAlignedBox m_TileBounds;
-
-            void Visit(NavMeshObstacleComponent& obstacle)
-            {
-                Float3 const& position = obstacle.GetOwner()->GetWorldPosition();
-                float radiusSqr = obstacle.GetRadius();
-
-                if (m_TileBounds.GetSquareDistanceToPoint(position) < radiusSqr*radiusSqr)
-                {
-                    m_Interface->RemoveObstacle(&obstacle);
-                    m_Interface->AddObstacle(&obstacle);
-                }
-            }
-        };
-        ObstacleVisitor obstacleVisitor;
-        obstacleVisitor.m_Interface = this;
-        obstacleVisitor.m_TileBounds = tileBounds;
-        auto& obstacles = GetWorld()->GetComponentManager<NavMeshObstacleComponent>();
-        obstacles.IterateComponents(obstacleVisitor);
-
         temporal.LayerSet = rcAllocHeightfieldLayerSet();
         if (!temporal.LayerSet)
         {
@@ -1935,26 +3144,17 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
             return false;
         }
 
-        struct TileCacheData
-        {
-            byte* Data;
-            int Size;
-        };
-
-        TileCacheData cacheData[MaxAllowedLayers];
-
         int numLayers = Math::Min(temporal.LayerSet->nlayers, MaxAllowedLayers);
-        int numValidLayers = 0;
+        ioTile.CacheLayers.Reserve(numLayers);
         for (int i = 0; i < numLayers; ++i)
         {
-            TileCacheData* tile = &cacheData[i];
             rcHeightfieldLayer const* layer = &temporal.LayerSet->layers[i];
 
             dtTileCacheLayerHeader header;
             header.magic   = DT_TILECACHE_MAGIC;
             header.version = DT_TILECACHE_VERSION;
-            header.tx      = inX;
-            header.ty      = inZ;
+            header.tx      = ioTile.X;
+            header.ty      = ioTile.Z;
             header.tlayer  = i;
             dtVcopy(header.bmin, layer->bmin);
             dtVcopy(header.bmax, layer->bmax);
@@ -1967,71 +3167,16 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
             header.hmin   = (unsigned short)layer->hmin;
             header.hmax   = (unsigned short)layer->hmax;
 
-            dtStatus status = dtBuildTileCacheLayer(&s_TileCompressorCallback, &header, layer->heights, layer->areas, layer->cons, &tile->Data, &tile->Size);
+            NavMeshTileBuild::CacheLayer cacheLayer;
+            dtStatus status = dtBuildTileCacheLayer(&s_TileCompressorCallback, &header, layer->heights, layer->areas, layer->cons, &cacheLayer.Data, &cacheLayer.Size);
             if (dtStatusFailed(status))
             {
                 LOG("Failed on dtBuildTileCacheLayer\n");
                 break;
             }
 
-            numValidLayers++;
-        }
-
-        int cachedLayerCount = 0;
-        //int cacheCompressedSize = 0;
-        //int cacheRawSize = 0;
-        //const int layerSize = dtAlign4(sizeof(dtTileCacheLayerHeader)) + m_TileSize * m_TileSize * numLayers;
-        for (int i = 0; i < numValidLayers; ++i)
-        {
-            dtCompressedTileRef ref;
-            dtStatus status = m_TileCache->addTile(cacheData[i].Data, cacheData[i].Size, DT_COMPRESSEDTILE_FREE_DATA, &ref);
-            if (dtStatusFailed(status))
-            {
-                dtFree(cacheData[i].Data);
-                cacheData[i].Data = nullptr;
-                continue;
-            }
-
-            status = m_TileCache->buildNavMeshTile(ref, m_NavMesh);
-            if (dtStatusFailed(status))
-                LOG("Failed to build navmesh tile: {}\n", GetErrorStr(status));
-
-            cachedLayerCount++;
-            //cacheCompressedSize += cacheData[i].Size;
-            //cacheRawSize += layerSize;
+            ioTile.CacheLayers.Add(cacheLayer);
         }
-
-        if (cachedLayerCount == 0)
-            return false;
-
-        //int buildPeakMemoryUsage = m_LinearAllocator->High;
-        //const float compressionRatio = (float)cacheCompressedSize / (float)(cacheRawSize + 1);
-
-        //int tileMemoryUsage = 0;
-        //const dtNavMesh* mesh = m_NavMesh;
-        //for (int i = 0; i < mesh->getMaxTiles(); ++i)
-        //{
-        //    const dtMeshTile* tile = mesh->getTile(i);
-        //    if (tile->header)
-        //        tileMemoryUsage += tile->dataSize;
-        //}
-
-        //auto gridSize = gridW * gridH;
-        //LOG("Processed navigation data:\n"
-        //    "Tile memory usage: {:1f} kB\n"
-        //    "Cache compressed size: {:1f} kB\n"
-        //    "Cache raw size: {:1f} kB\n"
-        //    "Cache compression ratio: {:1f}%%\n"
-        //    "Cache layers count: {}\n"
-        //    "Cache layers per tile: {:1f}\n"
-        //    "Build peak memory usage: {} kB\n",
-        //    tileMemoryUsage / 1024.0f,
-        //    cacheCompressedSize / 1024.0f,
-        //    cacheRawSize / 1024.0f,
-        //    compressionRatio * 100.0f,
-        //    cachedLayerCount,
-        //    (float)cachedLayerCount / gridSize,
-        //    buildPeakMemoryUsage);
     }
     else
     {
@@ -2068,6 +3213,7 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
         if (!temporal.PolyMesh->nverts || !temporal.PolyMesh->npolys)
         {
             // no data to build tile
+            ioTile.IsEmpty = true;
             return true;
         }
 
@@ -2109,15 +3255,19 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
         params.walkableHeight   = m_WalkableHeight;
         params.walkableRadius   = m_WalkableRadius;
         params.walkableClimb    = m_WalkableClimb;
-        params.tileX            = inX;
-        params.tileY            = inZ;
+        params.tileX            = ioTile.X;
+        params.tileY            = ioTile.Z;
         rcVcopy(params.bmin, temporal.PolyMesh->bmin);
         rcVcopy(params.bmax, temporal.PolyMesh->bmax);
         params.cs               = config.cs;
         params.ch               = config.ch;
         params.buildBvTree      = true;
 
-        m_MeshProcess->process(&params, temporal.PolyMesh->areas, temporal.PolyMesh->flags);
+        SetupPolyAreas(&params, temporal.PolyMesh->areas, temporal.PolyMesh->flags);
+
+        OffMeshConnections offMeshConnections;
+        offMeshConnections.Build(inTask.OffMeshLinks, BvAxisAlignedBox(Float3(params.bmin[0], params.bmin[1], params.bmin[2]), Float3(params.bmax[0], params.bmax[1], params.bmax[2])));
+        offMeshConnections.Apply(&params);
 
         unsigned char* navData = 0;
         int navDataSize = 0;
@@ -2133,15 +3283,89 @@ bool NavMeshInterface::BuildTile(int inX, int inZ)
             return false;
         }
 
-        dtStatus status = m_NavMesh->addTile(navData, navDataSize, DT_TILE_FREE_DATA, 0, nullptr);
-        if (dtStatusFailed(status))
+        ioTile.NavData = navData;
+        ioTile.NavDataSize = navDataSize;
+    }
+
+    return true;
+}
+
+bool NavMeshInterface::CommitTile(NavMeshTileBuild& ioTile)
+{
+    HK_ASSERT(m_NavMesh);
+
+    ClearTile(ioTile.X, ioTile.Z);
+
+    if (!ioTile.IsBuilt)
+        return false;
+
+    if (ioTile.GeometryHash)
+        m_TileHashes[MakeTileKey(ioTile.X, ioTile.Z)] = ioTile.GeometryHash;
+
+    if (ioTile.IsEmpty)
+        return true;
+
+    if (m_IsDynamic)
+    {
+        // Add obstacles inside tile
+        struct ObstacleVisitor
         {
-            dtFree(navData);
-            LOG("Could not add tile to navmesh\n");
-            return false;
+            NavMeshInterface* m_Interface;
+            BvAxisAlignedBox m_TileBounds;
+
+            void Visit(NavMeshObstacleComponent& obstacle)
+            {
+                Float3 const& position = obstacle.GetOwner()->GetWorldPosition();
+                float radiusSqr = obstacle.GetRadius();
+
+                if (m_TileBounds.GetSquareDistanceToPoint(position) < radiusSqr*radiusSqr)
+                {
+                    m_Interface->RemoveObstacle(&obstacle);
+                    m_Interface->AddObstacle(&obstacle);
+                }
+            }
+        };
+        ObstacleVisitor obstacleVisitor;
+        obstacleVisitor.m_Interface = this;
+        obstacleVisitor.m_TileBounds = GetTileWorldBounds(ioTile.X, ioTile.Z);
+        auto& obstacles = GetWorld()->GetComponentManager<NavMeshObstacleComponent>();
+        obstacles.IterateComponents(obstacleVisitor);
+
+        int cachedLayerCount = 0;
+        for (NavMeshTileBuild::CacheLayer& layer : ioTile.CacheLayers)
+        {
+            dtCompressedTileRef ref;
+            dtStatus status = m_TileCache->addTile(layer.Data, layer.Size, ioTile.IsShared ? 0 : DT_COMPRESSEDTILE_FREE_DATA, &ref);
+            if (dtStatusFailed(status))
+            {
+                if (!ioTile.IsShared)
+                    dtFree(layer.Data);
+                continue;
+            }
+
+            status = m_TileCache->buildNavMeshTile(ref, m_NavMesh);
+            if (dtStatusFailed(status))
+                LOG("Failed to build navmesh tile: {}\n", GetErrorStr(status));
+
+            cachedLayerCount++;
         }
+        ioTile.CacheLayers.Clear();
+
+        return cachedLayerCount > 0;
+    }
+
+    dtStatus status = m_NavMesh->addTile(ioTile.NavData, ioTile.NavDataSize, DT_TILE_FREE_DATA, 0, nullptr);
+    if (dtStatusFailed(status))
+    {
+        m_TileHashes.Erase(MakeTileKey(ioTile.X, ioTile.Z));
+        ioTile.FreeData();
+        LOG("Could not add tile to navmesh\n");
+        return false;
     }
 
+    // The navmesh owns the data now
+    ioTile.NavData = nullptr;
+    ioTile.NavDataSize = 0;
     return true;
 }
 
@@ -31,13 +31,19 @@ SOFTWARE.
 #pragma once
 
 #include <Engine/Core/Containers/Array.h>
+#include <Engine/Core/Containers/ArrayView.h>
+#include <Engine/Core/Containers/Hash.h>
+#include <Engine/Core/Atomic.h>
+#include <Engine/Core/Handle.h>
 #include <Engine/Core/Color.h>
 #include <Engine/Geometry/BV/BvAxisAlignedBox.h>
 #include <Engine/World/WorldInterface.h>
+#include <Engine/World/Resources/Resource_NavMesh.h>
 
 class dtNavMesh;
 class dtNavMeshQuery;
 class dtTileCache;
+struct rcConfig;
 
 HK_NAMESPACE_BEGIN
 
@@ -164,12 +170,52 @@ private:
     uint32_t                m_AreaMask = ~0u;
 };
 
+enum class NavPathStatus : uint8_t
+{
+    /// The handle is not valid or the result was already taken
+    Invalid,
+    /// The path is waiting in the queue or is being searched
+    Pending,
+    /// The path is found. It leads to the closest reachable point if the destination cannot be reached.
+    Succeeded,
+    /// The path could not be found
+    Failed
+};
+
+struct NavPathRequest;
+
+using NavPathHandle = Handle32<NavPathRequest>;
+
+/// Called from the navmesh update when the path request is finished. The path points are valid only during the call.
+/// The navmesh must not be recreated or purged from the callback.
+using NavPathCallback = Delegate<void(NavPathHandle, NavPathStatus, ArrayView<NavMeshPathPoint>)>;
+
+struct NavPathRequest
+{
+    Float3                  StartPos;
+    Float3                  EndPos;
+
+    /// The search distance along each axis to find the start and end polygons
+    Float3                  Extents{1.0f, 1.0f, 1.0f};
+
+    NavQueryFilter          Filter;
+
+    /// Requests with higher priority are searched first
+    int                     Priority = 0;
+
+    /// Called when the path is found. If not bound, take the result with NavMeshInterface::GetPathResult.
+    NavPathCallback         Callback;
+};
+
 class NavMeshInterface : public WorldInterfaceBase
 {
 public:
     static constexpr int    MaxVertsPerPoly = 6;
     static constexpr int    MaxAllowedLayers = 255;
 
+    /// Tiles are built in square chunks of this size. Geometry is gathered once per chunk.
+    static constexpr int    BuildChunkSize = 16;
+
     //
     // Initial properties
     //
@@ -226,6 +272,11 @@ public:
 
     Vector<BvAxisAlignedBox>NavigationVolumes;
 
+    /// Baked tiles. The build takes a tile from the resource instead of rebuilding it when the hash of the tile
+    /// input geometry is unchanged. Dynamic navmesh refers to the resource data, so the resource must stay loaded
+    /// while the navmesh exists.
+    NavMeshHandle           BakedTiles;
+
     //
     // Public
     //
@@ -262,6 +313,25 @@ public:
     /// Build tiles in specified bounding box
     bool                    Build(BvAxisAlignedBox const& inBoundingBox);
 
+    /// Build tiles in specified range on worker threads. Finished tiles are added to the navmesh during the
+    /// update within the com_NavMeshBuildBudget time limit.
+    void                    BuildAsync(Int2 const& inMins, Int2 const& inMaxs);
+
+    /// Build tiles in specified bounding box on worker threads
+    void                    BuildAsync(BvAxisAlignedBox const& inBoundingBox);
+
+    /// Is there any asynchronous build in progress
+    bool                    IsBuildInProgress() const { return !m_BuildTasks.IsEmpty() || !m_PendingBuildChunks.IsEmpty(); }
+
+    /// Wait for the asynchronous builds and add all tiles to the navmesh. Returns true if any tile was built.
+    bool                    CompleteBuild();
+
+    /// Discard the asynchronous builds that are not finished yet
+    void                    CancelBuild();
+
+    /// Writes the built tiles as NavMeshResource. Tiles are stored with the hash of their input geometry.
+    bool                    SaveBakedTiles(IBinaryStreamWriteInterface& stream) const;
+
     /// Sets the traversal cost of the area.
     void                    SetAreaCost(NAV_MESH_AREA inAreaType, float inCost);
 
@@ -363,6 +433,21 @@ public:
     /// Finds a path from the start position to the end position.
     bool                    FindPath(Float3 const& inStartPos, Float3 const& inEndPos, Float3 const& inExtents, Vector<Float3>& outPathPoints) const;
 
+    /// Queues an asynchronous path request. Paths are searched on worker threads during the navmesh update,
+    /// a limited number of A* iterations per frame (com_NavPathIterations). Requests with the same filter and
+    /// close start and end positions share the same search. Pending requests are discarded if the navmesh is recreated.
+    NavPathHandle           RequestPath(NavPathRequest const& inRequest);
+
+    /// Returns the status of the path request
+    NavPathStatus           GetPathStatus(NavPathHandle inHandle) const;
+
+    /// Takes the result of the finished path request and releases the handle.
+    /// Returns NavPathStatus::Pending and keeps the handle if the path is not ready yet.
+    NavPathStatus           GetPathResult(NavPathHandle inHandle, Vector<NavMeshPathPoint>& outPathPoints);
+
+    /// Cancels the path request and releases the handle. The callback will not be called.
+    void                    CancelPathRequest(NavPathHandle inHandle);
+
     /// Finds the straight path from the start to the end position within the polygon corridor.
     bool                    FindStraightPath(Float3 const& inStartPos, Float3 const& inEndPos, NavPolyRef const* inPath, int inPathSize, Float3* outStraightPath, NavMeshPathFlags* outStraightPathFlags, NavPolyRef* outStraightPathRefs, int& outStraightPathCount, int inMaxStraightPath, NavMeshCrossings inStraightPathCrossing = NavMeshCrossings::Default) const;
 
@@ -404,18 +489,48 @@ protected:
     virtual void            Deinitialize() override;
 
 private:
+    friend class CrowdInterface;
     friend class NavMeshObstacleComponent;
     void                    AddObstacle(class NavMeshObstacleComponent* inObstacle);
     void                    RemoveObstacle(class NavMeshObstacleComponent* inObstacle);
     void                    UpdateObstacle(class NavMeshObstacleComponent* inObstacle);
 
 private:
+    friend struct NavMeshBuildTask;
+
+    struct BuildChunk
+    {
+        Int2                Mins;
+        Int2                Maxs;
+    };
+
+    /// Max chunks that are built at the same time
+    static constexpr int    MaxBuildTasks = 2;
+
     void                    GatherNavigationGeometry(class NavigationGeometry& navGeometry);
-    bool                    BuildTile(int inX, int inZ);
+    void                    InitTileConfig(rcConfig& config) const;
+    uint64_t                CalcSettingsHash() const;
+    /// Gathers geometry for pending chunks and submits their jobs. With a non-zero time limit (Core::SysMicroseconds)
+    /// no more chunks are started once it is reached, but at least one chunk is kept in flight.
+    void                    StartBuildTasks(int64_t timeLimit = 0);
+    bool                    GetTileRange(BvAxisAlignedBox const& inBoundingBox, Int2& outMins, Int2& outMaxs) const;
+    bool                    BuildTile(struct NavMeshBuildTask const& inTask, struct NavMeshTileBuild& ioTile) const;
+    bool                    CommitTile(struct NavMeshTileBuild& ioTile);
     void                    Update();
+    void                    UpdatePathRequests();
+    void                    RunPathQuery(uint32_t inQueryIndex, int inMaxIterations);
+    /// Runs the sliced search of the query and returns the number of iterations used.
+    int                     UpdatePathSearch(struct NavPathQuery& inQuery, int inMaxIterations);
+    void                    FinishPathSearch(uint32_t inSearchIndex);
+    void                    ReleasePathSearch(uint32_t inSearchIndex);
+    bool                    IsPathRequestValid(NavPathHandle inHandle) const;
+    void                    ReleasePathRequest(NavPathHandle inHandle);
+    void                    DiscardPathRequests();
     void                    DrawDebug(DebugRenderer& renderer);
 
     bool                    m_BuildOnNextFrame = false;
+    /// Incremented each time the navmesh is recreated or purged
+    uint32_t                m_Generation = 0;
     uint64_t                m_FrameNum = 0;
     int                     m_NumTilesX{};
     int                     m_NumTilesZ{};
@@ -448,6 +563,55 @@ private:
     UniqueRef<struct DetourLinearAllocator> m_LinearAllocator;
     UniqueRef<struct DetourMeshProcess>     m_MeshProcess;
 
+    // Input geometry hashes of the committed tiles, used to bake the tiles
+    HashMap<uint32_t, uint64_t> m_TileHashes;
+
+    // Asynchronous builds. Tasks are committed in the order of creation so newer builds of the same tiles win.
+    Vector<BuildChunk>      m_PendingBuildChunks;
+    Vector<UniqueRef<struct NavMeshBuildTask>> m_BuildTasks;
+
+    // Path search shared by the requests with the same parameters
+    struct PathSearch
+    {
+        Float3              StartPos;
+        Float3              EndPos;
+        Float3              Extents;
+        NavQueryFilter      Filter;
+        int                 Priority;
+        /// Start and end positions snapped to the cell grid, used to find the same searches
+        int32_t             Cells[6];
+        uint32_t            Hash;
+        uint64_t            Order;
+        NavPathStatus       Status = NavPathStatus::Invalid;
+        int                 Query = -1;
+        int                 RefCount = 0;
+        Vector<uint32_t>    Requests;
+        Vector<NavMeshPathPoint> Path;
+    };
+
+    struct PathRequestRecord
+    {
+        uint32_t            Search;
+        uint32_t            Version = 0;
+        bool                IsUsed = false;
+        NavPathCallback     Callback;
+    };
+
+    Vector<PathRequestRecord> m_PathRequests;
+    Vector<uint32_t>        m_FreePathRequests;
+    Vector<PathSearch>      m_PathSearches;
+    Vector<uint32_t>        m_FreePathSearches;
+    // Sorted by priority, the next search to start is the last one
+    Vector<uint32_t>        m_PendingPathSearches;
+    bool                    m_SortPendingPathSearches = false;
+    uint64_t                m_PathSearchOrder = 0;
+    HashMap<uint32_t, uint32_t> m_PathSearchLookup;
+    // Each query runs one sliced search at a time, one query per worker thread
+    Vector<UniqueRef<struct NavPathQuery>> m_PathQueries;
+    Vector<uint32_t>        m_ActivePathQueries;
+    // Number of pending searches taken by the queries on this frame
+    AtomicInt               m_NumTakenPathSearches;
+
     // Temp array to reduce memory allocations in MoveAlongSurface
     mutable Vector<NavPolyRef> m_LastVisitedPolys;
 
@@ -38,11 +38,12 @@ SOFTWARE.
 #include "Components/WaterVolumeComponent.h"
 
 #include <Engine/World/DebugRenderer.h>
+#include <Engine/GameApplication/GameApplication.h>
 
 #include <Engine/Core/Logger.h>
 #include <Engine/Core/ConsoleVar.h>
 
-#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/JobSystem.h>
 #include <Jolt/Geometry/OrientedBox.h>
 #include <Jolt/Physics/Collision/Shape/RotatedTranslatedShape.h>
 #include <Jolt/Physics/Collision/Shape/SphereShape.h>
@@ -70,6 +71,8 @@ ConsoleVar com_DrawTriggers("com_DrawTriggers"s, "0"s, CVAR_CHEAT);
 ConsoleVar com_DrawCenterOfMass("com_DrawCenterOfMass"s, "0"s, CVAR_CHEAT);
 ConsoleVar com_DrawWaterVolume("com_DrawWaterVolume"s, "0"s, CVAR_CHEAT);
 ConsoleVar com_DrawCharacterController("com_DrawCharacterController"s, "0"s);
+ConsoleVar com_ParallelCharacters("com_ParallelCharacters"s, "1"s, 0, "Update character controllers on worker threads"s);
+ConsoleVar com_ParallelSceneQueries("com_ParallelSceneQueries"s, "1"s, 0, "Run batched ray and shape queries on worker threads"s);
 
 class BroadphaseLayerFilter final : public JPH::BroadPhaseLayerFilter
 {
@@ -973,6 +976,49 @@ namespace
 
 }
 
+bool PhysicsInterfaceImpl::CastRayClosest(JPH::RRayCast const& inRayCast, RayCastResult& outResult, RayCastFilter const& inFilter)
+{
+    JPH::RayCastResult hit;
+    if (inFilter.IgonreBackFaces)
+    {
+        JPH::RayCastSettings settings;
+
+        // How backfacing triangles should be treated
+        //settings.mBackFaceMode = inFilter.IgonreBackFaces ? JPH::EBackFaceMode::IgnoreBackFaces : JPH::EBackFaceMode::CollideWithBackFaces;
+        settings.mBackFaceMode = JPH::EBackFaceMode::IgnoreBackFaces;
+
+        // If convex shapes should be treated as solid. When true, a ray starting inside a convex shape will generate a hit at fraction 0.
+        settings.mTreatConvexAsSolid = true;
+
+        JPH::ClosestHitCollisionCollector<JPH::CastRayCollector> collector;
+        m_PhysSystem.GetNarrowPhaseQuery().CastRay(inRayCast, settings, collector, BroadphaseLayerFilter(inFilter.BroadphaseLayers.Get()), CastObjectLayerFilter(inFilter.ObjectLayers.Get()));
+
+        if (!collector.HadHit())
+            return false;
+
+        hit = collector.mHit;
+    }
+    else
+    {
+        if (!m_PhysSystem.GetNarrowPhaseQuery().CastRay(inRayCast, hit, BroadphaseLayerFilter(inFilter.BroadphaseLayers.Get()), CastObjectLayerFilter(inFilter.ObjectLayers.Get())))
+            return false;
+    }
+
+    outResult.BodyID = PhysBodyID(hit.mBodyID.GetIndexAndSequenceNumber());
+    outResult.Fraction = hit.mFraction;
+
+    if (inFilter.CalcSurfcaceNormal)
+    {
+        JPH::BodyLockRead lock(m_PhysSystem.GetBodyLockInterface(), hit.mBodyID);
+        JPH::Body const& body = lock.GetBody();
+
+        auto normal = body.GetWorldSpaceSurfaceNormal(hit.mSubShapeID2, inRayCast.GetPointOnRay(outResult.Fraction));
+        outResult.Normal = ConvertVector(normal);
+    }
+
+    return true;
+}
+
 bool PhysicsInterfaceImpl::CastShapeClosest(JPH::RShapeCast const& inShapeCast, JPH::RVec3Arg inBaseOffset, ShapeCastResult& outResult, ShapeCastFilter const& inFilter)
 {
     JPH::ShapeCastSettings settings;
@@ -1155,24 +1201,16 @@ void CharacterContactListener::OnContactAdded(const JPH::CharacterVirtual* chara
     {
         if (auto trigger = userData->TryGetComponent<TriggerComponent>(m_World))
         {
-            ContactID contactID = inBodyID2.GetIndexAndSequenceNumber() | (static_cast<uint64_t>(characterImpl->m_Component.ToUInt32()) << 32);
+            // Characters can be updated in parallel, so the contact is applied later by FlushPendingContacts
+            int threadIndex = GameApplication::GetAsyncJobManager().GetCurrentWorkerIndex();
+            if (threadIndex < 0)
+                threadIndex = m_PendingContacts.Size() - 1;
 
-            TriggerContact& contact = m_Triggers[contactID];
+            PendingContact& contact = m_PendingContacts[threadIndex].Add();
+            contact.ID = inBodyID2.GetIndexAndSequenceNumber() | (static_cast<uint64_t>(characterImpl->m_Component.ToUInt32()) << 32);
             contact.Trigger = Handle32<TriggerComponent>(trigger->GetHandle());
-            if (contact.FrameIndex == 0)
-            {
-                auto& event = m_pTriggerEvents->EmplaceBack();
-                event.Type = TriggerEvent::OnBeginOverlap;
-                event.Trigger = contact.Trigger;
-                event.Target.Handle = characterImpl->m_Component;
-                event.Target.TypeID = ComponentRTTR::TypeID<CharacterControllerComponent>;
-                m_UpdateOverlap.Add(contactID);
-            }
-            else
-            {
-                // TODO: Generate OnUpdateOverlap?
-            }
-            contact.FrameIndex = m_World->GetTick().FixedFrameNum;
+            contact.Character = characterImpl->m_Component;
+            contact.UpdateIndex = characterImpl->m_UpdateIndex;
         }
         return;
     }
@@ -1184,6 +1222,48 @@ void CharacterContactListener::OnContactAdded(const JPH::CharacterVirtual* chara
     }
 }
 
+void CharacterContactListener::AllocatePendingContacts(int numThreads)
+{
+    m_PendingContacts.Resize(numThreads);
+}
+
+void CharacterContactListener::FlushPendingContacts()
+{
+    m_SortedContacts.Clear();
+    for (auto& contacts : m_PendingContacts)
+    {
+        m_SortedContacts.Add(contacts);
+        contacts.Clear();
+    }
+
+    // Keep trigger events deterministic regardless of which thread updated the character
+    std::stable_sort(m_SortedContacts.begin(), m_SortedContacts.end(),
+        [](PendingContact const& a, PendingContact const& b)
+        {
+            return a.UpdateIndex < b.UpdateIndex;
+        });
+
+    for (PendingContact const& pendingContact : m_SortedContacts)
+    {
+        TriggerContact& contact = m_Triggers[pendingContact.ID];
+        contact.Trigger = pendingContact.Trigger;
+        if (contact.FrameIndex == 0)
+        {
+            auto& event = m_pTriggerEvents->EmplaceBack();
+            event.Type = TriggerEvent::OnBeginOverlap;
+            event.Trigger = contact.Trigger;
+            event.Target.Handle = pendingContact.Character;
+            event.Target.TypeID = ComponentRTTR::TypeID<CharacterControllerComponent>;
+            m_UpdateOverlap.Add(pendingContact.ID);
+        }
+        else
+        {
+            // TODO: Generate OnUpdateOverlap?
+        }
+        contact.FrameIndex = m_World->GetTick().FixedFrameNum;
+    }
+}
+
 void CharacterContactListener::OnContactSolve(const JPH::CharacterVirtual* character, const JPH::BodyID& inBodyID2, const JPH::SubShapeID& inSubShapeID2, JPH::Vec3Arg inContactPosition, JPH::Vec3Arg inContactNormal, JPH::Vec3Arg inContactVelocity, const JPH::PhysicsMaterial* inContactMaterial, JPH::Vec3Arg inCharacterVelocity, JPH::Vec3& ioNewCharacterVelocity)
 {
     CharacterControllerImpl const* characterImpl = static_cast<CharacterControllerImpl const*>(character);
@@ -1238,6 +1318,7 @@ void PhysicsInterface::Initialize()
     m_pImpl->m_CharacterContactListener.m_World = GetWorld();
     m_pImpl->m_CharacterContactListener.m_PhysSystem = &m_pImpl->m_PhysSystem;
     m_pImpl->m_CharacterContactListener.m_pTriggerEvents = &m_pImpl->m_TriggerEvents;
+    m_pImpl->m_CharacterContactListener.AllocatePendingContacts(GameApplication::GetAsyncJobManager().GetNumWorkerThreads() + 1);
 
     {
         TickFunction tickFunc;
@@ -1306,26 +1387,21 @@ void PhysicsInterface::Update()
 
         auto& characterControllerManager = GetWorld()->GetComponentManager<CharacterControllerComponent>();
 
-        struct Visitor
+        struct CharacterUpdate
         {
             float m_TimeStep;
             JPH::Vec3 m_Gravity;
             CollisionFilter const& m_CollisionFilter;
-            JPH::BodyInterface& m_BodyInterface;
 
-            Visitor(float timeStep, JPH::Vec3 const& gravity, CollisionFilter const& collisionFilter, JPH::BodyInterface& bodyInterface) :
+            CharacterUpdate(float timeStep, JPH::Vec3 const& gravity, CollisionFilter const& collisionFilter) :
                 m_TimeStep(timeStep),
                 m_Gravity(gravity),
-                m_CollisionFilter(collisionFilter),
-                m_BodyInterface(bodyInterface)
+                m_CollisionFilter(collisionFilter)
             {}
 
-            HK_FORCEINLINE void Visit(CharacterControllerComponent& character)
+            // Can be called from any thread. Doesn't touch the owner object, the transform is written back later.
+            void Update(CharacterControllerComponent& character, JPH::TempAllocator& temp_allocator) const
             {
-                GameObject* owner = character.GetOwner();
-
-                auto& temp_allocator = *PhysicsModule::Get().GetTempAllocator();
-
                 auto* phys_character = character.m_pImpl;
 
                 // Smooth the player input
@@ -1430,14 +1506,54 @@ void PhysicsInterface::Update()
                     body_filter,
                     {},
                     temp_allocator);
+            }
+        };
+
+        struct Visitor
+        {
+            Vector<CharacterControllerComponent*>& m_List;
+
+            Visitor(Vector<CharacterControllerComponent*>& list) :
+                m_List(list)
+            {}
 
-                owner->SetWorldPositionAndRotation(ConvertVector(phys_character->GetPosition()), ConvertQuaternion(phys_character->GetRotation()));
+            HK_FORCEINLINE void Visit(CharacterControllerComponent& character)
+            {
+                character.m_pImpl->m_UpdateIndex = m_List.Size();
+                m_List.Add(&character);
             }
         };
 
-        Visitor visitor(timeStep, m_pImpl->m_PhysSystem.GetGravity(), m_pImpl->m_CollisionFilter, bodyInterface);
+        auto& characters = m_pImpl->m_CharacterUpdateList;
+        characters.Clear();
+
+        Visitor visitor(characters);
         characterControllerManager.IterateComponents(visitor);
 
+        CharacterUpdate characterUpdate(timeStep, m_pImpl->m_PhysSystem.GetGravity(), m_pImpl->m_CollisionFilter);
+
+        auto updateCharacters = [&](uint32_t first, uint32_t last)
+        {
+            auto& tempAllocator = *PhysicsModule::Get().GetThreadTempAllocator();
+
+            for (uint32_t i = first; i < last; ++i)
+                characterUpdate.Update(*characters[i], tempAllocator);
+        };
+
+        if (com_ParallelCharacters)
+            GameApplication::GetAsyncJobManager().ParallelFor(characters.Size(), CHARACTERS_PER_JOB, updateCharacters);
+        else
+            updateCharacters(0, characters.Size());
+
+        // Write back transforms and contacts on this thread after all characters are moved
+        for (CharacterControllerComponent* character : characters)
+        {
+            auto* phys_character = character->m_pImpl;
+            character->GetOwner()->SetWorldPositionAndRotation(ConvertVector(phys_character->GetPosition()), ConvertQuaternion(phys_character->GetRotation()));
+        }
+
+        m_pImpl->m_CharacterContactListener.FlushPendingContacts();
+
         for (auto contactIt = m_pImpl->m_CharacterContactListener.m_UpdateOverlap.begin(); contactIt != m_pImpl->m_CharacterContactListener.m_UpdateOverlap.end();)
         {
             auto contactID = *contactIt;
@@ -1655,10 +1771,10 @@ void PhysicsInterface::Update()
 
     // Simulation step
     {
-        const int numCollisionSteps = 1;
+        const int numCollisionSteps = GetWorld()->GetSettings().CollisionSteps;
         auto& physicsModule = PhysicsModule::Get();
 
-        m_pImpl->m_PhysSystem.Update(tick.FixedTimeStep, numCollisionSteps, physicsModule.GetTempAllocator(), physicsModule.GetJobSystemThreadPool());
+        m_pImpl->m_PhysSystem.Update(tick.FixedTimeStep, numCollisionSteps, physicsModule.GetTempAllocator(), physicsModule.GetJobSystem());
     }
 
     // Capture active bodies transform
@@ -2042,45 +2158,7 @@ bool PhysicsInterface::CastRayClosest(Float3 const& inRayStart, Float3 const& in
     raycast.mOrigin = ConvertVector(inRayStart);
     raycast.mDirection = ConvertVector(inRayDir);
 
-    JPH::RayCastResult hit;
-    if (inFilter.IgonreBackFaces)
-    {
-        JPH::RayCastSettings settings;
-
-        // How backfacing triangles should be treated
-        //settings.mBackFaceMode = inFilter.IgonreBackFaces ? JPH::EBackFaceMode::IgnoreBackFaces : JPH::EBackFaceMode::CollideWithBackFaces;
-        settings.mBackFaceMode = JPH::EBackFaceMode::IgnoreBackFaces;
-
-        // If convex shapes should be treated as solid. When true, a ray starting inside a convex shape will generate a hit at fraction 0.
-        settings.mTreatConvexAsSolid = true;
-
-        JPH::ClosestHitCollisionCollector<JPH::CastRayCollector> collector;
-        m_pImpl->m_PhysSystem.GetNarrowPhaseQuery().CastRay(raycast, settings, collector, BroadphaseLayerFilter(inFilter.BroadphaseLayers.Get()), CastObjectLayerFilter(inFilter.ObjectLayers.Get()));
-
-        if (!collector.HadHit())
-            return false;
-
-        hit = collector.mHit;
-    }
-    else
-    {
-        if (!m_pImpl->m_PhysSystem.GetNarrowPhaseQuery().CastRay(raycast, hit, BroadphaseLayerFilter(inFilter.BroadphaseLayers.Get()), CastObjectLayerFilter(inFilter.ObjectLayers.Get())))
-            return false;
-    }
-
-    outResult.BodyID = PhysBodyID(hit.mBodyID.GetIndexAndSequenceNumber());
-    outResult.Fraction = hit.mFraction;
-
-    if (inFilter.CalcSurfcaceNormal)
-    {
-        JPH::BodyLockRead lock(m_pImpl->m_PhysSystem.GetBodyLockInterface(), hit.mBodyID);
-        JPH::Body const& body = lock.GetBody();
-
-        auto normal = body.GetWorldSpaceSurfaceNormal(hit.mSubShapeID2, raycast.GetPointOnRay(outResult.Fraction));
-        outResult.Normal = ConvertVector(normal);
-    }
-
-    return true;
+    return m_pImpl->CastRayClosest(raycast, outResult, inFilter);
 }
 
 bool PhysicsInterface::CastRay(Float3 const& inRayStart, Float3 const& inRayDir, Vector<RayCastResult>& outResult, RayCastFilter const& inFilter)
@@ -2699,6 +2777,263 @@ void PhysicsInterface::CollidePoint(Float3 const& inPosition, Vector<PhysBodyID>
     }
 }
 
+namespace
+{
+
+/// Collects up to a fixed number of ray hits into an external buffer. When the buffer is full the farthest hit is
+/// replaced by closer ones if inKeepClosest is set, otherwise the query stops.
+class FixedRayCastCollector : public JPH::CastRayCollector
+{
+public:
+    FixedRayCastCollector(JPH::RayCastResult* inHits, uint32_t inMaxHits, bool inKeepClosest) :
+        m_Hits(inHits), m_MaxHits(inMaxHits), m_KeepClosest(inKeepClosest)
+    {}
+
+    void AddHit(JPH::RayCastResult const& inResult) override
+    {
+        if (m_NumHits < m_MaxHits)
+        {
+            m_Hits[m_NumHits++] = inResult;
+            if (m_NumHits == m_MaxHits)
+            {
+                if (m_KeepClosest)
+                    UpdateEarlyOutFraction(m_Hits[FindFarthest()].mFraction);
+                else
+                    ForceEarlyOut();
+            }
+            return;
+        }
+
+        uint32_t farthest = FindFarthest();
+        if (inResult.mFraction < m_Hits[farthest].mFraction)
+        {
+            m_Hits[farthest] = inResult;
+            UpdateEarlyOutFraction(m_Hits[FindFarthest()].mFraction);
+        }
+    }
+
+    uint32_t GetNumHits() const { return m_NumHits; }
+
+private:
+    uint32_t FindFarthest() const
+    {
+        uint32_t farthest = 0;
+        for (uint32_t i = 1; i < m_NumHits; ++i)
+            if (m_Hits[i].mFraction > m_Hits[farthest].mFraction)
+                farthest = i;
+        return farthest;
+    }
+
+    JPH::RayCastResult* m_Hits;
+    uint32_t m_MaxHits;
+    uint32_t m_NumHits{};
+    bool m_KeepClosest;
+};
+
+/// Collects up to a fixed number of broadphase bodies into an external buffer
+class FixedBodyCollector : public JPH::CollideShapeBodyCollector
+{
+public:
+    FixedBodyCollector(PhysBodyID* inBodies, uint32_t inMaxBodies) :
+        m_Bodies(inBodies), m_MaxBodies(inMaxBodies)
+    {}
+
+    void AddHit(const JPH::BodyID& inBodyID) override
+    {
+        m_Bodies[m_NumBodies++] = PhysBodyID(inBodyID.GetIndexAndSequenceNumber());
+        if (m_NumBodies == m_MaxBodies)
+            ForceEarlyOut();
+    }
+
+    uint32_t GetNumBodies() const { return m_NumBodies; }
+
+private:
+    PhysBodyID* m_Bodies;
+    uint32_t m_MaxBodies;
+    uint32_t m_NumBodies{};
+};
+
+/// Creates a temporary shape for the query on the stack and passes it to the visitor
+template <typename Visitor>
+void VisitQueryShape(ShapeQuery const& inQuery, Visitor const& inVisitor)
+{
+    switch (inQuery.Type)
+    {
+        case ShapeQueryType::Box: {
+            JPH::BoxShape shape(ConvertVector(inQuery.HalfExtent));
+            inVisitor(shape);
+            break;
+        }
+        case ShapeQueryType::Sphere: {
+            JPH::SphereShape shape(inQuery.Radius);
+            inVisitor(shape);
+            break;
+        }
+        case ShapeQueryType::Capsule: {
+            JPH::CapsuleShape shape(inQuery.HalfHeight, inQuery.Radius);
+            inVisitor(shape);
+            break;
+        }
+        case ShapeQueryType::Cylinder: {
+            JPH::CylinderShape shape(inQuery.HalfHeight, inQuery.Radius);
+            inVisitor(shape);
+            break;
+        }
+    }
+}
+
+template <typename Function>
+void ProcessQueries(uint32_t inCount, uint32_t inQueriesPerJob, Function const& inFunction)
+{
+    if (com_ParallelSceneQueries)
+        GameApplication::GetAsyncJobManager().ParallelFor(inCount, inQueriesPerJob, inFunction);
+    else
+        inFunction(0, inCount);
+}
+
+} // namespace
+
+void PhysicsInterface::CastRayClosestBatch(ArrayView<RayCastQuery> inQueries, RayCastResult* outResults, RayCastFilter const& inFilter)
+{
+    ProcessQueries(inQueries.Size(), QUERIES_PER_JOB, [&](uint32_t first, uint32_t last)
+    {
+        JPH::RRayCast raycast;
+        for (uint32_t i = first; i < last; ++i)
+        {
+            raycast.mOrigin = ConvertVector(inQueries[i].Start);
+            raycast.mDirection = ConvertVector(inQueries[i].Dir);
+
+            if (!m_pImpl->CastRayClosest(raycast, outResults[i], inFilter))
+                outResults[i].BodyID = PhysBodyID();
+        }
+    });
+}
+
+void PhysicsInterface::CastRayBatch(ArrayView<RayCastQuery> inQueries, RayCastResult* outResults, uint32_t inMaxHitsPerQuery, uint32_t* outNumHits, RayCastFilter const& inFilter)
+{
+    HK_ASSERT(inMaxHitsPerQuery > 0);
+    if (inMaxHitsPerQuery == 0)
+        return;
+
+    JPH::RayCastSettings settings;
+
+    // How backfacing triangles should be treated
+    settings.mBackFaceMode = inFilter.IgonreBackFaces ? JPH::EBackFaceMode::IgnoreBackFaces : JPH::EBackFaceMode::CollideWithBackFaces;
+
+    // If convex shapes should be treated as solid. When true, a ray starting inside a convex shape will generate a hit at fraction 0.
+    settings.mTreatConvexAsSolid = true;
+
+    ProcessQueries(inQueries.Size(), QUERIES_PER_JOB, [&](uint32_t first, uint32_t last)
+    {
+        // Jolt hits are kept in the thread scratch memory because the surface normal needs the sub shape ID
+        JPH::TempAllocator* tempAllocator = PhysicsModule::Get().GetThreadTempAllocator();
+        uint32_t scratchSize = inMaxHitsPerQuery * sizeof(JPH::RayCastResult);
+        JPH::RayCastResult* hits = static_cast<JPH::RayCastResult*>(tempAllocator->Allocate(scratchSize));
+
+        JPH::RRayCast raycast;
+        for (uint32_t i = first; i < last; ++i)
+        {
+            raycast.mOrigin = ConvertVector(inQueries[i].Start);
+            raycast.mDirection = ConvertVector(inQueries[i].Dir);
+
+            FixedRayCastCollector collector(hits, inMaxHitsPerQuery, inFilter.SortByDistance);
+            m_pImpl->m_PhysSystem.GetNarrowPhaseQuery().CastRay(raycast, settings, collector, BroadphaseLayerFilter(inFilter.BroadphaseLayers.Get()), CastObjectLayerFilter(inFilter.ObjectLayers.Get()));
+
+            uint32_t numHits = collector.GetNumHits();
+
+            // Order hits on closest first
+            if (inFilter.SortByDistance)
+                std::sort(hits, hits + numHits, [](JPH::RayCastResult const& a, JPH::RayCastResult const& b) { return a.mFraction < b.mFraction; });
+
+            RayCastResult* results = outResults + i * inMaxHitsPerQuery;
+            for (uint32_t n = 0; n < numHits; ++n)
+            {
+                JPH::RayCastResult const& hit = hits[n];
+
+                results[n].BodyID = PhysBodyID(hit.mBodyID.GetIndexAndSequenceNumber());
+                results[n].Fraction = hit.mFraction;
+
+                if (inFilter.CalcSurfcaceNormal)
+                {
+                    JPH::BodyLockRead lock(m_pImpl->m_PhysSystem.GetBodyLockInterface(), hit.mBodyID);
+                    JPH::Body const& body = lock.GetBody();
+
+                    auto normal = body.GetWorldSpaceSurfaceNormal(hit.mSubShapeID2, raycast.GetPointOnRay(hit.mFraction));
+                    results[n].Normal = ConvertVector(normal);
+                }
+            }
+            outNumHits[i] = numHits;
+        }
+
+        tempAllocator->Free(hits, scratchSize);
+    });
+}
+
+void PhysicsInterface::CastShapeClosestBatch(ArrayView<ShapeCastQuery> inQueries, ShapeCastResult* outResults, ShapeCastFilter const& inFilter)
+{
+    ProcessQueries(inQueries.Size(), QUERIES_PER_JOB, [&](uint32_t first, uint32_t last)
+    {
+        for (uint32_t i = first; i < last; ++i)
+        {
+            ShapeCastQuery const& query = inQueries[i];
+
+            VisitQueryShape(query, [&](JPH::Shape const& shape)
+            {
+                JPH::Vec3 pos = ConvertVector(query.Position);
+                JPH::Vec3 direction = ConvertVector(query.Dir);
+                JPH::Quat rotation = ConvertQuaternion(query.Rotation);
+
+                JPH::RShapeCast shape_cast = JPH::RShapeCast::sFromWorldTransform(&shape, JPH::Vec3::sReplicate(1.0f), JPH::RMat44::sRotationTranslation(rotation, pos), direction);
+
+                if (!m_pImpl->CastShapeClosest(shape_cast, CalcBaseOffset(pos, direction), outResults[i], inFilter))
+                    outResults[i].BodyID = PhysBodyID();
+            });
+        }
+    });
+}
+
+void PhysicsInterface::OverlapBatch(ArrayView<ShapeQuery> inQueries, PhysBodyID* outBodies, uint32_t inMaxBodiesPerQuery, uint32_t* outNumBodies, ShapeOverlapFilter const& inFilter)
+{
+    HK_ASSERT(inMaxBodiesPerQuery > 0);
+    if (inMaxBodiesPerQuery == 0)
+        return;
+
+    ProcessQueries(inQueries.Size(), QUERIES_PER_JOB, [&](uint32_t first, uint32_t last)
+    {
+        JPH::BroadPhaseQuery const& broadphase = m_pImpl->m_PhysSystem.GetBroadPhaseQuery();
+
+        for (uint32_t i = first; i < last; ++i)
+        {
+            ShapeQuery const& query = inQueries[i];
+
+            FixedBodyCollector collector(outBodies + i * inMaxBodiesPerQuery, inMaxBodiesPerQuery);
+
+            if (query.Type == ShapeQueryType::Sphere)
+            {
+                broadphase.CollideSphere(ConvertVector(query.Position), query.Radius, collector, BroadphaseLayerFilter(inFilter.BroadphaseLayers.Get()));
+            }
+            else if (query.Type == ShapeQueryType::Box && query.Rotation == Quat::Identity())
+            {
+                broadphase.CollideAABox(JPH::AABox(ConvertVector(query.Position - query.HalfExtent), ConvertVector(query.Position + query.HalfExtent)),
+                    collector,
+                    BroadphaseLayerFilter(inFilter.BroadphaseLayers.Get()));
+            }
+            else
+            {
+                // Test the oriented local bounds of the shape
+                VisitQueryShape(query, [&](JPH::Shape const& shape)
+                {
+                    JPH::OrientedBox oriented_box(JPH::Mat44::sRotationTranslation(ConvertQuaternion(query.Rotation), ConvertVector(query.Position)), shape.GetLocalBounds());
+
+                    broadphase.CollideOrientedBox(oriented_box, collector, BroadphaseLayerFilter(inFilter.BroadphaseLayers.Get()));
+                });
+            }
+
+            outNumBodies[i] = collector.GetNumBodies();
+        }
+    });
+}
+
 void PhysicsInterface::SetGravity(Float3 const inGravity)
 {
     return m_pImpl->m_PhysSystem.SetGravity(ConvertVector(inGravity));
@@ -33,6 +33,7 @@ SOFTWARE.
 #include <Engine/World/WorldInterface.h>
 #include <Engine/World/Component.h>
 #include <Engine/Core/Ref.h>
+#include <Engine/Core/Containers/ArrayView.h>
 #include <Engine/Math/Quat.h>
 
 HK_NAMESPACE_BEGIN
@@ -167,6 +168,43 @@ struct ShapeOverlapFilter
     BroadphaseLayerMask    BroadphaseLayers;
 };
 
+/// Ray for batched ray casts
+struct RayCastQuery
+{
+    Float3                  Start;
+    /// Ray direction, the length of the vector is the length of the ray
+    Float3                  Dir;
+};
+
+enum class ShapeQueryType : uint8_t
+{
+    Box,
+    Sphere,
+    Capsule,
+    Cylinder
+};
+
+/// Shape for batched overlap queries
+struct ShapeQuery
+{
+    ShapeQueryType          Type = ShapeQueryType::Sphere;
+    Float3                  Position;
+    Quat                    Rotation;
+    /// Box half extents
+    Float3                  HalfExtent;
+    /// Sphere, capsule and cylinder radius
+    float                   Radius = 0;
+    /// Capsule and cylinder half height
+    float                   HalfHeight = 0;
+};
+
+/// Shape for batched shape casts. Position is the start of the cast.
+struct ShapeCastQuery : ShapeQuery
+{
+    /// Cast direction, the length of the vector is the length of the cast
+    Float3                  Dir;
+};
+
 enum class ScalingMode : uint8_t
 {
     NonUniform,
@@ -218,6 +256,20 @@ public:
     void                    CollideCylinder(Float3 const& inPosition, float inHalfHeight, float inRadius, Quat const& inRotation, Vector<ShapeCollideResult>& outResult, ShapeCastFilter const& inFilter = {});
     void                    CollidePoint(Float3 const& inPosition, Vector<PhysBodyID>& outResult, BroadphaseLayerMask inBroadphaseLayers = {}, ObjectLayerMask inObjectLayers = {});
 
+    // Batched queries. Queries are distributed across the job manager worker threads and the results are written to
+    // caller-provided buffers, so nothing is allocated per query. Must not be called while the physics system is updating.
+
+    /// outResults must hold inQueries.Size() elements. BodyID of the result is invalid if the ray missed.
+    void                    CastRayClosestBatch(ArrayView<RayCastQuery> inQueries, RayCastResult* outResults, RayCastFilter const& inFilter = {});
+    /// outResults must hold inQueries.Size() * inMaxHitsPerQuery elements, hits of query i start at outResults[i * inMaxHitsPerQuery].
+    /// outNumHits[i] receives the number of hits written for query i. If SortByDistance is set, the closest hits are kept.
+    void                    CastRayBatch(ArrayView<RayCastQuery> inQueries, RayCastResult* outResults, uint32_t inMaxHitsPerQuery, uint32_t* outNumHits, RayCastFilter const& inFilter = {});
+    /// outResults must hold inQueries.Size() elements. BodyID of the result is invalid if the shape hit nothing.
+    void                    CastShapeClosestBatch(ArrayView<ShapeCastQuery> inQueries, ShapeCastResult* outResults, ShapeCastFilter const& inFilter = {});
+    /// Broadphase overlap. outBodies must hold inQueries.Size() * inMaxBodiesPerQuery elements, bodies of query i start at
+    /// outBodies[i * inMaxBodiesPerQuery]. outNumBodies[i] receives the number of bodies written for query i.
+    void                    OverlapBatch(ArrayView<ShapeQuery> inQueries, PhysBodyID* outBodies, uint32_t inMaxBodiesPerQuery, uint32_t* outNumBodies, ShapeOverlapFilter const& inFilter = {});
+
     void                    SetGravity(Float3 const inGravity);
     Float3                  GetGravity() const;
 
@@ -237,6 +289,12 @@ protected:
     virtual void            Purge() override;
 
 private:
+    /// Minimum number of character controllers updated by one job
+    static constexpr uint32_t CHARACTERS_PER_JOB = 8;
+
+    /// Minimum number of batched scene queries processed by one job
+    static constexpr uint32_t QUERIES_PER_JOB = 32;
+
     void                    Update();
     void                    PostTransform();
     void                    DrawDebug(DebugRenderer& renderer);
@@ -270,12 +270,30 @@ public:
     using ContactID = uint64_t;
     using TriggerContacts = HashMap<ContactID, TriggerContact>;
 
+    // Trigger contact found while characters are updated in parallel
+    struct PendingContact
+    {
+        ContactID                   ID;
+        Handle32<TriggerComponent>  Trigger;
+        ComponentHandle             Character;
+        uint32_t                    UpdateIndex;
+    };
+
     World*                  m_World;
     JPH::PhysicsSystem*     m_PhysSystem;
     TriggerContacts         m_Triggers;
     Vector<TriggerEvent>*   m_pTriggerEvents;
     Vector<ContactID>       m_UpdateOverlap;
 
+    // One buffer for each engine worker thread and one for the thread that runs the world update
+    Vector<Vector<PendingContact>> m_PendingContacts;
+    Vector<PendingContact>  m_SortedContacts;
+
+    void                    AllocatePendingContacts(int numThreads);
+
+    // Applies the pending contacts in the order in which the characters were updated and generates trigger events.
+    void                    FlushPendingContacts();
+
     // Called whenever the character collides with a body. Returns true if the contact can push the character.
     void                    OnContactAdded(const JPH::CharacterVirtual*, const JPH::BodyID& inBodyID2, const JPH::SubShapeID& inSubShapeID2, JPH::Vec3Arg inContactPosition, JPH::Vec3Arg inContactNormal, JPH::CharacterContactSettings& ioSettings) override;
 
@@ -345,6 +363,7 @@ public:
 
     static void                         GatherShapeGeometry(JPH::Shape const* shape, Vector<Float3>& vertices, Vector<uint32_t>& indices);
 
+    bool                                CastRayClosest(JPH::RRayCast const& inRayCast, RayCastResult& outResult, RayCastFilter const& inFilter);
     bool                                CastShapeClosest(JPH::RShapeCast const& inShapeCast, JPH::RVec3Arg inBaseOffset, ShapeCastResult& outResult, ShapeCastFilter const& inFilter);
     bool                                CastShape(JPH::RShapeCast const& inShapeCast, JPH::RVec3Arg inBaseOffset, Vector<ShapeCastResult>& outResult, ShapeCastFilter const& inFilter);
 
@@ -362,6 +381,8 @@ public:
 
     Vector<DynamicBodyMessage>          m_DynamicBodyMessageQueue;
 
+    Vector<class CharacterControllerComponent*> m_CharacterUpdateList;
+
     CollisionFilter                     m_CollisionFilter;
 
     // Create mapping table from object layer to broadphase layer
@@ -400,6 +421,8 @@ public:
     JPH_OVERRIDE_NEW_DELETE
 
     ComponentHandle             m_Component;
+    // Index of the character in the current update, used to order deferred contacts
+    uint32_t                    m_UpdateIndex = 0;
     //JPH::RefConst<JPH::Shape>   m_StandingShape;
     //JPH::RefConst<JPH::Shape>   m_CrouchingShape;
     bool                        m_AllowSliding = false;
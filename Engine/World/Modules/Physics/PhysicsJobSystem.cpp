@@ -0,0 +1,130 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "PhysicsJobSystem.h"
+
+#include <Engine/Core/Thread.h>
+
+HK_NAMESPACE_BEGIN
+
+PhysicsJobSystem::PhysicsJobSystem(AsyncJobManager& jobManager, uint32_t maxJobs, uint32_t maxBarriers) :
+    JPH::JobSystemWithBarrier(maxBarriers),
+    m_JobManager(jobManager)
+{
+    m_Jobs.Init(maxJobs, maxJobs);
+
+    // Every queued job holds a reference, so there can't be more queued jobs than jobs
+    m_QueuedJobs.Init(maxJobs, maxJobs);
+}
+
+PhysicsJobSystem::~PhysicsJobSystem()
+{
+    // Engine jobs may still hold references to already executed physics jobs
+    m_JobManager.WaitForCounter(m_Counter);
+}
+
+int PhysicsJobSystem::GetMaxConcurrency() const
+{
+    // The thread that waits on a barrier executes jobs too
+    return m_JobManager.GetNumWorkerThreads() + 1;
+}
+
+PhysicsJobSystem::JobHandle PhysicsJobSystem::CreateJob(const char* inName, JPH::ColorArg inColor, const JobFunction& inJobFunction, JPH::uint32 inNumDependencies)
+{
+    uint32_t index;
+    for (;;)
+    {
+        index = m_Jobs.ConstructObject(inName, inColor, this, inJobFunction, inNumDependencies);
+        if (index != decltype(m_Jobs)::cInvalidObjectIndex)
+            break;
+
+        HK_ASSERT(0);
+        LOG("PhysicsJobSystem::CreateJob: No jobs available\n");
+
+        // Let the workers finish some jobs
+        if (!m_JobManager.ExecutePendingJob())
+            YieldCPU();
+    }
+    Job* job = &m_Jobs.Get(index);
+
+    // Construct handle to keep a reference, the job is queued below and may immediately complete
+    JobHandle handle(job);
+
+    if (inNumDependencies == 0)
+        QueueJob(job);
+
+    return handle;
+}
+
+void PhysicsJobSystem::QueueJob(Job* inJob)
+{
+    QueueJobs(&inJob, 1);
+}
+
+void PhysicsJobSystem::QueueJobs(Job** inJobs, JPH::uint inNumJobs)
+{
+    for (JPH::uint i = 0; i < inNumJobs; i++)
+    {
+        Job* job = inJobs[i];
+
+        // Released by ExecuteQueuedJob
+        job->AddRef();
+
+        uint32_t index = m_QueuedJobs.ConstructObject();
+        HK_ASSERT(index != decltype(m_QueuedJobs)::cInvalidObjectIndex);
+
+        QueuedJob& queuedJob = m_QueuedJobs.Get(index);
+        queuedJob.EngineJob.Callback = ExecuteQueuedJob;
+        queuedJob.EngineJob.Data = &queuedJob;
+        queuedJob.PhysicsJob = job;
+        queuedJob.Owner = this;
+
+        m_JobManager.SubmitJob(queuedJob.EngineJob, m_Counter);
+    }
+}
+
+void PhysicsJobSystem::ExecuteQueuedJob(void* data)
+{
+    QueuedJob* queuedJob = static_cast<QueuedJob*>(data);
+    PhysicsJobSystem* owner = queuedJob->Owner;
+
+    // Does nothing if the job was already executed by a thread waiting on a barrier
+    queuedJob->PhysicsJob->Execute();
+    queuedJob->PhysicsJob->Release();
+
+    owner->m_QueuedJobs.DestructObject(queuedJob);
+}
+
+void PhysicsJobSystem::FreeJob(Job* inJob)
+{
+    m_Jobs.DestructObject(inJob);
+}
+
+HK_NAMESPACE_END
@@ -0,0 +1,75 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <Engine/Core/AsyncJobManager.h>
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
+
+HK_NAMESPACE_BEGIN
+
+/// Jolt job system that runs physics jobs on the worker threads of the engine job manager,
+/// so physics and gameplay jobs share one pool of threads.
+class PhysicsJobSystem final : public JPH::JobSystemWithBarrier
+{
+public:
+                            PhysicsJobSystem(AsyncJobManager& jobManager, uint32_t maxJobs, uint32_t maxBarriers);
+                            ~PhysicsJobSystem() override;
+
+    int                     GetMaxConcurrency() const override;
+    JobHandle               CreateJob(const char* inName, JPH::ColorArg inColor, const JobFunction& inJobFunction, JPH::uint32 inNumDependencies = 0) override;
+
+protected:
+    void                    QueueJob(Job* inJob) override;
+    void                    QueueJobs(Job** inJobs, JPH::uint inNumJobs) override;
+    void                    FreeJob(Job* inJob) override;
+
+private:
+    /// Engine job that executes a Jolt job. Holds a reference to the Jolt job until it runs.
+    struct QueuedJob
+    {
+        AsyncJob            EngineJob;
+        Job*                PhysicsJob;
+        PhysicsJobSystem*   Owner;
+    };
+
+    static void             ExecuteQueuedJob(void* data);
+
+    AsyncJobManager&        m_JobManager;
+    AsyncJobCounter         m_Counter;
+
+    JPH::FixedSizeFreeList<Job> m_Jobs;
+    JPH::FixedSizeFreeList<QueuedJob> m_QueuedJobs;
+};
+
+HK_NAMESPACE_END
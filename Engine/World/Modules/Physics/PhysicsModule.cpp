@@ -29,16 +29,15 @@ SOFTWARE.
 */
 
 #include "PhysicsModule.h"
+#include "PhysicsJobSystem.h"
 
 #include <Engine/Core/Logger.h>
-#include <Engine/Core/Thread.h>
-#include <Engine/Core/BaseMath.h>
+#include <Engine/GameApplication/GameApplication.h>
 
 #include <Jolt/Jolt.h>
 #include <Jolt/RegisterTypes.h>
 #include <Jolt/Core/Factory.h>
 #include <Jolt/Core/TempAllocator.h>
-#include <Jolt/Core/JobSystemThreadPool.h>
 #include <Jolt/Physics/PhysicsSettings.h>
 
 HK_NAMESPACE_BEGIN
@@ -103,22 +102,33 @@ PhysicsModule::PhysicsModule()
     // malloc / free.
     m_PhysicsTempAllocator = std::make_unique<JPH::TempAllocatorImpl>(10 * 1024 * 1024);
 
-    // We need a job system that will execute physics jobs on multiple threads. Typically
-    // you would implement the JobSystem interface yourself and let Jolt Physics run on top
-    // of your own job scheduler. JobSystemThreadPool is an example implementation.
-    int numThreads = Math::Max(1, Thread::NumHardwareThreads - 1);
-    LOG("Job system thread count {}\n", numThreads);
-    m_JobSystemThreadPool = std::make_unique<JPH::JobSystemThreadPool>(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, numThreads);
+    // Physics jobs run on the engine worker threads, so physics doesn't compete with gameplay jobs for the cores.
+    m_JobSystem = std::make_unique<PhysicsJobSystem>(GameApplication::GetAsyncJobManager(), JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers);
+
+    int numThreadTempAllocators = GameApplication::GetAsyncJobManager().GetNumWorkerThreads() + 1;
+    for (int i = 0; i < numThreadTempAllocators; i++)
+        m_ThreadTempAllocators.Add(std::make_unique<JPH::TempAllocatorImpl>(1024 * 1024));
 }
 
 PhysicsModule::~PhysicsModule()
 {
     m_PhysicsTempAllocator.reset();
-    m_JobSystemThreadPool.reset();
+    m_ThreadTempAllocators.Clear();
+    m_JobSystem.reset();
 
     // Destroy the factory
     delete JPH::Factory::sInstance;
     JPH::Factory::sInstance = nullptr;
 }
 
+JPH::TempAllocator* PhysicsModule::GetThreadTempAllocator()
+{
+    // Threads that are not engine workers share the last allocator. Only the thread that runs the world update may use it.
+    int workerIndex = GameApplication::GetAsyncJobManager().GetCurrentWorkerIndex();
+    if (workerIndex < 0)
+        workerIndex = m_ThreadTempAllocators.Size() - 1;
+
+    return m_ThreadTempAllocators[workerIndex].get();
+}
+
 HK_NAMESPACE_END
@@ -35,7 +35,7 @@ SOFTWARE.
 namespace JPH
 {
 class TempAllocator;
-class JobSystemThreadPool;
+class JobSystem;
 }
 
 HK_NAMESPACE_BEGIN
@@ -50,17 +50,23 @@ public:
         return m_PhysicsTempAllocator.get();
     }
 
-    JPH::JobSystemThreadPool* GetJobSystemThreadPool()
+    JPH::JobSystem* GetJobSystem()
     {
-        return m_JobSystemThreadPool.get();
+        return m_JobSystem.get();
     }
 
+    /// Temp allocator of the calling thread. Can be used in jobs that run in parallel with other physics jobs.
+    JPH::TempAllocator* GetThreadTempAllocator();
+
 private:
     PhysicsModule();
     ~PhysicsModule();
 
     std::unique_ptr<JPH::TempAllocator> m_PhysicsTempAllocator;
-    std::unique_ptr<JPH::JobSystemThreadPool> m_JobSystemThreadPool;
+    std::unique_ptr<JPH::JobSystem> m_JobSystem;
+
+    /// One allocator for each engine worker thread and one for the thread that runs the world update
+    Vector<std::unique_ptr<JPH::TempAllocator>> m_ThreadTempAllocators;
 };
 
 HK_NAMESPACE_END
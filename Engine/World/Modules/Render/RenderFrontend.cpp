@@ -51,6 +51,7 @@ ConsoleVar r_VertexLight("r_VertexLight"s, "0"s);
 ConsoleVar r_MotionBlur("r_MotionBlur"s, "1"s);
 ConsoleVar r_RenderMeshes("r_RenderMeshes"s, "1"s, CVAR_CHEAT);
 ConsoleVar r_RenderTerrain("r_RenderTerrain"s, "1"s, CVAR_CHEAT);
+ConsoleVar r_FrustumCulling("r_FrustumCulling"s, "1"s, CVAR_CHEAT);
 
 extern ConsoleVar r_HBAO;
 extern ConsoleVar r_HBAODeinterleaved;
@@ -473,12 +474,19 @@ void RenderFrontend::AddDirectionalLightShadows(LightShadowmap* shadowmap, Direc
         }
     }
 #endif
-    AddMeshesShadow<StaticMeshComponent>(shadowmap);
-    AddMeshesShadow<DynamicMeshComponent>(shadowmap);
+    BvFrustum cascadeFrustum[MAX_SHADOW_CASCADES];
+
+    Float4x4 const* lightViewProjectionMatrices = (Float4x4 const*)m_RenderDef.StreamedMemory->Map(lightDef->ViewProjStreamHandle);
+
+    for (int cascadeIndex = 0; cascadeIndex < lightDef->NumCascades; cascadeIndex++)
+        cascadeFrustum[cascadeIndex].FromMatrix(lightViewProjectionMatrices[cascadeIndex]);
+
+    AddMeshesShadow<StaticMeshComponent>(shadowmap, cascadeFrustum, lightDef->NumCascades);
+    AddMeshesShadow<DynamicMeshComponent>(shadowmap, cascadeFrustum, lightDef->NumCascades);
 }
 
 template <typename MeshComponentType>
-void RenderFrontend::AddMeshes()
+void RenderFrontend::GatherMeshBounds()
 {
     PreRenderContext context;
     context.FrameNum = m_RenderDef.FrameNumber;
@@ -486,6 +494,9 @@ void RenderFrontend::AddMeshes()
     context.Cur = m_World->GetTick().StateIndex;
     context.Frac = m_World->GetTick().Interpolate;
 
+    m_CullMeshes.Clear();
+    m_CullBoxes.Clear();
+
     auto& meshManager = m_World->GetComponentManager<MeshComponentType>();
     for (auto it = meshManager.GetComponents(); it.IsValid(); ++it)
     {
@@ -496,6 +507,67 @@ void RenderFrontend::AddMeshes()
 
         mesh.PreRender(context);
 
+        BvAxisAlignedBox bounds;
+        bounds.Clear();
+
+        if (mesh.m_Pose)
+            bounds = mesh.m_Pose->m_Bounds;
+        else if (auto* meshResource = GameApplication::GetResourceManager().TryGet(mesh.m_Resource))
+            bounds = meshResource->GetBoundingBox();
+
+        if (mesh.m_ProceduralData)
+            bounds.AddAABB(mesh.m_ProceduralData->BoundingBox);
+
+        m_CullMeshes.Add(&mesh);
+
+        // Meshes without bounds are never culled
+        if (bounds.IsEmpty())
+            m_CullBoxes.Add(BvAxisAlignedBox(Float3(-std::numeric_limits<float>::max()), Float3(std::numeric_limits<float>::max())));
+        else
+            m_CullBoxes.Add(bounds.Transform(mesh.GetRenderTransform()));
+    }
+
+    // Culling processes four boxes per step
+    if (m_CullBoxes.Size() & 3)
+    {
+        BvAxisAlignedBoxSSE last = m_CullBoxes.Last();
+        while (m_CullBoxes.Size() & 3)
+            m_CullBoxes.Add(last);
+    }
+
+    m_CullResult.ResizeInvalidate(m_CullBoxes.Size() / 4);
+}
+
+void RenderFrontend::CullMeshes(BvFrustum const& frustum, bool ignoreZ)
+{
+    if (m_CullBoxes.IsEmpty())
+        return;
+
+    if (!r_FrustumCulling)
+    {
+        m_CullResult.ZeroMem();
+        return;
+    }
+
+    if (ignoreZ)
+        frustum.CullBox_IgnoreZ_SSE(m_CullBoxes.ToPtr(), m_CullBoxes.Size(), &m_CullResult[0].Result[0]);
+    else
+        frustum.CullBox_SSE(m_CullBoxes.ToPtr(), m_CullBoxes.Size(), &m_CullResult[0].Result[0]);
+}
+
+template <typename MeshComponentType>
+void RenderFrontend::AddMeshes()
+{
+    GatherMeshBounds<MeshComponentType>();
+    CullMeshes(*m_RenderDef.Frustum, false);
+
+    for (uint32_t meshIndex = 0; meshIndex < m_CullMeshes.Size(); ++meshIndex)
+    {
+        if (m_CullResult[meshIndex >> 2].Result[meshIndex & 3])
+            continue;
+
+        MeshComponentType& mesh = *static_cast<MeshComponentType*>(m_CullMeshes[meshIndex]);
+
         Float4x4 instanceMatrix = m_View->ViewProjection * mesh.GetRenderTransform();
         Float4x4 instanceMatrixP = m_View->ViewProjectionP * mesh.GetRenderTransformPrev();
 
@@ -510,6 +582,8 @@ void RenderFrontend::AddMeshes()
             skeletonOffset = mesh.m_Pose->m_SkeletonOffset;
             skeletonOffsetMB = mesh.m_Pose->m_SkeletonOffsetMB;
             skeletonSize = mesh.m_Pose->m_SkeletonSize;
+
+            mesh.m_Pose->MarkVisible(m_FrameNumber, m_View->ViewPosition.Dist(mesh.GetRenderTransform().DecomposeTranslation()));
         }
 
         for (int surfaceIndex = 0; surfaceIndex < mesh.m_Surfaces.Size(); ++surfaceIndex)
@@ -665,23 +739,32 @@ void RenderFrontend::AddMeshes()
 }
 
 template <typename MeshComponentType>
-void RenderFrontend::AddMeshesShadow(LightShadowmap* shadowMap)
+void RenderFrontend::AddMeshesShadow(LightShadowmap* shadowMap, BvFrustum const* cascadeFrustum, int numCascades)
 {
-    PreRenderContext context;
-    context.FrameNum = m_RenderDef.FrameNumber;
-    context.Prev = m_World->GetTick().PrevStateIndex;
-    context.Cur = m_World->GetTick().StateIndex;
-    context.Frac = m_World->GetTick().Interpolate;
+    GatherMeshBounds<MeshComponentType>();
 
-    auto& meshManager = m_World->GetComponentManager<MeshComponentType>();
-    for (auto it = meshManager.GetComponents(); it.IsValid(); ++it)
+    m_CullCascadeMask.ResizeInvalidate(m_CullMeshes.Size());
+    m_CullCascadeMask.ZeroMem();
+
+    // Casters in front of the cascade near plane still cast shadows into it, so test only the side planes
+    for (int cascadeIndex = 0; cascadeIndex < numCascades; cascadeIndex++)
     {
-        MeshComponentType& mesh = *it;
+        CullMeshes(cascadeFrustum[cascadeIndex], true);
 
-        if (!mesh.IsInitialized())
+        for (uint32_t meshIndex = 0; meshIndex < m_CullMeshes.Size(); ++meshIndex)
+            m_CullCascadeMask[meshIndex] |= (m_CullResult[meshIndex >> 2].Result[meshIndex & 3] == 0) << cascadeIndex;
+    }
+
+    for (uint32_t meshIndex = 0; meshIndex < m_CullMeshes.Size(); ++meshIndex)
+    {
+        uint32_t cascadeMask = m_CullCascadeMask[meshIndex];
+        if (!cascadeMask)
             continue;
 
-        mesh.PreRender(context);
+        MeshComponentType& mesh = *static_cast<MeshComponentType*>(m_CullMeshes[meshIndex]);
+
+        if (!mesh.m_CastShadow)
+            continue;
 
         Float3x4 const& instanceMatrix = mesh.GetRenderTransform();
 
@@ -692,6 +775,8 @@ void RenderFrontend::AddMeshesShadow(LightShadowmap* shadowMap)
         {
             skeletonOffset = mesh.m_Pose->m_SkeletonOffset;
             skeletonSize = mesh.m_Pose->m_SkeletonSize;
+
+            mesh.m_Pose->MarkVisible(m_FrameNumber, m_View->ViewPosition.Dist(instanceMatrix.DecomposeTranslation()));
         }
 
         for (int surfaceIndex = 0; surfaceIndex < mesh.m_Surfaces.Size(); ++surfaceIndex)
@@ -736,7 +821,7 @@ void RenderFrontend::AddMeshesShadow(LightShadowmap* shadowMap)
                 instance->SkeletonOffset = skeletonOffset;
                 instance->SkeletonSize = skeletonSize;
                 instance->WorldTransformMatrix = instanceMatrix;
-                instance->CascadeMask = 0xffff;//mesh.m_CascadeMask; // TODO
+                instance->CascadeMask = cascadeMask;
 
                 uint8_t priority = material->m_pCompiledMaterial->RenderingPriority;
 
@@ -771,7 +856,7 @@ void RenderFrontend::AddMeshesShadow(LightShadowmap* shadowMap)
                 instance->SkeletonOffset = 0;
                 instance->SkeletonSize = 0;
                 instance->WorldTransformMatrix = instanceMatrix;
-                instance->CascadeMask = 0xffff;//mesh.m_CascadeMask; // TODO
+                instance->CascadeMask = cascadeMask;
 
                 uint8_t priority = material->m_pCompiledMaterial->RenderingPriority;
 
@@ -40,6 +40,7 @@ SOFTWARE.
 HK_NAMESPACE_BEGIN
 
 class DirectionalLightComponent;
+class MeshComponent;
 
 struct RenderFrontendStat
 {
@@ -93,7 +94,14 @@ private:
     void AddMeshes();
 
     template <typename MeshComponentType>
-    void AddMeshesShadow(LightShadowmap* shadowMap);
+    void AddMeshesShadow(LightShadowmap* shadowMap, BvFrustum const* cascadeFrustum, int numCascades);
+
+    /** Call PreRender for initialized meshes and gather their world bounds for culling */
+    template <typename MeshComponentType>
+    void GatherMeshBounds();
+
+    /** Cull gathered mesh bounds. Non-zero result means the mesh is outside of the frustum. */
+    void CullMeshes(BvFrustum const& frustum, bool ignoreZ);
 
     //bool AddLightShadowmap(PunctualLightComponent* Light, float Radius);
 
@@ -121,6 +129,11 @@ private:
     };
     Vector<CullResult> m_ShadowCasterCullResult;
 
+    Vector<MeshComponent*> m_CullMeshes;
+    Vector<BvAxisAlignedBoxSSE> m_CullBoxes;
+    Vector<CullResult> m_CullResult;
+    Vector<uint32_t> m_CullCascadeMask;
+
     RenderFrontendDef m_RenderDef;
 
     Ref<RenderCore::ITexture> m_PhotometricProfiles;
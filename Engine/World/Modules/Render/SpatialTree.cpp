@@ -28,22 +28,700 @@ SOFTWARE.
 
 */
 
-#if 0
 #include "SpatialTree.h"
 
+#include <Engine/Geometry/BV/BvIntersect.h>
+
+#include <algorithm>
+
 HK_NAMESPACE_BEGIN
 
-struct SpatialPrimitive
+namespace
+{
+
+HK_FORCEINLINE BvAxisAlignedBox CombineBounds(BvAxisAlignedBox const& a, BvAxisAlignedBox const& b)
+{
+    return BvAxisAlignedBox(Float3(Math::Min(a.Mins.X, b.Mins.X), Math::Min(a.Mins.Y, b.Mins.Y), Math::Min(a.Mins.Z, b.Mins.Z)),
+                            Float3(Math::Max(a.Maxs.X, b.Maxs.X), Math::Max(a.Maxs.Y, b.Maxs.Y), Math::Max(a.Maxs.Z, b.Maxs.Z)));
+}
+
+HK_FORCEINLINE bool ContainsBounds(BvAxisAlignedBox const& outer, BvAxisAlignedBox const& inner)
+{
+    return outer.Mins.X <= inner.Mins.X && outer.Mins.Y <= inner.Mins.Y && outer.Mins.Z <= inner.Mins.Z &&
+           outer.Maxs.X >= inner.Maxs.X && outer.Maxs.Y >= inner.Maxs.Y && outer.Maxs.Z >= inner.Maxs.Z;
+}
+
+HK_FORCEINLINE float SurfaceArea(BvAxisAlignedBox const& box)
+{
+    Float3 size = box.Size();
+    return 2.0f * (size.X * size.Y + size.Y * size.Z + size.Z * size.X);
+}
+
+HK_FORCEINLINE BvAxisAlignedBox SphereBounds(BvSphere const& sphere)
 {
-    BvAxisAlignedBox m_BoundingBox;
-    BvSphere m_BoundingSphere;
+    return BvAxisAlignedBox(sphere.Center, sphere.Radius);
+}
+
+}
+
+uint32_t SpatialTree::AllocatePrimitive(SPATIAL_MASK mask)
+{
+    uint32_t primitiveId;
+    if (!m_FreePrimitives.IsEmpty())
+    {
+        primitiveId = m_FreePrimitives.Last();
+        m_FreePrimitives.RemoveLast();
+    }
+    else
+    {
+        primitiveId = m_Primitives.Size();
+        m_Primitives.Add();
+    }
+
+    Primitive& primitive = m_Primitives[primitiveId];
+    primitive.BoundingBox.Clear();
+    primitive.BoundingSphere = BvSphere(0.0f);
+    primitive.Entity = {};
+    primitive.Mask = mask;
+    primitive.Leaf = NullNode;
+    primitive.bSphere = false;
+    primitive.bFree = false;
+
+    m_PrimitiveCount++;
+
+    return primitiveId;
+}
+
+uint32_t SpatialTree::AddPrimitive(SPATIAL_MASK mask)
+{
+    return AllocatePrimitive(mask);
+}
+
+uint32_t SpatialTree::AddPrimitive(BvAxisAlignedBox const& box, SPATIAL_MASK mask)
+{
+    uint32_t primitiveId = AllocatePrimitive(mask);
+    SetBounds(primitiveId, box);
+    return primitiveId;
+}
+
+uint32_t SpatialTree::AddPrimitive(BvSphere const& sphere, SPATIAL_MASK mask)
+{
+    uint32_t primitiveId = AllocatePrimitive(mask);
+    SetBounds(primitiveId, sphere);
+    return primitiveId;
+}
+
+void SpatialTree::RemovePrimitive(uint32_t primitiveId)
+{
+    HK_ASSERT(primitiveId < m_Primitives.Size());
+    HK_ASSERT(!m_Primitives[primitiveId].bFree);
+
+    Primitive& primitive = m_Primitives[primitiveId];
+    if (primitive.Leaf != NullNode)
+    {
+        RemoveLeaf(primitive.Leaf);
+        FreeNode(primitive.Leaf);
+        primitive.Leaf = NullNode;
+        m_ModificationCount++;
+    }
+
+    primitive.bFree = true;
+    m_FreePrimitives.Add(primitiveId);
+    m_PrimitiveCount--;
+}
+
+void SpatialTree::AssignEntity(uint32_t primitiveId, GameObjectHandle entityHandle)
+{
+    HK_ASSERT(primitiveId < m_Primitives.Size());
+    m_Primitives[primitiveId].Entity = entityHandle;
+}
+
+GameObjectHandle SpatialTree::GetEntity(uint32_t primitiveId) const
+{
+    HK_ASSERT(primitiveId < m_Primitives.Size());
+    return m_Primitives[primitiveId].Entity;
+}
+
+void SpatialTree::SetMask(uint32_t primitiveId, SPATIAL_MASK mask)
+{
+    HK_ASSERT(primitiveId < m_Primitives.Size());
+    m_Primitives[primitiveId].Mask = mask;
+}
+
+void SpatialTree::SetBounds(uint32_t primitiveId, BvAxisAlignedBox const& box)
+{
+    HK_ASSERT(primitiveId < m_Primitives.Size());
+
+    Primitive& primitive = m_Primitives[primitiveId];
+    primitive.BoundingBox = box;
+    primitive.bSphere = false;
+
+    UpdateLeaf(primitiveId, box);
+}
+
+void SpatialTree::SetBounds(uint32_t primitiveId, BvSphere const& sphere)
+{
+    HK_ASSERT(primitiveId < m_Primitives.Size());
+
+    Primitive& primitive = m_Primitives[primitiveId];
+    primitive.BoundingBox = SphereBounds(sphere);
+    primitive.BoundingSphere = sphere;
+    primitive.bSphere = true;
+
+    UpdateLeaf(primitiveId, primitive.BoundingBox);
+}
+
+void SpatialTree::UpdateLeaf(uint32_t primitiveId, BvAxisAlignedBox const& bounds)
+{
+    int32_t leaf = m_Primitives[primitiveId].Leaf;
+
+    if (leaf != NullNode)
+    {
+        // Keep the leaf while the primitive stays inside the fat bounds and the fat bounds are not too loose
+        BvAxisAlignedBox const& fatBounds = m_Nodes[leaf].Bounds;
+        if (ContainsBounds(fatBounds, bounds) && ContainsBounds(BvAxisAlignedBox(bounds.Mins - FatMargin * 4, bounds.Maxs + FatMargin * 4), fatBounds))
+            return;
+
+        RemoveLeaf(leaf);
+    }
+    else
+    {
+        leaf = AllocateNode();
+        m_Nodes[leaf].PrimitiveId = primitiveId;
+        m_Nodes[leaf].Height = 0;
+        m_Primitives[primitiveId].Leaf = leaf;
+    }
+
+    m_Nodes[leaf].Bounds = BvAxisAlignedBox(bounds.Mins - FatMargin, bounds.Maxs + FatMargin);
+
+    InsertLeaf(leaf);
+
+    m_ModificationCount++;
+}
+
+int32_t SpatialTree::AllocateNode()
+{
+    int32_t nodeId;
+    if (m_FreeNode != NullNode)
+    {
+        nodeId = m_FreeNode;
+        m_FreeNode = m_Nodes[nodeId].Parent;
+    }
+    else
+    {
+        nodeId = m_Nodes.Size();
+        m_Nodes.Add();
+    }
+
+    Node& node = m_Nodes[nodeId];
+    node.Parent = NullNode;
+    node.Child1 = NullNode;
+    node.Child2 = NullNode;
+    node.Height = 0;
+    node.PrimitiveId = 0;
+
+    return nodeId;
+}
+
+void SpatialTree::FreeNode(int32_t nodeId)
+{
+    m_Nodes[nodeId].Parent = m_FreeNode;
+    m_Nodes[nodeId].Height = -1;
+    m_FreeNode = nodeId;
+}
+
+void SpatialTree::InsertLeaf(int32_t leaf)
+{
+    if (m_Root == NullNode)
+    {
+        m_Root = leaf;
+        m_Nodes[leaf].Parent = NullNode;
+        return;
+    }
+
+    // Find the best sibling using the surface area heuristic
+    BvAxisAlignedBox leafBounds = m_Nodes[leaf].Bounds;
+    int32_t index = m_Root;
+    while (!m_Nodes[index].IsLeaf())
+    {
+        Node const& node = m_Nodes[index];
+
+        float area = SurfaceArea(node.Bounds);
+        float combinedArea = SurfaceArea(CombineBounds(node.Bounds, leafBounds));
+
+        // Cost of creating a new parent for this node and the new leaf
+        float cost = 2.0f * combinedArea;
+
+        // Minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto childCost = [&](int32_t child)
+        {
+            float newArea = SurfaceArea(CombineBounds(leafBounds, m_Nodes[child].Bounds));
+            if (m_Nodes[child].IsLeaf())
+                return newArea + inheritanceCost;
+            return (newArea - SurfaceArea(m_Nodes[child].Bounds)) + inheritanceCost;
+        };
+
+        float cost1 = childCost(node.Child1);
+        float cost2 = childCost(node.Child2);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? node.Child1 : node.Child2;
+    }
+
+    int32_t sibling = index;
+
+    // Create a new parent
+    int32_t oldParent = m_Nodes[sibling].Parent;
+    int32_t newParent = AllocateNode();
+
+    m_Nodes[newParent].Parent = oldParent;
+    m_Nodes[newParent].Bounds = CombineBounds(leafBounds, m_Nodes[sibling].Bounds);
+    m_Nodes[newParent].Height = m_Nodes[sibling].Height + 1;
+    m_Nodes[newParent].Child1 = sibling;
+    m_Nodes[newParent].Child2 = leaf;
+    m_Nodes[sibling].Parent = newParent;
+    m_Nodes[leaf].Parent = newParent;
+
+    if (oldParent != NullNode)
+    {
+        if (m_Nodes[oldParent].Child1 == sibling)
+            m_Nodes[oldParent].Child1 = newParent;
+        else
+            m_Nodes[oldParent].Child2 = newParent;
+    }
+    else
+    {
+        m_Root = newParent;
+    }
+
+    // Walk back up the tree fixing heights and bounds
+    index = m_Nodes[leaf].Parent;
+    while (index != NullNode)
+    {
+        index = Balance(index);
+
+        Node& node = m_Nodes[index];
+        node.Height = 1 + Math::Max(m_Nodes[node.Child1].Height, m_Nodes[node.Child2].Height);
+        node.Bounds = CombineBounds(m_Nodes[node.Child1].Bounds, m_Nodes[node.Child2].Bounds);
+
+        index = node.Parent;
+    }
+}
+
+void SpatialTree::RemoveLeaf(int32_t leaf)
+{
+    if (leaf == m_Root)
+    {
+        m_Root = NullNode;
+        return;
+    }
+
+    int32_t parent = m_Nodes[leaf].Parent;
+    int32_t grandParent = m_Nodes[parent].Parent;
+    int32_t sibling = m_Nodes[parent].Child1 == leaf ? m_Nodes[parent].Child2 : m_Nodes[parent].Child1;
+
+    if (grandParent != NullNode)
+    {
+        // Destroy parent and connect sibling to grandparent
+        if (m_Nodes[grandParent].Child1 == parent)
+            m_Nodes[grandParent].Child1 = sibling;
+        else
+            m_Nodes[grandParent].Child2 = sibling;
+        m_Nodes[sibling].Parent = grandParent;
+        FreeNode(parent);
+
+        int32_t index = grandParent;
+        while (index != NullNode)
+        {
+            index = Balance(index);
+
+            Node& node = m_Nodes[index];
+            node.Height = 1 + Math::Max(m_Nodes[node.Child1].Height, m_Nodes[node.Child2].Height);
+            node.Bounds = CombineBounds(m_Nodes[node.Child1].Bounds, m_Nodes[node.Child2].Bounds);
+
+            index = node.Parent;
+        }
+    }
+    else
+    {
+        m_Root = sibling;
+        m_Nodes[sibling].Parent = NullNode;
+        FreeNode(parent);
+    }
+}
+
+int32_t SpatialTree::Balance(int32_t iA)
+{
+    Node& A = m_Nodes[iA];
+    if (A.IsLeaf() || A.Height < 2)
+        return iA;
+
+    int32_t iB = A.Child1;
+    int32_t iC = A.Child2;
+    Node& B = m_Nodes[iB];
+    Node& C = m_Nodes[iC];
+
+    int32_t balance = C.Height - B.Height;
+
+    // Rotate C up
+    if (balance > 1)
+    {
+        int32_t iF = C.Child1;
+        int32_t iG = C.Child2;
+        Node& F = m_Nodes[iF];
+        Node& G = m_Nodes[iG];
+
+        C.Child1 = iA;
+        C.Parent = A.Parent;
+        A.Parent = iC;
+
+        if (C.Parent != NullNode)
+        {
+            if (m_Nodes[C.Parent].Child1 == iA)
+                m_Nodes[C.Parent].Child1 = iC;
+            else
+                m_Nodes[C.Parent].Child2 = iC;
+        }
+        else
+        {
+            m_Root = iC;
+        }
+
+        if (F.Height > G.Height)
+        {
+            C.Child2 = iF;
+            A.Child2 = iG;
+            G.Parent = iA;
+            A.Bounds = CombineBounds(B.Bounds, G.Bounds);
+            C.Bounds = CombineBounds(A.Bounds, F.Bounds);
+            A.Height = 1 + Math::Max(B.Height, G.Height);
+            C.Height = 1 + Math::Max(A.Height, F.Height);
+        }
+        else
+        {
+            C.Child2 = iG;
+            A.Child2 = iF;
+            F.Parent = iA;
+            A.Bounds = CombineBounds(B.Bounds, F.Bounds);
+            C.Bounds = CombineBounds(A.Bounds, G.Bounds);
+            A.Height = 1 + Math::Max(B.Height, F.Height);
+            C.Height = 1 + Math::Max(A.Height, G.Height);
+        }
+
+        return iC;
+    }
+
+    // Rotate B up
+    if (balance < -1)
+    {
+        int32_t iD = B.Child1;
+        int32_t iE = B.Child2;
+        Node& D = m_Nodes[iD];
+        Node& E = m_Nodes[iE];
+
+        B.Child1 = iA;
+        B.Parent = A.Parent;
+        A.Parent = iB;
+
+        if (B.Parent != NullNode)
+        {
+            if (m_Nodes[B.Parent].Child1 == iA)
+                m_Nodes[B.Parent].Child1 = iB;
+            else
+                m_Nodes[B.Parent].Child2 = iB;
+        }
+        else
+        {
+            m_Root = iB;
+        }
+
+        if (D.Height > E.Height)
+        {
+            B.Child2 = iD;
+            A.Child1 = iE;
+            E.Parent = iA;
+            A.Bounds = CombineBounds(C.Bounds, E.Bounds);
+            B.Bounds = CombineBounds(A.Bounds, D.Bounds);
+            A.Height = 1 + Math::Max(C.Height, E.Height);
+            B.Height = 1 + Math::Max(A.Height, D.Height);
+        }
+        else
+        {
+            B.Child2 = iE;
+            A.Child1 = iD;
+            D.Parent = iA;
+            A.Bounds = CombineBounds(C.Bounds, D.Bounds);
+            B.Bounds = CombineBounds(A.Bounds, E.Bounds);
+            A.Height = 1 + Math::Max(C.Height, D.Height);
+            B.Height = 1 + Math::Max(A.Height, E.Height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+int32_t SpatialTree::BuildTopDown(int32_t* leaves, int32_t count)
+{
+    if (count == 1)
+        return leaves[0];
+
+    // Split along the longest axis of the centroid bounds at the median
+    BvAxisAlignedBox centerBounds;
+    centerBounds.Clear();
+    for (int32_t i = 0; i < count; ++i)
+        centerBounds.AddPoint(m_Nodes[leaves[i]].Bounds.Center());
+
+    Float3 size = centerBounds.Size();
+    int axis = size.X > size.Y ? (size.X > size.Z ? 0 : 2) : (size.Y > size.Z ? 1 : 2);
+
+    int32_t half = count / 2;
+    std::nth_element(leaves, leaves + half, leaves + count, [this, axis](int32_t a, int32_t b)
+    {
+        return m_Nodes[a].Bounds.Center()[axis] < m_Nodes[b].Bounds.Center()[axis];
+    });
+
+    int32_t child1 = BuildTopDown(leaves, half);
+    int32_t child2 = BuildTopDown(leaves + half, count - half);
+
+    int32_t nodeId = AllocateNode();
+    Node& node = m_Nodes[nodeId];
+    node.Child1 = child1;
+    node.Child2 = child2;
+    node.Height = 1 + Math::Max(m_Nodes[child1].Height, m_Nodes[child2].Height);
+    node.Bounds = CombineBounds(m_Nodes[child1].Bounds, m_Nodes[child2].Bounds);
+
+    m_Nodes[child1].Parent = nodeId;
+    m_Nodes[child2].Parent = nodeId;
+
+    return nodeId;
+}
+
+void SpatialTree::Rebalance()
+{
+    Vector<int32_t> leaves;
+    leaves.Reserve(m_PrimitiveCount);
+
+    for (int32_t nodeId = 0; nodeId < (int32_t)m_Nodes.Size(); ++nodeId)
+    {
+        Node& node = m_Nodes[nodeId];
+        if (node.Height < 0)
+            continue;
+
+        if (node.IsLeaf())
+        {
+            node.Parent = NullNode;
+            leaves.Add(nodeId);
+        }
+        else
+        {
+            FreeNode(nodeId);
+        }
+    }
+
+    m_Root = leaves.IsEmpty() ? NullNode : BuildTopDown(leaves.ToPtr(), leaves.Size());
+    if (m_Root != NullNode)
+        m_Nodes[m_Root].Parent = NullNode;
+
+    m_RebuildAreaRatio = GetAreaRatio();
+    m_ModificationCount = 0;
+}
+
+void SpatialTree::RebalanceIfNeeded()
+{
+    // Incremental updates keep the tree height balanced, but the quality of the bounds slowly degrades
+    if (m_ModificationCount < 64 || m_ModificationCount < m_PrimitiveCount / 4)
+        return;
+
+    if (GetAreaRatio() > m_RebuildAreaRatio * 1.5f)
+        Rebalance();
+    else
+        m_ModificationCount = 0;
+}
+
+float SpatialTree::GetAreaRatio() const
+{
+    if (m_Root == NullNode)
+        return 0;
+
+    float rootArea = SurfaceArea(m_Nodes[m_Root].Bounds);
+    if (rootArea <= 0.0f)
+        return 0;
+
+    float totalArea = 0;
+    for (Node const& node : m_Nodes)
+    {
+        if (node.Height < 0)
+            continue;
+        totalArea += SurfaceArea(node.Bounds);
+    }
+
+    return totalArea / rootArea;
+}
+
+int SpatialTree::GetHeight() const
+{
+    return m_Root == NullNode ? 0 : m_Nodes[m_Root].Height;
+}
+
+bool SpatialTree::TestPrimitive(Primitive const& primitive, BvAxisAlignedBox const& box) const
+{
+    if (primitive.bSphere)
+        return BvBoxOverlapSphere(box, primitive.BoundingSphere);
+    return BvBoxOverlapBox(box, primitive.BoundingBox);
+}
+
+void SpatialTree::QueryBox(BvAxisAlignedBox const& box, SPATIAL_MASK filterMask, Vector<uint32_t>& result) const
+{
+    if (m_Root == NullNode)
+        return;
+
+    SmallVector<int32_t, 256> stack;
+    stack.Add(m_Root);
+
+    while (!stack.IsEmpty())
+    {
+        int32_t nodeId = stack.Last();
+        stack.RemoveLast();
+
+        Node const& node = m_Nodes[nodeId];
+        if (!BvBoxOverlapBox(node.Bounds, box))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            Primitive const& primitive = m_Primitives[node.PrimitiveId];
+            if ((primitive.Mask & filterMask) && TestPrimitive(primitive, box))
+                result.Add(node.PrimitiveId);
+        }
+        else
+        {
+            stack.Add(node.Child1);
+            stack.Add(node.Child2);
+        }
+    }
+}
+
+void SpatialTree::QuerySphere(BvSphere const& sphere, SPATIAL_MASK filterMask, Vector<uint32_t>& result) const
+{
+    if (m_Root == NullNode)
+        return;
+
+    SmallVector<int32_t, 256> stack;
+    stack.Add(m_Root);
+
+    while (!stack.IsEmpty())
+    {
+        int32_t nodeId = stack.Last();
+        stack.RemoveLast();
+
+        Node const& node = m_Nodes[nodeId];
+        if (!BvBoxOverlapSphere(node.Bounds, sphere))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            Primitive const& primitive = m_Primitives[node.PrimitiveId];
+            if (!(primitive.Mask & filterMask))
+                continue;
+
+            bool overlap = primitive.bSphere ? BvSphereOverlapSphere(sphere, primitive.BoundingSphere) : BvBoxOverlapSphere(primitive.BoundingBox, sphere);
+            if (overlap)
+                result.Add(node.PrimitiveId);
+        }
+        else
+        {
+            stack.Add(node.Child1);
+            stack.Add(node.Child2);
+        }
+    }
+}
+
+void SpatialTree::QueryFrustum(BvFrustum const& frustum, SPATIAL_MASK filterMask, Vector<uint32_t>& result) const
+{
+    if (m_Root == NullNode)
+        return;
+
+    SmallVector<int32_t, 256> stack;
+    stack.Add(m_Root);
+
+    while (!stack.IsEmpty())
+    {
+        int32_t nodeId = stack.Last();
+        stack.RemoveLast();
+
+        Node const& node = m_Nodes[nodeId];
+        if (!frustum.IsBoxVisible(node.Bounds))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            Primitive const& primitive = m_Primitives[node.PrimitiveId];
+            if (!(primitive.Mask & filterMask))
+                continue;
+
+            bool visible = primitive.bSphere ? frustum.IsSphereVisible(primitive.BoundingSphere) : frustum.IsBoxVisible(primitive.BoundingBox);
+            if (visible)
+                result.Add(node.PrimitiveId);
+        }
+        else
+        {
+            stack.Add(node.Child1);
+            stack.Add(node.Child2);
+        }
+    }
+}
+
+void SpatialTree::Raycast(Float3 const& rayStart, Float3 const& rayDir, float maxDistance, SPATIAL_MASK filterMask, Vector<SpatialRaycastResult>& result) const
+{
+    if (m_Root == NullNode)
+        return;
+
+    const Float3 invRayDir(1.0f / rayDir.X, 1.0f / rayDir.Y, 1.0f / rayDir.Z);
+    const uint32_t firstResult = result.Size();
+
+    SmallVector<int32_t, 256> stack;
+    stack.Add(m_Root);
+
+    float boxMin, boxMax;
+    while (!stack.IsEmpty())
+    {
+        int32_t nodeId = stack.Last();
+        stack.RemoveLast();
+
+        Node const& node = m_Nodes[nodeId];
+        if (!BvRayIntersectBox(rayStart, invRayDir, node.Bounds, boxMin, boxMax) || boxMin > maxDistance)
+            continue;
 
-    //RaycastCallback m_RaycastCallback;
+        if (node.IsLeaf())
+        {
+            Primitive const& primitive = m_Primitives[node.PrimitiveId];
+            if (!(primitive.Mask & filterMask))
+                continue;
 
-    ECS::EntityHandle Entity;
-};
+            bool hit = primitive.bSphere ? BvRayIntersectSphere(rayStart, rayDir, primitive.BoundingSphere, boxMin, boxMax) : BvRayIntersectBox(rayStart, invRayDir, primitive.BoundingBox, boxMin, boxMax);
 
+            // Distance is zero when the ray starts inside the primitive
+            float distance = Math::Max(boxMin, 0.0f);
+            if (hit && distance <= maxDistance)
+                result.Add({node.PrimitiveId, distance});
+        }
+        else
+        {
+            stack.Add(node.Child1);
+            stack.Add(node.Child2);
+        }
+    }
 
+    std::sort(result.Begin() + firstResult, result.End(), [](SpatialRaycastResult const& a, SpatialRaycastResult const& b)
+    {
+        return a.Distance < b.Distance;
+    });
+}
 
 HK_NAMESPACE_END
-#endif
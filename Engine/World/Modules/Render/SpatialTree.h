@@ -30,112 +30,133 @@ SOFTWARE.
 
 #pragma once
 
-#if 0
-
-#include <Engine/ECS/ECS.h>
+#include <Engine/Core/Containers/Vector.h>
 #include <Engine/Geometry/BV/BvAxisAlignedBox.h>
 #include <Engine/Geometry/BV/BvSphere.h>
+#include <Engine/Geometry/BV/BvFrustum.h>
+#include <Engine/World/GameObject.h>
 
 HK_NAMESPACE_BEGIN
 
-class SpatialArea
-{
-    /** Area bounding box */
-    BvAxisAlignedBox Bounds; // FIXME: will be removed later?
+using SPATIAL_MASK = uint32_t;
 
-    /** Linked portals */
-    //PortalLink* PortalList;
-    uint32_t FirstPortal;
+constexpr SPATIAL_MASK SPATIAL_MASK_ALL = ~0u;
 
-    /** Movable primitives inside the area */
-    //PrimitiveLink* Links;
-    uint32_t FirstPrimitive;
+struct SpatialRaycastResult
+{
+    uint32_t PrimitiveId;
+    float Distance;
 };
 
-class AreaPool
+/**
+Dynamic AABB tree. Leaves hold fattened bounds of the primitives, so small movements do not touch the tree.
+The tree is kept balanced by rotations on insertion and removal, and can be rebuilt top-down when its
+quality degrades (see RebalanceIfNeeded).
+*/
+class SpatialTree final : public Noncopyable
 {
 public:
-    uint32_t Add()
-    {
-        if (!m_FreeList.IsEmpty())
-        {
-            int i = m_FreeList.Last();
-            m_FreeList.RemoveLast();
+    /** Margin added to the leaf bounds */
+    float FatMargin = 0.1f;
 
-            return i;
-        }
+    /** Add primitive without geometry (Geometry will be applyed in SetBounds) */
+    uint32_t AddPrimitive(SPATIAL_MASK mask = SPATIAL_MASK_ALL);
 
-        m_Areas.Add();
-        return m_Areas.Size() - 1;
-    }
+    /** Add box primitive */
+    uint32_t AddPrimitive(BvAxisAlignedBox const& box, SPATIAL_MASK mask = SPATIAL_MASK_ALL);
 
-    void Remove(uint32_t id)
-    {
-        HK_ASSERT(id < m_Areas.Size());
-        HK_ASSERT(!m_Areas[id].bFree);
+    /** Add sphere primitive */
+    uint32_t AddPrimitive(BvSphere const& sphere, SPATIAL_MASK mask = SPATIAL_MASK_ALL);
 
-        m_FreeList.Add(id);
-    }
+    void RemovePrimitive(uint32_t primitiveId);
 
-private:
-    Vector<SpatialArea> m_Areas;
-    Vector<uint32_t> m_FreeList;
-};
+    void AssignEntity(uint32_t primitiveId, GameObjectHandle entityHandle);
 
-class SpatialTree
-{
-public:
-    uint32_t AddArea()
-    {
-        return m_AreaPool.Add();
-    }
+    GameObjectHandle GetEntity(uint32_t primitiveId) const;
 
-    void RemoveArea(uint32_t id)
-    {
-        m_AreaPool.Remove(id);
-    }
+    void SetMask(uint32_t primitiveId, SPATIAL_MASK mask);
 
+    /** Set box geometry for the primitive */
+    void SetBounds(uint32_t primitiveId, BvAxisAlignedBox const& box);
 
-    // Add primitive without geometry (Geometry will be applyed in SetBounds)
-    uint32_t AddPrimitive()
-    {
-        return 0;
-    }
+    /** Set sphere geometry for the primitive */
+    void SetBounds(uint32_t primitiveId, BvSphere const& sphere);
 
-    // Add box primitive
-    uint32_t AddPrimitive(BvAxisAlignedBox const& box)
-    {
-        return 0;
-    }
+    /** Append ids of the primitives overlapping the box */
+    void QueryBox(BvAxisAlignedBox const& box, SPATIAL_MASK filterMask, Vector<uint32_t>& result) const;
 
-    // Add sphere primitive
-    uint32_t AddPrimitive(BvSphere const& sphere)
-    {
-        return 0;
-    }
+    /** Append ids of the primitives overlapping the sphere */
+    void QuerySphere(BvSphere const& sphere, SPATIAL_MASK filterMask, Vector<uint32_t>& result) const;
+
+    /** Append ids of the primitives inside the frustum */
+    void QueryFrustum(BvFrustum const& frustum, SPATIAL_MASK filterMask, Vector<uint32_t>& result) const;
 
-    void RemovePrimitive(uint32_t id)
-    {}
+    /** Append primitives hit by the ray sorted by distance. Ray direction must be normalized. */
+    void Raycast(Float3 const& rayStart, Float3 const& rayDir, float maxDistance, SPATIAL_MASK filterMask, Vector<SpatialRaycastResult>& result) const;
 
-    void AssignEntity(uint32_t primitiveId, ECS::EntityHandle entityHandle)
-    {}
-    //void AssignCallbacks(...) - TODO: callbacks for raycast
+    /** Rebuild the tree top-down */
+    void Rebalance();
 
-    // Set box geometry for the primitive
-    void SetBounds(uint32_t primitiveId, BvAxisAlignedBox const& box)
-    {}
+    /** Rebuild the tree if its quality dropped noticeably since the last rebuild. Cheap to call once per frame. */
+    void RebalanceIfNeeded();
 
-    // Set sphere geometry for the primitive
-    void SetBounds(uint32_t primitiveId, BvSphere const& sphere)
-    {}
+    /** Sum of the surface areas of all nodes divided by the surface area of the root. Lower is better. */
+    float GetAreaRatio() const;
 
-    //Vector<uint32_t> QueryBox(BvAxisAlignedBox const& box, SPATIAL_MASK filterMask);
-    //Vector<uint32_t> QuerySphere(BvSphere const& sphere, SPATIAL_MASK filterMask);
-    //Vector<uint32_t> Raycast(Float3 const& rayStart, Float3 const& rayDir, SPATIAL_MASK filterMask);
-    //Vector<uint32_t> QueryFrustum(BvFrustum const& frustum, SPATIAL_MASK filterMask)
+    int GetHeight() const;
 
-    AreaPool m_AreaPool;
+    uint32_t GetPrimitiveCount() const { return m_PrimitiveCount; }
+
+private:
+    static constexpr int32_t NullNode = -1;
+
+    struct Node
+    {
+        BvAxisAlignedBox Bounds;
+        /** Parent node or next free node */
+        int32_t Parent;
+        int32_t Child1;
+        int32_t Child2;
+        /** Leaf = 0, free node = -1 */
+        int32_t Height;
+        uint32_t PrimitiveId;
+
+        bool IsLeaf() const { return Child1 == NullNode; }
+    };
+
+    struct Primitive
+    {
+        BvAxisAlignedBox BoundingBox;
+        BvSphere BoundingSphere;
+        GameObjectHandle Entity;
+        SPATIAL_MASK Mask;
+        int32_t Leaf;
+        bool bSphere;
+        bool bFree;
+    };
+
+    uint32_t AllocatePrimitive(SPATIAL_MASK mask);
+    void UpdateLeaf(uint32_t primitiveId, BvAxisAlignedBox const& bounds);
+
+    int32_t AllocateNode();
+    void FreeNode(int32_t nodeId);
+    void InsertLeaf(int32_t leaf);
+    void RemoveLeaf(int32_t leaf);
+    int32_t Balance(int32_t nodeId);
+    int32_t BuildTopDown(int32_t* leaves, int32_t count);
+
+    bool TestPrimitive(Primitive const& primitive, BvAxisAlignedBox const& box) const;
+
+    Vector<Node> m_Nodes;
+    int32_t m_Root = NullNode;
+    int32_t m_FreeNode = NullNode;
+
+    Vector<Primitive> m_Primitives;
+    Vector<uint32_t> m_FreePrimitives;
+    uint32_t m_PrimitiveCount = 0;
+
+    float m_RebuildAreaRatio = 0;
+    uint32_t m_ModificationCount = 0;
 };
 
 HK_NAMESPACE_END
-#endif
\ No newline at end of file
@@ -35,6 +35,9 @@ SOFTWARE.
 #include <Engine/Geometry/ConvexHull.h>
 #include <Engine/Core/IntrusiveLinkedListMacro.h>
 #include <Engine/Core/ConsoleVar.h>
+#include <Engine/GameApplication/GameApplication.h>
+
+#include <xmmintrin.h>
 
 HK_NAMESPACE_BEGIN
 
@@ -42,7 +45,7 @@ ConsoleVar com_DrawLevelAreaBounds("com_DrawLevelAreaBounds"s, "0"s, CVAR_CHEAT)
 ConsoleVar com_DrawLevelIndoorBounds("com_DrawLevelIndoorBounds"s, "0"s, CVAR_CHEAT);
 ConsoleVar com_DrawLevelPortals("com_DrawLevelPortals"s, "0"s, CVAR_CHEAT);
 
-//ConsoleVar vsd_FrustumCullingType("vsd_FrustumCullingType"s, "0"s, 0, "0 - combined, 1 - separate, 2 - simple"s);
+ConsoleVar vsd_FrustumCullingType("vsd_FrustumCullingType"s, "0"s, 0, "0 - combined, 1 - separate, 2 - simple"s);
 
 #define MAX_HULL_POINTS 128
 struct PortalHull
@@ -55,6 +58,8 @@ int VisibilityLevel::m_VisQueryMarker = 0;
 
 static const WorldRaycastFilter DefaultRaycastFilter;
 
+struct VisibilityCullBatch;
+
 struct VisibilityQueryContext
 {
     enum
@@ -75,6 +80,9 @@ struct VisibilityQueryContext
 
     VSD_QUERY_MASK VisQueryMask = VSD_QUERY_MASK(0);
     VISIBILITY_GROUP VisibilityMask = VISIBILITY_GROUP(0);
+
+    /** Box culling scratch of the query */
+    VisibilityCullBatch* pCullBatch;
 };
 
 struct VisibilityQueryResult
@@ -82,6 +90,176 @@ struct VisibilityQueryResult
     Vector<PrimitiveDef*>* pVisPrimitives;
 };
 
+/** Box primitives that survived portal flow. Bounds are stored as SoA and culled four boxes per step. */
+struct VisibilityCullBatch
+{
+    enum
+    {
+        /** Number of groups of four boxes processed by one job */
+        GROUPS_PER_JOB = 256
+    };
+
+    struct CullSubmit
+    {
+        PlaneF CullPlanes[PortalStack::MAX_CULL_PLANES];
+        int CullPlanesCount;
+    };
+
+    /** Padded with nullptr to a multiple of four */
+    Vector<PrimitiveDef*> Primitives;
+    Vector<float> MinsX, MinsY, MinsZ;
+    Vector<float> MaxsX, MaxsY, MaxsZ;
+    Vector<CullSubmit> Submits;
+    /** Submit of each group */
+    Vector<uint32_t> GroupSubmit;
+    /** Visibility bits of each group */
+    Vector<uint8_t> VisibleMask;
+
+    void Clear()
+    {
+        Primitives.Clear();
+        MinsX.Clear();
+        MinsY.Clear();
+        MinsZ.Clear();
+        MaxsX.Clear();
+        MaxsY.Clear();
+        MaxsZ.Clear();
+        Submits.Clear();
+        GroupSubmit.Clear();
+    }
+
+    uint32_t GetGroupCount() const
+    {
+        return GroupSubmit.Size();
+    }
+
+    void BeginSubmit(PlaneF const* cullPlanes, int cullPlanesCount)
+    {
+        HK_ASSERT(cullPlanesCount <= PortalStack::MAX_CULL_PLANES);
+
+        CullSubmit& submit = Submits.Add();
+        for (int i = 0; i < cullPlanesCount; i++)
+            submit.CullPlanes[i] = cullPlanes[i];
+        submit.CullPlanesCount = cullPlanesCount;
+    }
+
+    void Add(PrimitiveDef* primitive, BvAxisAlignedBox const& bounds)
+    {
+        Primitives.Add(primitive);
+        MinsX.Add(bounds.Mins.X);
+        MinsY.Add(bounds.Mins.Y);
+        MinsZ.Add(bounds.Mins.Z);
+        MaxsX.Add(bounds.Maxs.X);
+        MaxsY.Add(bounds.Maxs.Y);
+        MaxsZ.Add(bounds.Maxs.Z);
+    }
+
+    void EndSubmit()
+    {
+        uint32_t firstBox = GroupSubmit.Size() * 4;
+        if (Primitives.Size() == firstBox)
+        {
+            // Nothing to cull
+            Submits.RemoveLast();
+            return;
+        }
+
+        while (Primitives.Size() & 3)
+            Add(nullptr, BvAxisAlignedBox(Float3(0.0f), Float3(0.0f)));
+
+        uint32_t submitIndex = Submits.Size() - 1;
+        for (uint32_t i = firstBox; i < Primitives.Size(); i += 4)
+            GroupSubmit.Add(submitIndex);
+    }
+
+    void CullGroups(uint32_t firstGroup, uint32_t lastGroup)
+    {
+        const __m128 zero = _mm_setzero_ps();
+
+        for (uint32_t group = firstGroup; group < lastGroup; group++)
+        {
+            CullSubmit const& submit = Submits[GroupSubmit[group]];
+            uint32_t i = group * 4;
+
+            __m128 minsX = _mm_loadu_ps(&MinsX[i]);
+            __m128 minsY = _mm_loadu_ps(&MinsY[i]);
+            __m128 minsZ = _mm_loadu_ps(&MinsZ[i]);
+            __m128 maxsX = _mm_loadu_ps(&MaxsX[i]);
+            __m128 maxsY = _mm_loadu_ps(&MaxsY[i]);
+            __m128 maxsZ = _mm_loadu_ps(&MaxsZ[i]);
+
+            __m128 inside = _mm_cmpeq_ps(zero, zero);
+
+            // Same as VSD_CullBoxSingle: test the box corner farthest along the plane normal
+            for (int p = 0; p < submit.CullPlanesCount; p++)
+            {
+                PlaneF const& plane = submit.CullPlanes[p];
+
+                __m128 nx = _mm_set1_ps(plane.Normal.X);
+                __m128 ny = _mm_set1_ps(plane.Normal.Y);
+                __m128 nz = _mm_set1_ps(plane.Normal.Z);
+
+                __m128 dx = _mm_max_ps(_mm_mul_ps(minsX, nx), _mm_mul_ps(maxsX, nx));
+                __m128 dy = _mm_max_ps(_mm_mul_ps(minsY, ny), _mm_mul_ps(maxsY, ny));
+                __m128 dz = _mm_max_ps(_mm_mul_ps(minsZ, nz), _mm_mul_ps(maxsZ, nz));
+
+                __m128 distance = _mm_add_ps(_mm_add_ps(dx, dy), _mm_add_ps(dz, _mm_set1_ps(plane.D)));
+
+                inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, zero));
+            }
+
+            VisibleMask[group] = _mm_movemask_ps(inside);
+        }
+    }
+
+    void Cull(uint32_t firstGroup, bool bParallel)
+    {
+        uint32_t groupCount = GetGroupCount();
+
+        VisibleMask.ResizeInvalidate(groupCount);
+
+        if (bParallel)
+        {
+            GameApplication::GetAsyncJobManager().ParallelFor(groupCount - firstGroup, GROUPS_PER_JOB, [this, firstGroup](uint32_t first, uint32_t last)
+            {
+                CullGroups(firstGroup + first, firstGroup + last);
+            });
+        }
+        else
+        {
+            CullGroups(firstGroup, groupCount);
+        }
+    }
+
+    void AddVisible(uint32_t firstGroup, int visQueryMarker, Vector<PrimitiveDef*>& visPrimitives)
+    {
+        for (uint32_t group = firstGroup, groupCount = GetGroupCount(); group < groupCount; group++)
+        {
+            uint32_t mask = VisibleMask[group];
+
+            for (uint32_t lane = 0; lane < 4; lane++)
+            {
+                PrimitiveDef* primitive = Primitives[group * 4 + lane];
+
+                // Skip padding and primitives already added through another area
+                if (!primitive || primitive->VisMark == visQueryMarker)
+                    continue;
+
+                if (mask & (1u << lane))
+                {
+                    // Mark primitive visibility processed
+                    primitive->VisMark = visQueryMarker;
+
+                    // Mark primitive visible
+                    primitive->VisPass = visQueryMarker;
+
+                    visPrimitives.Add(primitive);
+                }
+            }
+        }
+    }
+};
+
 VisibilityLevel::VisibilityLevel(VisibilitySystemCreateInfo const& CreateInfo)
 {
     Float3 extents(CONVEX_HULL_MAX_BOUNDS * 2);
@@ -1087,17 +1265,15 @@ HK_FORCEINLINE bool VisibilityLevel::FaceCull(PrimitiveDef const* InPrimitive)
 
 void VisibilityLevel::CullPrimitives(VisArea const* InArea, PlaneF const* InCullPlanes, const int InCullPlanesCount)
 {
-    /*!!!
-    if (vsd_FrustumCullingType.GetInteger() != FRUSTUM_CULLING_COMBINED)
-    {
-        BoxPrimitives.Clear();
-        BoundingBoxesSSE.Clear();
-        CullSubmits.Clear();
-    }
+    const int cullingType = vsd_FrustumCullingType.GetInteger();
 
-    int numBoxes          = 0;
-    int firstBoxPrimitive = BoxPrimitives.Size();
-*/
+    VisibilityCullBatch& cullBatch = *m_pQueryContext->pCullBatch;
+
+    if (cullingType == FRUSTUM_CULLING_SEPARATE)
+        cullBatch.Clear();
+
+    if (cullingType != FRUSTUM_CULLING_SIMPLE)
+        cullBatch.BeginSubmit(InCullPlanes, InCullPlanesCount);
 
     for (PrimitiveLink* link = InArea->Links; link; link = link->NextInArea)
     {
@@ -1146,7 +1322,7 @@ void VisibilityLevel::CullPrimitives(VisArea const* InArea, PlaneF const* InCull
         switch (primitive->Type)
         {
             case VSD_PRIMITIVE_BOX: {
-                /*!!!                if (vsd_FrustumCullingType.GetInteger() == FRUSTUM_CULLING_SIMPLE) */
+                if (cullingType == FRUSTUM_CULLING_SIMPLE)
                 {
                     if (VSD_CullBoxSingle(InCullPlanes, InCullPlanesCount, primitive->Box))
                     {
@@ -1158,16 +1334,12 @@ void VisibilityLevel::CullPrimitives(VisArea const* InArea, PlaneF const* InCull
                         continue;
                     }
                 }
-                /*!!!
                 else
                 {
                     // Prepare primitive for frustum culling
-                    BoxPrimitives.Add(primitive);
-                    BoundingBoxesSSE.Add() = primitive->Box;
-                    numBoxes++;
+                    cullBatch.Add(primitive, primitive->Box);
                     continue;
                 }
-*/
                 break;
             }
             case VSD_PRIMITIVE_SPHERE: {
@@ -1192,72 +1364,16 @@ void VisibilityLevel::CullPrimitives(VisArea const* InArea, PlaneF const* InCull
         m_pQueryResult->pVisPrimitives->Add(primitive);
     }
 
-    /*!!!
-    if (numBoxes > 0)
+    if (cullingType != FRUSTUM_CULLING_SIMPLE)
     {
-        // Create job submit
+        cullBatch.EndSubmit();
 
-        SCullJobSubmit& submit = CullSubmits.Add();
-
-        submit.First      = firstBoxPrimitive;
-        submit.NumObjects = numBoxes;
-        for (int i = 0; i < InCullPlanesCount; i++)
+        if (cullingType == FRUSTUM_CULLING_SEPARATE)
         {
-            submit.JobCullPlanes[i] = InCullPlanes[i];
-        }
-        submit.JobCullPlanesCount = InCullPlanesCount;
-
-        if (BoxPrimitives.Size() & 3)
-        {
-            // Apply objects count alignment
-            int count = (BoxPrimitives.Size() & ~3) + 4;
-
-            BoxPrimitives.Resize(count);
-            BoundingBoxesSSE.Resize(count);
-        }
-
-        if (vsd_FrustumCullingType.GetInteger() == FRUSTUM_CULLING_SEPARATE)
-        {
-            SubmitCullingJobs(submit);
-
-            // Wait when it's done
-            GEngine->RenderFrontendJobList->Wait();
-
-            Dbg_TotalPrimitiveBounds += numBoxes;
-
-            CullingResult.ResizeInvalidate(Align(BoundingBoxesSSE.Size(), 4));
-
-            PrimitiveDef** boxes      = BoxPrimitives.ToPtr() + submit.First;
-            const int*      cullResult = CullingResult.ToPtr() + submit.First;
-
-            for (int n = 0; n < submit.NumObjects; n++)
-            {
-                PrimitiveDef* primitive = boxes[n];
-
-                if (primitive->VisMark != m_VisQueryMarker)
-                {
-
-                    if (!cullResult[n])
-                    { // TODO: Use atomic increment and store only visible objects?
-                        // Mark primitive visibility processed
-                        primitive->VisMark = m_VisQueryMarker;
-
-                        // Mark primitive visible
-                        primitive->VisPass = m_VisQueryMarker;
-
-                        m_pQueryResult->pVisPrimitives->Add(primitive);
-                    }
-                    else
-                    {
-#ifdef DEBUG_TRAVERSING_COUNTERS
-                        Dbg_CulledByPrimitiveBounds++;
-#endif
-                    }
-                }
-            }
+            cullBatch.Cull(0, false);
+            cullBatch.AddVisible(0, m_VisQueryMarker, *m_pQueryResult->pVisPrimitives);
         }
     }
-*/
 }
 
 void VisibilityLevel::QueryVisiblePrimitives(Vector<VisibilityLevel*> const& m_Levels, Vector<PrimitiveDef*>& VisPrimitives, int* VisPass, VisibilityQuery const& InQuery)
@@ -1266,6 +1382,11 @@ void VisibilityLevel::QueryVisiblePrimitives(Vector<VisibilityLevel*> const& m_L
     VisibilityQueryContext QueryContext;
     VisibilityQueryResult QueryResult;
 
+    // Scratch is kept per thread so its storage is reused between queries
+    thread_local VisibilityCullBatch CullBatch;
+
+    QueryContext.pCullBatch = &CullBatch;
+
     ++m_VisQueryMarker;
 
     if (VisPass)
@@ -1279,11 +1400,9 @@ void VisibilityLevel::QueryVisiblePrimitives(Vector<VisibilityLevel*> const& m_L
     QueryResult.pVisPrimitives = &VisPrimitives;
     QueryResult.pVisPrimitives->Clear();
 
+    CullBatch.Clear();
+
     /*!!!
-    BoxPrimitives.Clear();
-    BoundingBoxesSSE.Clear();
-    CullingResult.Clear();
-    CullSubmits.Clear();
 
 #ifdef DEBUG_TRAVERSING_COUNTERS
     Dbg_SkippedByVisFrame        = 0;
@@ -1339,61 +1458,14 @@ void VisibilityLevel::QueryVisiblePrimitives(Vector<VisibilityLevel*> const& m_L
     {
         level->ProcessLevelVisibility(QueryContext, QueryResult);
     }
-    /*!!!
-    if (vsd_FrustumCullingType.GetInteger() == FRUSTUM_CULLING_COMBINED)
-    {
-        CullingResult.ResizeInvalidate(Align(BoundingBoxesSSE.Size(), 4));
 
-    for (SCullJobSubmit& submit : CullSubmits)
+    if (vsd_FrustumCullingType.GetInteger() == FRUSTUM_CULLING_COMBINED)
     {
-        SubmitCullingJobs(submit);
-
-        Dbg_TotalPrimitiveBounds += submit.NumObjects;
+        // Cull boxes from all areas at once. Large batches are split across worker threads.
+        CullBatch.Cull(0, true);
+        CullBatch.AddVisible(0, m_VisQueryMarker, *QueryResult.pVisPrimitives);
     }
 
-    // Wait when it's done
-    GEngine->RenderFrontendJobList->Wait();
-
-    {
-        ScopedTimer TimeCheck("Evaluate submits");
-
-        for (SCullJobSubmit& submit : CullSubmits)
-        {
-
-            PrimitiveDef** boxes      = BoxPrimitives.ToPtr() + submit.First;
-            int*            cullResult = CullingResult.ToPtr() + submit.First;
-
-            for (int n = 0; n < submit.NumObjects; n++)
-            {
-
-                PrimitiveDef* primitive = boxes[n];
-
-                if (primitive->VisMark != m_VisQueryMarker)
-                {
-
-                    if (!cullResult[n])
-                    { // TODO: Use atomic increment and store only visible objects?
-                        // Mark primitive visibility processed
-                        primitive->VisMark = m_VisQueryMarker;
-
-                        // Mark primitive visible
-                        primitive->VisPass = m_VisQueryMarker;
-
-                        QueryResult.pVisPrimitives->Add(primitive);
-                    }
-                    else
-                    {
-#ifdef DEBUG_TRAVERSING_COUNTERS
-                        Dbg_CulledByPrimitiveBounds++;
-#endif
-                    }
-                }
-            }
-        }
-    }
-}
-*/
-
 #ifdef DEBUG_TRAVERSING_COUNTERS
     DEBUG("VSD: VisFrame {}\n", Dbg_SkippedByVisFrame);
     DEBUG("VSD: PlaneOfs {}\n", Dbg_SkippedByPlaneOffset);
@@ -34,6 +34,9 @@ SOFTWARE.
 HK_NAMESPACE_BEGIN
 
 ConsoleVar com_DrawSkeleton("com_DrawSkeleton"s, "0"s);
+ConsoleVar com_AnimUpdateOffscreen("com_AnimUpdateOffscreen"s, "0"s, 0, "Update poses of skinned meshes that were not rendered"s);
+ConsoleVar com_AnimLodDistance("com_AnimLodDistance"s, "20"s, 0, "View distance per animation update rate LOD. Each LOD halves the pose update rate. 0 to disable"s);
+ConsoleVar com_AnimMaxLod("com_AnimMaxLod"s, "3"s);
 
 void SkinnedMeshComponent::UpdatePoses()
 {
@@ -44,42 +47,48 @@ void SkinnedMeshComponent::UpdatePoses()
     float timeStep = GetWorld()->GetTick().FixedTimeStep;
 
     if (AnimInstance)
-        AnimInstance->Update(timeStep, pose);
-#if 0
-                SkeletonResource* skeleton = GameApplication::GetResourceManager().TryGet(pose->Skeleton);
-                if (skeleton)
-                {
-                    {
-                        SkeletonJoint const* joints = skeleton->GetJoints().ToPtr();
-                        uint32_t jointsCount = skeleton->GetJointsCount();
+    {
+        m_PendingTime += timeStep;
 
-                        for (uint32_t jointIndex = 0; jointIndex < jointsCount; jointIndex++)
-                        {
-                            pose->m_AbsoluteTransforms[jointIndex + 1] = pose->m_AbsoluteTransforms[joints[jointIndex].Parent + 1] * pose->m_RelativeTransforms[jointIndex];
-                        }
-                    }
+        if (m_InterpolationStep < m_UpdateInterval)
+        {
+            // The pose was evaluated ahead, blend towards it
+            m_InterpolationStep++;
+            InterpolatePose(pose);
+        }
+        else
+        {
+            // Don't update poses that were not rendered recently. The time accumulates until the mesh becomes visible.
+            bool bVisible = !pose->IsValid() || com_AnimUpdateOffscreen || GameApplication::GetFrameLoop().SysFrameNumber() - pose->m_VisibleFrame <= 2;
+            if (!bVisible)
+                return;
 
-                    IkTransform target;
+            int interval = pose->IsValid() ? SelectUpdateInterval(pose) : 1;
+            if (interval > 1)
+            {
+                float timeAhead = (interval - 1) * timeStep;
 
-                    int joint = skeleton->FindJoint("Bone.011");
-                    target.Rotation.FromMatrix(pose->m_AbsoluteTransforms[joint+1].DecomposeRotation());
-                    target.Position = pose->m_AbsoluteTransforms[joint+1].DecomposeTranslation();
+                // The last evaluated pose is the one on screen: the previous interval has finished interpolating
+                Core::Swap(m_PrevJointTransforms, m_NextJointTransforms);
 
-                    target.Position.Y += (sin(frame.VariableTime*2) * 0.5f + 0.5f) * 0.6f;
-                    //if (target.Position.Y < 0.6f)
-                    //    target.Position.Y = 0.6f;
+                AnimInstance->Update(m_PendingTime + timeAhead, pose, &m_NextJointTransforms);
 
-                    skeleton->Solve(pose, 1, target);
+                m_PendingTime = -timeAhead;
+                m_UpdateInterval = interval;
+                m_InterpolationStep = 1;
 
-                    SkeletonJoint const* joints = skeleton->GetJoints().ToPtr();
-                    uint32_t jointsCount = skeleton->GetJointsCount();
+                InterpolatePose(pose);
+            }
+            else
+            {
+                AnimInstance->Update(m_PendingTime, pose, &m_NextJointTransforms);
 
-                    for (uint32_t jointIndex = 0; jointIndex < jointsCount; jointIndex++)
-                    {
-                        pose->m_AbsoluteTransforms[jointIndex + 1] = pose->m_AbsoluteTransforms[joints[jointIndex].Parent + 1] * pose->m_RelativeTransforms[jointIndex];
-                    }
-                }
-#else
+                m_PendingTime = 0;
+                m_UpdateInterval = 1;
+                m_InterpolationStep = 1;
+            }
+        }
+    }
 
     SkeletonResource* skeleton = GameApplication::GetResourceManager().TryGet(pose->Skeleton);
     if (skeleton)
@@ -92,7 +101,47 @@ void SkinnedMeshComponent::UpdatePoses()
         }
     }
 
-#endif
+    m_bPoseChanged = true;
+}
+
+void SkinnedMeshComponent::InterpolatePose(SkeletonPose* pose)
+{
+    if (m_PrevJointTransforms.Size() != m_NextJointTransforms.Size() || m_NextJointTransforms.Size() != pose->m_RelativeTransforms.Size())
+    {
+        // Skeleton was changed
+        m_InterpolationStep = m_UpdateInterval;
+        return;
+    }
+
+    float blend = (float)m_InterpolationStep / m_UpdateInterval;
+
+    for (int jointIndex = 0; jointIndex < m_NextJointTransforms.Size(); jointIndex++)
+    {
+        Transform const& prev = m_PrevJointTransforms[jointIndex];
+        Transform const& next = m_NextJointTransforms[jointIndex];
+
+        // Lerping the matrix rows would shear and shrink the rotation, so the joint is blended as position/rotation/scale
+        // and the matrix is recomposed. Rotation uses nlerp along the shortest path.
+        float dot = prev.Rotation.X * next.Rotation.X + prev.Rotation.Y * next.Rotation.Y + prev.Rotation.Z * next.Rotation.Z + prev.Rotation.W * next.Rotation.W;
+
+        Transform transform;
+        transform.Position = Math::Lerp(prev.Position, next.Position, blend);
+        transform.Rotation = prev.Rotation * (1.0f - blend) + next.Rotation * (dot < 0.0f ? -blend : blend);
+        transform.Rotation.NormalizeSelf();
+        transform.Scale = Math::Lerp(prev.Scale, next.Scale, blend);
+
+        transform.ComputeTransformMatrix(pose->m_RelativeTransforms[jointIndex]);
+    }
+}
+
+int SkinnedMeshComponent::SelectUpdateInterval(SkeletonPose const* pose) const
+{
+    float lodDistance = com_AnimLodDistance.GetFloat();
+    if (lodDistance <= 0.0f)
+        return 1;
+
+    int lod = Math::Clamp((int)(pose->m_ViewDistance / lodDistance), 0, Math::Clamp(com_AnimMaxLod.GetInteger(), 0, 7));
+    return 1 << lod;
 }
 
 void SkinnedMeshComponent::UpdateSkins()
@@ -118,18 +167,29 @@ void SkinnedMeshComponent::UpdateSkins()
     pose->m_SkeletonSize = skin.JointIndices.Size() * sizeof(Float3x4);
     if (pose->m_SkeletonSize > 0)
     {
+        // Skins are updated on worker threads, each thread allocates from its own block
         StreamedMemoryGPU* streamedMemory = GameApplication::GetFrameLoop().GetStreamedMemoryGPU();
 
-        // Write joints from previous frame
-        pose->m_SkeletonOffsetMB = streamedMemory->AllocateJoint(pose->m_SkeletonSize, pose->m_SkinningTransforms);
+        if (m_bPoseChanged)
+        {
+            // Write joints from previous frame
+            pose->m_SkeletonOffsetMB = streamedMemory->AllocateJointThreadSafe(pose->m_SkeletonSize, pose->m_SkinningTransforms);
+
+            // Write joints from current frame
+            pose->m_SkeletonOffset = streamedMemory->AllocateJointThreadSafe(pose->m_SkeletonSize, nullptr);
+            Float3x4* data = (Float3x4*)streamedMemory->Map(pose->m_SkeletonOffset);
+            for (int j = 0; j < skin.JointIndices.Size(); j++)
+            {
+                int jointIndex = skin.JointIndices[j];
+                data[j] = pose->m_SkinningTransforms[j] = pose->m_AbsoluteTransforms[jointIndex + 1] * skin.OffsetMatrices[j];
+            }
 
-        // Write joints from current frame
-        pose->m_SkeletonOffset = streamedMemory->AllocateJoint(pose->m_SkeletonSize, nullptr);
-        Float3x4* data = (Float3x4*)streamedMemory->Map(pose->m_SkeletonOffset);
-        for (int j = 0; j < skin.JointIndices.Size(); j++)
+            m_bPoseChanged = false;
+        }
+        else
         {
-            int jointIndex = skin.JointIndices[j];
-            data[j] = pose->m_SkinningTransforms[j] = pose->m_AbsoluteTransforms[jointIndex + 1] * skin.OffsetMatrices[j];
+            // Pose was not updated, current and previous joints are the same
+            pose->m_SkeletonOffset = pose->m_SkeletonOffsetMB = streamedMemory->AllocateJointThreadSafe(pose->m_SkeletonSize, pose->m_SkinningTransforms);
         }
     }
     else
@@ -65,8 +65,32 @@ public:
 private:
     void UpdatePoses();
     void UpdateSkins();
+    void InterpolatePose(SkeletonPose* pose);
+    int SelectUpdateInterval(SkeletonPose const* pose) const;
+
+    // Poses evaluated on update rate LOD, relative to the parent joints. Skipped frames are interpolated between them.
+    // The next pose is also the last evaluated one.
+    Vector<Transform> m_PrevJointTransforms;
+    Vector<Transform> m_NextJointTransforms;
+
+    // Time not yet passed to the animation instance. Negative when the evaluated pose is ahead.
+    float m_PendingTime = 0;
+    int m_UpdateInterval = 1;
+    int m_InterpolationStep = 1;
+
+    // Pose was changed since the skinning matrices were computed
+    bool m_bPoseChanged = false;
 };
 
+namespace ComponentMeta
+{
+    template <>
+    constexpr bool ThreadSafeUpdate<SkinnedMeshComponent>()
+    {
+        return true;
+    }
+}
+
 namespace TickGroup_FixedUpdate
 {
     template <>
@@ -32,6 +32,8 @@ SOFTWARE.
 
 #include <Engine/GameApplication/GameApplication.h>
 
+#include <xmmintrin.h>
+
 HK_NAMESPACE_BEGIN
 
 HK_FORCEINLINE float Quantize(float v, float quantizer)
@@ -210,15 +212,26 @@ PlaybackFrame LocateFrame(SkeletalAnimation* animation, SkeletalAnimationTrack::
     return frame;
 }
 
-void SetupPose(SkeletonPose* pose, SkeletonResource const* skeleton)
+void PoseBlendBuffer::Clear(int jointsCount)
+{
+    size_t size = sizeof(float) * Align(jointsCount, 4);
+
+    for (int i = 0; i < 4; i++)
+        Core::ZeroMem(Rotation[i], size);
+    for (int i = 0; i < 3; i++)
+        Core::ZeroMem(Position[i], size);
+    for (int i = 0; i < 3; i++)
+        Core::ZeroMem(Scale[i], size);
+    Core::ZeroMem(Weight, size);
+}
+
+void SetupPose(SkeletonPose* pose, SkeletonResource const* skeleton, PoseBlendBuffer& blendBuffer)
 {
     auto jointsCount = skeleton->GetJointsCount();
 
-    //pose->SummaryWeights.Resize(jointsCount);
-    Core::ZeroMem(pose->SummaryWeights, sizeof(float) * jointsCount);
+    blendBuffer.Clear(jointsCount);
 
     pose->m_RelativeTransforms.Resize(jointsCount);
-    pose->m_RelativeTransforms.ZeroMem();
 
     pose->m_AbsoluteTransforms.Resize(jointsCount + 1); // + 1 for root's parent
     pose->m_AbsoluteTransforms[0].SetIdentity();
@@ -226,66 +239,206 @@ void SetupPose(SkeletonPose* pose, SkeletonResource const* skeleton)
     pose->m_Bounds.Clear();
 }
 
-void CalculateJointTransforms(SkeletonPose* pose, SkeletalAnimation const* animation, PlaybackFrame const& frame, float weight)
+void CalculateJointTransforms(PoseBlendBuffer& blendBuffer, int jointsCount, SkeletalAnimation const* animation, PlaybackFrame const& frame, float weight)
 {
-    Float3x4 jointMatrix;
-    Transform jointTransform;
+    Transform transforms[MAX_SKELETON_JOINTS];
+    PoseBlendBuffer sample;
+
+    Vector<AnimationChannel> const& channels = animation->GetChannels();
+    HK_ASSERT(channels.Size() <= MAX_SKELETON_JOINTS);
 
-    for (AnimationChannel const& channel : animation->GetChannels())
+    // Frames are always adjacent, so the playback frame maps to a fractional frame index
+    float frameIndex = frame.FrameIndex + (frame.NextFrameIndex - frame.FrameIndex) * frame.FrameBlend;
+
+    animation->SampleChannels(frameIndex, transforms);
+
+    // Scatter channels to joints. Joints without channel have zero weight.
+    Core::ZeroMem(sample.Weight, sizeof(float) * Align(jointsCount, 4));
+
+    for (int channelIndex = 0; channelIndex < channels.Size(); channelIndex++)
     {
-        int jointIndex = channel.JointIndex;
+        int jointIndex = channels[channelIndex].JointIndex;
+        Transform const& transform = transforms[channelIndex];
+
+        sample.Rotation[0][jointIndex] = transform.Rotation.X;
+        sample.Rotation[1][jointIndex] = transform.Rotation.Y;
+        sample.Rotation[2][jointIndex] = transform.Rotation.Z;
+        sample.Rotation[3][jointIndex] = transform.Rotation.W;
+        sample.Position[0][jointIndex] = transform.Position.X;
+        sample.Position[1][jointIndex] = transform.Position.Y;
+        sample.Position[2][jointIndex] = transform.Position.Z;
+        sample.Scale[0][jointIndex] = transform.Scale.X;
+        sample.Scale[1][jointIndex] = transform.Scale.Y;
+        sample.Scale[2][jointIndex] = transform.Scale.Z;
+        sample.Weight[jointIndex] = 1.0f;
+    }
 
-        Vector<Transform> const& transforms = animation->GetTransforms();
+    // Accumulate weighted transforms. Rotations are blended with nlerp, normalized in FinalizeJointTransforms.
+    const __m128 vweight = _mm_set1_ps(weight);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
 
-        if (frame.FrameIndex == frame.NextFrameIndex || frame.FrameBlend < 0.0001f)
+    for (int jointIndex = 0; jointIndex < jointsCount; jointIndex += 4)
+    {
+        __m128 w = _mm_mul_ps(_mm_load_ps(sample.Weight + jointIndex), vweight);
+
+        // Values of joints without channel are undefined
+        __m128 mask = _mm_cmpgt_ps(w, _mm_setzero_ps());
+
+        __m128 q[4], a[4];
+        for (int i = 0; i < 4; i++)
         {
-            jointTransform = transforms[channel.TransformOffset + frame.FrameIndex];
+            q[i] = _mm_load_ps(sample.Rotation[i] + jointIndex);
+            a[i] = _mm_load_ps(blendBuffer.Rotation[i] + jointIndex);
         }
-        else
+
+        // Take the shortest path to the accumulated rotation
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(q[0], a[0]), _mm_mul_ps(q[1], a[1])), _mm_add_ps(_mm_mul_ps(q[2], a[2]), _mm_mul_ps(q[3], a[3])));
+        __m128 rotationWeight = _mm_xor_ps(w, _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), signBit));
+
+        for (int i = 0; i < 4; i++)
+            _mm_store_ps(blendBuffer.Rotation[i] + jointIndex, _mm_add_ps(a[i], _mm_and_ps(mask, _mm_mul_ps(q[i], rotationWeight))));
+
+        for (int i = 0; i < 3; i++)
         {
-            Transform const& frame1 = transforms[channel.TransformOffset + frame.FrameIndex];
-            Transform const& frame2 = transforms[channel.TransformOffset + frame.NextFrameIndex];
+            __m128 position = _mm_load_ps(sample.Position[i] + jointIndex);
+            __m128 scale = _mm_load_ps(sample.Scale[i] + jointIndex);
 
-            jointTransform.Position = Math::Lerp(frame1.Position, frame2.Position, frame.FrameBlend);
-            jointTransform.Rotation = Math::Slerp(frame1.Rotation, frame2.Rotation, frame.FrameBlend);
-            jointTransform.Scale = Math::Lerp(frame1.Scale, frame2.Scale, frame.FrameBlend);
+            _mm_store_ps(blendBuffer.Position[i] + jointIndex, _mm_add_ps(_mm_load_ps(blendBuffer.Position[i] + jointIndex), _mm_and_ps(mask, _mm_mul_ps(position, w))));
+            _mm_store_ps(blendBuffer.Scale[i] + jointIndex, _mm_add_ps(_mm_load_ps(blendBuffer.Scale[i] + jointIndex), _mm_and_ps(mask, _mm_mul_ps(scale, w))));
         }
 
-        jointTransform.ComputeTransformMatrix(jointMatrix);
+        _mm_store_ps(blendBuffer.Weight + jointIndex, _mm_add_ps(_mm_load_ps(blendBuffer.Weight + jointIndex), _mm_and_ps(mask, w)));
+    }
+}
+
+void FinalizeJointTransforms(SkeletonPose* pose, SkeletonResource const* skeleton, PoseBlendBuffer const& blendBuffer)
+{
+    SkeletonJoint const* joints = skeleton->GetJoints().ToPtr();
+    uint32_t jointsCount = skeleton->GetJointsCount();
+
+    Float3x4* relativeTransforms = pose->m_RelativeTransforms.ToPtr();
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
 
-        pose->m_RelativeTransforms[jointIndex][0] += jointMatrix[0] * weight;
-        pose->m_RelativeTransforms[jointIndex][1] += jointMatrix[1] * weight;
-        pose->m_RelativeTransforms[jointIndex][2] += jointMatrix[2] * weight;
+    for (uint32_t jointIndex = 0; jointIndex < jointsCount; jointIndex += 4)
+    {
+        __m128 w = _mm_load_ps(blendBuffer.Weight + jointIndex);
+        __m128 mask = _mm_cmpgt_ps(w, zero);
+        __m128 invWeight = _mm_and_ps(mask, _mm_div_ps(one, _mm_or_ps(w, _mm_andnot_ps(mask, one))));
+
+        __m128 x = _mm_load_ps(blendBuffer.Rotation[0] + jointIndex);
+        __m128 y = _mm_load_ps(blendBuffer.Rotation[1] + jointIndex);
+        __m128 z = _mm_load_ps(blendBuffer.Rotation[2] + jointIndex);
+        __m128 qw = _mm_load_ps(blendBuffer.Rotation[3] + jointIndex);
+
+        // Normalize accumulated rotation
+        __m128 lengthSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(qw, qw)));
+        __m128 lengthMask = _mm_cmpgt_ps(lengthSqr, zero);
+        __m128 invLength = _mm_and_ps(lengthMask, _mm_div_ps(one, _mm_sqrt_ps(_mm_or_ps(lengthSqr, _mm_andnot_ps(lengthMask, one)))));
+
+        x = _mm_mul_ps(x, invLength);
+        y = _mm_mul_ps(y, invLength);
+        z = _mm_mul_ps(z, invLength);
+        qw = _mm_mul_ps(qw, invLength);
+
+        __m128 tx = _mm_mul_ps(_mm_load_ps(blendBuffer.Position[0] + jointIndex), invWeight);
+        __m128 ty = _mm_mul_ps(_mm_load_ps(blendBuffer.Position[1] + jointIndex), invWeight);
+        __m128 tz = _mm_mul_ps(_mm_load_ps(blendBuffer.Position[2] + jointIndex), invWeight);
+
+        __m128 sx = _mm_mul_ps(_mm_load_ps(blendBuffer.Scale[0] + jointIndex), invWeight);
+        __m128 sy = _mm_mul_ps(_mm_load_ps(blendBuffer.Scale[1] + jointIndex), invWeight);
+        __m128 sz = _mm_mul_ps(_mm_load_ps(blendBuffer.Scale[2] + jointIndex), invWeight);
+
+        // Same as Transform::ComputeTransformMatrix
+        __m128 xx = _mm_mul_ps(x, x);
+        __m128 yy = _mm_mul_ps(y, y);
+        __m128 zz = _mm_mul_ps(z, z);
+        __m128 xz = _mm_mul_ps(x, z);
+        __m128 xy = _mm_mul_ps(x, y);
+        __m128 yz = _mm_mul_ps(y, z);
+        __m128 wx = _mm_mul_ps(qw, x);
+        __m128 wy = _mm_mul_ps(qw, y);
+        __m128 wz = _mm_mul_ps(qw, z);
+
+        __m128 r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+        __m128 r01 = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+        __m128 r02 = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+        __m128 r10 = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+        __m128 r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+        __m128 r12 = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+        __m128 r20 = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+        __m128 r21 = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+        __m128 r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+        __m128 col0[4] = {_mm_mul_ps(r00, sx), _mm_mul_ps(r10, sy), _mm_mul_ps(r20, sz), tx};
+        __m128 col1[4] = {_mm_mul_ps(r01, sx), _mm_mul_ps(r11, sy), _mm_mul_ps(r21, sz), ty};
+        __m128 col2[4] = {_mm_mul_ps(r02, sx), _mm_mul_ps(r12, sy), _mm_mul_ps(r22, sz), tz};
+
+        _MM_TRANSPOSE4_PS(col0[0], col0[1], col0[2], col0[3]);
+        _MM_TRANSPOSE4_PS(col1[0], col1[1], col1[2], col1[3]);
+        _MM_TRANSPOSE4_PS(col2[0], col2[1], col2[2], col2[3]);
+
+        alignas(16) Float3x4 matrices[4];
+        for (int i = 0; i < 4; i++)
+        {
+            _mm_store_ps(&matrices[i].Col0.X, col0[i]);
+            _mm_store_ps(&matrices[i].Col1.X, col1[i]);
+            _mm_store_ps(&matrices[i].Col2.X, col2[i]);
+        }
 
-        pose->SummaryWeights[jointIndex] += weight;
+        for (uint32_t i = 0; i < 4 && jointIndex + i < jointsCount; i++)
+        {
+            if (blendBuffer.Weight[jointIndex + i] > 0.0f)
+                relativeTransforms[jointIndex + i] = matrices[i];
+            else
+                relativeTransforms[jointIndex + i] = joints[jointIndex + i].LocalTransform;
+        }
     }
 }
 
-void FinalizeJointTransforms(SkeletonPose* pose, SkeletonResource const* skeleton)
+// Same values as FinalizeJointTransforms, but as position, rotation and scale
+void GatherJointTransforms(SkeletonResource const* skeleton, PoseBlendBuffer const& blendBuffer, Vector<Transform>& jointTransforms)
 {
     SkeletonJoint const* joints = skeleton->GetJoints().ToPtr();
     uint32_t jointsCount = skeleton->GetJointsCount();
 
+    jointTransforms.Resize(jointsCount);
+
     for (uint32_t jointIndex = 0; jointIndex < jointsCount; jointIndex++)
     {
-        if (pose->SummaryWeights[jointIndex] > 0.0f)
+        Transform& transform = jointTransforms[jointIndex];
+
+        float weight = blendBuffer.Weight[jointIndex];
+        if (weight > 0.0f)
         {
-            const float sumWeightReciprocal = 1.0f / pose->SummaryWeights[jointIndex];
+            float invWeight = 1.0f / weight;
+
+            transform.Rotation = Quat(blendBuffer.Rotation[3][jointIndex],
+                                      blendBuffer.Rotation[0][jointIndex],
+                                      blendBuffer.Rotation[1][jointIndex],
+                                      blendBuffer.Rotation[2][jointIndex]);
+            transform.Rotation.NormalizeSelf();
 
-            pose->m_RelativeTransforms[jointIndex][0] *= sumWeightReciprocal;
-            pose->m_RelativeTransforms[jointIndex][1] *= sumWeightReciprocal;
-            pose->m_RelativeTransforms[jointIndex][2] *= sumWeightReciprocal;
+            transform.Position = Float3(blendBuffer.Position[0][jointIndex],
+                                        blendBuffer.Position[1][jointIndex],
+                                        blendBuffer.Position[2][jointIndex]) * invWeight;
+
+            transform.Scale = Float3(blendBuffer.Scale[0][jointIndex],
+                                     blendBuffer.Scale[1][jointIndex],
+                                     blendBuffer.Scale[2][jointIndex]) * invWeight;
         }
         else
         {
-            pose->m_RelativeTransforms[jointIndex] = joints[jointIndex].LocalTransform;
+            Float3x3 rotation;
+            joints[jointIndex].LocalTransform.DecomposeAll(transform.Position, rotation, transform.Scale);
+            transform.Rotation.FromMatrix(rotation);
         }
-
-        //pose->m_AbsoluteTransforms[jointIndex + 1] = pose->m_AbsoluteTransforms[joints[jointIndex].Parent + 1] * pose->m_RelativeTransforms[jointIndex];
     }
 }
 
-void AnimationBlendMachine::Layer::SampleAnimationTrack(SkeletonResource const* skeleton, SkeletalAnimationTrack const* track, float weight, float position, SkeletonPose* pose) const
+void AnimationBlendMachine::Layer::SampleAnimationTrack(SkeletonResource const* skeleton, SkeletalAnimationTrack const* track, float weight, float position, PoseBlendBuffer& blendBuffer, SkeletonPose* pose) const
 {
     if (!skeleton)
         return;    
@@ -302,30 +455,38 @@ void AnimationBlendMachine::Layer::SampleAnimationTrack(SkeletonResource const*
 
     auto frame = LocateFrame(animation, track->GetPlaybackMode(), track->GetQuantizer(), position);
 
-    CalculateJointTransforms(pose, animation, frame, weight);
+    CalculateJointTransforms(blendBuffer, skeleton->GetJointsCount(), animation, frame, weight);
     pose->m_Bounds.AddAABB(animation->GetBoundingBoxes()[frame.FrameIndex]);
 }
 
-void AnimationInstance::Update(float timeStep, SkeletonPose* pose)
+void AnimationInstance::Update(float timeStep, SkeletonPose* pose, Vector<Transform>* jointTransforms)
 {
     auto skeletonHandle = m_BlendMachine->GetSkeleton();
 
     HK_ASSERT(pose->Skeleton == skeletonHandle);
 
-    SkeletonResource const* skeleton = GameApplication::GetResourceManager().TryGet(skeletonHandle);
+    Update(timeStep, GameApplication::GetResourceManager().TryGet(skeletonHandle), pose, jointTransforms);
+}
+
+void AnimationInstance::Update(float timeStep, SkeletonResource const* skeleton, SkeletonPose* pose, Vector<Transform>* jointTransforms)
+{
+    PoseBlendBuffer blendBuffer;
 
     if (skeleton)
-        SetupPose(pose, skeleton);
+        SetupPose(pose, skeleton, blendBuffer);
 
     for (auto& layer : m_Layers)
     {
         float weight = 1.0f;
-        layer.Update(timeStep, weight, skeleton, pose);
+        layer.Update(timeStep, weight, skeleton, blendBuffer, pose);
     }
 
     if (skeleton)
     {
-        FinalizeJointTransforms(pose, skeleton);
+        FinalizeJointTransforms(pose, skeleton, blendBuffer);
+
+        if (jointTransforms)
+            GatherJointTransforms(skeleton, blendBuffer, *jointTransforms);
 
         if (pose->m_Bounds.IsEmpty())
             pose->m_Bounds = skeleton->GetBindposeBounds();
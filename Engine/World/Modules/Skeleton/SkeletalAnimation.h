@@ -61,6 +61,18 @@ private:
 
 class AnimationInstance;
 
+/// Joint transforms in SoA layout, so blending processes four joints per SIMD operation.
+/// Allocated on the stack during pose evaluation.
+struct alignas(16) PoseBlendBuffer
+{
+    float Rotation[4][MAX_SKELETON_JOINTS];
+    float Position[3][MAX_SKELETON_JOINTS];
+    float Scale[3][MAX_SKELETON_JOINTS];
+    float Weight[MAX_SKELETON_JOINTS];
+
+    void Clear(int jointsCount);
+};
+
 //enum ANIMATION_STATE_FLAGS
 //{
 //    ANIMATION_STATE_DEFAULT = 0,
@@ -110,10 +122,20 @@ public:
         NODE_BLEND
     };
 
+    /// Sample the track and blend it into the pose with the weight
+    struct SampleOp
+    {
+        SkeletalAnimationTrack const* Track;
+        float Weight;
+    };
+
     struct Node
     {
         NODE_TYPE Type;
         Ref<SkeletalAnimationTrack> Track;
+
+        /// Flattened blend tree of the node. Built when the node is added.
+        Vector<SampleOp> Program;
     };
 
     struct BlendPose
@@ -186,6 +208,7 @@ public:
             Node* node = new Node;
             node->Type = NODE_ANIM;
             node->Track = track;
+            node->Program.Add({track, 1.0f});
             m_Nodes.Add(node);
             return NodeHandle(m_Nodes.Size());
         }
@@ -195,6 +218,14 @@ public:
             BlendNode* node = new BlendNode;
             node->Type = NODE_BLEND;
             node->BlendPoses = blendPoses;
+
+            // Nested blend nodes are collapsed into a single list of weighted tracks
+            for (BlendPose const& blendPose : node->BlendPoses)
+            {
+                for (SampleOp const& op : GetNode(blendPose.AnimNode)->Program)
+                    AddSampleOp(node->Program, op.Track, op.Weight * blendPose.Weight);
+            }
+
             m_Nodes.Add(node);
             return NodeHandle(m_Nodes.Size());
         }
@@ -254,26 +285,33 @@ public:
             return nullptr;
         }
 
-        void ProcessNode(Node const* node, float weight, float position, SkeletonResource const* skeleton, SkeletonPose* pose) const
+        static void AddSampleOp(Vector<SampleOp>& program, SkeletalAnimationTrack const* track, float weight)
         {
-            if (weight < std::numeric_limits<float>::epsilon())
-                return;
-
-            if (node->Type == NODE_BLEND)
+            // Same track reached by different paths is sampled once
+            for (SampleOp& op : program)
             {
-                auto blendNode = static_cast<BlendNode const*>(node);
-                for (auto const& blendPose : blendNode->BlendPoses)
+                if (op.Track == track)
                 {
-                    ProcessNode(GetNode(blendPose.AnimNode), weight * blendPose.Weight, position, skeleton, pose);
+                    op.Weight += weight;
+                    return;
                 }
             }
-            else
+            program.Add({track, weight});
+        }
+
+        void ProcessNode(Node const* node, float weight, float position, SkeletonResource const* skeleton, PoseBlendBuffer& blendBuffer, SkeletonPose* pose) const
+        {
+            for (SampleOp const& op : node->Program)
             {
-                SampleAnimationTrack(skeleton, node->Track, weight, position, pose);
+                float opWeight = weight * op.Weight;
+                if (opWeight < std::numeric_limits<float>::epsilon())
+                    continue;
+
+                SampleAnimationTrack(skeleton, op.Track, opWeight, position, blendBuffer, pose);
             }
         }
 
-        void SampleAnimationTrack(SkeletonResource const* skeleton, SkeletalAnimationTrack const* track, float weight, float position, SkeletonPose* pose) const;
+        void SampleAnimationTrack(SkeletonResource const* skeleton, SkeletalAnimationTrack const* track, float weight, float position, PoseBlendBuffer& blendBuffer, SkeletonPose* pose) const;
 
         String m_Name;
 
@@ -356,7 +394,7 @@ public:
             return m_TransitionState;
         }
 
-        void Update(float timeStep, float weight, SkeletonResource const* skeleton, SkeletonPose* pose)
+        void Update(float timeStep, float weight, SkeletonResource const* skeleton, PoseBlendBuffer& blendBuffer, SkeletonPose* pose)
         {
             if (!m_CurrentState.IsValid() || !m_TransitionState.IsValid())
                 return;
@@ -392,8 +430,8 @@ public:
                 m_PlaybackPosition[0] += curTimeStep;
                 m_PlaybackPosition[1] += targetTimeStep;
 
-                m_Layer->ProcessNode(currentNode, weight * (1.0f - transitionBlend), m_PlaybackPosition[0], skeleton, pose);
-                m_Layer->ProcessNode(transitionNode, weight * transitionBlend, m_PlaybackPosition[1], skeleton, pose);
+                m_Layer->ProcessNode(currentNode, weight * (1.0f - transitionBlend), m_PlaybackPosition[0], skeleton, blendBuffer, pose);
+                m_Layer->ProcessNode(transitionNode, weight * transitionBlend, m_PlaybackPosition[1], skeleton, blendBuffer, pose);
 
                 if (m_CurTransitionTime == m_TransitionTime)
                 {
@@ -407,7 +445,7 @@ public:
 
                 State const* current = m_Layer->GetState(m_CurrentState);
                 Node const* currentNode = m_Layer->GetNode(current->Node);
-                m_Layer->ProcessNode(currentNode, weight, m_PlaybackPosition[0], skeleton, pose);
+                m_Layer->ProcessNode(currentNode, weight, m_PlaybackPosition[0], skeleton, blendBuffer, pose);
             }
         }
 
@@ -538,7 +576,11 @@ public:
         return m_Layers[layerIndex].GetState();
     }
 
-    void Update(float timeStep, SkeletonPose* pose);
+    /// If jointTransforms is not null, it also receives the relative joint transforms as position, rotation and scale.
+    void Update(float timeStep, SkeletonPose* pose, Vector<Transform>* jointTransforms = nullptr);
+
+    /// Evaluate the pose for the skeleton resource directly, without resolving the skeleton handle.
+    void Update(float timeStep, SkeletonResource const* skeleton, SkeletonPose* pose, Vector<Transform>* jointTransforms = nullptr);
 
 private:
     Ref<AnimationBlendMachine> m_BlendMachine;
@@ -47,11 +47,11 @@ enum RESOURCE_TYPE : uint8_t
     RESOURCE_FONT,//ok
     RESOURCE_TERRAIN,// ok
     RESOURCE_VIRTUAL_TEXTURE,// todo
+    RESOURCE_NAVMESH,// ok
 
 
     // BAKE:
     //
-    // Navigation Mesh
     // Lightmaps
     // Photometric profiles
     // Envmaps? - can be streamed lod by lod
@@ -37,14 +37,19 @@ SOFTWARE.
 #include "Resource_Font.h"
 #include "Resource_Terrain.h"
 #include "Resource_Sound.h"
+#include "Resource_NavMesh.h"
 
 #include <Engine/Geometry/BV/BvhTree.h>
 #include <Engine/World/Modules/Render/MaterialGraph.h> // TODO: remove dependency
 #include <Engine/GameApplication/GameApplication.h>
 #include <Engine/Core/Platform.h>
+#include <Engine/Core/ConsoleVar.h>
 
 HK_NAMESPACE_BEGIN
 
+ConsoleVar rm_IOThreads("rm_IOThreads"s, "1"s, 0, "Number of threads reading resource files"s);
+ConsoleVar rm_DecodeThreads("rm_DecodeThreads"s, "0"s, 0, "Number of threads decoding resources. 0 - hardware threads not taken by the main thread and job workers, at least two"s);
+
 struct ResourceArea
 {
     ResourceAreaID      m_Id{};
@@ -311,9 +316,27 @@ ResourceManager::ResourceManager()
 
     m_RunAsync.Store(true);
 
-    // TODO: thread pool
-    m_Thread.Start([this]()
-                   { UpdateAsync(); });
+    int numIOThreads = Math::Max(rm_IOThreads.GetInteger(), 1);
+    int numDecodeThreads = rm_DecodeThreads.GetInteger();
+    if (numDecodeThreads <= 0)
+    {
+        // Decode threads run alongside the job workers, so take the cores they leave free. At least two threads
+        // are kept so a large resource doesn't hold back the decoding of the others.
+        int numJobWorkers = GameApplication::GetAsyncJobManager().GetNumWorkerThreads();
+        numDecodeThreads = Math::Max(Thread::NumHardwareThreads - numJobWorkers - 1, 2);
+    }
+
+    for (int i = 0; i < numIOThreads; i++)
+    {
+        m_IOThreads.Add(MakeUnique<Thread>([this]()
+                                           { IOThreadMain(); }));
+    }
+
+    for (int i = 0; i < numDecodeThreads; i++)
+    {
+        m_DecodeThreads.Add(MakeUnique<Thread>([this]()
+                                               { DecodeThreadMain(); }));
+    }
 
     Core::TraverseDirectory(CoreApplication::GetRootPath(), false,
                             [this](StringView fileName, bool bIsDirectory)
@@ -335,9 +358,16 @@ ResourceManager::ResourceManager()
 ResourceManager::~ResourceManager()
 {
     m_RunAsync.Store(false);
+
+    // Each thread passes the signal on to the next one when it exits
     m_StreamQueueEvent.Signal();
+    m_DecodeQueueEvent.Signal();
+
+    for (auto& thread : m_IOThreads)
+        thread->Join();
 
-    m_Thread.Join();
+    for (auto& thread : m_DecodeThreads)
+        thread->Join();
 
     // TODO: Purge resources
 }
@@ -445,35 +475,26 @@ ResourceProxy* ResourceManager::FindResource(StringView resourcePath)
     return &GetProxy(resource);
 }
 
-UniqueRef<ResourceBase> ResourceManager::LoadResourceAsync(RESOURCE_TYPE type, StringView name)
+UniqueRef<ResourceBase> ResourceManager::DecodeResource(RESOURCE_TYPE type, IBinaryStreamReadInterface& stream)
 {
-    File f = OpenFile(name);
-    if (!f)
-        return {};
-
-    //Thread::WaitSeconds(1);
-    //Thread::WaitMilliseconds(100);
-
     switch (type)
     {
         case RESOURCE_MESH:
-            return MakeUnique<MeshResource>(f, this);
+            return MakeUnique<MeshResource>(stream, this);
         case RESOURCE_SKELETON:
-            return MakeUnique<SkeletonResource>(f, this);
+            return MakeUnique<SkeletonResource>(stream, this);
         case RESOURCE_TEXTURE:
-            return MakeUnique<TextureResource>(f, this);
+            return MakeUnique<TextureResource>(stream, this);
         case RESOURCE_MATERIAL:
-            return MakeUnique<MaterialResource>(f, this);
+            return MakeUnique<MaterialResource>(stream, this);
         case RESOURCE_SOUND:
-            return MakeUnique<SoundResource>(f, this);
+            return MakeUnique<SoundResource>(stream, this);
         case RESOURCE_FONT:
-            return MakeUnique<FontResource>(f, this);
+            return MakeUnique<FontResource>(stream, this);
         case RESOURCE_TERRAIN:
-            return MakeUnique<TerrainResource>(f, this);
-#if 0
-        case RESOURCE_SOUND:
-            return LoadSound(name);
-#endif
+            return MakeUnique<TerrainResource>(stream, this);
+        case RESOURCE_NAVMESH:
+            return MakeUnique<NavMeshResource>(stream, this);
         default:
             break;
     }
@@ -481,28 +502,172 @@ UniqueRef<ResourceBase> ResourceManager::LoadResourceAsync(RESOURCE_TYPE type, S
     return {};
 }
 
-void ResourceManager::UpdateAsync()
+void ResourceManager::ResourceStreamQueue::Enqueue(ResourceID resource, RESOURCE_PRIORITY priority)
 {
-    while (m_RunAsync.Load())
+    MutexGuard lock(m_Mutex);
+
+    *m_Queues[priority].Push() = resource;
+    m_Queued[resource] = priority;
+}
+
+bool ResourceManager::ResourceStreamQueue::SetPriority(ResourceID resource, RESOURCE_PRIORITY priority, bool bRaiseOnly)
+{
+    MutexGuard lock(m_Mutex);
+
+    auto it = m_Queued.Find(resource);
+    if (it == m_Queued.End())
+        return false;
+
+    if (it->second == priority || (bRaiseOnly && it->second < priority))
+        return true;
+
+    // The entry in the previous priority class becomes stale and is skipped by Dequeue
+    it->second = priority;
+    *m_Queues[priority].Push() = resource;
+    return true;
+}
+
+bool ResourceManager::ResourceStreamQueue::Cancel(ResourceID resource)
+{
+    MutexGuard lock(m_Mutex);
+
+    auto it = m_Queued.Find(resource);
+    if (it == m_Queued.End())
+        return false;
+
+    m_Queued.Erase(it);
+    return true;
+}
+
+bool ResourceManager::ResourceStreamQueue::Dequeue(ResourceID& resource, RESOURCE_PRIORITY& priority)
+{
+    MutexGuard lock(m_Mutex);
+
+    for (int i = 0; i < RESOURCE_PRIORITY_MAX; i++)
     {
-        ResourceID resource = m_StreamQueue.Dequeue();
-        if (resource)
+        while (ResourceID* entry = m_Queues[i].Pop())
         {
-            auto& proxy = GetProxy(resource);
-            proxy.m_Resource = LoadResourceAsync(RESOURCE_TYPE(resource.GetType()), proxy.GetName());
+            auto it = m_Queued.Find(*entry);
 
-            m_ProcessingQueue.Push(resource);
-            m_ProcessingQueueEvent.Signal();
+            // Skip cancelled and moved entries
+            if (it == m_Queued.End() || it->second != i)
+                continue;
+
+            resource = *entry;
+            priority = RESOURCE_PRIORITY(i);
+
+            m_Queued.Erase(it);
+            return true;
         }
-        else
+    }
+    return false;
+}
+
+bool ResourceManager::ResourceStreamQueue::IsEmpty()
+{
+    MutexGuard lock(m_Mutex);
+
+    return m_Queued.IsEmpty();
+}
+
+ResourceManager::ResourceDecodeQueue::~ResourceDecodeQueue()
+{
+    while (StreamingRequest* request = Dequeue())
+        delete request;
+}
+
+void ResourceManager::ResourceDecodeQueue::Enqueue(StreamingRequest* request)
+{
+    MutexGuard lock(m_Mutex);
+
+    *m_Queues[request->Priority].Push() = request;
+}
+
+ResourceManager::StreamingRequest* ResourceManager::ResourceDecodeQueue::Dequeue()
+{
+    MutexGuard lock(m_Mutex);
+
+    for (int i = 0; i < RESOURCE_PRIORITY_MAX; i++)
+    {
+        if (StreamingRequest** request = m_Queues[i].Pop())
+            return *request;
+    }
+    return nullptr;
+}
+
+bool ResourceManager::ResourceDecodeQueue::IsEmpty()
+{
+    MutexGuard lock(m_Mutex);
+
+    for (int i = 0; i < RESOURCE_PRIORITY_MAX; i++)
+    {
+        if (!m_Queues[i].IsEmpty())
+            return false;
+    }
+    return true;
+}
+
+void ResourceManager::IOThreadMain()
+{
+    while (m_RunAsync.Load())
+    {
+        ResourceID resource;
+        RESOURCE_PRIORITY priority;
+        if (!m_StreamQueue.Dequeue(resource, priority))
         {
-            LOG("Sleep\n");
             m_StreamQueueEvent.Wait();
-            LOG("Awake\n");
-            // TODO: wait event
-            //Thread::WaitMilliseconds(17);
+            continue;
+        }
+
+        // The event wakes up only one thread, so wake up another one if there is more work
+        if (!m_StreamQueue.IsEmpty())
+            m_StreamQueueEvent.Signal();
+
+        StreamingRequest* request = new StreamingRequest;
+        request->Resource = resource;
+        request->Priority = priority;
+        request->Stream = OpenFile(GetProxy(resource).GetName());
+
+        // Read the whole file here so that decoding threads never wait for the disk.
+        // Files from resource packs are already in memory.
+        if (request->Stream.IsFileSystem())
+        {
+            request->Data = request->Stream.AsBlob();
+            request->Stream = File::OpenRead(request->Stream.GetName(), request->Data.GetData(), request->Data.Size());
+        }
+
+        m_DecodeQueue.Enqueue(request);
+        m_DecodeQueueEvent.Signal();
+    }
+
+    m_StreamQueueEvent.Signal();
+}
+
+void ResourceManager::DecodeThreadMain()
+{
+    while (m_RunAsync.Load())
+    {
+        StreamingRequest* request = m_DecodeQueue.Dequeue();
+        if (!request)
+        {
+            m_DecodeQueueEvent.Wait();
+            continue;
         }
+
+        if (!m_DecodeQueue.IsEmpty())
+            m_DecodeQueueEvent.Signal();
+
+        ResourceID resource = request->Resource;
+
+        if (request->Stream)
+            GetProxy(resource).m_Resource = DecodeResource(RESOURCE_TYPE(resource.GetType()), request->Stream);
+
+        delete request;
+
+        m_ProcessingQueue.Push(resource);
     }
+
+    m_DecodeQueueEvent.Signal();
 }
 
 void ResourceManager::MainThread_Update(float timeBudget)
@@ -573,10 +738,12 @@ HK_FORCEINLINE T FetchAdd(T& val, T const& add)
 void ResourceManager::ExecuteCommands()
 {
     m_Refs.Clear();
+    m_LoadPriorities.Clear();
+    m_NewPriorities.Clear();
     m_ReloadResources.Clear();
 
-    m_CommandBufferMutex.Lock();
-    for (Command& command : m_CommandBuffer)
+    Command command;
+    while (m_CommandQueue.TryPop(command))
     {
         switch (command.Type)
         {
@@ -617,6 +784,7 @@ void ResourceManager::ExecuteCommands()
             }
             case Command::LOAD_RESOURCE:
                 m_Refs[ResourceID(command.ResourceOrAreaID)]++;
+                MergeLoadPriority(ResourceID(command.ResourceOrAreaID), command.Priority);
                 break;
             case Command::UNLOAD_RESOURCE:
                 m_Refs[ResourceID(command.ResourceOrAreaID)]--;
@@ -631,6 +799,8 @@ void ResourceManager::ExecuteCommands()
 
                     area->m_Load = true;
                 }
+                for (ResourceID resource : area->m_ResourceList)
+                    MergeLoadPriority(resource, command.Priority);
                 break;
             }
             case Command::UNLOAD_AREA:
@@ -659,10 +829,22 @@ void ResourceManager::ExecuteCommands()
                 }
                 break;
             }
+            case Command::SET_RESOURCE_PRIORITY:
+            {
+                m_NewPriorities[ResourceID(command.ResourceOrAreaID)] = command.Priority;
+                break;
+            }
+            case Command::SET_AREA_PRIORITY:
+            {
+                ResourceArea* area = FetchArea(command.ResourceOrAreaID);
+                for (ResourceID resource : area->m_ResourceList)
+                {
+                    m_NewPriorities[resource] = command.Priority;
+                }
+                break;
+            }
         }
     }
-    m_CommandBuffer.Clear();
-    m_CommandBufferMutex.Unlock();
 
     bool signal = false;
 
@@ -692,7 +874,7 @@ void ResourceManager::ExecuteCommands()
                 {
                     if (proxy.m_State != RESOURCE_STATE_LOAD)
                     {
-                        m_StreamQueue.Enqueue(resource);
+                        m_StreamQueue.Enqueue(resource, GetLoadPriority(resource));
                         signal = true;
 
                         proxy.m_State = RESOURCE_STATE_LOAD;
@@ -715,7 +897,15 @@ void ResourceManager::ExecuteCommands()
                 // Check if resource was sent to loader thread
                 if (proxy.m_State == RESOURCE_STATE_LOAD)
                 {
-                    m_DelayedRelease.Add(resource);
+                    if (m_StreamQueue.Cancel(resource))
+                    {
+                        // Loading has not started yet
+                        proxy.m_State = RESOURCE_STATE_FREE;
+                    }
+                    else
+                    {
+                        m_DelayedRelease.Add(resource);
+                    }
                 }
                 else
                 {
@@ -752,7 +942,7 @@ void ResourceManager::ExecuteCommands()
             }
             case RESOURCE_STATE_FREE:
             {
-                m_StreamQueue.Enqueue(resource);
+                m_StreamQueue.Enqueue(resource, GetLoadPriority(resource));
                 signal = true;
 
                 proxy.m_State = RESOURCE_STATE_LOAD;
@@ -762,10 +952,38 @@ void ResourceManager::ExecuteCommands()
         }
     }
 
+    // A new load request may need the resource sooner than the previous ones
+    for (auto& pair : m_LoadPriorities)
+    {
+        if (GetProxy(pair.first).m_State == RESOURCE_STATE_LOAD)
+            m_StreamQueue.SetPriority(pair.first, pair.second, true);
+    }
+
+    for (auto& pair : m_NewPriorities)
+    {
+        if (GetProxy(pair.first).m_State == RESOURCE_STATE_LOAD)
+            m_StreamQueue.SetPriority(pair.first, pair.second, false);
+    }
+
     if (signal)
         m_StreamQueueEvent.Signal();
 }
 
+void ResourceManager::MergeLoadPriority(ResourceID resource, RESOURCE_PRIORITY priority)
+{
+    auto it = m_LoadPriorities.Find(resource);
+    if (it == m_LoadPriorities.End())
+        m_LoadPriorities[resource] = priority;
+    else if (priority < it->second)
+        it->second = priority;
+}
+
+RESOURCE_PRIORITY ResourceManager::GetLoadPriority(ResourceID resource) const
+{
+    auto it = m_LoadPriorities.Find(resource);
+    return it != m_LoadPriorities.End() ? it->second : RESOURCE_PRIORITY_NORMAL;
+}
+
 void ResourceManager::ReleaseResource(ResourceID resource)
 {
     ResourceProxy& proxy = GetProxy(resource);
@@ -859,8 +1077,7 @@ ResourceArea* ResourceManager::FetchArea(ResourceAreaID areaID)
 
 void ResourceManager::AddCommand(Command const& command)
 {
-    MutexGuard lock(m_CommandBufferMutex);
-    m_CommandBuffer.Add(command);
+    m_CommandQueue.Push(command);
 }
 
 namespace
@@ -916,13 +1133,14 @@ void ResourceManager::DestroyResourceArea(ResourceAreaID area)
     AddCommand(command);
 }
 
-void ResourceManager::LoadArea(ResourceAreaID area)
+void ResourceManager::LoadArea(ResourceAreaID area, RESOURCE_PRIORITY priority)
 {
     if (!area)
         return;
 
     Command command;
     command.Type = Command::LOAD_AREA;
+    command.Priority = priority;
     command.ResourceOrAreaID = area;
 
     AddCommand(command);
@@ -952,13 +1170,14 @@ void ResourceManager::ReloadArea(ResourceAreaID area)
     AddCommand(command);
 }
 
-bool ResourceManager::LoadResource(ResourceID resource)
+bool ResourceManager::LoadResource(ResourceID resource, RESOURCE_PRIORITY priority)
 {
     if (!resource.IsValid())
         return false;
     
     Command command;
     command.Type = Command::LOAD_RESOURCE;
+    command.Priority = priority;
     command.ResourceOrAreaID = resource;
 
     AddCommand(command);
@@ -994,6 +1213,32 @@ bool ResourceManager::ReloadResource(ResourceID resource)
     return true;
 }
 
+void ResourceManager::SetAreaPriority(ResourceAreaID area, RESOURCE_PRIORITY priority)
+{
+    if (!area)
+        return;
+
+    Command command;
+    command.Type = Command::SET_AREA_PRIORITY;
+    command.Priority = priority;
+    command.ResourceOrAreaID = area;
+
+    AddCommand(command);
+}
+
+void ResourceManager::SetResourcePriority(ResourceID resource, RESOURCE_PRIORITY priority)
+{
+    if (!resource.IsValid())
+        return;
+
+    Command command;
+    command.Type = Command::SET_RESOURCE_PRIORITY;
+    command.Priority = priority;
+    command.ResourceOrAreaID = resource;
+
+    AddCommand(command);
+}
+
 bool ResourceManager::IsAreaReady(ResourceAreaID areaID)
 {
     ResourceArea* area = FetchArea(areaID);
@@ -1016,7 +1261,7 @@ void ResourceManager::MainThread_WaitResourceArea(ResourceAreaID areaID)
         if (area->IsReady())
             break;
 
-        m_ProcessingQueueEvent.Wait();
+        m_ProcessingQueue.Wait();
     }
 }
 
@@ -1036,7 +1281,7 @@ void ResourceManager::MainThread_WaitResource(ResourceID resource)
         if (proxy.IsReady())
             break;
 
-        m_ProcessingQueueEvent.Wait();
+        m_ProcessingQueue.Wait();
     }
 }
 
@@ -34,18 +34,32 @@ SOFTWARE.
 #include <Engine/Core/Containers/ArrayView.h>
 #include <Engine/Core/Containers/PagedVector.h>
 #include <Engine/Core/Containers/Hash.h>
+#include <Engine/Core/Containers/PodQueue.h>
+#include <Engine/Core/Containers/MPSCQueue.h>
+#include <Engine/Core/Containers/WaitableQueue.h>
 
 #include "ResourceHandle.h"
 #include "ResourceProxy.h"
 
-#include "ThreadSafeQueue.h"
-
 HK_NAMESPACE_BEGIN
 
 using ResourceAreaID = uint32_t;
 
 struct ResourceArea;
 
+/// Loading priority class. Queued loads are served from the highest class first.
+enum RESOURCE_PRIORITY : uint8_t
+{
+    /// The resource is needed right now, e.g. it is visible
+    RESOURCE_PRIORITY_CRITICAL,
+    RESOURCE_PRIORITY_HIGH,
+    RESOURCE_PRIORITY_NORMAL,
+    /// The resource may be needed soon
+    RESOURCE_PRIORITY_PREFETCH,
+
+    RESOURCE_PRIORITY_MAX
+};
+
 class ResourceManager final
 {
 public:
@@ -60,17 +74,23 @@ public:
     ResourceAreaID          CreateResourceArea(ArrayView<ResourceID> resourceList);
     void                    DestroyResourceArea(ResourceAreaID area);
 
-    void                    LoadArea(ResourceAreaID area);
+    void                    LoadArea(ResourceAreaID area, RESOURCE_PRIORITY priority = RESOURCE_PRIORITY_NORMAL);
     void                    UnloadArea(ResourceAreaID area);
     void                    ReloadArea(ResourceAreaID area);
 
-    bool                    LoadResource(ResourceID resource);
+    bool                    LoadResource(ResourceID resource, RESOURCE_PRIORITY priority = RESOURCE_PRIORITY_NORMAL);
     bool                    UnloadResource(ResourceID resource);
     bool                    ReloadResource(ResourceID resource);
 
+    /// Changes the priority of queued loads. Has no effect on resources that are already being loaded.
+    void                    SetAreaPriority(ResourceAreaID area, RESOURCE_PRIORITY priority);
+
+    /// Changes the priority of a queued load. Has no effect on a resource that is already being loaded.
+    void                    SetResourcePriority(ResourceID resource, RESOURCE_PRIORITY priority);
+
     /// Enques a resource to unload, increases the usage counter
     template <typename T>
-    ResourceHandle<T>       LoadResource(StringView name);
+    ResourceHandle<T>       LoadResource(StringView name, RESOURCE_PRIORITY priority = RESOURCE_PRIORITY_NORMAL);
 
     /// Enques a resource to unload, decreases the usage counter, unloads if the usage counter == 0
     template <typename T>
@@ -134,14 +154,69 @@ private:
             UNLOAD_AREA,
             RELOAD_RESOURCE,
             RELOAD_AREA,
+            SET_RESOURCE_PRIORITY,
+            SET_AREA_PRIORITY,
         };
         TYPE        Type;
+        RESOURCE_PRIORITY Priority{RESOURCE_PRIORITY_NORMAL};
         uint32_t    ResourceOrAreaID;
     };
 
-    void                    UpdateAsync();
+    struct StreamingRequest
+    {
+        ResourceID          Resource;
+        RESOURCE_PRIORITY   Priority;
+        File                Stream;
+        HeapBlob            Data;
+    };
+
+    /// Resources waiting for I/O. Queued loads can be reprioritized or cancelled.
+    class ResourceStreamQueue
+    {
+    public:
+        void Enqueue(ResourceID resource, RESOURCE_PRIORITY priority);
+
+        /// Moves a queued resource to another priority class. Returns false if the resource is not queued.
+        bool SetPriority(ResourceID resource, RESOURCE_PRIORITY priority, bool bRaiseOnly);
+
+        /// Removes a resource from the queue. Returns false if the resource has already been taken by a loader.
+        bool Cancel(ResourceID resource);
+
+        bool Dequeue(ResourceID& resource, RESOURCE_PRIORITY& priority);
+
+        bool IsEmpty();
+
+    private:
+        Mutex m_Mutex;
+        PodQueue<ResourceID, 256, true> m_Queues[RESOURCE_PRIORITY_MAX];
+        /// Current priority class of each queued resource. Entries left behind in other classes are stale.
+        HashMap<ResourceID, RESOURCE_PRIORITY> m_Queued;
+    };
+
+    /// Files waiting for decoding.
+    class ResourceDecodeQueue
+    {
+    public:
+        ~ResourceDecodeQueue();
+
+        void Enqueue(StreamingRequest* request);
+
+        StreamingRequest* Dequeue();
+
+        bool IsEmpty();
 
-    UniqueRef<ResourceBase> LoadResourceAsync(RESOURCE_TYPE type, StringView name);
+    private:
+        Mutex m_Mutex;
+        PodQueue<StreamingRequest*, 256, true> m_Queues[RESOURCE_PRIORITY_MAX];
+    };
+
+    /// Reads files of the queued resources into memory.
+    void                    IOThreadMain();
+
+    /// Creates resources from the files read by the I/O threads.
+    void                    DecodeThreadMain();
+
+    UniqueRef<ResourceBase> DecodeResource(RESOURCE_TYPE type, IBinaryStreamReadInterface& stream);
 
     /** Find file in resource packs */
     bool                    FindFile(StringView fileName, int* pResourcePackIndex, FileHandle* pFileHandle) const;
@@ -156,6 +231,9 @@ private:
 
     void                    ReleaseResource(ResourceID resource);
 
+    void                    MergeLoadPriority(ResourceID resource, RESOURCE_PRIORITY priority);
+    RESOURCE_PRIORITY       GetLoadPriority(ResourceID resource) const;
+
     void                    IncrementAreas(ResourceProxy& proxy);
     void                    DecrementAreas(ResourceProxy& proxy);
 
@@ -166,40 +244,25 @@ private:
 
     Vector<ResourceID>      m_DelayedRelease;
 
-    class ResourceStreamQueue
-    {
-    public:
-        void Enqueue(ResourceID resource)
-        {
-            m_Queue.Push(resource);
-        }
-
-        ResourceID Dequeue()
-        {
-            ResourceID resource;
-            m_Queue.TryPop(resource);
-            return resource;
-        }
-
-        ThreadSafeQueue<ResourceID> m_Queue;
-    };
-
     ResourceStreamQueue     m_StreamQueue;
-    ThreadSafeQueue<ResourceID> m_ProcessingQueue;
+    ResourceDecodeQueue     m_DecodeQueue;
+    WaitableQueue<MPSCQueue<ResourceID>> m_ProcessingQueue;
     SyncEvent               m_StreamQueueEvent;
-    SyncEvent               m_ProcessingQueueEvent;
+    SyncEvent               m_DecodeQueueEvent;
 
     Vector<ResourceArea*>   m_ResourceAreas;
     Vector<uint32_t>        m_ResourceAreaFreeList;
     Mutex                   m_ResourceAreaAllocMutex;
 
-    Vector<Command>         m_CommandBuffer;
-    Mutex                   m_CommandBufferMutex;    
+    MPSCQueue<Command>      m_CommandQueue;
 
     HashMap<ResourceID, int> m_Refs;
+    HashMap<ResourceID, RESOURCE_PRIORITY> m_LoadPriorities;
+    HashMap<ResourceID, RESOURCE_PRIORITY> m_NewPriorities;
     HashSet<ResourceID>     m_ReloadResources;
 
-    Thread                  m_Thread;
+    Vector<UniqueRef<Thread>> m_IOThreads;
+    Vector<UniqueRef<Thread>> m_DecodeThreads;
     AtomicBool              m_RunAsync;
 
     Vector<Archive>         m_ResourcePacks;
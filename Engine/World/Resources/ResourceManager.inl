@@ -33,10 +33,10 @@ SOFTWARE.
 HK_NAMESPACE_BEGIN
 
 template <typename T>
-ResourceHandle<T> ResourceManager::LoadResource(StringView name)
+ResourceHandle<T> ResourceManager::LoadResource(StringView name, RESOURCE_PRIORITY priority)
 {
     ResourceHandle<T> resource = GetResource<T>(name);
-    LoadResource(resource);
+    LoadResource(resource, priority);
     return resource;
 }
 
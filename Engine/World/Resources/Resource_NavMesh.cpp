@@ -0,0 +1,179 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Resource_NavMesh.h"
+
+#include <Engine/Core/Logger.h>
+
+HK_NAMESPACE_BEGIN
+
+void NavMeshResource::Tile::Read(IBinaryStreamReadInterface& stream)
+{
+    X = stream.ReadInt32();
+    Z = stream.ReadInt32();
+    GeometryHash = stream.ReadUInt64();
+    FirstLayer = stream.ReadUInt32();
+    NumLayers = stream.ReadUInt32();
+}
+
+void NavMeshResource::Tile::Write(IBinaryStreamWriteInterface& stream) const
+{
+    stream.WriteInt32(X);
+    stream.WriteInt32(Z);
+    stream.WriteUInt64(GeometryHash);
+    stream.WriteUInt32(FirstLayer);
+    stream.WriteUInt32(NumLayers);
+}
+
+void NavMeshResource::Layer::Read(IBinaryStreamReadInterface& stream)
+{
+    Offset = stream.ReadUInt32();
+    Size = stream.ReadUInt32();
+}
+
+void NavMeshResource::Layer::Write(IBinaryStreamWriteInterface& stream) const
+{
+    stream.WriteUInt32(Offset);
+    stream.WriteUInt32(Size);
+}
+
+NavMeshResource::NavMeshResource(IBinaryStreamReadInterface& stream, ResourceManager* resManager)
+{
+    Read(stream, resManager);
+}
+
+NavMeshResource::NavMeshResource(uint64_t settingsHash, bool isDynamic) :
+    m_SettingsHash(settingsHash),
+    m_IsDynamic(isDynamic)
+{}
+
+bool NavMeshResource::Read(IBinaryStreamReadInterface& stream, ResourceManager* resManager)
+{
+    uint32_t fileMagic = stream.ReadUInt32();
+
+    if (fileMagic != MakeResourceMagic(Type, Version))
+    {
+        LOG("Unexpected file format\n");
+        return false;
+    }
+
+    m_SettingsHash = stream.ReadUInt64();
+    m_IsDynamic = stream.ReadBool();
+
+    stream.ReadArray(m_Tiles);
+    stream.ReadArray(m_Layers);
+
+    uint32_t dataSize = stream.ReadUInt32();
+    m_Data.ResizeInvalidate(dataSize);
+    if (stream.Read(m_Data.ToPtr(), dataSize) != dataSize)
+    {
+        LOG("NavMeshResource::Read: Unexpected end of file\n");
+        m_Tiles.Clear();
+        m_Layers.Clear();
+        m_Data.Clear();
+        return false;
+    }
+
+    for (Layer const& layer : m_Layers)
+    {
+        if (uint64_t(layer.Offset) + layer.Size > dataSize || (layer.Offset & (DataAlignment - 1)))
+        {
+            LOG("NavMeshResource::Read: Invalid layer\n");
+            m_Tiles.Clear();
+            m_Layers.Clear();
+            m_Data.Clear();
+            return false;
+        }
+    }
+
+    m_TileLookup.Clear();
+    for (uint32_t i = 0; i < m_Tiles.Size(); ++i)
+    {
+        Tile const& tile = m_Tiles[i];
+        if (uint64_t(tile.FirstLayer) + tile.NumLayers > m_Layers.Size())
+        {
+            LOG("NavMeshResource::Read: Invalid tile\n");
+            continue;
+        }
+        m_TileLookup[MakeTileKey(tile.X, tile.Z)] = i;
+    }
+
+    return true;
+}
+
+void NavMeshResource::Write(IBinaryStreamWriteInterface& stream) const
+{
+    stream.WriteUInt32(MakeResourceMagic(Type, Version));
+    stream.WriteUInt64(m_SettingsHash);
+    stream.WriteBool(m_IsDynamic);
+    stream.WriteArray(m_Tiles);
+    stream.WriteArray(m_Layers);
+    stream.WriteUInt32(m_Data.Size());
+    stream.Write(m_Data.ToPtr(), m_Data.Size());
+}
+
+void NavMeshResource::AddTile(int x, int z, uint64_t geometryHash, ArrayView<ArrayView<uint8_t>> layers)
+{
+    uint64_t key = MakeTileKey(x, z);
+    if (m_TileLookup.Find(key) != m_TileLookup.End())
+    {
+        LOG("NavMeshResource::AddTile: Tile {} {} is already added\n", x, z);
+        return;
+    }
+
+    m_TileLookup[key] = m_Tiles.Size();
+
+    Tile& tile = m_Tiles.Add();
+    tile.X = x;
+    tile.Z = z;
+    tile.GeometryHash = geometryHash;
+    tile.FirstLayer = m_Layers.Size();
+    tile.NumLayers = layers.Size();
+
+    for (ArrayView<uint8_t> const& data : layers)
+    {
+        Layer& layer = m_Layers.Add();
+        layer.Offset = Align(m_Data.Size(), DataAlignment);
+        layer.Size = data.Size();
+
+        m_Data.Resize(layer.Offset + layer.Size);
+        Core::Memcpy(m_Data.ToPtr() + layer.Offset, data.ToPtr(), data.Size());
+    }
+}
+
+NavMeshResource::Tile const* NavMeshResource::FindTile(int x, int z) const
+{
+    auto it = m_TileLookup.Find(MakeTileKey(x, z));
+    if (it == m_TileLookup.End())
+        return nullptr;
+    return &m_Tiles[it->second];
+}
+
+HK_NAMESPACE_END
@@ -0,0 +1,116 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "ResourceHandle.h"
+#include "ResourceBase.h"
+
+#include <Engine/Core/BinaryStream.h>
+#include <Engine/Core/Containers/ArrayView.h>
+#include <Engine/Core/Containers/Hash.h>
+#include <Engine/Core/Containers/Vector.h>
+
+HK_NAMESPACE_BEGIN
+
+/// Baked navmesh tiles. Each tile keeps the hash of the geometry it was built from, so NavMeshInterface
+/// rebuilds only the tiles whose input has changed.
+class NavMeshResource : public ResourceBase
+{
+public:
+    static const uint8_t Type = RESOURCE_NAVMESH;
+    static const uint8_t Version = 1;
+
+    /// Tile data offsets are aligned to this value
+    static constexpr uint32_t DataAlignment = 16;
+
+    struct Tile
+    {
+        int32_t             X;
+        int32_t             Z;
+        uint64_t            GeometryHash;
+        uint32_t            FirstLayer;
+        /// Zero for a tile without walkable surface
+        uint32_t            NumLayers;
+
+        void Read(IBinaryStreamReadInterface& stream);
+        void Write(IBinaryStreamWriteInterface& stream) const;
+    };
+
+    /// Detour tile data for static navmesh or a compressed tile cache layer for dynamic navmesh
+    struct Layer
+    {
+        uint32_t            Offset;
+        uint32_t            Size;
+
+        void Read(IBinaryStreamReadInterface& stream);
+        void Write(IBinaryStreamWriteInterface& stream) const;
+    };
+
+    NavMeshResource() = default;
+    NavMeshResource(IBinaryStreamReadInterface& stream, class ResourceManager* resManager);
+    NavMeshResource(uint64_t settingsHash, bool isDynamic);
+
+    bool Read(IBinaryStreamReadInterface& stream, ResourceManager* resManager);
+
+    void Write(IBinaryStreamWriteInterface& stream) const;
+
+    /// Adds a tile. The layers are copied.
+    void AddTile(int x, int z, uint64_t geometryHash, ArrayView<ArrayView<uint8_t>> layers);
+
+    Tile const* FindTile(int x, int z) const;
+
+    Vector<Tile> const& GetTiles() const { return m_Tiles; }
+
+    Vector<Layer> const& GetLayers() const { return m_Layers; }
+
+    /// Layer data stays valid while the resource is loaded
+    const uint8_t* GetLayerData(Layer const& layer) const { return m_Data.ToPtr() + layer.Offset; }
+
+    /// Hash of the navmesh settings the tiles were built with
+    uint64_t GetSettingsHash() const { return m_SettingsHash; }
+
+    bool IsDynamic() const { return m_IsDynamic; }
+
+private:
+    static uint64_t MakeTileKey(int x, int z) { return uint64_t(uint32_t(x)) | (uint64_t(uint32_t(z)) << 32); }
+
+    uint64_t                m_SettingsHash = 0;
+    bool                    m_IsDynamic = false;
+    Vector<Tile>            m_Tiles;
+    Vector<Layer>           m_Layers;
+    /// All layers in one allocation, read from the file at once
+    Vector<uint8_t>         m_Data;
+    HashMap<uint64_t, uint32_t> m_TileLookup;
+};
+
+using NavMeshHandle = ResourceHandle<NavMeshResource>;
+
+HK_NAMESPACE_END
@@ -33,9 +33,9 @@ SOFTWARE.
 
 HK_NAMESPACE_BEGIN
 
-SkeletalAnimation::SkeletalAnimation(IBinaryStreamReadInterface& stream)
+SkeletalAnimation::SkeletalAnimation(IBinaryStreamReadInterface& stream, uint8_t version)
 {
-    Read(stream);
+    Read(stream, version);
 }
 
 SkeletalAnimation::SkeletalAnimation(int frameCount, float frameDelta, Transform const* transforms, int transformsCount, AnimationChannel const* animatedJoints, int numAnimatedJoints, BvAxisAlignedBox const* bounds)
@@ -65,13 +65,66 @@ void SkeletalAnimation::Initialize()
     m_bIsAnimationValid  = m_FrameCount > 0 && !m_Channels.IsEmpty();
 }
 
-void SkeletalAnimation::Read(IBinaryStreamReadInterface& stream)
+void SkeletalAnimation::Compress(AnimationCompressionSettings const& settings)
+{
+    if (IsCompressed() || !m_bIsAnimationValid)
+        return;
+
+    m_Compressed.Compress(m_FrameCount, m_Transforms.ToPtr(), m_Channels.ToPtr(), m_Channels.Size(), settings);
+
+    m_Transforms.Free();
+}
+
+void SkeletalAnimation::SampleChannels(float frame, Transform* outTransforms) const
+{
+    if (IsCompressed())
+    {
+        m_Compressed.Sample(frame, outTransforms);
+        return;
+    }
+
+    frame = Math::Clamp(frame, 0.0f, (float)(m_FrameCount - 1));
+
+    int frameIndex = (int)frame;
+    int nextFrameIndex = Math::Min(frameIndex + 1, m_FrameCount - 1);
+    float blend = frame - frameIndex;
+
+    for (int channelIndex = 0; channelIndex < m_Channels.Size(); channelIndex++)
+    {
+        Transform const* transforms = m_Transforms.ToPtr() + m_Channels[channelIndex].TransformOffset;
+
+        if (frameIndex == nextFrameIndex || blend < 0.0001f)
+        {
+            outTransforms[channelIndex] = transforms[frameIndex];
+        }
+        else
+        {
+            Transform const& frame1 = transforms[frameIndex];
+            Transform const& frame2 = transforms[nextFrameIndex];
+
+            outTransforms[channelIndex].Position = Math::Lerp(frame1.Position, frame2.Position, blend);
+            outTransforms[channelIndex].Rotation = Math::Slerp(frame1.Rotation, frame2.Rotation, blend);
+            outTransforms[channelIndex].Scale = Math::Lerp(frame1.Scale, frame2.Scale, blend);
+        }
+    }
+}
+
+void SkeletalAnimation::Read(IBinaryStreamReadInterface& stream, uint8_t version)
 {
     m_Name = stream.ReadString();
     m_FrameDelta = stream.ReadFloat();
     m_FrameCount = stream.ReadUInt32();
     stream.ReadArray(m_Channels);
-    stream.ReadArray(m_Transforms);
+    if (version >= 2 && stream.ReadBool())
+    {
+        m_Transforms.Clear();
+        m_Compressed.Read(stream);
+    }
+    else
+    {
+        m_Compressed = {};
+        stream.ReadArray(m_Transforms);
+    }
     stream.ReadArray(m_Bounds);
 
     Initialize();
@@ -83,7 +136,11 @@ void SkeletalAnimation::Write(IBinaryStreamWriteInterface& stream) const
     stream.WriteFloat(m_FrameDelta);
     stream.WriteUInt32(m_FrameCount);
     stream.WriteArray(m_Channels);
-    stream.WriteArray(m_Transforms);
+    stream.WriteBool(IsCompressed());
+    if (IsCompressed())
+        m_Compressed.Write(stream);
+    else
+        stream.WriteArray(m_Transforms);
     stream.WriteArray(m_Bounds);
 }
 
@@ -132,7 +189,13 @@ bool SkeletonResource::Read(IBinaryStreamReadInterface& stream, ResourceManager*
 {
     uint32_t fileMagic = stream.ReadUInt32();
 
-    if (fileMagic != MakeResourceMagic(Type, Version))
+    // Version 1 skeletons are still accepted, their animations are uncompressed
+    uint8_t version;
+    if (fileMagic == MakeResourceMagic(Type, Version))
+        version = Version;
+    else if (fileMagic == MakeResourceMagic(Type, 1))
+        version = 1;
+    else
     {
         LOG("Unexpected file format\n");
         return false;
@@ -146,7 +209,7 @@ bool SkeletonResource::Read(IBinaryStreamReadInterface& stream, ResourceManager*
     m_Animations.Reserve(numAnimations);
     for (uint32_t i = 0 ; i < numAnimations ; ++i)
     {
-        m_Animations.Add(MakeRef<SkeletalAnimation>(stream));
+        m_Animations.Add(MakeRef<SkeletalAnimation>(stream, version));
     }
 
     // -------------- TEST -------------------
@@ -34,6 +34,7 @@ SOFTWARE.
 #include "ResourceBase.h"
 
 #include <Engine/Geometry/Skinning.h>
+#include <Engine/Geometry/AnimationCompression.h>
 #include <Engine/Geometry/IK/FABRIKSolver.h>
 
 #include <Engine/Core/Containers/ArrayView.h>
@@ -47,7 +48,7 @@ class SkeletalAnimation : public RefCounted
 {
 public:
     SkeletalAnimation() = default;
-    SkeletalAnimation(IBinaryStreamReadInterface& stream);
+    SkeletalAnimation(IBinaryStreamReadInterface& stream, uint8_t version);
     SkeletalAnimation(int frameCount, float frameDelta, Transform const* transforms, int transformsCount, AnimationChannel const* animatedJoints, int numAnimatedJoints, BvAxisAlignedBox const* bounds);
 
     StringView GetName() const { return m_Name; }
@@ -63,7 +64,18 @@ public:
     Vector<BvAxisAlignedBox> const& GetBoundingBoxes() const { return m_Bounds; }
     bool IsValid() const { return m_bIsAnimationValid; }
 
-    void Read(IBinaryStreamReadInterface& stream);
+    /// Quantize animation tracks. Source transforms are released.
+    void Compress(AnimationCompressionSettings const& settings);
+
+    bool IsCompressed() const { return !m_Compressed.IsEmpty(); }
+
+    CompressedAnimation const& GetCompressed() const { return m_Compressed; }
+
+    /// Sample local transforms of all channels at fractional frame index. Transforms are ordered as channels.
+    void SampleChannels(float frame, Transform* outTransforms) const;
+
+    /// Version 1 animations have no compressed flag and are always uncompressed.
+    void Read(IBinaryStreamReadInterface& stream, uint8_t version);
 
     void Write(IBinaryStreamWriteInterface& stream) const;
 
@@ -73,6 +85,7 @@ public:
     String m_Name;
     Vector<AnimationChannel> m_Channels;
     Vector<Transform> m_Transforms;
+    CompressedAnimation m_Compressed;
     Vector<BvAxisAlignedBox> m_Bounds;
     int m_FrameCount = 0;           // frames count
     float m_FrameDelta = 0;         // fixed time delta between frames
@@ -86,7 +99,7 @@ class SkeletonResource : public ResourceBase
 {
 public:
     static const uint8_t Type = RESOURCE_SKELETON;
-    static const uint8_t Version = 1;
+    static const uint8_t Version = 2;
 
     SkeletonResource() = default;
     SkeletonResource(IBinaryStreamReadInterface& stream, ResourceManager* resManager);
@@ -140,8 +153,6 @@ struct SkeletonPose : RefCounted
 {
     SkeletonHandle Skeleton;
 
-    float SummaryWeights[MAX_SKELETON_JOINTS];
-
     Vector<Float3x4> m_RelativeTransforms;
     Vector<Float3x4> m_AbsoluteTransforms;
 
@@ -154,6 +165,21 @@ struct SkeletonPose : RefCounted
 
     BvAxisAlignedBox m_Bounds;
 
+    // Written by the render frontend for each view the pose is drawn in. Used to select the update rate of the pose.
+    int m_VisibleFrame = 0;
+    float m_ViewDistance = 0;
+
+    void MarkVisible(int frameNumber, float viewDistance)
+    {
+        if (m_VisibleFrame != frameNumber)
+        {
+            m_VisibleFrame = frameNumber;
+            m_ViewDistance = viewDistance;
+        }
+        else
+            m_ViewDistance = Math::Min(m_ViewDistance, viewDistance);
+    }
+
     Float3x4 const& GetJointTransform(uint32_t jointIndex) const
     {
         //HK_ASSERT(jointIndex + 1 < m_AbsoluteTransforms.Size());
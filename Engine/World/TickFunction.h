@@ -49,7 +49,14 @@ struct TickFunctionDesc
 {
     StringID                    Name;
     bool                        TickEvenWhenPaused = false;
+    /// The function can run on a worker thread, concurrently with functions it has no dependency with.
+    bool                        ThreadSafe = false;
     SmallVector<uint32_t, 4>    Prerequisites;
+    /// Optional data access declarations (component or interface type IDs). Used to detect data races between
+    /// functions that can run concurrently. The owner type of the function is always treated as written.
+    /// A function that is not thread safe and declares nothing is ordered with all thread safe functions.
+    SmallVector<uint32_t, 4>    Reads;
+    SmallVector<uint32_t, 4>    Writes;
 
     template <typename ComponentType>
     void AddPrerequisiteComponent()
@@ -63,6 +70,30 @@ struct TickFunctionDesc
         // Use high bit to mark interface
         Prerequisites.Add(InterfaceRTTR::TypeID<InterfaceType> | (1 << 31));
     }
+
+    template <typename ComponentType>
+    void AddReadComponent()
+    {
+        Reads.Add(ComponentRTTR::TypeID<ComponentType>);
+    }
+
+    template <typename ComponentType>
+    void AddWriteComponent()
+    {
+        Writes.Add(ComponentRTTR::TypeID<ComponentType>);
+    }
+
+    template <typename InterfaceType>
+    void AddReadInterface()
+    {
+        Reads.Add(InterfaceRTTR::TypeID<InterfaceType> | (1 << 31));
+    }
+
+    template <typename InterfaceType>
+    void AddWriteInterface()
+    {
+        Writes.Add(InterfaceRTTR::TypeID<InterfaceType> | (1 << 31));
+    }
 };
 
 struct TickFunction
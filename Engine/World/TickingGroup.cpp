@@ -31,8 +31,25 @@ SOFTWARE.
 #include "TickingGroup.h"
 #include "WorldTick.h"
 
+#include <Engine/Core/ConsoleVar.h>
+#include <Engine/Core/Logger.h>
+#include <Engine/Core/Platform.h>
+#include <Engine/GameApplication/GameApplication.h>
+
 HK_NAMESPACE_BEGIN
 
+ConsoleVar com_ParallelTick("com_ParallelTick"s, "1"s, 0, "Run thread-safe tick functions on worker threads"s);
+
+namespace
+{
+constexpr uint32_t NO_PREREQUISITE = ~0u;
+}
+
+TickingGroup::~TickingGroup()
+{
+    delete[] m_PendingPrerequisites;
+}
+
 void TickingGroup::AddFunction(TickFunction const& f)
 {
     Function& function = m_FunctionList.EmplaceBack();
@@ -41,6 +58,10 @@ void TickingGroup::AddFunction(TickFunction const& f)
     function.Delegate = f.Delegate;
     function.OwnerTypeID = f.OwnerTypeID;
     function.TraverseID = m_TraverseID;
+    function.NumPrerequisites = 0;
+    function.Duration = 0;
+    function.FinishTime = 0;
+    function.CriticalPrerequisite = NO_PREREQUISITE;
 
     m_RebuildRequired = true;
 }
@@ -50,17 +71,243 @@ void TickingGroup::Dispatch(WorldTick& tick)
     if (m_RebuildRequired)
         Rebuild();
 
+    m_IsPaused = tick.IsPaused;
+
     //LOG("---------------------------------------\n");
 
+    if (com_ParallelTick && m_HasThreadSafeFunctions)
+        DispatchParallel();
+    else
+        DispatchSerial();
+
+    UpdateCriticalPath();
+}
+
+void TickingGroup::DispatchSerial()
+{
     for (uint32_t index = 0; index < m_ExecutionOrder.Size(); ++index)
     {
-        auto& f = m_FunctionList[m_ExecutionOrder[index]];
-        if (!tick.IsPaused || f.Desc.TickEvenWhenPaused)
+        ExecuteFunction(m_ExecutionOrder[index]);
+    }
+}
+
+void TickingGroup::DispatchParallel()
+{
+    AsyncJobCounter counter;
+
+    m_JobManager = &GameApplication::GetAsyncJobManager();
+    m_JobCounter = &counter;
+
+    m_NumCompleted.Store(0);
+    m_MainThreadQueue.Clear();
+    m_MainThreadQueueHead = 0;
+
+    uint32_t functionCount = m_FunctionList.Size();
+    for (uint32_t index = 0; index < functionCount; ++index)
+        m_PendingPrerequisites[index].Store(m_FunctionList[index].NumPrerequisites);
+
+    for (uint32_t index : m_ExecutionOrder)
+    {
+        if (m_FunctionList[index].NumPrerequisites == 0)
+            ScheduleFunction(index);
+    }
+
+    // Functions that are not thread-safe are executed here, in the calling thread.
+    // While there is nothing for us, help the workers.
+    while (m_NumCompleted.Load() < functionCount)
+    {
+        uint32_t index;
+        if (PopMainThreadFunction(index))
+        {
+            ExecuteFunction(index);
+            CompleteFunction(index);
+        }
+        else if (!m_JobManager->ExecutePendingJob())
+        {
+            YieldCPU();
+        }
+    }
+
+    // The last jobs can still be returning from their callbacks
+    m_JobManager->WaitForCounter(counter);
+
+    m_JobCounter = nullptr;
+}
+
+void TickingGroup::ExecuteFunction(uint32_t index)
+{
+    Function& function = m_FunctionList[index];
+    if (!m_IsPaused || function.Desc.TickEvenWhenPaused)
+    {
+        //LOG("EXECUTE: {}\n", function.Desc.Name.GetStringView());
+
+        int64_t startTime = Core::SysMicroseconds();
+        function.Delegate.Invoke();
+        function.Duration = Core::SysMicroseconds() - startTime;
+    }
+    else
+    {
+        function.Duration = 0;
+    }
+}
+
+void TickingGroup::CompleteFunction(uint32_t index)
+{
+    for (uint32_t successor : m_FunctionList[index].Successors)
+    {
+        if (m_PendingPrerequisites[successor].Decrement() == 0)
         {
-            //LOG("EXECUTE: {}\n", f.Function.Desc.Name);
-            f.Delegate.Invoke();
+            // Make the results of all prerequisites visible to the successor
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            ScheduleFunction(successor);
         }
     }
+
+    m_NumCompleted.Increment();
+}
+
+void TickingGroup::ScheduleFunction(uint32_t index)
+{
+    if (m_FunctionList[index].Desc.ThreadSafe)
+    {
+        m_JobManager->SubmitJob(m_Jobs[index], *m_JobCounter);
+    }
+    else
+    {
+        SpinLockGuard lock(m_MainThreadQueueLock);
+        m_MainThreadQueue.Add(index);
+    }
+}
+
+bool TickingGroup::PopMainThreadFunction(uint32_t& index)
+{
+    SpinLockGuard lock(m_MainThreadQueueLock);
+    if (m_MainThreadQueueHead == m_MainThreadQueue.Size())
+        return false;
+    index = m_MainThreadQueue[m_MainThreadQueueHead++];
+    return true;
+}
+
+void TickingGroup::ExecuteJob(void* data)
+{
+    JobData* jobData = static_cast<JobData*>(data);
+
+    jobData->Group->ExecuteFunction(jobData->Index);
+    jobData->Group->CompleteFunction(jobData->Index);
+}
+
+void TickingGroup::UpdateCriticalPath()
+{
+    // Longest path through the graph weighted by the function durations.
+    // FinishTime accumulates the latest finish time of the prerequisites until the function itself is visited.
+    for (Function& function : m_FunctionList)
+    {
+        function.FinishTime = 0;
+        function.CriticalPrerequisite = NO_PREREQUISITE;
+    }
+
+    m_CriticalPathTime = 0;
+    m_CriticalPathEnd = NO_PREREQUISITE;
+
+    for (uint32_t index : m_ExecutionOrder)
+    {
+        Function& function = m_FunctionList[index];
+
+        function.FinishTime += function.Duration;
+
+        if (m_CriticalPathEnd == NO_PREREQUISITE || function.FinishTime > m_CriticalPathTime)
+        {
+            m_CriticalPathTime = function.FinishTime;
+            m_CriticalPathEnd = index;
+        }
+
+        for (uint32_t successor : function.Successors)
+        {
+            Function& next = m_FunctionList[successor];
+            if (next.CriticalPrerequisite == NO_PREREQUISITE || function.FinishTime > next.FinishTime)
+            {
+                next.FinishTime = function.FinishTime;
+                next.CriticalPrerequisite = index;
+            }
+        }
+    }
+}
+
+void TickingGroup::GetCriticalPath(Vector<uint32_t>& path) const
+{
+    path.Clear();
+
+    for (uint32_t index = m_CriticalPathEnd; index != NO_PREREQUISITE; index = m_FunctionList[index].CriticalPrerequisite)
+        path.Add(index);
+
+    path.Reverse();
+}
+
+void TickingGroup::AddEdge(uint32_t from, uint32_t to)
+{
+    Function& function = m_FunctionList[from];
+    if (!function.Successors.Contains(to))
+    {
+        function.Successors.Add(to);
+        m_FunctionList[to].NumPrerequisites++;
+    }
+}
+
+bool TickingGroup::IsReachable(uint32_t from, uint32_t to)
+{
+    uint32_t traverseID = ++m_TraverseID;
+
+    SmallVector<uint32_t, 32> stack;
+    stack.Add(from);
+
+    while (!stack.IsEmpty())
+    {
+        uint32_t index = stack.Last();
+        stack.RemoveLast();
+
+        if (index == to)
+            return true;
+
+        Function& function = m_FunctionList[index];
+        if (function.TraverseID == traverseID)
+            continue;
+        function.TraverseID = traverseID;
+
+        for (uint32_t successor : function.Successors)
+            stack.Add(successor);
+    }
+    return false;
+}
+
+bool TickingGroup::HasDataRace(Function const& a, Function const& b) const
+{
+    auto writes = [](Function const& function, uint32_t typeID)
+    {
+        return function.OwnerTypeID == typeID || function.Desc.Writes.Contains(typeID);
+    };
+
+    auto reads = [](Function const& function, uint32_t typeID)
+    {
+        return function.Desc.Reads.Contains(typeID);
+    };
+
+    if (writes(b, a.OwnerTypeID) || reads(b, a.OwnerTypeID))
+        return true;
+
+    for (uint32_t typeID : a.Desc.Writes)
+    {
+        if (writes(b, typeID) || reads(b, typeID))
+            return true;
+    }
+
+    for (uint32_t typeID : a.Desc.Reads)
+    {
+        if (writes(b, typeID))
+            return true;
+    }
+
+    return false;
 }
 
 void TickingGroup::Rebuild()
@@ -115,6 +362,92 @@ void TickingGroup::Rebuild()
     traverse.TraverseID = ++m_TraverseID;
     traverse.Traverse();
 
+    uint32_t functionCount = m_FunctionList.Size();
+
+    // Build the dependency graph. Only edges that agree with the execution order are kept, so cyclic
+    // prerequisites are resolved the same way for the serial and the parallel dispatch.
+    Vector<uint32_t> position;
+    position.Resize(functionCount);
+    for (uint32_t i = 0; i < functionCount; ++i)
+        position[m_ExecutionOrder[i]] = i;
+
+    m_HasThreadSafeFunctions = false;
+    for (Function& function : m_FunctionList)
+    {
+        function.Successors.Clear();
+        function.NumPrerequisites = 0;
+
+        if (function.Desc.ThreadSafe)
+            m_HasThreadSafeFunctions = true;
+    }
+
+    for (uint32_t index = 0; index < functionCount; ++index)
+    {
+        for (auto prerequisite : m_FunctionList[index].Desc.Prerequisites)
+        {
+            for (uint32_t index2 = 0; index2 < functionCount; ++index2)
+                if (m_FunctionList[index2].OwnerTypeID == prerequisite && position[index2] < position[index])
+                    AddEdge(index2, index);
+        }
+    }
+
+    // Main thread functions that don't declare their data access may touch any component, so they act as
+    // barriers for the thread safe functions.
+    auto isBarrier = [](Function const& function)
+    {
+        return !function.Desc.ThreadSafe && function.Desc.Reads.IsEmpty() && function.Desc.Writes.IsEmpty();
+    };
+
+    // Functions without a path between them may run concurrently. Use declared data access to find races
+    // and serialize such functions in execution order. All edges go forward in the execution order, so only
+    // the path from the earlier function to the later one needs to be checked.
+    for (uint32_t i = 0; i < functionCount; ++i)
+    {
+        uint32_t first = m_ExecutionOrder[i];
+
+        for (uint32_t j = i + 1; j < functionCount; ++j)
+        {
+            uint32_t second = m_ExecutionOrder[j];
+
+            Function const& a = m_FunctionList[first];
+            Function const& b = m_FunctionList[second];
+
+            if (!a.Desc.ThreadSafe && !b.Desc.ThreadSafe)
+                continue;
+
+            bool barrier = isBarrier(a) || isBarrier(b);
+
+            if (!barrier && !HasDataRace(a, b) && !HasDataRace(b, a))
+                continue;
+
+            if (IsReachable(first, second))
+                continue;
+
+            if (!barrier)
+                LOG("Warning: TickingGroup: data race between \"{}\" and \"{}\", the functions will be executed sequentially\n",
+                    a.Desc.Name.GetStringView(), b.Desc.Name.GetStringView());
+
+            AddEdge(first, second);
+        }
+    }
+
+    delete[] m_PendingPrerequisites;
+    m_PendingPrerequisites = functionCount ? new AtomicInt[functionCount] : nullptr;
+
+    m_JobData.Resize(functionCount);
+    m_Jobs.Resize(functionCount);
+    for (uint32_t index = 0; index < functionCount; ++index)
+    {
+        m_JobData[index].Group = this;
+        m_JobData[index].Index = index;
+
+        m_Jobs[index].Callback = &TickingGroup::ExecuteJob;
+        m_Jobs[index].Data = &m_JobData[index];
+        m_Jobs[index].Counter = nullptr;
+    }
+
+    m_MainThreadQueue.Reserve(functionCount);
+
     m_RebuildRequired = false;
 }
 
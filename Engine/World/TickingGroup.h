@@ -32,9 +32,11 @@ SOFTWARE.
 
 #include "TickFunction.h"
 
+#include <Engine/Core/AsyncJobManager.h>
+
 HK_NAMESPACE_BEGIN
 
-struct TickingGroup
+struct TickingGroup final : Noncopyable
 {
 private:
     struct Function
@@ -43,6 +45,21 @@ private:
         Delegate<void()>    Delegate;
         uint32_t            OwnerTypeID;
         uint32_t            TraverseID;
+
+        // Functions that depend on this one
+        SmallVector<uint32_t, 4> Successors;
+        uint32_t            NumPrerequisites;
+
+        // Timings of the last dispatch, in microseconds
+        int64_t             Duration;
+        int64_t             FinishTime;
+        uint32_t            CriticalPrerequisite;
+    };
+
+    struct JobData
+    {
+        TickingGroup*       Group;
+        uint32_t            Index;
     };
 
     Vector<Function>        m_FunctionList;
@@ -50,10 +67,53 @@ private:
     bool                    m_RebuildRequired{};
     uint32_t                m_TraverseID{};
 
+    // Parallel dispatch state
+    Vector<JobData>         m_JobData;
+    Vector<AsyncJob>        m_Jobs;
+    AtomicInt*              m_PendingPrerequisites{};
+    AtomicInt               m_NumCompleted{0};
+    SpinLock                m_MainThreadQueueLock;
+    Vector<uint32_t>        m_MainThreadQueue;
+    uint32_t                m_MainThreadQueueHead{};
+    AsyncJobManager*        m_JobManager{};
+    AsyncJobCounter*        m_JobCounter{};
+    bool                    m_IsPaused{};
+    bool                    m_HasThreadSafeFunctions{};
+
+    int64_t                 m_CriticalPathTime{};
+    uint32_t                m_CriticalPathEnd{};
+
+    void                    DispatchSerial();
+    void                    DispatchParallel();
+    void                    ExecuteFunction(uint32_t index);
+    void                    CompleteFunction(uint32_t index);
+    void                    ScheduleFunction(uint32_t index);
+    bool                    PopMainThreadFunction(uint32_t& index);
+    void                    UpdateCriticalPath();
+    bool                    IsReachable(uint32_t from, uint32_t to);
+    bool                    HasDataRace(Function const& a, Function const& b) const;
+    void                    AddEdge(uint32_t from, uint32_t to);
+
+    static void             ExecuteJob(void* data);
+
 public:
+                            TickingGroup() = default;
+                            ~TickingGroup();
+
     void                    AddFunction(TickFunction const& f);
     void                    Dispatch(struct WorldTick& tick);
     void                    Rebuild();
+
+    /// Statistics of the last dispatch. Times are in microseconds.
+    uint32_t                GetFunctionCount() const { return m_FunctionList.Size(); }
+    StringID const&         GetFunctionName(uint32_t index) const { return m_FunctionList[index].Desc.Name; }
+    int64_t                 GetFunctionTime(uint32_t index) const { return m_FunctionList[index].Duration; }
+
+    /// The longest chain of dependent functions, i.e. the lower bound of the group time with unlimited threads.
+    int64_t                 GetCriticalPathTime() const { return m_CriticalPathTime; }
+
+    /// Function indices of the critical path, from the first function to the last.
+    void                    GetCriticalPath(Vector<uint32_t>& path) const;
 };
 
 HK_NAMESPACE_END
@@ -0,0 +1,299 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "TransformBatch.h"
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+HK_NAMESPACE_BEGIN
+
+namespace
+{
+
+HK_FORCEINLINE __m128 Select_SSE(__m128 mask, __m128 a, __m128 b)
+{
+    // mask ? a : b
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+HK_FORCEINLINE __m128 MulAdd_SSE(__m128 a, __m128 b, __m128 c)
+{
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+}
+
+void TransformBatch::AddRoot(GameObject::TransformData* transform)
+{
+    HK_ASSERT(m_Count < MAX_SIZE);
+
+    uint32_t i = m_Count++;
+
+    m_Items[i] = transform;
+
+    m_Position[0][i] = transform->Position.X;
+    m_Position[1][i] = transform->Position.Y;
+    m_Position[2][i] = transform->Position.Z;
+
+    m_Rotation[0][i] = transform->Rotation.X;
+    m_Rotation[1][i] = transform->Rotation.Y;
+    m_Rotation[2][i] = transform->Rotation.Z;
+    m_Rotation[3][i] = transform->Rotation.W;
+
+    m_Scale[0][i] = transform->Scale.X;
+    m_Scale[1][i] = transform->Scale.Y;
+    m_Scale[2][i] = transform->Scale.Z;
+}
+
+void TransformBatch::AddWithParent(GameObject::TransformData* transform)
+{
+    HK_ASSERT(transform->Parent);
+    HK_ASSERT(!transform->LockWorldPositionAndRotation);
+
+    uint32_t i = m_Count;
+
+    AddRoot(transform);
+
+    GameObject::TransformData const* parent = transform->Parent;
+
+    float const* parentMatrix = parent->WorldTransform.ToPtr();
+    for (int k = 0; k < 12; ++k)
+        m_ParentMatrix[k][i] = parentMatrix[k];
+
+    m_ParentRotation[0][i] = parent->WorldRotation.X;
+    m_ParentRotation[1][i] = parent->WorldRotation.Y;
+    m_ParentRotation[2][i] = parent->WorldRotation.Z;
+    m_ParentRotation[3][i] = parent->WorldRotation.W;
+
+    m_ParentScale[0][i] = parent->WorldScale.X;
+    m_ParentScale[1][i] = parent->WorldScale.Y;
+    m_ParentScale[2][i] = parent->WorldScale.Z;
+
+    m_Absolute[0][i] = transform->AbsolutePosition ? -1 : 0;
+    m_Absolute[1][i] = transform->AbsoluteRotation ? -1 : 0;
+    m_Absolute[2][i] = transform->AbsoluteScale ? -1 : 0;
+}
+
+void TransformBatch::Pad(bool withParent)
+{
+    // Replicate the last item to fill the last group of four lanes, so the kernels never read uninitialized data
+    HK_ASSERT(m_Count > 0);
+
+    uint32_t last = m_Count - 1;
+    uint32_t end = (m_Count + 3) & ~3u;
+
+    for (uint32_t i = m_Count; i < end; ++i)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            m_Position[k][i] = m_Position[k][last];
+            m_Scale[k][i] = m_Scale[k][last];
+        }
+        for (int k = 0; k < 4; ++k)
+            m_Rotation[k][i] = m_Rotation[k][last];
+
+        if (withParent)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                m_ParentScale[k][i] = m_ParentScale[k][last];
+                m_Absolute[k][i] = m_Absolute[k][last];
+            }
+            for (int k = 0; k < 4; ++k)
+                m_ParentRotation[k][i] = m_ParentRotation[k][last];
+            for (int k = 0; k < 12; ++k)
+                m_ParentMatrix[k][i] = m_ParentMatrix[k][last];
+        }
+    }
+}
+
+void TransformBatch::Compose(uint32_t first)
+{
+    // Same as Float3x4::Compose(WorldPosition, WorldRotation.ToMatrix3x3(), WorldScale)
+    const __m128 one = _mm_set_ps1(1.0f);
+    const __m128 two = _mm_set_ps1(2.0f);
+
+    __m128 x = _mm_load_ps(&m_WorldRotation[0][first]);
+    __m128 y = _mm_load_ps(&m_WorldRotation[1][first]);
+    __m128 z = _mm_load_ps(&m_WorldRotation[2][first]);
+    __m128 w = _mm_load_ps(&m_WorldRotation[3][first]);
+
+    __m128 xx = _mm_mul_ps(x, x);
+    __m128 yy = _mm_mul_ps(y, y);
+    __m128 zz = _mm_mul_ps(z, z);
+    __m128 xz = _mm_mul_ps(x, z);
+    __m128 xy = _mm_mul_ps(x, y);
+    __m128 yz = _mm_mul_ps(y, z);
+    __m128 wx = _mm_mul_ps(w, x);
+    __m128 wy = _mm_mul_ps(w, y);
+    __m128 wz = _mm_mul_ps(w, z);
+
+    __m128 r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+    __m128 r01 = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+    __m128 r02 = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+    __m128 r10 = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+    __m128 r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+    __m128 r12 = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+    __m128 r20 = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+    __m128 r21 = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+    __m128 r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+    __m128 sx = _mm_load_ps(&m_WorldScale[0][first]);
+    __m128 sy = _mm_load_ps(&m_WorldScale[1][first]);
+    __m128 sz = _mm_load_ps(&m_WorldScale[2][first]);
+
+    _mm_store_ps(&m_WorldMatrix[0][first], _mm_mul_ps(r00, sx));
+    _mm_store_ps(&m_WorldMatrix[1][first], _mm_mul_ps(r10, sy));
+    _mm_store_ps(&m_WorldMatrix[2][first], _mm_mul_ps(r20, sz));
+    _mm_store_ps(&m_WorldMatrix[3][first], _mm_load_ps(&m_WorldPosition[0][first]));
+
+    _mm_store_ps(&m_WorldMatrix[4][first], _mm_mul_ps(r01, sx));
+    _mm_store_ps(&m_WorldMatrix[5][first], _mm_mul_ps(r11, sy));
+    _mm_store_ps(&m_WorldMatrix[6][first], _mm_mul_ps(r21, sz));
+    _mm_store_ps(&m_WorldMatrix[7][first], _mm_load_ps(&m_WorldPosition[1][first]));
+
+    _mm_store_ps(&m_WorldMatrix[8][first], _mm_mul_ps(r02, sx));
+    _mm_store_ps(&m_WorldMatrix[9][first], _mm_mul_ps(r12, sy));
+    _mm_store_ps(&m_WorldMatrix[10][first], _mm_mul_ps(r22, sz));
+    _mm_store_ps(&m_WorldMatrix[11][first], _mm_load_ps(&m_WorldPosition[2][first]));
+}
+
+void TransformBatch::UpdateRoots(uint32_t updateIndex)
+{
+    if (!m_Count)
+        return;
+
+    Pad(false);
+
+    for (uint32_t i = 0; i < m_Count; i += 4)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            _mm_store_ps(&m_WorldPosition[k][i], _mm_load_ps(&m_Position[k][i]));
+            _mm_store_ps(&m_WorldScale[k][i], _mm_load_ps(&m_Scale[k][i]));
+        }
+        for (int k = 0; k < 4; ++k)
+            _mm_store_ps(&m_WorldRotation[k][i], _mm_load_ps(&m_Rotation[k][i]));
+
+        Compose(i);
+    }
+
+    WriteBack(updateIndex);
+}
+
+void TransformBatch::UpdateWithParent(uint32_t updateIndex)
+{
+    if (!m_Count)
+        return;
+
+    Pad(true);
+
+    for (uint32_t i = 0; i < m_Count; i += 4)
+    {
+        __m128 m[12];
+        for (int k = 0; k < 12; ++k)
+            m[k] = _mm_load_ps(&m_ParentMatrix[k][i]);
+
+        // Position: Parent->WorldTransform * Position
+        __m128 px = _mm_load_ps(&m_Position[0][i]);
+        __m128 py = _mm_load_ps(&m_Position[1][i]);
+        __m128 pz = _mm_load_ps(&m_Position[2][i]);
+
+        __m128 wpx = MulAdd_SSE(m[0], px, MulAdd_SSE(m[1], py, MulAdd_SSE(m[2], pz, m[3])));
+        __m128 wpy = MulAdd_SSE(m[4], px, MulAdd_SSE(m[5], py, MulAdd_SSE(m[6], pz, m[7])));
+        __m128 wpz = MulAdd_SSE(m[8], px, MulAdd_SSE(m[9], py, MulAdd_SSE(m[10], pz, m[11])));
+
+        __m128 absPosition = _mm_castsi128_ps(_mm_load_si128((__m128i const*)&m_Absolute[0][i]));
+
+        _mm_store_ps(&m_WorldPosition[0][i], Select_SSE(absPosition, px, wpx));
+        _mm_store_ps(&m_WorldPosition[1][i], Select_SSE(absPosition, py, wpy));
+        _mm_store_ps(&m_WorldPosition[2][i], Select_SSE(absPosition, pz, wpz));
+
+        // Rotation: Parent->WorldRotation * Rotation
+        __m128 ax = _mm_load_ps(&m_ParentRotation[0][i]);
+        __m128 ay = _mm_load_ps(&m_ParentRotation[1][i]);
+        __m128 az = _mm_load_ps(&m_ParentRotation[2][i]);
+        __m128 aw = _mm_load_ps(&m_ParentRotation[3][i]);
+
+        __m128 bx = _mm_load_ps(&m_Rotation[0][i]);
+        __m128 by = _mm_load_ps(&m_Rotation[1][i]);
+        __m128 bz = _mm_load_ps(&m_Rotation[2][i]);
+        __m128 bw = _mm_load_ps(&m_Rotation[3][i]);
+
+        __m128 qw = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(aw, bw), _mm_mul_ps(ax, bx)), _mm_add_ps(_mm_mul_ps(ay, by), _mm_mul_ps(az, bz)));
+        __m128 qx = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, bx), _mm_mul_ps(ax, bw)), _mm_mul_ps(ay, bz)), _mm_mul_ps(az, by));
+        __m128 qy = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, by), _mm_mul_ps(ay, bw)), _mm_mul_ps(az, bx)), _mm_mul_ps(ax, bz));
+        __m128 qz = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, bz), _mm_mul_ps(az, bw)), _mm_mul_ps(ax, by)), _mm_mul_ps(ay, bx));
+
+        __m128 absRotation = _mm_castsi128_ps(_mm_load_si128((__m128i const*)&m_Absolute[1][i]));
+
+        _mm_store_ps(&m_WorldRotation[0][i], Select_SSE(absRotation, bx, qx));
+        _mm_store_ps(&m_WorldRotation[1][i], Select_SSE(absRotation, by, qy));
+        _mm_store_ps(&m_WorldRotation[2][i], Select_SSE(absRotation, bz, qz));
+        _mm_store_ps(&m_WorldRotation[3][i], Select_SSE(absRotation, bw, qw));
+
+        // Scale: Parent->WorldScale * Scale
+        __m128 absScale = _mm_castsi128_ps(_mm_load_si128((__m128i const*)&m_Absolute[2][i]));
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m128 s = _mm_load_ps(&m_Scale[k][i]);
+            _mm_store_ps(&m_WorldScale[k][i], Select_SSE(absScale, s, _mm_mul_ps(_mm_load_ps(&m_ParentScale[k][i]), s)));
+        }
+
+        Compose(i);
+    }
+
+    WriteBack(updateIndex);
+}
+
+void TransformBatch::WriteBack(uint32_t updateIndex)
+{
+    for (uint32_t i = 0; i < m_Count; ++i)
+    {
+        GameObject::TransformData* transform = m_Items[i];
+
+        transform->WorldPosition = Float3(m_WorldPosition[0][i], m_WorldPosition[1][i], m_WorldPosition[2][i]);
+        transform->WorldRotation = Quat(m_WorldRotation[3][i], m_WorldRotation[0][i], m_WorldRotation[1][i], m_WorldRotation[2][i]);
+        transform->WorldScale    = Float3(m_WorldScale[0][i], m_WorldScale[1][i], m_WorldScale[2][i]);
+
+        transform->WorldTransform.Col0 = Float4(m_WorldMatrix[0][i], m_WorldMatrix[1][i], m_WorldMatrix[2][i], m_WorldMatrix[3][i]);
+        transform->WorldTransform.Col1 = Float4(m_WorldMatrix[4][i], m_WorldMatrix[5][i], m_WorldMatrix[6][i], m_WorldMatrix[7][i]);
+        transform->WorldTransform.Col2 = Float4(m_WorldMatrix[8][i], m_WorldMatrix[9][i], m_WorldMatrix[10][i], m_WorldMatrix[11][i]);
+
+        transform->Dirty = false;
+        transform->UpdateIndex = updateIndex;
+    }
+
+    m_Count = 0;
+}
+
+HK_NAMESPACE_END
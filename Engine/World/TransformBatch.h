@@ -0,0 +1,91 @@
+/*
+
+Hork Engine Source Code
+
+MIT License
+
+Copyright (C) 2017-2024 Alexander Samusev.
+
+This file is part of the Hork Engine Source Code.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "GameObject.h"
+
+HK_NAMESPACE_BEGIN
+
+/// Structure-of-arrays staging of transforms. Items are gathered from TransformData,
+/// updated by SSE kernels four at a time and scattered back.
+/// Game objects keep pointers into the AoS pages of the transform hierarchy, so the pages
+/// stay the storage and only dirty transforms of a page are staged on each update.
+class TransformBatch final : public Noncopyable
+{
+public:
+    /// Matches the page size of the transform hierarchy storage
+    static constexpr uint32_t MAX_SIZE = 64;
+
+    /// Add root transform. World transform is equal to the local one.
+    void                AddRoot(GameObject::TransformData* transform);
+
+    /// Add transform with parent. Transforms with locked world position and rotation are not supported.
+    void                AddWithParent(GameObject::TransformData* transform);
+
+    /// Update transforms added with AddRoot and write them back
+    void                UpdateRoots(uint32_t updateIndex);
+
+    /// Update transforms added with AddWithParent and write them back
+    void                UpdateWithParent(uint32_t updateIndex);
+
+    bool                IsFull() const { return m_Count == MAX_SIZE; }
+
+    bool                IsEmpty() const { return m_Count == 0; }
+
+private:
+    void                Pad(bool withParent);
+    void                Compose(uint32_t first);
+    void                WriteBack(uint32_t updateIndex);
+
+    uint32_t            m_Count = 0;
+    GameObject::TransformData* m_Items[MAX_SIZE];
+
+    // Local transform
+    alignas(16) float   m_Position[3][MAX_SIZE];
+    alignas(16) float   m_Rotation[4][MAX_SIZE];
+    alignas(16) float   m_Scale[3][MAX_SIZE];
+
+    // Parent world transform
+    alignas(16) float   m_ParentMatrix[12][MAX_SIZE];
+    alignas(16) float   m_ParentRotation[4][MAX_SIZE];
+    alignas(16) float   m_ParentScale[3][MAX_SIZE];
+
+    // Lane masks for AbsolutePosition, AbsoluteRotation, AbsoluteScale
+    alignas(16) int32_t m_Absolute[3][MAX_SIZE];
+
+    // World transform
+    alignas(16) float   m_WorldPosition[3][MAX_SIZE];
+    alignas(16) float   m_WorldRotation[4][MAX_SIZE];
+    alignas(16) float   m_WorldScale[3][MAX_SIZE];
+    alignas(16) float   m_WorldMatrix[12][MAX_SIZE];
+};
+
+HK_NAMESPACE_END
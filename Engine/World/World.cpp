@@ -30,13 +30,26 @@ SOFTWARE.
 
 #include "World.h"
 #include "Component.h"
+#include "TransformBatch.h"
 
 #include <Engine/World/DebugRenderer.h>
+#include <Engine/GameApplication/GameApplication.h>
+#include <Engine/Core/ConsoleVar.h>
 
 HK_NAMESPACE_BEGIN
 
-World::World()
+ConsoleVar com_TransformSIMD("com_TransformSIMD"s, "1"s, 0, "Use SIMD kernels to update world transforms"s);
+ConsoleVar com_ParallelTransforms("com_ParallelTransforms"s, "1"s, 0, "Update world transforms of a hierarchy level on worker threads"s);
+
+World::World(WorldSettings const& settings) :
+    m_Settings(settings)
 {
+    HK_ASSERT(m_Settings.FixedUpdateRate > 0);
+    HK_ASSERT(m_Settings.CollisionSteps > 0);
+
+    m_Settings.FixedUpdateRate = Math::Max(m_Settings.FixedUpdateRate, 1u);
+    m_Settings.CollisionSteps = Math::Max(m_Settings.CollisionSteps, 1u);
+
     m_ComponentManagers.Resize(ComponentRTTR::GetTypesCount());
     m_Interfaces.Resize(InterfaceRTTR::GetTypesCount());
     m_EventHolders.Resize(WorldEventRTTR::GetTypesCount());
@@ -212,6 +225,7 @@ void World::UpdateHierarchyData(GameObject* object, bool wasDynamic)
         GameObject::TransformData* newData = AllocateTransformData(isDynamic ? HierarchyType::Dynamic : HierarchyType::Static, newLevel);
 
         *newData = std::move(*oldData);
+        newData->Dirty = true;
 
         object->m_HierarchyLevel = newLevel;
         object->m_TransformData = newData;
@@ -430,7 +444,7 @@ void World::Tick(float timeStep)
 {
     ProcessCommands();
 
-    const float fixedTimeStep = 1.0f / 60.0f;
+    const float fixedTimeStep = 1.0f / m_Settings.FixedUpdateRate;
 
     m_Tick.FrameTimeStep = timeStep;
     m_Tick.FixedTimeStep = fixedTimeStep;
@@ -439,8 +453,18 @@ void World::Tick(float timeStep)
 
     m_TimeAccumulator += timeStep;
 
+    uint32_t numSubsteps = 0;
+
     while (m_TimeAccumulator >= fixedTimeStep)
     {
+        if (m_Settings.MaxSubsteps && numSubsteps == m_Settings.MaxSubsteps)
+        {
+            // Drop the whole steps we can't afford, keep the fraction for interpolation
+            m_TimeAccumulator -= Math::Floor(m_TimeAccumulator / fixedTimeStep) * fixedTimeStep;
+            break;
+        }
+        numSubsteps++;
+
         m_TimeAccumulator -= fixedTimeStep;
 
         m_Tick.PrevStateIndex = m_Tick.StateIndex;
@@ -489,6 +513,24 @@ void World::Tick(float timeStep)
     m_Tick.RunningTime += timeStep;
 }
 
+TickingGroup const& World::GetTickingGroup(TickGroup group) const
+{
+    switch (group)
+    {
+        case TickGroup::Update:
+            return m_Update;
+        case TickGroup::FixedUpdate:
+            return m_FixedUpdate;
+        case TickGroup::PhysicsUpdate:
+            return m_PhysicsUpdate;
+        case TickGroup::PostTransform:
+            return m_PostTransform;
+        case TickGroup::LateUpdate:
+            break;
+    }
+    return m_LateUpdate;
+}
+
 void World::SetPaused(bool paused)
 {
     m_CommandBuffer.Add(paused ? Command::Pause : Command::Unpause);
@@ -555,62 +597,98 @@ void World::FreeTransformData(HierarchyType hierarchyType, uint32_t hierarchyLev
 }
 
 template <typename Visitor>
-HK_FORCEINLINE void World::UpdateTransformLevel(PageStorage<GameObject::TransformData>& transforms)
+HK_FORCEINLINE void World::UpdateTransformLevel(PageStorage<GameObject::TransformData>& transforms, Visitor& visitor)
 {
-#if 0
-    for (uint32_t i = 0; i < transforms.Size(); ++i)
-    {
-        Visitor::Visit(transforms[i]);
-    }
-#else
-    uint32_t processed = 0;
-    for (uint32_t pageIndex = 0; pageIndex < transforms.GetPageCount(); ++pageIndex)
+    auto visitPages = [&transforms, &visitor](uint32_t firstPage, uint32_t lastPage)
     {
-        GameObject::TransformData* pageData = transforms.GetPageData(pageIndex);
+        const uint32_t pageSize = uint32_t(transforms.GetPageSize());
+        const uint32_t count = transforms.Size();
 
-        uint32_t remaining = transforms.Size() - processed;
-        if (remaining < transforms.GetPageSize())
+        for (uint32_t pageIndex = firstPage; pageIndex < lastPage; ++pageIndex)
         {
-            for (uint32_t i = 0; i < remaining; ++i)
-            {
-                Visitor::Visit(pageData[i]);
-            }
+            uint32_t first = pageIndex * pageSize;
+            if (first >= count)
+                break;
 
-            processed += remaining;
-        }
-        else
-        {
-            for (size_t i = 0; i < transforms.GetPageSize(); ++i)
-            {
-                Visitor::Visit(pageData[i]);
-            }
+            GameObject::TransformData* pageData = transforms.GetPageData(pageIndex);
 
-            processed += transforms.GetPageSize();
+            visitor.VisitPage(pageData, Math::Min(count - first, pageSize));
         }
+    };
+
+    uint32_t pageCount = transforms.GetPageCount();
+
+    if (com_ParallelTransforms && pageCount > TRANSFORM_PAGES_PER_JOB)
+    {
+        // Pages of one level are independent: each node reads only its parent from the previous level
+        GameApplication::GetAsyncJobManager().ParallelFor(pageCount, TRANSFORM_PAGES_PER_JOB, visitPages);
+    }
+    else
+    {
+        visitPages(0, pageCount);
     }
-#endif
 }
 
 void World::UpdateWorldTransforms()
 {
     DestroyObjectsAndComponents();
 
+    // Zero is reserved for "never updated"
+    if (++m_TransformUpdateIndex == 0)
+        m_TransformUpdateIndex = 1;
+
     struct UpdateRoot
     {
+        uint32_t UpdateIndex;
+
         HK_FORCEINLINE void Visit(GameObject::TransformData& transform)
         {
+            if (!transform.Dirty)
+                return;
+
             transform.WorldPosition = transform.Position;
             transform.WorldRotation = transform.Rotation;
             transform.WorldScale    = transform.Scale;
 
             transform.UpdateWorldTransformMatrix();
+
+            transform.Dirty = false;
+            transform.UpdateIndex = UpdateIndex;
+        }
+
+        HK_FORCEINLINE void VisitPage(GameObject::TransformData* transforms, uint32_t count)
+        {
+            if (!com_TransformSIMD)
+            {
+                for (uint32_t i = 0; i < count; ++i)
+                    Visit(transforms[i]);
+                return;
+            }
+
+            TransformBatch batch;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (transforms[i].Dirty)
+                {
+                    if (batch.IsFull())
+                        batch.UpdateRoots(UpdateIndex);
+                    batch.AddRoot(&transforms[i]);
+                }
+            }
+            batch.UpdateRoots(UpdateIndex);
         }
     };
 
     struct UpdateWithParent
     {
+        uint32_t UpdateIndex;
+
         HK_FORCEINLINE void Visit(GameObject::TransformData& transform)
         {
+            // Skip the node if neither it nor its parent has changed
+            if (!transform.Dirty && transform.Parent->UpdateIndex != UpdateIndex)
+                return;
+
             if (transform.LockWorldPositionAndRotation)
             {
                 // Пересчитать локальную позицию и поворот относительно родителя так, чтобы мировая позиция
@@ -627,6 +705,40 @@ void World::UpdateWorldTransforms()
             transform.WorldScale = transform.AbsoluteScale    ? transform.Scale    : transform.Parent->WorldScale * transform.Scale;
 
             transform.UpdateWorldTransformMatrix();
+
+            transform.Dirty = false;
+            transform.UpdateIndex = UpdateIndex;
+        }
+
+        HK_FORCEINLINE void VisitPage(GameObject::TransformData* transforms, uint32_t count)
+        {
+            if (!com_TransformSIMD)
+            {
+                for (uint32_t i = 0; i < count; ++i)
+                    Visit(transforms[i]);
+                return;
+            }
+
+            TransformBatch batch;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                GameObject::TransformData& transform = transforms[i];
+
+                if (!transform.Dirty && transform.Parent->UpdateIndex != UpdateIndex)
+                    continue;
+
+                // Locked transforms are rare, keep them on the scalar path
+                if (transform.LockWorldPositionAndRotation)
+                {
+                    Visit(transform);
+                    continue;
+                }
+
+                if (batch.IsFull())
+                    batch.UpdateWithParent(UpdateIndex);
+                batch.AddWithParent(&transform);
+            }
+            batch.UpdateWithParent(UpdateIndex);
         }
     };
 
@@ -634,13 +746,14 @@ void World::UpdateWorldTransforms()
 
     if (!transformHierarchy.IsEmpty())
     {
-        UpdateRoot updateRoot;
-        UpdateWithParent updateWithParent;
+        UpdateRoot updateRoot{m_TransformUpdateIndex};
+        UpdateWithParent updateWithParent{m_TransformUpdateIndex};
 
-        transformHierarchy[0].Iterate(updateRoot);
+        // Levels are processed in order, so parents are always up to date before their children
+        UpdateTransformLevel(transformHierarchy[0], updateRoot);
         for (uint32_t hierarchyLevel = 1; hierarchyLevel < transformHierarchy.Size(); ++hierarchyLevel)
         {
-            transformHierarchy[hierarchyLevel].Iterate(updateWithParent);
+            UpdateTransformLevel(transformHierarchy[hierarchyLevel], updateWithParent);
         }
     }
 }
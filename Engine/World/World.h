@@ -43,6 +43,20 @@ HK_NAMESPACE_BEGIN
 
 class DebugRenderer;
 
+/// Simulation settings of the world. Set on world creation.
+struct WorldSettings
+{
+    /// Number of fixed updates (and physics updates) per second
+    uint32_t            FixedUpdateRate = 60;
+
+    /// Number of collision detection steps per physics update. Use more steps to keep fast bodies stable at low update rates.
+    uint32_t            CollisionSteps = 1;
+
+    /// Max fixed updates per frame, 0 - unlimited. When a frame takes longer, the rest of its time is dropped
+    /// so the simulation doesn't fall further and further behind.
+    uint32_t            MaxSubsteps = 8;
+};
+
 class World final : public Noncopyable
 {
     friend class WorldInterfaceBase;
@@ -50,9 +64,11 @@ class World final : public Noncopyable
     friend class GameObject;
 
 public:
-                        World();
+                        World(WorldSettings const& settings = {});
                         ~World();
 
+    WorldSettings const& GetSettings() const { return m_Settings; }
+
     template <typename ComponentType>
     ComponentManager<ComponentType>& GetComponentManager();
 
@@ -90,6 +106,9 @@ public:
 
     void                SetPaused(bool paused);
 
+    /// Ticking group of the world, e.g. to inspect function timings and the critical path of the last tick.
+    TickingGroup const& GetTickingGroup(TickGroup group) const;
+
     void                DrawDebug(DebugRenderer& renderer);
 
     template <typename Event>
@@ -130,8 +149,11 @@ private:
     void                        FreeTransformData(HierarchyType hierarchyType, uint32_t hierarchyLevel, GameObject::TransformData* transformData);
 
 
+    /// Number of transform pages processed by one job
+    static constexpr uint32_t TRANSFORM_PAGES_PER_JOB = 4;
+
     template <typename Visitor>
-    void                UpdateTransformLevel(PageStorage<GameObject::TransformData>& transforms);
+    void                UpdateTransformLevel(PageStorage<GameObject::TransformData>& transforms, Visitor& visitor);
     void                UpdateWorldTransforms();
 
     void                UpdateHierarchy(GameObject* object, GameObject::TransformRule transformRule);
@@ -163,9 +185,11 @@ private:
     TickingGroup                m_PostTransform;
     TickingGroup                m_LateUpdate;
     Vector<Command>             m_CommandBuffer;
+    WorldSettings               m_Settings;
     WorldTick                   m_Tick;
     float                       m_TimeAccumulator = 0.0f;
     Vector<PageStorage<GameObject::TransformData>> m_TransformHierarchy[2];
+    uint32_t                    m_TransformUpdateIndex = 0;
 };
 
 HK_NAMESPACE_END